@@ -0,0 +1,183 @@
+/**
+ * section: Information
+ * synopsis: Compare per-domain queries with virDomainListGetInfo
+ * purpose: Demonstrate querying basic information about many domains
+ *          at once and measure how much faster it is than querying
+ *          every domain separately.
+ * usage: listinfo [URI [COUNT]]
+ * test: listinfo test:///default 10000
+ * copy: see Copyright for the status of this software.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <libvirt/libvirt.h>
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * createDomains:
+ * @conn: connection to the test driver
+ * @count: number of domains to create
+ *
+ * Start @count transient domains, so that there is something to query.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int
+createDomains(virConnectPtr conn, int count)
+{
+    char xml[512];
+    int i;
+
+    for (i = 0; i < count; i++) {
+        virDomainPtr dom;
+
+        snprintf(xml, sizeof(xml),
+                 "<domain type='test'>"
+                 "  <name>listinfo-%d</name>"
+                 "  <memory>8192</memory>"
+                 "  <os><type>hvm</type></os>"
+                 "</domain>", i);
+
+        if (!(dom = virDomainCreateXML(conn, xml, 0))) {
+            fprintf(stderr, "Failed to create domain %d\n", i);
+            return -1;
+        }
+        virDomainFree(dom);
+    }
+
+    return 0;
+}
+
+/**
+ * queryEach:
+ * @doms: domains to query
+ * @ndoms: number of domains
+ *
+ * Query every domain separately, the way most applications do it.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int
+queryEach(virDomainPtr *doms, int ndoms)
+{
+    int i;
+
+    for (i = 0; i < ndoms; i++) {
+        virDomainInfo info;
+        int state;
+        int reason;
+        char *xml;
+
+        if (virDomainGetInfo(doms[i], &info) < 0 ||
+            virDomainGetState(doms[i], &state, &reason, 0) < 0 ||
+            !(xml = virDomainGetXMLDesc(doms[i], 0)))
+            return -1;
+
+        free(xml);
+    }
+
+    return 0;
+}
+
+/**
+ * queryAll:
+ * @doms: NULL terminated list of domains to query
+ *
+ * Query all domains with a single call.
+ *
+ * Returns number of records returned, -1 on error.
+ */
+static int
+queryAll(virDomainPtr *doms)
+{
+    virDomainStatsRecordPtr *records = NULL;
+    int nrecords;
+
+    nrecords = virDomainListGetInfo(doms,
+                                    VIR_DOMAIN_LIST_INFO_BASIC |
+                                    VIR_DOMAIN_LIST_INFO_STATE |
+                                    VIR_DOMAIN_LIST_INFO_XML,
+                                    &records, 0);
+
+    virDomainStatsRecordListFree(records);
+    return nrecords;
+}
+
+int main(int argc, char **argv)
+{
+    const char *uri = "test:///default";
+    int count = 10000;
+    virConnectPtr conn = NULL;
+    virDomainPtr *doms = NULL;
+    int ndoms = 0;
+    int nrecords;
+    double start;
+    double each;
+    double all;
+    int ret = EXIT_FAILURE;
+    int i;
+
+    if (argc > 3) {
+        fprintf(stderr, "syntax: %s: [URI [COUNT]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+        uri = argv[1];
+    if (argc > 2)
+        count = atoi(argv[2]);
+
+    if (!(conn = virConnectOpen(uri))) {
+        fprintf(stderr, "Failed to connect to hypervisor\n");
+        goto cleanup;
+    }
+
+    if (createDomains(conn, count) < 0)
+        goto cleanup;
+
+    if ((ndoms = virConnectListAllDomains(conn, &doms, 0)) < 0) {
+        fprintf(stderr, "Failed to list domains\n");
+        goto cleanup;
+    }
+
+    start = now();
+    if (queryEach(doms, ndoms) < 0) {
+        fprintf(stderr, "Failed to query domains one by one\n");
+        goto cleanup;
+    }
+    each = now() - start;
+
+    start = now();
+    if ((nrecords = queryAll(doms)) < 0) {
+        fprintf(stderr, "Failed to query all domains at once\n");
+        goto cleanup;
+    }
+    all = now() - start;
+
+    printf("Domains:              %d\n", ndoms);
+    printf("One by one:           %.3f s\n", each);
+    printf("virDomainListGetInfo: %.3f s (%d records)\n", all, nrecords);
+    if (all > 0)
+        printf("Speedup:              %.1fx\n", each / all);
+
+    ret = EXIT_SUCCESS;
+
+ cleanup:
+    if (doms) {
+        for (i = 0; i < ndoms; i++)
+            virDomainFree(doms[i]);
+        free(doms);
+    }
+    if (conn)
+        virConnectClose(conn);
+    return ret;
+}
@@ -0,0 +1,114 @@
+/* Measure how many remote procedure calls per second the daemon
+ * handles over a single connection.
+ *
+ * To see the effect of the daemon's message buffer pool, run this
+ * once against a daemon with 'message_pool_size = 0' in its config
+ * file and once against one with the default setting. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <libvirt/libvirt.h>
+#include <libvirt/virterror.h>
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* A call with a tiny reply */
+static int
+callLibVersion(virConnectPtr conn)
+{
+    unsigned long version;
+
+    return virConnectGetLibVersion(conn, &version);
+}
+
+/* A call with a reply of several kilobytes */
+static int
+callCapabilities(virConnectPtr conn)
+{
+    char *caps;
+
+    if (!(caps = virConnectGetCapabilities(conn)))
+        return -1;
+
+    free(caps);
+    return 0;
+}
+
+/**
+ * runCalls:
+ * @conn: connection to the daemon
+ * @name: name of the call to print
+ * @call: function issuing a single call
+ * @seconds: how long to keep calling
+ *
+ * Issue the call repeatedly for @seconds and print the achieved rate.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int
+runCalls(virConnectPtr conn,
+         const char *name,
+         int (*call)(virConnectPtr conn),
+         double seconds)
+{
+    double start = now();
+    double elapsed;
+    unsigned long long ncalls = 0;
+
+    do {
+        if (call(conn) < 0) {
+            fprintf(stderr, "%s failed: %s\n",
+                    name, virGetLastErrorMessage());
+            return -1;
+        }
+        ncalls++;
+    } while ((elapsed = now() - start) < seconds);
+
+    printf("%-26s %10llu calls %12.1f calls/s\n",
+           name, ncalls, ncalls / elapsed);
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    const char *uri = NULL;
+    double seconds = 5;
+    virConnectPtr conn = NULL;
+    int ret = EXIT_FAILURE;
+
+    if (argc > 3) {
+        fprintf(stderr, "syntax: %s: [URI [SECONDS]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+        uri = argv[1];
+    if (argc > 2)
+        seconds = atof(argv[2]);
+
+    if (!(conn = virConnectOpenReadOnly(uri))) {
+        fprintf(stderr, "Failed to connect to hypervisor\n");
+        goto cleanup;
+    }
+
+    if (runCalls(conn, "virConnectGetLibVersion",
+                 callLibVersion, seconds) < 0 ||
+        runCalls(conn, "virConnectGetCapabilities",
+                 callCapabilities, seconds) < 0)
+        goto cleanup;
+
+    ret = EXIT_SUCCESS;
+
+ cleanup:
+    if (conn)
+        virConnectClose(conn);
+    return ret;
+}
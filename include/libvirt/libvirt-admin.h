@@ -213,6 +213,102 @@ virAdmServerPtr virAdmConnectLookupServer(virAdmConnectPtr conn,
 
 # define VIR_THREADPOOL_JOB_QUEUE_DEPTH "jobQueueDepth"
 
+/**
+ * VIR_THREADPOOL_IO_LOOPS:
+ * Macro for the threadpool ioLoops attribute: represents the number of
+ * dedicated event loop threads handling socket I/O of clients, as
+ * VIR_TYPED_PARAM_UINT. Zero means client I/O is handled by the main event
+ * loop of the daemon.
+ *
+ * With VIR_ADM_SERVER_THREADPOOL_PARAMS_IO_LOOPS, the attributes
+ * "ioLoop.<num>.clients" and "ioLoop.<num>.latency" report the number of
+ * clients handled by each of the loops and the delay in milliseconds the loop
+ * most recently dispatched its events with, both as VIR_TYPED_PARAM_UINT.
+ *
+ * NOTE: These attributes are read-only and any attempt to set them will be
+ * denied by daemon
+ *
+ * Since: 8.6.0
+ */
+
+# define VIR_THREADPOOL_IO_LOOPS "ioLoops"
+
+/**
+ * VIR_THREADPOOL_FAIR_SCHEDULING:
+ * Macro for the threadpool fairScheduling attribute: 1 if calls of every
+ * client are queued separately and served in a round robin fashion, 0 if
+ * all calls are served in order of arrival, as VIR_TYPED_PARAM_UINT.
+ *
+ * Since: 8.6.0
+ */
+
+# define VIR_THREADPOOL_FAIR_SCHEDULING "fairScheduling"
+
+/**
+ * VIR_THREADPOOL_FAIR_WEIGHT_READONLY:
+ * Macro for the threadpool fairWeightReadonly attribute: represents the
+ * number of calls of a read-only client served in a row when fair
+ * scheduling is enabled, as VIR_TYPED_PARAM_UINT.
+ *
+ * Since: 8.6.0
+ */
+
+# define VIR_THREADPOOL_FAIR_WEIGHT_READONLY "fairWeightReadonly"
+
+/**
+ * VIR_THREADPOOL_FAIR_WEIGHT_READWRITE:
+ * Macro for the threadpool fairWeightReadWrite attribute: represents the
+ * number of calls of a read-write client served in a row when fair
+ * scheduling is enabled, as VIR_TYPED_PARAM_UINT.
+ *
+ * Since: 8.6.0
+ */
+
+# define VIR_THREADPOOL_FAIR_WEIGHT_READWRITE "fairWeightReadWrite"
+
+/**
+ * VIR_THREADPOOL_FAIR_QUEUES:
+ * Macro for the threadpool fairQueues attribute: represents the current
+ * number of clients with calls waiting in fair scheduling queues, as
+ * VIR_TYPED_PARAM_UINT. Only reported with
+ * VIR_ADM_SERVER_THREADPOOL_PARAMS_FAIR_QUEUES.
+ *
+ * NOTE: This attribute is read-only and any attempt to set it will be denied
+ * by daemon
+ *
+ * Since: 8.6.0
+ */
+
+# define VIR_THREADPOOL_FAIR_QUEUES "fairQueues"
+
+/**
+ * VIR_THREADPOOL_FAIR_QUEUE_DEPTH_MAX:
+ * Macro for the threadpool fairQueueDepthMax attribute: represents the
+ * current number of calls waiting in the longest fair scheduling queue, as
+ * VIR_TYPED_PARAM_UINT. Only reported with
+ * VIR_ADM_SERVER_THREADPOOL_PARAMS_FAIR_QUEUES.
+ *
+ * NOTE: This attribute is read-only and any attempt to set it will be denied
+ * by daemon
+ *
+ * Since: 8.6.0
+ */
+
+# define VIR_THREADPOOL_FAIR_QUEUE_DEPTH_MAX "fairQueueDepthMax"
+
+/**
+ * virAdmServerThreadPoolParamsFlags:
+ *
+ * Groups of statistics reported by virAdmServerGetThreadPoolParameters
+ * instead of the threadpool tunables.
+ *
+ * Since: 8.6.0
+ */
+typedef enum {
+    VIR_ADM_SERVER_THREADPOOL_PARAMS_IO_LOOPS = (1 << 0), /* statistics of every client I/O loop (Since: 8.6.0) */
+    VIR_ADM_SERVER_THREADPOOL_PARAMS_FAIR_QUEUES = (1 << 1), /* statistics of fair scheduling queues (Since: 8.6.0) */
+} virAdmServerThreadPoolParamsFlags;
+
 /* Tunables for a server workerpool */
 int virAdmServerGetThreadPoolParameters(virAdmServerPtr srv,
                                         virTypedParameterPtr *params,
@@ -394,6 +490,32 @@ virAdmServerLookupClient(virAdmServerPtr srv,
 
 # define VIR_CLIENT_INFO_SELINUX_CONTEXT "selinux_context"
 
+/**
+ * VIR_CLIENT_INFO_COMPRESSION:
+ * Macro represents whether large messages sent to the client are compressed,
+ * as VIR_TYPED_PARAM_BOOLEAN.
+ *
+ * NOTE: This attribute is read-only and any attempt to set it will be denied
+ * by daemon
+ *
+ * Since: 8.6.0
+ */
+
+# define VIR_CLIENT_INFO_COMPRESSION "compression"
+
+/**
+ * VIR_CLIENT_INFO_COMPRESSION_BYTES_SAVED:
+ * Macro represents the number of bytes compression saved so far on messages
+ * sent to the client, as VIR_TYPED_PARAM_ULLONG.
+ *
+ * NOTE: This attribute is read-only and any attempt to set it will be denied
+ * by daemon
+ *
+ * Since: 8.6.0
+ */
+
+# define VIR_CLIENT_INFO_COMPRESSION_BYTES_SAVED "compression_bytes_saved"
+
 int virAdmClientGetInfo(virAdmClientPtr client,
                         virTypedParameterPtr *params,
                         int *nparams,
@@ -451,6 +573,35 @@ int virAdmClientClose(virAdmClientPtr client, unsigned int flags);
 
 # define VIR_SERVER_CLIENTS_UNAUTH_CURRENT "nclients_unauth"
 
+/**
+ * VIR_SERVER_CLIENTS_KEEPALIVE:
+ * Macro for the nclients_keepalive attribute: represents the current
+ * number of connections of the daemon whose liveness is checked with
+ * keepalive messages, as VIR_TYPED_PARAM_UINT. The value covers all
+ * servers of the daemon.
+ *
+ * NOTE: This attribute is read-only and any attempt to set it will be denied
+ * by daemon
+ *
+ * Since: 8.6.0
+ */
+
+# define VIR_SERVER_CLIENTS_KEEPALIVE "nclients_keepalive"
+
+/**
+ * VIR_SERVER_CLIENTS_KEEPALIVE_WAKEUPS:
+ * Macro for the keepalive_wakeups attribute: represents the number of
+ * times the daemon woke up to check connections for keepalive timeouts,
+ * as VIR_TYPED_PARAM_ULLONG. The value covers all servers of the daemon.
+ *
+ * NOTE: This attribute is read-only and any attempt to set it will be denied
+ * by daemon
+ *
+ * Since: 8.6.0
+ */
+
+# define VIR_SERVER_CLIENTS_KEEPALIVE_WAKEUPS "keepalive_wakeups"
+
 int virAdmServerGetClientLimits(virAdmServerPtr srv,
                                 virTypedParameterPtr *params,
                                 int *nparams,
@@ -484,6 +635,11 @@ int virAdmConnectSetDaemonTimeout(virAdmConnectPtr conn,
                                   unsigned int timeout,
                                   unsigned int flags);
 
+int virAdmConnectGetDriverStats(virAdmConnectPtr conn,
+                                virTypedParameterPtr *params,
+                                int *nparams,
+                                unsigned int flags);
+
 # ifdef __cplusplus
 }
 # endif
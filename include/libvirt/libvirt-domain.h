@@ -2706,6 +2706,8 @@ typedef enum {
     VIR_DOMAIN_STATS_IOTHREAD = (1 << 7), /* return iothread poll info (Since: 4.10.0) */
     VIR_DOMAIN_STATS_MEMORY = (1 << 8), /* return domain memory info (Since: 6.0.0) */
     VIR_DOMAIN_STATS_DIRTYRATE = (1 << 9), /* return domain dirty rate info (Since: 7.2.0) */
+    VIR_DOMAIN_STATS_VCPU_HYPERVISOR = (1 << 10), /* return hypervisor specific
+                                                     virtual CPU info (Since: 8.6.0) */
 } virDomainStatsTypes;
 
 /**
@@ -2743,6 +2745,25 @@ int virDomainListGetStats(virDomainPtr *doms,
 
 void virDomainStatsRecordListFree(virDomainStatsRecordPtr *stats);
 
+/**
+ * virDomainListInfoFields:
+ *
+ * Since: 8.6.0
+ */
+typedef enum {
+    VIR_DOMAIN_LIST_INFO_BASIC = (1 << 0), /* return what virDomainGetInfo
+                                              reports (Since: 8.6.0) */
+    VIR_DOMAIN_LIST_INFO_STATE = (1 << 1), /* return what virDomainGetState
+                                              reports (Since: 8.6.0) */
+    VIR_DOMAIN_LIST_INFO_XML = (1 << 2), /* return the domain XML description
+                                            (Since: 8.6.0) */
+} virDomainListInfoFields;
+
+int virDomainListGetInfo(virDomainPtr *doms,
+                         unsigned int fields,
+                         virDomainStatsRecordPtr **retInfo,
+                         unsigned int flags);
+
 /*
  * Perf Event API
  */
@@ -5342,6 +5363,16 @@ typedef void (*virConnectDomainEventJobCompletedCallback)(virConnectPtr conn,
  */
 # define VIR_DOMAIN_TUNABLE_CPU_IOTHREAD_QUOTA "cputune.iothread_quota"
 
+/**
+ * VIR_DOMAIN_TUNABLE_NUMA_NODESET:
+ *
+ * Macro represents the host NUMA nodes chosen by automatic placement for
+ * the memory of the domain, as VIR_TYPED_PARAM_STRING.
+ *
+ * Since: 8.6.0
+ */
+# define VIR_DOMAIN_TUNABLE_NUMA_NODESET "numatune.nodeset"
+
 /**
  * VIR_DOMAIN_TUNABLE_BLKDEV_DISK:
  *
@@ -988,6 +988,18 @@ char *virConnectBaselineHypervisorCPU(virConnectPtr conn,
                                       unsigned int flags);
 
 
+/**
+ * virNodeGetFreePagesFlags:
+ *
+ * Since: 8.6.0
+ */
+typedef enum {
+    VIR_NODE_FREE_PAGES_UNRESERVED = (1 << 0), /* Don't count pages reserved
+                                                  for running domains as free
+                                                  even if they didn't use them
+                                                  yet. (Since: 8.6.0) */
+} virNodeGetFreePagesFlags;
+
 int virNodeGetFreePages(virConnectPtr conn,
                         unsigned int npages,
                         unsigned int *pages,
@@ -46,6 +46,9 @@ const ADMIN_CLIENT_INFO_PARAMETERS_MAX = 64;
 /* Upper limit on number of client processing controls */
 const ADMIN_SERVER_CLIENT_LIMITS_MAX = 32;
 
+/* Upper limit on number of driver statistics */
+const ADMIN_CONNECT_DRIVER_STATS_MAX = 64;
+
 /* A long string, which may NOT be NULL. */
 typedef string admin_nonnull_string<ADMIN_STRING_MAX>;
 
@@ -219,6 +222,14 @@ struct admin_connect_set_daemon_timeout_args {
     unsigned int flags;
 };
 
+struct admin_connect_get_driver_stats_args {
+    unsigned int flags;
+};
+
+struct admin_connect_get_driver_stats_ret {
+    admin_typed_param params<ADMIN_CONNECT_DRIVER_STATS_MAX>;
+};
+
 /* Define the program number, protocol version and procedure numbers here. */
 const ADMIN_PROGRAM = 0x06900690;
 const ADMIN_PROTOCOL_VERSION = 1;
@@ -334,5 +345,10 @@ enum admin_procedure {
     /**
      * @generate: both
      */
-    ADMIN_PROC_CONNECT_SET_DAEMON_TIMEOUT = 19
+    ADMIN_PROC_CONNECT_SET_DAEMON_TIMEOUT = 19,
+
+    /**
+     * @generate: none
+     */
+    ADMIN_PROC_CONNECT_GET_DRIVER_STATS = 20
 };
@@ -24,6 +24,7 @@
 #include "virerror.h"
 #include "viridentity.h"
 #include "virlog.h"
+#include "rpc/virkeepalive.h"
 #include "rpc/virnetdaemon.h"
 #include "rpc/virnetserver.h"
 #include "virtypedparam.h"
@@ -64,6 +65,55 @@ adminConnectLookupServer(virNetDaemon *dmn,
     return virNetDaemonGetServer(dmn, name);
 }
 
+static int
+adminServerGetIOLoopStats(virNetServer *srv,
+                          virTypedParamList *paramlist)
+{
+    size_t nioLoops;
+    g_autofree size_t *ioLoopClients = NULL;
+    g_autofree unsigned int *ioLoopLatency = NULL;
+    size_t i;
+
+    nioLoops = virNetServerGetIOLoopStats(srv, &ioLoopClients, &ioLoopLatency);
+
+    for (i = 0; i < nioLoops; i++) {
+        if (virTypedParamListAddUInt(paramlist, ioLoopClients[i],
+                                     "ioLoop.%zu.clients", i) < 0)
+            return -1;
+
+        if (virTypedParamListAddUInt(paramlist, ioLoopLatency[i],
+                                     "ioLoop.%zu.latency", i) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+static int
+adminServerGetFairQueueStats(virNetServer *srv,
+                             virTypedParamList *paramlist)
+{
+    bool fair;
+    unsigned int fairWeightReadonly;
+    unsigned int fairWeightReadWrite;
+    size_t fairQueues;
+    size_t fairQueueDepthMax;
+
+    virNetServerGetSchedulerParameters(srv, &fair, &fairWeightReadonly,
+                                       &fairWeightReadWrite, &fairQueues,
+                                       &fairQueueDepthMax);
+
+    if (virTypedParamListAddUInt(paramlist, fairQueues,
+                                 "%s", VIR_THREADPOOL_FAIR_QUEUES) < 0)
+        return -1;
+
+    if (virTypedParamListAddUInt(paramlist, fairQueueDepthMax,
+                                 "%s", VIR_THREADPOOL_FAIR_QUEUE_DEPTH_MAX) < 0)
+        return -1;
+
+    return 0;
+}
+
 int
 adminServerGetThreadPoolParameters(virNetServer *srv,
                                    virTypedParameterPtr *params,
@@ -76,9 +126,34 @@ adminServerGetThreadPoolParameters(virNetServer *srv,
     size_t freeWorkers;
     size_t nPrioWorkers;
     size_t jobQueueDepth;
+    bool fair;
+    unsigned int fairWeightReadonly;
+    unsigned int fairWeightReadWrite;
+    size_t fairQueues;
+    size_t fairQueueDepthMax;
+    size_t nioLoops;
+    g_autofree size_t *ioLoopClients = NULL;
+    g_autofree unsigned int *ioLoopLatency = NULL;
     g_autoptr(virTypedParamList) paramlist = g_new0(virTypedParamList, 1);
 
-    virCheckFlags(0, -1);
+    virCheckFlags(VIR_ADM_SERVER_THREADPOOL_PARAMS_IO_LOOPS |
+                  VIR_ADM_SERVER_THREADPOOL_PARAMS_FAIR_QUEUES, -1);
+
+    /* The statistics groups are reported on their own so that every reply
+     * stays within the limit of the admin protocol on the number of
+     * parameters */
+    if (flags != 0) {
+        if (flags & VIR_ADM_SERVER_THREADPOOL_PARAMS_IO_LOOPS &&
+            adminServerGetIOLoopStats(srv, paramlist) < 0)
+            return -1;
+
+        if (flags & VIR_ADM_SERVER_THREADPOOL_PARAMS_FAIR_QUEUES &&
+            adminServerGetFairQueueStats(srv, paramlist) < 0)
+            return -1;
+
+        *nparams = virTypedParamListStealParams(paramlist, params);
+        return 0;
+    }
 
     if (virNetServerGetThreadPoolParameters(srv, &minWorkers, &maxWorkers,
                                             &nWorkers, &freeWorkers,
@@ -113,6 +188,28 @@ adminServerGetThreadPoolParameters(virNetServer *srv,
                                  "%s", VIR_THREADPOOL_JOB_QUEUE_DEPTH) < 0)
         return -1;
 
+    virNetServerGetSchedulerParameters(srv, &fair, &fairWeightReadonly,
+                                       &fairWeightReadWrite, &fairQueues,
+                                       &fairQueueDepthMax);
+
+    if (virTypedParamListAddUInt(paramlist, fair,
+                                 "%s", VIR_THREADPOOL_FAIR_SCHEDULING) < 0)
+        return -1;
+
+    if (virTypedParamListAddUInt(paramlist, fairWeightReadonly,
+                                 "%s", VIR_THREADPOOL_FAIR_WEIGHT_READONLY) < 0)
+        return -1;
+
+    if (virTypedParamListAddUInt(paramlist, fairWeightReadWrite,
+                                 "%s", VIR_THREADPOOL_FAIR_WEIGHT_READWRITE) < 0)
+        return -1;
+
+    nioLoops = virNetServerGetIOLoopStats(srv, &ioLoopClients, &ioLoopLatency);
+
+    if (virTypedParamListAddUInt(paramlist, nioLoops,
+                                 "%s", VIR_THREADPOOL_IO_LOOPS) < 0)
+        return -1;
+
     *nparams = virTypedParamListStealParams(paramlist, params);
 
     return 0;
@@ -127,6 +224,9 @@ adminServerSetThreadPoolParameters(virNetServer *srv,
     long long int minWorkers = -1;
     long long int maxWorkers = -1;
     long long int prioWorkers = -1;
+    int fair = -1;
+    long long int fairWeightReadonly = -1;
+    long long int fairWeightReadWrite = -1;
     virTypedParameterPtr param = NULL;
 
     virCheckFlags(0, -1);
@@ -138,6 +238,12 @@ adminServerSetThreadPoolParameters(virNetServer *srv,
                                VIR_TYPED_PARAM_UINT,
                                VIR_THREADPOOL_WORKERS_PRIORITY,
                                VIR_TYPED_PARAM_UINT,
+                               VIR_THREADPOOL_FAIR_SCHEDULING,
+                               VIR_TYPED_PARAM_UINT,
+                               VIR_THREADPOOL_FAIR_WEIGHT_READONLY,
+                               VIR_TYPED_PARAM_UINT,
+                               VIR_THREADPOOL_FAIR_WEIGHT_READWRITE,
+                               VIR_TYPED_PARAM_UINT,
                                NULL) < 0)
         return -1;
 
@@ -153,10 +259,40 @@ adminServerSetThreadPoolParameters(virNetServer *srv,
                                    VIR_THREADPOOL_WORKERS_PRIORITY)))
         prioWorkers = param->value.ui;
 
+    if ((param = virTypedParamsGet(params, nparams,
+                                   VIR_THREADPOOL_FAIR_SCHEDULING))) {
+        if (param->value.ui > 1) {
+            virReportError(VIR_ERR_INVALID_ARG,
+                           _("invalid value for '%s', expected 0 or 1"),
+                           VIR_THREADPOOL_FAIR_SCHEDULING);
+            return -1;
+        }
+        fair = param->value.ui;
+    }
+
+    if ((param = virTypedParamsGet(params, nparams,
+                                   VIR_THREADPOOL_FAIR_WEIGHT_READONLY)))
+        fairWeightReadonly = param->value.ui;
+
+    if ((param = virTypedParamsGet(params, nparams,
+                                   VIR_THREADPOOL_FAIR_WEIGHT_READWRITE)))
+        fairWeightReadWrite = param->value.ui;
+
+    /* Check the weights upfront so that we don't fail half way through */
+    if (fairWeightReadonly == 0 || fairWeightReadWrite == 0) {
+        virReportError(VIR_ERR_INVALID_ARG, "%s",
+                       _("scheduler weights must be greater than 0"));
+        return -1;
+    }
+
     if (virNetServerSetThreadPoolParameters(srv, minWorkers,
                                             maxWorkers, prioWorkers) < 0)
         return -1;
 
+    if (virNetServerSetSchedulerParameters(srv, fair, fairWeightReadonly,
+                                           fairWeightReadWrite) < 0)
+        return -1;
+
     return 0;
 }
 
@@ -202,6 +338,8 @@ adminClientGetInfo(virNetServerClient *client,
     const char *attr = NULL;
     g_autoptr(virTypedParamList) paramlist = g_new0(virTypedParamList, 1);
     g_autoptr(virIdentity) identity = NULL;
+    unsigned long long compressionSaved;
+    bool compression;
     int rc;
 
     virCheckFlags(0, -1);
@@ -279,6 +417,15 @@ adminClientGetInfo(virNetServerClient *client,
                                    "%s", VIR_CLIENT_INFO_SELINUX_CONTEXT) < 0)
         return -1;
 
+    compression = virNetServerClientGetCompression(client, &compressionSaved);
+    if (virTypedParamListAddBoolean(paramlist, compression,
+                                    "%s", VIR_CLIENT_INFO_COMPRESSION) < 0)
+        return -1;
+    if (compression &&
+        virTypedParamListAddULLong(paramlist, compressionSaved,
+                                   "%s", VIR_CLIENT_INFO_COMPRESSION_BYTES_SAVED) < 0)
+        return -1;
+
     *nparams = virTypedParamListStealParams(paramlist, params);
     return 0;
 }
@@ -299,6 +446,8 @@ adminServerGetClientLimits(virNetServer *srv,
                            unsigned int flags)
 {
     g_autoptr(virTypedParamList) paramlist = g_new0(virTypedParamList, 1);
+    size_t nkeepalives;
+    unsigned long long keepaliveWakeups;
 
     virCheckFlags(0, -1);
 
@@ -322,6 +471,16 @@ adminServerGetClientLimits(virNetServer *srv,
                                  "%s", VIR_SERVER_CLIENTS_UNAUTH_CURRENT) < 0)
         return -1;
 
+    virKeepAliveGetStats(&nkeepalives, &keepaliveWakeups);
+
+    if (virTypedParamListAddUInt(paramlist, nkeepalives,
+                                 "%s", VIR_SERVER_CLIENTS_KEEPALIVE) < 0)
+        return -1;
+
+    if (virTypedParamListAddULLong(paramlist, keepaliveWakeups,
+                                   "%s", VIR_SERVER_CLIENTS_KEEPALIVE_WAKEUPS) < 0)
+        return -1;
+
     *nparams = virTypedParamListStealParams(paramlist, params);
 
     return 0;
@@ -24,6 +24,7 @@
 
 #include "admin_server_dispatch.h"
 #include "admin_server.h"
+#include "libvirt_internal.h"
 #include "viralloc.h"
 #include "virerror.h"
 #include "virlog.h"
@@ -475,6 +476,17 @@ adminConnectSetDaemonTimeout(virNetDaemon *dmn,
 }
 
 
+static int
+adminConnectGetDriverStats(virTypedParameterPtr *params,
+                           int *nparams,
+                           unsigned int flags)
+{
+    virCheckFlags(0, -1);
+
+    return virStateGetStats(params, nparams);
+}
+
+
 static int
 adminDispatchConnectGetLoggingOutputs(virNetServer *server G_GNUC_UNUSED,
                                       virNetServerClient *client G_GNUC_UNUSED,
@@ -526,4 +538,34 @@ adminDispatchConnectGetLoggingFilters(virNetServer *server G_GNUC_UNUSED,
 
     return 0;
 }
+
+static int
+adminDispatchConnectGetDriverStats(virNetServer *server G_GNUC_UNUSED,
+                                   virNetServerClient *client G_GNUC_UNUSED,
+                                   virNetMessage *msg G_GNUC_UNUSED,
+                                   struct virNetMessageError *rerr,
+                                   admin_connect_get_driver_stats_args *args,
+                                   admin_connect_get_driver_stats_ret *ret)
+{
+    int rv = -1;
+    virTypedParameterPtr params = NULL;
+    int nparams = 0;
+
+    if (adminConnectGetDriverStats(&params, &nparams, args->flags) < 0)
+        goto cleanup;
+
+    if (virTypedParamsSerialize(params, nparams,
+                                ADMIN_CONNECT_DRIVER_STATS_MAX,
+                                (struct _virTypedParameterRemote **) &ret->params.params_val,
+                                &ret->params.params_len, 0) < 0)
+        goto cleanup;
+
+    rv = 0;
+ cleanup:
+    if (rv < 0)
+        virNetMessageSaveError(rerr);
+
+    virTypedParamsFree(params, nparams);
+    return rv;
+}
 #include "admin_server_dispatch_stubs.h"
@@ -796,7 +796,7 @@ virAdmConnectLookupServer(virAdmConnectPtr conn,
  * @params: pointer to a list of typed parameters which will be allocated
  *          to store all returned parameters
  * @nparams: pointer which will hold the number of params returned in @params
- * @flags: extra flags; not used yet, so callers should always pass 0
+ * @flags: bitwise-OR of virAdmServerThreadPoolParamsFlags
  *
  * Retrieves threadpool parameters from @srv. Upon successful completion,
  * @params will be allocated automatically to hold all returned data, setting
@@ -808,6 +808,18 @@ virAdmConnectLookupServer(virAdmConnectPtr conn,
  *      VIR_THREADPOOL_WORKERS_PRIORITY
  *      VIR_THREADPOOL_WORKERS_FREE
  *      VIR_THREADPOOL_WORKERS_CURRENT
+ *      VIR_THREADPOOL_JOB_QUEUE_DEPTH
+ *      VIR_THREADPOOL_IO_LOOPS
+ *      VIR_THREADPOOL_FAIR_SCHEDULING
+ *      VIR_THREADPOOL_FAIR_WEIGHT_READONLY
+ *      VIR_THREADPOOL_FAIR_WEIGHT_READWRITE
+ *
+ * When @flags select any of the statistics groups in
+ * virAdmServerThreadPoolParamsFlags, only the statistics of those groups are
+ * returned instead: the per-loop "ioLoop.<num>.clients" and
+ * "ioLoop.<num>.latency" with VIR_ADM_SERVER_THREADPOOL_PARAMS_IO_LOOPS, and
+ * VIR_THREADPOOL_FAIR_QUEUES and VIR_THREADPOOL_FAIR_QUEUE_DEPTH_MAX with
+ * VIR_ADM_SERVER_THREADPOOL_PARAMS_FAIR_QUEUES.
  *
  * Returns 0 on success, -1 in case of an error.
  *
@@ -1361,3 +1373,57 @@ virAdmConnectSetDaemonTimeout(virAdmConnectPtr conn,
 
     return ret;
 }
+
+
+/**
+ * virAdmConnectGetDriverStats:
+ * @conn: pointer to an active admin connection
+ * @params: pointer to a list of typed parameters which will be allocated
+ *          to store all returned statistics
+ * @nparams: pointer which will hold the number of params returned in @params
+ * @flags: extra flags; not used yet, so callers should always pass 0
+ *
+ * Retrieves statistics of the virtualization drivers running in the
+ * daemon. Upon successful completion, @params will be allocated
+ * automatically to hold all returned data, setting @nparams accordingly.
+ * The caller should free @params with virTypedParamsFree.
+ *
+ * The name of every statistic starts with the name of the driver which
+ * reports it. The QEMU driver reports its progress of reconnecting to
+ * domains which were running when the daemon started, as
+ * VIR_TYPED_PARAM_UINT:
+ *
+ *      "qemu.reconnect.total"  - number of domains to reconnect to
+ *      "qemu.reconnect.done"   - number of reconnects which finished,
+ *                                successfully or not
+ *      "qemu.reconnect.failed" - number of reconnects which failed
+ *
+ * Returns 0 on success, -1 in case of an error.
+ *
+ * Since: 8.6.0
+ */
+int
+virAdmConnectGetDriverStats(virAdmConnectPtr conn,
+                            virTypedParameterPtr *params,
+                            int *nparams,
+                            unsigned int flags)
+{
+    int ret;
+
+    VIR_DEBUG("conn=%p, params=%p, nparams=%p, flags=0x%x",
+              conn, params, nparams, flags);
+
+    virResetLastError();
+    virCheckAdmConnectReturn(conn, -1);
+    virCheckNonNullArgGoto(params, error);
+    virCheckNonNullArgGoto(nparams, error);
+
+    if ((ret = remoteAdminConnectGetDriverStats(conn, params, nparams,
+                                                flags)) < 0)
+        goto error;
+
+    return ret;
+ error:
+    virDispatchError(NULL);
+    return -1;
+}
@@ -82,6 +82,16 @@ virDomainDeviceInfoClear(virDomainDeviceInfo *info)
     info->isolationGroupLocked = false;
 }
 
+void
+virDomainDeviceInfoCopy(virDomainDeviceInfo *dst,
+                        const virDomainDeviceInfo *src)
+{
+    *dst = *src;
+    dst->alias = g_strdup(src->alias);
+    dst->romfile = g_strdup(src->romfile);
+    dst->loadparm = g_strdup(src->loadparm);
+}
+
 void
 virDomainDeviceInfoFree(virDomainDeviceInfo *info)
 {
@@ -170,6 +170,8 @@ struct _virDomainDeviceInfo {
 };
 
 void virDomainDeviceInfoClear(virDomainDeviceInfo *info);
+void virDomainDeviceInfoCopy(virDomainDeviceInfo *dst,
+                             const virDomainDeviceInfo *src);
 void virDomainDeviceInfoFree(virDomainDeviceInfo *info);
 
 bool virDomainDeviceInfoAddressIsEqual(const virDomainDeviceInfo *a,
@@ -2731,8 +2731,8 @@ virDomainChrSourceDefClear(virDomainChrSourceDef *def)
     VIR_FREE(def->logfile);
 }
 
-/* Almost deep copies the contents of src into dest. Some parts are not copied
- * though. */
+/* Almost deep copies the contents of src into dest. Security labels are not
+ * copied though. */
 void
 virDomainChrSourceDefCopy(virDomainChrSourceDef *dest,
                           const virDomainChrSourceDef *src)
@@ -2763,6 +2763,9 @@ virDomainChrSourceDefCopy(virDomainChrSourceDef *dest,
     case VIR_DOMAIN_CHR_TYPE_TCP:
         dest->data.tcp.host = g_strdup(src->data.tcp.host);
         dest->data.tcp.service = g_strdup(src->data.tcp.service);
+        dest->data.tcp.listen = src->data.tcp.listen;
+        dest->data.tcp.protocol = src->data.tcp.protocol;
+        dest->data.tcp.tlscreds = src->data.tcp.tlscreds;
 
         dest->data.tcp.haveTLS = src->data.tcp.haveTLS;
         dest->data.tcp.tlsFromConfig = src->data.tcp.tlsFromConfig;
@@ -2773,6 +2776,7 @@ virDomainChrSourceDefCopy(virDomainChrSourceDef *dest,
 
     case VIR_DOMAIN_CHR_TYPE_UNIX:
         dest->data.nix.path = g_strdup(src->data.nix.path);
+        dest->data.nix.listen = src->data.nix.listen;
 
         dest->data.nix.reconnect.enabled = src->data.nix.reconnect.enabled;
         dest->data.nix.reconnect.timeout = src->data.nix.reconnect.timeout;
@@ -27905,6 +27909,999 @@ virDomainDefCopy(virDomainDef *src,
     return virDomainDefParseString(xml, xmlopt, parseOpaque, parse_flags);
 }
 
+
+/*
+ * Native copy of inactive definitions
+ *
+ * virDomainDefCopy clones the definition by formatting it into XML and
+ * parsing it back which makes it by far the most expensive part of
+ * operations which only need a scratch copy of the persistent definition.
+ * The helpers below duplicate the in-memory structures directly.
+ *
+ * The copy is exact, i.e. unlike the XML round-trip it doesn't strip any
+ * live-only state and thus it must be used only on inactive definitions.
+ * Only constructs for which a complete copy is implemented are accepted by
+ * virDomainDefCopyNativeSupported(); anything else must be copied via XML.
+ * When adding new members to any of the copied structures don't forget to
+ * update the appropriate helper below.
+ */
+
+static virDomainVirtioOptions *
+virDomainVirtioOptionsCopy(const virDomainVirtioOptions *src)
+{
+    virDomainVirtioOptions *ret;
+
+    if (!src)
+        return NULL;
+
+    ret = g_new0(virDomainVirtioOptions, 1);
+    *ret = *src;
+
+    return ret;
+}
+
+
+static virDomainChrSourceDef *
+virDomainChrSourceDefCopyNative(const virDomainChrSourceDef *src,
+                                virDomainXMLOption *xmlopt)
+{
+    virDomainChrSourceDef *def;
+    size_t i;
+
+    if (!(def = virDomainChrSourceDefNew(xmlopt)))
+        return NULL;
+
+    virDomainChrSourceDefCopy(def, src);
+
+    if (src->nseclabels > 0) {
+        def->seclabels = g_new0(virSecurityDeviceLabelDef *, src->nseclabels);
+        def->nseclabels = src->nseclabels;
+
+        for (i = 0; i < src->nseclabels; i++)
+            def->seclabels[i] = virSecurityDeviceLabelDefCopy(src->seclabels[i]);
+    }
+
+    return def;
+}
+
+
+static virDomainDiskDef *
+virDomainDiskDefCopyNative(const virDomainDiskDef *src,
+                           virDomainXMLOption *xmlopt)
+{
+    g_autoptr(virStorageSource) storage = NULL;
+    virDomainDiskDef *def;
+    virObject *privateData;
+
+    if (!(storage = virStorageSourceCopy(src->src, true)))
+        return NULL;
+
+    if (!(def = virDomainDiskDefNewSource(xmlopt, &storage)))
+        return NULL;
+
+    storage = g_steal_pointer(&def->src);
+    privateData = def->privateData;
+
+    *def = *src;
+
+    def->src = g_steal_pointer(&storage);
+    def->privateData = privateData;
+    def->mirror = NULL;
+    def->dst = g_strdup(src->dst);
+    def->driverName = g_strdup(src->driverName);
+    def->serial = g_strdup(src->serial);
+    def->wwn = g_strdup(src->wwn);
+    def->vendor = g_strdup(src->vendor);
+    def->product = g_strdup(src->product);
+    def->domain_name = g_strdup(src->domain_name);
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+    virDomainBlockIoTuneInfoCopy(&src->blkdeviotune, &def->blkdeviotune);
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virDomainControllerDef *
+virDomainControllerDefCopyNative(const virDomainControllerDef *src)
+{
+    virDomainControllerDef *def = g_new0(virDomainControllerDef, 1);
+
+    *def = *src;
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virDomainNetDef *
+virDomainNetDefCopyNative(const virDomainNetDef *src,
+                          virDomainXMLOption *xmlopt)
+{
+    g_autoptr(virDomainNetDef) def = NULL;
+    virObject *privateData;
+
+    /* rejected by virDomainDefCopyNativeSupported */
+    if (src->type == VIR_DOMAIN_NET_TYPE_HOSTDEV) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("hostdev interfaces can't be copied natively"));
+        return NULL;
+    }
+
+    if (!(def = virDomainNetDefNew(xmlopt)))
+        return NULL;
+
+    privateData = def->privateData;
+
+    *def = *src;
+
+    /* Replace all pointers shared with @src before anything can fail */
+    def->privateData = privateData;
+    def->modelstr = g_strdup(src->modelstr);
+    def->backend.tap = g_strdup(src->backend.tap);
+    def->backend.vhost = g_strdup(src->backend.vhost);
+    def->teaming = NULL;
+    def->virtPortProfile = NULL;
+    def->script = g_strdup(src->script);
+    def->downscript = g_strdup(src->downscript);
+    def->domain_name = g_strdup(src->domain_name);
+    def->ifname = g_strdup(src->ifname);
+    def->ifname_guest_actual = g_strdup(src->ifname_guest_actual);
+    def->ifname_guest = g_strdup(src->ifname_guest);
+    memset(&def->hostIP, 0, sizeof(def->hostIP));
+    memset(&def->guestIP, 0, sizeof(def->guestIP));
+    virNetDevIPInfoCopy(&def->hostIP, &src->hostIP);
+    virNetDevIPInfoCopy(&def->guestIP, &src->guestIP);
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+    def->filter = g_strdup(src->filter);
+    def->filterparams = NULL;
+    def->bandwidth = NULL;
+    memset(&def->vlan, 0, sizeof(def->vlan));
+    def->coalesce = NULL;
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+
+    switch (src->type) {
+    case VIR_DOMAIN_NET_TYPE_VHOSTUSER:
+        def->data.vhostuser = NULL;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_VDPA:
+        def->data.vdpa.devicepath = g_strdup(src->data.vdpa.devicepath);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_SERVER:
+    case VIR_DOMAIN_NET_TYPE_CLIENT:
+    case VIR_DOMAIN_NET_TYPE_MCAST:
+    case VIR_DOMAIN_NET_TYPE_UDP:
+        def->data.socket.address = g_strdup(src->data.socket.address);
+        def->data.socket.localaddr = g_strdup(src->data.socket.localaddr);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_NETWORK:
+        def->data.network.name = g_strdup(src->data.network.name);
+        def->data.network.portgroup = g_strdup(src->data.network.portgroup);
+        def->data.network.actual = NULL;
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_BRIDGE:
+        def->data.bridge.brname = g_strdup(src->data.bridge.brname);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_INTERNAL:
+        def->data.internal.name = g_strdup(src->data.internal.name);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_DIRECT:
+        def->data.direct.linkdev = g_strdup(src->data.direct.linkdev);
+        break;
+
+    case VIR_DOMAIN_NET_TYPE_HOSTDEV:
+    case VIR_DOMAIN_NET_TYPE_ETHERNET:
+    case VIR_DOMAIN_NET_TYPE_USER:
+    case VIR_DOMAIN_NET_TYPE_LAST:
+        break;
+    }
+
+    if (src->type == VIR_DOMAIN_NET_TYPE_VHOSTUSER &&
+        !(def->data.vhostuser = virDomainChrSourceDefCopyNative(src->data.vhostuser,
+                                                                xmlopt)))
+        return NULL;
+
+    if (src->teaming) {
+        def->teaming = g_new0(virDomainNetTeamingInfo, 1);
+        def->teaming->type = src->teaming->type;
+        def->teaming->persistent = g_strdup(src->teaming->persistent);
+    }
+
+    if (virNetDevVPortProfileCopy(&def->virtPortProfile, src->virtPortProfile) < 0)
+        return NULL;
+
+    if (src->filterparams) {
+        def->filterparams = virHashNew(virNWFilterVarValueHashFree);
+
+        if (virNWFilterHashTablePutAll(src->filterparams, def->filterparams) < 0)
+            return NULL;
+    }
+
+    if (virNetDevBandwidthCopy(&def->bandwidth, src->bandwidth) < 0)
+        return NULL;
+
+    if (virNetDevVlanCopy(&def->vlan, &src->vlan) < 0)
+        return NULL;
+
+    if (src->coalesce) {
+        def->coalesce = g_new0(virNetDevCoalesce, 1);
+        *def->coalesce = *src->coalesce;
+    }
+
+    return g_steal_pointer(&def);
+}
+
+
+static virDomainInputDef *
+virDomainInputDefCopyNative(const virDomainInputDef *src)
+{
+    virDomainInputDef *def = g_new0(virDomainInputDef, 1);
+
+    *def = *src;
+    def->source.evdev = g_strdup(src->source.evdev);
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static void
+virDomainGraphicsAuthDefCopy(virDomainGraphicsAuthDef *dst,
+                             const virDomainGraphicsAuthDef *src)
+{
+    *dst = *src;
+    dst->passwd = g_strdup(src->passwd);
+}
+
+
+static virDomainGraphicsDef *
+virDomainGraphicsDefCopyNative(const virDomainGraphicsDef *src,
+                               virDomainXMLOption *xmlopt)
+{
+    virDomainGraphicsDef *def;
+    virObject *privateData;
+    size_t i;
+
+    if (!(def = virDomainGraphicsDefNew(xmlopt)))
+        return NULL;
+
+    privateData = def->privateData;
+
+    *def = *src;
+
+    def->privateData = privateData;
+
+    switch (src->type) {
+    case VIR_DOMAIN_GRAPHICS_TYPE_VNC:
+        def->data.vnc.keymap = g_strdup(src->data.vnc.keymap);
+        virDomainGraphicsAuthDefCopy(&def->data.vnc.auth, &src->data.vnc.auth);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_SDL:
+        def->data.sdl.display = g_strdup(src->data.sdl.display);
+        def->data.sdl.xauth = g_strdup(src->data.sdl.xauth);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_DESKTOP:
+        def->data.desktop.display = g_strdup(src->data.desktop.display);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_SPICE:
+        def->data.spice.rendernode = g_strdup(src->data.spice.rendernode);
+        def->data.spice.keymap = g_strdup(src->data.spice.keymap);
+        virDomainGraphicsAuthDefCopy(&def->data.spice.auth, &src->data.spice.auth);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_EGL_HEADLESS:
+        def->data.egl_headless.rendernode = g_strdup(src->data.egl_headless.rendernode);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_DBUS:
+        def->data.dbus.address = g_strdup(src->data.dbus.address);
+        def->data.dbus.rendernode = g_strdup(src->data.dbus.rendernode);
+        break;
+
+    case VIR_DOMAIN_GRAPHICS_TYPE_RDP:
+    case VIR_DOMAIN_GRAPHICS_TYPE_LAST:
+        break;
+    }
+
+    def->listens = NULL;
+    if (src->nListens > 0) {
+        def->listens = g_new0(virDomainGraphicsListenDef, src->nListens);
+
+        for (i = 0; i < src->nListens; i++) {
+            def->listens[i] = src->listens[i];
+            def->listens[i].address = g_strdup(src->listens[i].address);
+            def->listens[i].network = g_strdup(src->listens[i].network);
+            def->listens[i].socket = g_strdup(src->listens[i].socket);
+        }
+    }
+
+    return def;
+}
+
+
+static virDomainSoundDef *
+virDomainSoundDefCopyNative(const virDomainSoundDef *src)
+{
+    virDomainSoundDef *def = g_new0(virDomainSoundDef, 1);
+    size_t i;
+
+    *def = *src;
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    def->codecs = NULL;
+    if (src->ncodecs > 0) {
+        def->codecs = g_new0(virDomainSoundCodecDef *, src->ncodecs);
+
+        for (i = 0; i < src->ncodecs; i++) {
+            def->codecs[i] = g_new0(virDomainSoundCodecDef, 1);
+            *def->codecs[i] = *src->codecs[i];
+        }
+    }
+
+    return def;
+}
+
+
+static virDomainVideoDef *
+virDomainVideoDefCopyNative(const virDomainVideoDef *src,
+                            virDomainXMLOption *xmlopt)
+{
+    virDomainVideoDef *def;
+    virObject *privateData;
+
+    if (!(def = virDomainVideoDefNew(xmlopt)))
+        return NULL;
+
+    privateData = def->privateData;
+
+    *def = *src;
+
+    def->privateData = privateData;
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    if (src->accel) {
+        def->accel = g_new0(virDomainVideoAccelDef, 1);
+        *def->accel = *src->accel;
+        def->accel->rendernode = g_strdup(src->accel->rendernode);
+    }
+
+    if (src->res) {
+        def->res = g_new0(virDomainVideoResolutionDef, 1);
+        *def->res = *src->res;
+    }
+
+    if (src->driver) {
+        def->driver = g_new0(virDomainVideoDriverDef, 1);
+        *def->driver = *src->driver;
+        def->driver->vhost_user_binary = g_strdup(src->driver->vhost_user_binary);
+    }
+
+    return def;
+}
+
+
+static virDomainChrDef *
+virDomainChrDefCopyNative(const virDomainChrDef *src,
+                          virDomainXMLOption *xmlopt)
+{
+    g_autoptr(virDomainChrDef) def = g_new0(virDomainChrDef, 1);
+
+    *def = *src;
+
+    def->source = NULL;
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    if (src->deviceType == VIR_DOMAIN_CHR_DEVICE_TYPE_CHANNEL) {
+        switch (src->targetType) {
+        case VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_GUESTFWD:
+            def->target.addr = NULL;
+            if (src->target.addr) {
+                def->target.addr = g_new0(virSocketAddr, 1);
+                *def->target.addr = *src->target.addr;
+            }
+            break;
+
+        case VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_XEN:
+        case VIR_DOMAIN_CHR_CHANNEL_TARGET_TYPE_VIRTIO:
+            def->target.name = g_strdup(src->target.name);
+            break;
+        }
+    }
+
+    if (!(def->source = virDomainChrSourceDefCopyNative(src->source, xmlopt)))
+        return NULL;
+
+    return g_steal_pointer(&def);
+}
+
+
+static virDomainRNGDef *
+virDomainRNGDefCopyNative(const virDomainRNGDef *src,
+                          virDomainXMLOption *xmlopt)
+{
+    virDomainRNGDef *def = g_new0(virDomainRNGDef, 1);
+
+    *def = *src;
+
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    switch ((virDomainRNGBackend) src->backend) {
+    case VIR_DOMAIN_RNG_BACKEND_RANDOM:
+        def->source.file = g_strdup(src->source.file);
+        break;
+
+    case VIR_DOMAIN_RNG_BACKEND_EGD:
+        if (!(def->source.chardev = virDomainChrSourceDefCopyNative(src->source.chardev,
+                                                                    xmlopt))) {
+            virDomainRNGDefFree(def);
+            return NULL;
+        }
+        break;
+
+    case VIR_DOMAIN_RNG_BACKEND_BUILTIN:
+    case VIR_DOMAIN_RNG_BACKEND_LAST:
+        break;
+    }
+
+    return def;
+}
+
+
+static virDomainMemballoonDef *
+virDomainMemballoonDefCopyNative(const virDomainMemballoonDef *src)
+{
+    virDomainMemballoonDef *def = g_new0(virDomainMemballoonDef, 1);
+
+    *def = *src;
+    def->virtio = virDomainVirtioOptionsCopy(src->virtio);
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virDomainWatchdogDef *
+virDomainWatchdogDefCopyNative(const virDomainWatchdogDef *src)
+{
+    virDomainWatchdogDef *def = g_new0(virDomainWatchdogDef, 1);
+
+    *def = *src;
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virDomainPanicDef *
+virDomainPanicDefCopyNative(const virDomainPanicDef *src)
+{
+    virDomainPanicDef *def = g_new0(virDomainPanicDef, 1);
+
+    *def = *src;
+    virDomainDeviceInfoCopy(&def->info, &src->info);
+
+    return def;
+}
+
+
+static virSecurityLabelDef *
+virDomainSecurityLabelDefCopyNative(const virSecurityLabelDef *src)
+{
+    virSecurityLabelDef *def = g_new0(virSecurityLabelDef, 1);
+
+    *def = *src;
+    def->model = g_strdup(src->model);
+    def->label = g_strdup(src->label);
+    def->imagelabel = g_strdup(src->imagelabel);
+    def->baselabel = g_strdup(src->baselabel);
+
+    return def;
+}
+
+
+static int
+virDomainOSDefCopyNative(virDomainOSDef *dst,
+                         const virDomainOSDef *src)
+{
+    size_t i;
+
+    *dst = *src;
+
+    /* Replace all pointers shared with @src before anything can fail */
+    dst->firmwareFeatures = NULL;
+    if (src->firmwareFeatures) {
+        dst->firmwareFeatures = g_new0(int, VIR_DOMAIN_OS_DEF_FIRMWARE_FEATURE_LAST);
+        memcpy(dst->firmwareFeatures, src->firmwareFeatures,
+               VIR_DOMAIN_OS_DEF_FIRMWARE_FEATURE_LAST * sizeof(int));
+    }
+
+    dst->machine = g_strdup(src->machine);
+    dst->init = g_strdup(src->init);
+    dst->initargv = NULL;
+    if (src->initargv)
+        dst->initargv = g_strdupv(src->initargv);
+
+    dst->initenv = NULL;
+    if (src->initenv) {
+        size_t nenv = 0;
+
+        while (src->initenv[nenv])
+            nenv++;
+
+        dst->initenv = g_new0(virDomainOSEnv *, nenv + 1);
+        for (i = 0; i < nenv; i++) {
+            dst->initenv[i] = g_new0(virDomainOSEnv, 1);
+            dst->initenv[i]->name = g_strdup(src->initenv[i]->name);
+            dst->initenv[i]->value = g_strdup(src->initenv[i]->value);
+        }
+    }
+
+    dst->initdir = g_strdup(src->initdir);
+    dst->inituser = g_strdup(src->inituser);
+    dst->initgroup = g_strdup(src->initgroup);
+    dst->kernel = g_strdup(src->kernel);
+    dst->initrd = g_strdup(src->initrd);
+    dst->cmdline = g_strdup(src->cmdline);
+    dst->dtb = g_strdup(src->dtb);
+    dst->root = g_strdup(src->root);
+    dst->slic_table = g_strdup(src->slic_table);
+    dst->bootloader = g_strdup(src->bootloader);
+    dst->bootloaderArgs = g_strdup(src->bootloaderArgs);
+
+    dst->loader = NULL;
+    if (src->loader) {
+        dst->loader = g_new0(virDomainLoaderDef, 1);
+        *dst->loader = *src->loader;
+        dst->loader->path = g_strdup(src->loader->path);
+        dst->loader->nvramTemplate = g_strdup(src->loader->nvramTemplate);
+        dst->loader->nvram = NULL;
+
+        if (src->loader->nvram &&
+            !(dst->loader->nvram = virStorageSourceCopy(src->loader->nvram, false)))
+            return -1;
+    }
+
+    return 0;
+}
+
+
+static void
+virDomainClockDefCopyNative(virDomainClockDef *dst,
+                            const virDomainClockDef *src)
+{
+    size_t i;
+
+    *dst = *src;
+
+    if (src->offset == VIR_DOMAIN_CLOCK_OFFSET_TIMEZONE)
+        dst->data.timezone = g_strdup(src->data.timezone);
+
+    dst->timers = NULL;
+    if (src->ntimers > 0) {
+        dst->timers = g_new0(virDomainTimerDef *, src->ntimers);
+
+        for (i = 0; i < src->ntimers; i++) {
+            dst->timers[i] = g_new0(virDomainTimerDef, 1);
+            *dst->timers[i] = *src->timers[i];
+        }
+    }
+}
+
+
+/**
+ * virDomainDefCopyNativeSupported:
+ * @def: domain definition
+ *
+ * Returns true if virDomainDefCopyNative() is able to produce a complete
+ * copy of @def.
+ */
+bool
+virDomainDefCopyNativeSupported(const virDomainDef *def)
+{
+    size_t i;
+
+    if (def->nresctrls > 0 ||
+        def->namespaceData ||
+        def->nhostdevs > 0 ||
+        def->nleases > 0 ||
+        def->nfss > 0 ||
+        def->naudios > 0 ||
+        def->nhubs > 0 ||
+        def->nredirdevs > 0 ||
+        def->nsmartcards > 0 ||
+        def->nshmems > 0 ||
+        def->nmems > 0 ||
+        def->ntpms > 0 ||
+        def->nvram ||
+        def->redirfilter ||
+        def->iommu ||
+        def->vsock ||
+        def->sec)
+        return false;
+
+    for (i = 0; i < def->ndisks; i++) {
+        if (def->disks[i]->mirror ||
+            def->disks[i]->src->type == VIR_STORAGE_TYPE_VHOST_USER)
+            return false;
+    }
+
+    for (i = 0; i < def->nnets; i++) {
+        if (def->nets[i]->type == VIR_DOMAIN_NET_TYPE_HOSTDEV ||
+            (def->nets[i]->type == VIR_DOMAIN_NET_TYPE_NETWORK &&
+             def->nets[i]->data.network.actual))
+            return false;
+    }
+
+    return true;
+}
+
+
+static int
+virDomainDefCopyNativeChrs(virDomainChrDef ***dst,
+                           size_t *ndst,
+                           virDomainChrDef **src,
+                           size_t nsrc,
+                           virDomainXMLOption *xmlopt)
+{
+    size_t i;
+
+    *dst = NULL;
+    *ndst = 0;
+
+    if (nsrc == 0)
+        return 0;
+
+    *dst = g_new0(virDomainChrDef *, nsrc);
+
+    for (i = 0; i < nsrc; i++) {
+        if (!((*dst)[i] = virDomainChrDefCopyNative(src[i], xmlopt)))
+            return -1;
+        (*ndst)++;
+    }
+
+    return 0;
+}
+
+
+/**
+ * virDomainDefCopyNative:
+ * @src: inactive domain definition
+ * @xmlopt: XML parser configuration object
+ *
+ * Creates a deep copy of @src without formatting it into XML. Callers must
+ * make sure that virDomainDefCopyNativeSupported() returns true for @src.
+ *
+ * Returns the copy on success, NULL with error reported on failure.
+ */
+virDomainDef *
+virDomainDefCopyNative(const virDomainDef *src,
+                       virDomainXMLOption *xmlopt)
+{
+    g_autoptr(virDomainDef) def = NULL;
+    size_t i;
+
+    if (!virDomainDefCopyNativeSupported(src)) {
+        virReportError(VIR_ERR_OPERATION_UNSUPPORTED, "%s",
+                       _("domain definition can't be copied natively"));
+        return NULL;
+    }
+
+    def = g_new0(virDomainDef, 1);
+    *def = *src;
+
+    /* Replace all pointers shared with @src before anything can fail. The
+     * remaining ones are NULL as checked by virDomainDefCopyNativeSupported */
+    def->name = g_strdup(src->name);
+    def->title = g_strdup(src->title);
+    def->description = g_strdup(src->description);
+    def->emulator = g_strdup(src->emulator);
+    def->hyperv_vendor_id = g_strdup(src->hyperv_vendor_id);
+
+    def->blkio.devices = NULL;
+    if (src->blkio.ndevices > 0) {
+        def->blkio.devices = g_new0(virBlkioDevice, src->blkio.ndevices);
+
+        for (i = 0; i < src->blkio.ndevices; i++) {
+            def->blkio.devices[i] = src->blkio.devices[i];
+            def->blkio.devices[i].path = g_strdup(src->blkio.devices[i].path);
+        }
+    }
+
+    def->mem.hugepages = NULL;
+    if (src->mem.nhugepages > 0) {
+        def->mem.hugepages = g_new0(virDomainHugePage, src->mem.nhugepages);
+
+        for (i = 0; i < src->mem.nhugepages; i++) {
+            def->mem.hugepages[i].size = src->mem.hugepages[i].size;
+            if (src->mem.hugepages[i].nodemask)
+                def->mem.hugepages[i].nodemask = virBitmapNewCopy(src->mem.hugepages[i].nodemask);
+        }
+    }
+
+    def->vcpus = NULL;
+    def->maxvcpus = 0;
+
+    def->cpumask = NULL;
+    if (src->cpumask)
+        def->cpumask = virBitmapNewCopy(src->cpumask);
+
+    def->iothreadids = NULL;
+    if (src->niothreadids > 0) {
+        def->iothreadids = g_new0(virDomainIOThreadIDDef *, src->niothreadids);
+
+        for (i = 0; i < src->niothreadids; i++) {
+            def->iothreadids[i] = g_new0(virDomainIOThreadIDDef, 1);
+            *def->iothreadids[i] = *src->iothreadids[i];
+            if (src->iothreadids[i]->cpumask)
+                def->iothreadids[i]->cpumask = virBitmapNewCopy(src->iothreadids[i]->cpumask);
+        }
+    }
+
+    def->defaultIOThread = NULL;
+    if (src->defaultIOThread) {
+        def->defaultIOThread = g_new0(virDomainDefaultIOThreadDef, 1);
+        *def->defaultIOThread = *src->defaultIOThread;
+    }
+
+    def->cputune.emulatorpin = NULL;
+    if (src->cputune.emulatorpin)
+        def->cputune.emulatorpin = virBitmapNewCopy(src->cputune.emulatorpin);
+
+    def->cputune.emulatorsched = NULL;
+    if (src->cputune.emulatorsched) {
+        def->cputune.emulatorsched = g_new0(virDomainThreadSchedParam, 1);
+        *def->cputune.emulatorsched = *src->cputune.emulatorsched;
+    }
+
+    def->numa = NULL;
+    if (src->numa)
+        def->numa = virDomainNumaCopy(src->numa);
+
+    def->resource = NULL;
+    if (src->resource) {
+        def->resource = g_new0(virDomainResourceDef, 1);
+        def->resource->partition = g_strdup(src->resource->partition);
+        def->resource->appid = g_strdup(src->resource->appid);
+    }
+
+    def->idmap.uidmap = NULL;
+    if (src->idmap.nuidmap > 0) {
+        def->idmap.uidmap = g_new0(virDomainIdMapEntry, src->idmap.nuidmap);
+        memcpy(def->idmap.uidmap, src->idmap.uidmap,
+               src->idmap.nuidmap * sizeof(*src->idmap.uidmap));
+    }
+
+    def->idmap.gidmap = NULL;
+    if (src->idmap.ngidmap > 0) {
+        def->idmap.gidmap = g_new0(virDomainIdMapEntry, src->idmap.ngidmap);
+        memcpy(def->idmap.gidmap, src->idmap.gidmap,
+               src->idmap.ngidmap * sizeof(*src->idmap.gidmap));
+    }
+
+    def->kvm_features = NULL;
+    if (src->kvm_features) {
+        def->kvm_features = g_new0(virDomainFeatureKVM, 1);
+        *def->kvm_features = *src->kvm_features;
+    }
+
+    def->tcg_features = NULL;
+    if (src->tcg_features) {
+        def->tcg_features = g_new0(virDomainFeatureTCG, 1);
+        *def->tcg_features = *src->tcg_features;
+    }
+
+    virDomainClockDefCopyNative(&def->clock, &src->clock);
+
+    def->graphics = NULL;
+    def->ngraphics = 0;
+    def->disks = NULL;
+    def->ndisks = 0;
+    def->controllers = NULL;
+    def->ncontrollers = 0;
+    def->nets = NULL;
+    def->nnets = 0;
+    def->inputs = NULL;
+    def->ninputs = 0;
+    def->sounds = NULL;
+    def->nsounds = 0;
+    def->videos = NULL;
+    def->nvideos = 0;
+    def->serials = NULL;
+    def->nserials = 0;
+    def->parallels = NULL;
+    def->nparallels = 0;
+    def->channels = NULL;
+    def->nchannels = 0;
+    def->consoles = NULL;
+    def->nconsoles = 0;
+    def->rngs = NULL;
+    def->nrngs = 0;
+    def->panics = NULL;
+    def->npanics = 0;
+    def->seclabels = NULL;
+    def->nseclabels = 0;
+    def->sysinfo = NULL;
+    def->nsysinfo = 0;
+    def->watchdog = NULL;
+    def->memballoon = NULL;
+    def->cpu = NULL;
+    def->keywrap = NULL;
+    def->metadata = NULL;
+
+    /* From now on @def doesn't share anything with @src */
+    if (virDomainOSDefCopyNative(&def->os, &src->os) < 0)
+        return NULL;
+
+    def->vcpus = g_new0(virDomainVcpuDef *, src->maxvcpus);
+    for (i = 0; i < src->maxvcpus; i++) {
+        virDomainVcpuDef *vcpu;
+
+        if (!(vcpu = virDomainVcpuDefNew(xmlopt)))
+            return NULL;
+
+        vcpu->online = src->vcpus[i]->online;
+        vcpu->hotpluggable = src->vcpus[i]->hotpluggable;
+        vcpu->order = src->vcpus[i]->order;
+        vcpu->sched = src->vcpus[i]->sched;
+        if (src->vcpus[i]->cpumask)
+            vcpu->cpumask = virBitmapNewCopy(src->vcpus[i]->cpumask);
+
+        def->vcpus[def->maxvcpus++] = vcpu;
+    }
+
+    if (src->ngraphics > 0) {
+        def->graphics = g_new0(virDomainGraphicsDef *, src->ngraphics);
+        for (i = 0; i < src->ngraphics; i++) {
+            if (!(def->graphics[i] = virDomainGraphicsDefCopyNative(src->graphics[i],
+                                                                    xmlopt)))
+                return NULL;
+            def->ngraphics++;
+        }
+    }
+
+    if (src->ndisks > 0) {
+        def->disks = g_new0(virDomainDiskDef *, src->ndisks);
+        for (i = 0; i < src->ndisks; i++) {
+            if (!(def->disks[i] = virDomainDiskDefCopyNative(src->disks[i], xmlopt)))
+                return NULL;
+            def->ndisks++;
+        }
+    }
+
+    if (src->ncontrollers > 0) {
+        def->controllers = g_new0(virDomainControllerDef *, src->ncontrollers);
+        for (i = 0; i < src->ncontrollers; i++)
+            def->controllers[def->ncontrollers++] = virDomainControllerDefCopyNative(src->controllers[i]);
+    }
+
+    if (src->nnets > 0) {
+        def->nets = g_new0(virDomainNetDef *, src->nnets);
+        for (i = 0; i < src->nnets; i++) {
+            if (!(def->nets[i] = virDomainNetDefCopyNative(src->nets[i], xmlopt)))
+                return NULL;
+            def->nnets++;
+        }
+    }
+
+    if (src->ninputs > 0) {
+        def->inputs = g_new0(virDomainInputDef *, src->ninputs);
+        for (i = 0; i < src->ninputs; i++)
+            def->inputs[def->ninputs++] = virDomainInputDefCopyNative(src->inputs[i]);
+    }
+
+    if (src->nsounds > 0) {
+        def->sounds = g_new0(virDomainSoundDef *, src->nsounds);
+        for (i = 0; i < src->nsounds; i++)
+            def->sounds[def->nsounds++] = virDomainSoundDefCopyNative(src->sounds[i]);
+    }
+
+    if (src->nvideos > 0) {
+        def->videos = g_new0(virDomainVideoDef *, src->nvideos);
+        for (i = 0; i < src->nvideos; i++) {
+            if (!(def->videos[i] = virDomainVideoDefCopyNative(src->videos[i], xmlopt)))
+                return NULL;
+            def->nvideos++;
+        }
+    }
+
+    if (virDomainDefCopyNativeChrs(&def->serials, &def->nserials,
+                                   src->serials, src->nserials, xmlopt) < 0 ||
+        virDomainDefCopyNativeChrs(&def->parallels, &def->nparallels,
+                                   src->parallels, src->nparallels, xmlopt) < 0 ||
+        virDomainDefCopyNativeChrs(&def->channels, &def->nchannels,
+                                   src->channels, src->nchannels, xmlopt) < 0 ||
+        virDomainDefCopyNativeChrs(&def->consoles, &def->nconsoles,
+                                   src->consoles, src->nconsoles, xmlopt) < 0)
+        return NULL;
+
+    if (src->nrngs > 0) {
+        def->rngs = g_new0(virDomainRNGDef *, src->nrngs);
+        for (i = 0; i < src->nrngs; i++) {
+            if (!(def->rngs[i] = virDomainRNGDefCopyNative(src->rngs[i], xmlopt)))
+                return NULL;
+            def->nrngs++;
+        }
+    }
+
+    if (src->npanics > 0) {
+        def->panics = g_new0(virDomainPanicDef *, src->npanics);
+        for (i = 0; i < src->npanics; i++)
+            def->panics[def->npanics++] = virDomainPanicDefCopyNative(src->panics[i]);
+    }
+
+    if (src->nseclabels > 0) {
+        def->seclabels = g_new0(virSecurityLabelDef *, src->nseclabels);
+        for (i = 0; i < src->nseclabels; i++)
+            def->seclabels[def->nseclabels++] = virDomainSecurityLabelDefCopyNative(src->seclabels[i]);
+    }
+
+    if (src->nsysinfo > 0) {
+        def->sysinfo = g_new0(virSysinfoDef *, src->nsysinfo);
+        for (i = 0; i < src->nsysinfo; i++)
+            def->sysinfo[def->nsysinfo++] = virSysinfoDefCopy(src->sysinfo[i]);
+    }
+
+    if (src->watchdog)
+        def->watchdog = virDomainWatchdogDefCopyNative(src->watchdog);
+
+    if (src->memballoon)
+        def->memballoon = virDomainMemballoonDefCopyNative(src->memballoon);
+
+    if (src->cpu &&
+        !(def->cpu = virCPUDefCopy(src->cpu)))
+        return NULL;
+
+    if (src->keywrap) {
+        def->keywrap = g_new0(virDomainKeyWrapDef, 1);
+        *def->keywrap = *src->keywrap;
+    }
+
+    if (src->metadata &&
+        !(def->metadata = xmlCopyNode(src->metadata, 1))) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Failed to copy XML node"));
+        return NULL;
+    }
+
+    return g_steal_pointer(&def);
+}
+
+
+/**
+ * virDomainDefCopyInactive:
+ * @src: inactive domain definition
+ * @xmlopt: XML parser configuration object
+ * @parseOpaque: opaque data passed to the parser callbacks
+ *
+ * Creates a copy of the inactive definition @src. The copy is done natively
+ * if possible, otherwise the definition is cloned via XML.
+ *
+ * Returns the copy on success, NULL with error reported on failure.
+ */
+virDomainDef *
+virDomainDefCopyInactive(virDomainDef *src,
+                         virDomainXMLOption *xmlopt,
+                         void *parseOpaque)
+{
+    if (virDomainDefCopyNativeSupported(src))
+        return virDomainDefCopyNative(src, xmlopt);
+
+    return virDomainDefCopy(src, xmlopt, parseOpaque, false);
+}
+
 virDomainDef *
 virDomainObjCopyPersistentDef(virDomainObj *dom,
                               virDomainXMLOption *xmlopt,
@@ -27919,7 +28916,12 @@ virDomainObjCopyPersistentDef(virDomainObj *dom,
         return NULL;
     }
 
-    return virDomainDefCopy(cur, xmlopt, parseOpaque, false);
+    /* The live definition of a transient domain may contain runtime data
+     * which is stripped only by the XML round-trip. */
+    if (cur == dom->def && virDomainObjIsActive(dom))
+        return virDomainDefCopy(cur, xmlopt, parseOpaque, false);
+
+    return virDomainDefCopyInactive(cur, xmlopt, parseOpaque);
 }
 
 
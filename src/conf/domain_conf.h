@@ -3506,6 +3506,12 @@ virDomainDef *virDomainDefCopy(virDomainDef *src,
                                virDomainXMLOption *xmlopt,
                                void *parseOpaque,
                                bool migratable);
+bool virDomainDefCopyNativeSupported(const virDomainDef *def);
+virDomainDef *virDomainDefCopyNative(const virDomainDef *src,
+                                     virDomainXMLOption *xmlopt);
+virDomainDef *virDomainDefCopyInactive(virDomainDef *src,
+                                       virDomainXMLOption *xmlopt,
+                                       void *parseOpaque);
 virDomainDef *virDomainObjCopyPersistentDef(virDomainObj *dom,
                                             virDomainXMLOption *xmlopt,
                                             void *parseOpaque);
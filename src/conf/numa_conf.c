@@ -375,6 +375,65 @@ virDomainNumaFree(virDomainNuma *numa)
     g_free(numa);
 }
 
+
+/**
+ * virDomainNumaCopy:
+ * @src: NUMA definition
+ *
+ * Returns a deep copy of @src.
+ */
+virDomainNuma *
+virDomainNumaCopy(const virDomainNuma *src)
+{
+    virDomainNuma *numa = virDomainNumaNew();
+    size_t i;
+
+    numa->memory = src->memory;
+    if (src->memory.nodeset)
+        numa->memory.nodeset = virBitmapNewCopy(src->memory.nodeset);
+
+    if (src->nmem_nodes > 0) {
+        numa->mem_nodes = g_new0(struct _virDomainNumaNode, src->nmem_nodes);
+        numa->nmem_nodes = src->nmem_nodes;
+    }
+
+    for (i = 0; i < src->nmem_nodes; i++) {
+        const struct _virDomainNumaNode *s = &src->mem_nodes[i];
+        struct _virDomainNumaNode *d = &numa->mem_nodes[i];
+
+        *d = *s;
+        d->cpumask = NULL;
+        d->nodeset = NULL;
+        d->distances = NULL;
+        d->caches = NULL;
+
+        if (s->cpumask)
+            d->cpumask = virBitmapNewCopy(s->cpumask);
+        if (s->nodeset)
+            d->nodeset = virBitmapNewCopy(s->nodeset);
+
+        if (s->ndistances > 0) {
+            d->distances = g_new0(virNumaDistance, s->ndistances);
+            memcpy(d->distances, s->distances,
+                   s->ndistances * sizeof(*s->distances));
+        }
+
+        if (s->ncaches > 0) {
+            d->caches = g_new0(virNumaCache, s->ncaches);
+            memcpy(d->caches, s->caches, s->ncaches * sizeof(*s->caches));
+        }
+    }
+
+    if (src->ninterconnects > 0) {
+        numa->interconnects = g_new0(virNumaInterconnect, src->ninterconnects);
+        memcpy(numa->interconnects, src->interconnects,
+               src->ninterconnects * sizeof(*src->interconnects));
+        numa->ninterconnects = src->ninterconnects;
+    }
+
+    return numa;
+}
+
 /**
  * virDomainNumatuneGetMode:
  * @numatune: pointer to numatune definition
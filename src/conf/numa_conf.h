@@ -86,6 +86,7 @@ VIR_ENUM_DECL(virMemoryLatency);
 
 virDomainNuma *virDomainNumaNew(void);
 void virDomainNumaFree(virDomainNuma *numa);
+virDomainNuma *virDomainNumaCopy(const virDomainNuma *src);
 
 /*
  * XML Parse/Format functions
@@ -39,9 +39,28 @@ VIR_LOG_INIT("conf.virdomainobjlist");
 static virClass *virDomainObjListClass;
 static void virDomainObjListDispose(void *obj);
 
+#define VIR_DOMAIN_OBJ_LIST_SHARDS 16
 
-struct _virDomainObjList {
-    virObjectRWLockable parent;
+/*
+ * The UUID, name and ID indexes are split into shards, each protected
+ * by its own lock, so that lookups of different domains don't contend
+ * on a single lock and aren't stalled by writers holding the list lock.
+ *
+ * The objs and objsName tables are only modified with both the list
+ * lock and the shard lock held for writing. Hence code holding the
+ * list lock can read them directly, while virDomainObjListFindBy*
+ * only take the shard lock for reading.
+ *
+ * The ids table is a cache of the domains found by their ID, holding
+ * at most one entry per domain. Entries may be stale and are validated
+ * on every lookup, which drops them once they are found stale. It is
+ * only accessed with the shard lock held.
+ *
+ * The shard locks are never held while acquiring any other lock.
+ */
+typedef struct _virDomainObjListShard virDomainObjListShard;
+struct _virDomainObjListShard {
+    virRWLock lock;
 
     /* uuid string -> virDomainObj  mapping
      * for O(1), lookup-by-uuid */
@@ -50,6 +69,16 @@ struct _virDomainObjList {
     /* name -> virDomainObj mapping for O(1),
      * lookup-by-name */
     GHashTable *objsName;
+
+    /* id -> virDomainObj mapping for O(1),
+     * lookup-by-id */
+    GHashTable *ids;
+};
+
+struct _virDomainObjList {
+    virObjectRWLockable parent;
+
+    virDomainObjListShard *shards[VIR_DOMAIN_OBJ_LIST_SHARDS];
 };
 
 
@@ -66,6 +95,7 @@ VIR_ONCE_GLOBAL_INIT(virDomainObjList);
 virDomainObjList *virDomainObjListNew(void)
 {
     virDomainObjList *doms;
+    size_t i;
 
     if (virDomainObjListInitialize() < 0)
         return NULL;
@@ -73,8 +103,26 @@ virDomainObjList *virDomainObjListNew(void)
     if (!(doms = virObjectRWLockableNew(virDomainObjListClass)))
         return NULL;
 
-    doms->objs = virHashNew(virObjectUnref);
-    doms->objsName = virHashNew(virObjectUnref);
+    /* Shards are allocated separately so that their locks don't
+     * share a cache line */
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++) {
+        virDomainObjListShard *shard = g_new0(virDomainObjListShard, 1);
+
+        if (virRWLockInit(&shard->lock) < 0) {
+            virReportSystemError(errno, "%s",
+                                 _("Unable to initialize domain list lock"));
+            g_free(shard);
+            virObjectUnref(doms);
+            return NULL;
+        }
+
+        shard->objs = virHashNew(virObjectUnref);
+        shard->objsName = virHashNew(virObjectUnref);
+        shard->ids = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                           NULL, virObjectUnref);
+        doms->shards[i] = shard;
+    }
+
     return doms;
 }
 
@@ -82,9 +130,103 @@ virDomainObjList *virDomainObjListNew(void)
 static void virDomainObjListDispose(void *obj)
 {
     virDomainObjList *doms = obj;
+    size_t i;
+
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++) {
+        virDomainObjListShard *shard = doms->shards[i];
+
+        if (!shard)
+            continue;
+
+        g_clear_pointer(&shard->ids, g_hash_table_unref);
+        g_clear_pointer(&shard->objs, g_hash_table_unref);
+        g_clear_pointer(&shard->objsName, g_hash_table_unref);
+        virRWLockDestroy(&shard->lock);
+        g_free(shard);
+    }
+}
+
+
+static virDomainObjListShard *
+virDomainObjListShardByUUID(virDomainObjList *doms,
+                            const unsigned char *uuid)
+{
+    /* UUIDs are random enough to pick the shard directly */
+    return doms->shards[uuid[VIR_UUID_BUFLEN - 1] % VIR_DOMAIN_OBJ_LIST_SHARDS];
+}
+
+
+static virDomainObjListShard *
+virDomainObjListShardByName(virDomainObjList *doms,
+                            const char *name)
+{
+    return doms->shards[g_str_hash(name) % VIR_DOMAIN_OBJ_LIST_SHARDS];
+}
+
+
+static virDomainObjListShard *
+virDomainObjListShardByID(virDomainObjList *doms,
+                          int id)
+{
+    return doms->shards[(unsigned int)id % VIR_DOMAIN_OBJ_LIST_SHARDS];
+}
+
+
+/* Call @iter for every domain on the list. The caller must hold
+ * the list lock. */
+static void
+virDomainObjListForEachShard(virDomainObjList *doms,
+                             virHashIterator iter,
+                             void *opaque)
+{
+    size_t i;
 
-    g_clear_pointer(&doms->objs, g_hash_table_unref);
-    g_clear_pointer(&doms->objsName, g_hash_table_unref);
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++)
+        virHashForEach(doms->shards[i]->objs, iter, opaque);
+}
+
+
+static size_t
+virDomainObjListSize(virDomainObjList *doms)
+{
+    size_t ret = 0;
+    size_t i;
+
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++)
+        ret += virHashSize(doms->shards[i]->objs);
+
+    return ret;
+}
+
+
+static virDomainObj *
+virDomainObjListLookupUUID(virDomainObjList *doms,
+                           const char *uuidstr,
+                           const unsigned char *uuid)
+{
+    virDomainObjListShard *shard = virDomainObjListShardByUUID(doms, uuid);
+    virDomainObj *obj;
+
+    virRWLockRead(&shard->lock);
+    obj = virObjectRef(virHashLookup(shard->objs, uuidstr));
+    virRWLockUnlock(&shard->lock);
+
+    return obj;
+}
+
+
+static virDomainObj *
+virDomainObjListLookupName(virDomainObjList *doms,
+                           const char *name)
+{
+    virDomainObjListShard *shard = virDomainObjListShardByName(doms, name);
+    virDomainObj *obj;
+
+    virRWLockRead(&shard->lock);
+    obj = virObjectRef(virHashLookup(shard->objsName, name));
+    virRWLockUnlock(&shard->lock);
+
+    return obj;
 }
 
 
@@ -105,15 +247,75 @@ static int virDomainObjListSearchID(const void *payload,
 }
 
 
+static gboolean
+virDomainObjListRemoveID(gpointer key G_GNUC_UNUSED,
+                         gpointer value,
+                         gpointer opaque)
+{
+    return value == opaque;
+}
+
+
+/* Drops @dom from the ids tables, where it may be cached under any ID
+ * it had in the past */
+static void
+virDomainObjListRemoveIDs(virDomainObjList *doms,
+                          virDomainObj *dom)
+{
+    size_t i;
+
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++) {
+        virDomainObjListShard *shard = doms->shards[i];
+
+        virRWLockWrite(&shard->lock);
+        g_hash_table_foreach_remove(shard->ids, virDomainObjListRemoveID, dom);
+        virRWLockUnlock(&shard->lock);
+    }
+}
+
+
 virDomainObj *
 virDomainObjListFindByID(virDomainObjList *doms,
                          int id)
 {
+    virDomainObjListShard *shard = virDomainObjListShardByID(doms, id);
     virDomainObj *obj;
+    size_t i;
 
+    virRWLockRead(&shard->lock);
+    obj = virObjectRef(g_hash_table_lookup(shard->ids, GINT_TO_POINTER(id)));
+    virRWLockUnlock(&shard->lock);
+
+    if (obj) {
+        virObjectLock(obj);
+        if (!obj->removing &&
+            virDomainObjIsActive(obj) &&
+            obj->def->id == id)
+            return obj;
+        virObjectUnlock(obj);
+
+        /* Drop the stale entry, unless it was replaced meanwhile */
+        virRWLockWrite(&shard->lock);
+        if (g_hash_table_lookup(shard->ids, GINT_TO_POINTER(id)) == obj)
+            g_hash_table_remove(shard->ids, GINT_TO_POINTER(id));
+        virRWLockUnlock(&shard->lock);
+        g_clear_pointer(&obj, virObjectUnref);
+    }
+
+    /* Not found in the ID index or the entry is stale */
     virObjectRWLockRead(doms);
-    obj = virHashSearch(doms->objs, virDomainObjListSearchID, &id, NULL);
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS && !obj; i++)
+        obj = virHashSearch(doms->shards[i]->objs,
+                            virDomainObjListSearchID, &id, NULL);
     virObjectRef(obj);
+    if (obj) {
+        /* The domain had a different ID if it was started again */
+        virDomainObjListRemoveIDs(doms, obj);
+
+        virRWLockWrite(&shard->lock);
+        g_hash_table_insert(shard->ids, GINT_TO_POINTER(id), virObjectRef(obj));
+        virRWLockUnlock(&shard->lock);
+    }
     virObjectRWUnlock(doms);
     if (obj) {
         virObjectLock(obj);
@@ -133,20 +335,18 @@ virDomainObjListFindByUUIDLocked(virDomainObjList *doms,
     virDomainObj *obj;
 
     virUUIDFormat(uuid, uuidstr);
-    obj = virHashLookup(doms->objs, uuidstr);
-    if (obj) {
-        virObjectRef(obj);
+    obj = virDomainObjListLookupUUID(doms, uuidstr, uuid);
+    if (obj)
         virObjectLock(obj);
-    }
     return obj;
 }
 
 
 /**
  * @doms: Domain object list
- * @uuid: UUID to search the doms->objs table
+ * @uuid: UUID to search the UUID index
  *
- * Lookup the @uuid in the doms->objs hash table and return a
+ * Lookup the @uuid in the UUID index and return a
  * locked and ref counted domain object if found. Caller is
  * expected to use the virDomainObjEndAPI when done with the object.
  */
@@ -156,9 +356,7 @@ virDomainObjListFindByUUID(virDomainObjList *doms,
 {
     virDomainObj *obj;
 
-    virObjectRWLockRead(doms);
     obj = virDomainObjListFindByUUIDLocked(doms, uuid);
-    virObjectRWUnlock(doms);
 
     if (obj && obj->removing)
         virDomainObjEndAPI(&obj);
@@ -173,20 +371,18 @@ virDomainObjListFindByNameLocked(virDomainObjList *doms,
 {
     virDomainObj *obj;
 
-    obj = virHashLookup(doms->objsName, name);
-    if (obj) {
-        virObjectRef(obj);
+    obj = virDomainObjListLookupName(doms, name);
+    if (obj)
         virObjectLock(obj);
-    }
     return obj;
 }
 
 
 /**
  * @doms: Domain object list
- * @name: Name to search the doms->objsName table
+ * @name: Name to search the name index
  *
- * Lookup the @name in the doms->objsName hash table and return a
+ * Lookup the @name in the name index and return a
  * locked and ref counted domain object if found. Caller is expected
  * to use the virDomainObjEndAPI when done with the object.
  */
@@ -196,9 +392,7 @@ virDomainObjListFindByName(virDomainObjList *doms,
 {
     virDomainObj *obj;
 
-    virObjectRWLockRead(doms);
     obj = virDomainObjListFindByNameLocked(doms, name);
-    virObjectRWUnlock(doms);
 
     if (obj && obj->removing)
         virDomainObjEndAPI(&obj);
@@ -213,8 +407,8 @@ virDomainObjListFindByName(virDomainObjList *doms,
  *
  * Upon entry @vm should have at least 1 ref and be locked.
  *
- * Add the @vm into the @doms->objs and @doms->objsName hash
- * tables. Once successfully added into a table, increase the
+ * Add the @vm into the UUID and name indexes of @doms.
+ * Once successfully added into a table, increase the
  * reference count since upon removal in virHashRemoveEntry
  * the virObjectUnref will be called since the hash tables were
  * configured to call virObjectUnref when the object is
@@ -227,15 +421,27 @@ static int
 virDomainObjListAddObjLocked(virDomainObjList *doms,
                              virDomainObj *vm)
 {
+    virDomainObjListShard *uuidShard = virDomainObjListShardByUUID(doms, vm->def->uuid);
+    virDomainObjListShard *nameShard = virDomainObjListShardByName(doms, vm->def->name);
     char uuidstr[VIR_UUID_STRING_BUFLEN];
+    int rc;
 
     virUUIDFormat(vm->def->uuid, uuidstr);
-    if (virHashAddEntry(doms->objs, uuidstr, vm) < 0)
+
+    virRWLockWrite(&uuidShard->lock);
+    rc = virHashAddEntry(uuidShard->objs, uuidstr, vm);
+    virRWLockUnlock(&uuidShard->lock);
+    if (rc < 0)
         return -1;
     virObjectRef(vm);
 
-    if (virHashAddEntry(doms->objsName, vm->def->name, vm) < 0) {
-        virHashRemoveEntry(doms->objs, uuidstr);
+    virRWLockWrite(&nameShard->lock);
+    rc = virHashAddEntry(nameShard->objsName, vm->def->name, vm);
+    virRWLockUnlock(&nameShard->lock);
+    if (rc < 0) {
+        virRWLockWrite(&uuidShard->lock);
+        virHashRemoveEntry(uuidShard->objs, uuidstr);
+        virRWLockUnlock(&uuidShard->lock);
         return -1;
     }
     virObjectRef(vm);
@@ -366,20 +572,29 @@ void
 virDomainObjListRemoveLocked(virDomainObjList *doms,
                              virDomainObj *dom)
 {
+    virDomainObjListShard *uuidShard = virDomainObjListShardByUUID(doms, dom->def->uuid);
+    virDomainObjListShard *nameShard = virDomainObjListShardByName(doms, dom->def->name);
     char uuidstr[VIR_UUID_STRING_BUFLEN];
 
     virUUIDFormat(dom->def->uuid, uuidstr);
 
-    virHashRemoveEntry(doms->objs, uuidstr);
-    virHashRemoveEntry(doms->objsName, dom->def->name);
+    virRWLockWrite(&uuidShard->lock);
+    virHashRemoveEntry(uuidShard->objs, uuidstr);
+    virRWLockUnlock(&uuidShard->lock);
+
+    virRWLockWrite(&nameShard->lock);
+    virHashRemoveEntry(nameShard->objsName, dom->def->name);
+    virRWLockUnlock(&nameShard->lock);
+
+    virDomainObjListRemoveIDs(doms, dom);
 }
 
 
 /**
  * @doms: Pointer to the domain object list
  * @dom: Domain pointer from either after Add or FindBy* API where the
- *       @dom was successfully added to both the doms->objs and ->objsName
- *       hash tables that now would need to be removed.
+ *       @dom was successfully added to both the UUID and name indexes
+ *       that now would need to be removed.
  *
  * The caller must hold a lock on the driver owning 'doms',
  * and must also have locked and ref counted 'dom', to ensure
@@ -422,6 +637,8 @@ virDomainObjListRename(virDomainObjList *doms,
 {
     int ret = -1;
     g_autofree char *old_name = NULL;
+    virDomainObjListShard *newShard;
+    virDomainObjListShard *oldShard;
     int rc;
 
     if (STREQ(dom->def->name, new_name)) {
@@ -441,14 +658,20 @@ virDomainObjListRename(virDomainObjList *doms,
     virObjectLock(dom);
     virObjectUnref(dom);
 
-    if (virHashLookup(doms->objsName, new_name) != NULL) {
+    newShard = virDomainObjListShardByName(doms, new_name);
+    oldShard = virDomainObjListShardByName(doms, old_name);
+
+    if (virHashLookup(newShard->objsName, new_name) != NULL) {
         virReportError(VIR_ERR_OPERATION_INVALID,
                        _("domain with name '%s' already exists"),
                        new_name);
         goto cleanup;
     }
 
-    if (virHashAddEntry(doms->objsName, new_name, dom) < 0)
+    virRWLockWrite(&newShard->lock);
+    rc = virHashAddEntry(newShard->objsName, new_name, dom);
+    virRWLockUnlock(&newShard->lock);
+    if (rc < 0)
         goto cleanup;
 
     /* Increment the refcnt for @new_name. We're about to remove
@@ -459,9 +682,16 @@ virDomainObjListRename(virDomainObjList *doms,
     virObjectRef(dom);
 
     rc = callback(dom, new_name, flags, opaque);
-    virHashRemoveEntry(doms->objsName, rc < 0 ? new_name : old_name);
-    if (rc < 0)
+    if (rc < 0) {
+        virRWLockWrite(&newShard->lock);
+        virHashRemoveEntry(newShard->objsName, new_name);
+        virRWLockUnlock(&newShard->lock);
         goto cleanup;
+    }
+
+    virRWLockWrite(&oldShard->lock);
+    virHashRemoveEntry(oldShard->objsName, old_name);
+    virRWLockUnlock(&oldShard->lock);
 
     ret = 0;
  cleanup:
@@ -537,7 +767,8 @@ virDomainObjListLoadStatus(virDomainObjList *doms,
 
     virUUIDFormat(obj->def->uuid, uuidstr);
 
-    if (virHashLookup(doms->objs, uuidstr) != NULL) {
+    if (virHashLookup(virDomainObjListShardByUUID(doms, obj->def->uuid)->objs,
+                      uuidstr) != NULL) {
         virReportError(VIR_ERR_INTERNAL_ERROR,
                        _("unexpected domain %s already exists"),
                        obj->def->name);
@@ -657,7 +888,7 @@ virDomainObjListNumOfDomains(virDomainObjList *doms,
 {
     struct virDomainObjListData data = { filter, conn, active, 0 };
     virObjectRWLockRead(doms);
-    virHashForEach(doms->objs, virDomainObjListCount, &data);
+    virDomainObjListForEachShard(doms, virDomainObjListCount, &data);
     virObjectRWUnlock(doms);
     return data.count;
 }
@@ -701,7 +932,7 @@ virDomainObjListGetActiveIDs(virDomainObjList *doms,
     struct virDomainIDData data = { filter, conn,
                                     0, maxids, ids };
     virObjectRWLockRead(doms);
-    virHashForEach(doms->objs, virDomainObjListCopyActiveIDs, &data);
+    virDomainObjListForEachShard(doms, virDomainObjListCopyActiveIDs, &data);
     virObjectRWUnlock(doms);
     return data.numids;
 }
@@ -754,7 +985,7 @@ virDomainObjListGetInactiveNames(virDomainObjList *doms,
                                       0, 0, maxnames, names };
     size_t i;
     virObjectRWLockRead(doms);
-    virHashForEach(doms->objs, virDomainObjListCopyInactiveNames, &data);
+    virDomainObjListForEachShard(doms, virDomainObjListCopyInactiveNames, &data);
     virObjectRWUnlock(doms);
     if (data.oom) {
         for (i = 0; i < data.numnames; i++)
@@ -811,12 +1042,14 @@ virDomainObjListForEach(virDomainObjList *doms,
     struct virDomainListIterData data = {
         callback, opaque, 0,
     };
+    size_t i;
 
     if (modify)
         virObjectRWLockWrite(doms);
     else
         virObjectRWLockRead(doms);
-    virHashForEachSafe(doms->objs, virDomainObjListHelper, &data);
+    for (i = 0; i < VIR_DOMAIN_OBJ_LIST_SHARDS; i++)
+        virHashForEachSafe(doms->shards[i]->objs, virDomainObjListHelper, &data);
     virObjectRWUnlock(doms);
     return data.ret;
 }
@@ -957,9 +1190,9 @@ virDomainObjListCollect(virDomainObjList *domlist,
     struct virDomainListData data = { NULL, 0 };
 
     virObjectRWLockRead(domlist);
-    data.vms = g_new0(virDomainObj *, virHashSize(domlist->objs));
+    data.vms = g_new0(virDomainObj *, virDomainObjListSize(domlist));
 
-    virHashForEach(domlist->objs, virDomainObjListCollectIterator, &data);
+    virDomainObjListForEachShard(domlist, virDomainObjListCollectIterator, &data);
     virObjectRWUnlock(domlist);
 
     virDomainObjListFilter(&data.vms, &data.nvms, conn, filter, flags);
@@ -995,7 +1228,8 @@ virDomainObjListConvert(virDomainObjList *domlist,
 
         virUUIDFormat(dom->uuid, uuidstr);
 
-        if (!(vm = virHashLookup(domlist->objs, uuidstr))) {
+        if (!(vm = virHashLookup(virDomainObjListShardByUUID(domlist, dom->uuid)->objs,
+                                 uuidstr))) {
             if (skip_missing)
                 continue;
 
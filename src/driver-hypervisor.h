@@ -1285,6 +1285,14 @@ typedef int
                                   virDomainStatsRecordPtr **retStats,
                                   unsigned int flags);
 
+typedef int
+(*virDrvDomainListGetInfo)(virConnectPtr conn,
+                           virDomainPtr *doms,
+                           unsigned int ndoms,
+                           unsigned int fields,
+                           virDomainStatsRecordPtr **retInfo,
+                           unsigned int flags);
+
 typedef int
 (*virDrvNodeAllocPages)(virConnectPtr conn,
                         unsigned int npages,
@@ -1680,6 +1688,7 @@ struct _virHypervisorDriver {
     virDrvNodeGetFreePages nodeGetFreePages;
     virDrvConnectGetDomainCapabilities connectGetDomainCapabilities;
     virDrvConnectGetAllDomainStats connectGetAllDomainStats;
+    virDrvDomainListGetInfo domainListGetInfo;
     virDrvNodeAllocPages nodeAllocPages;
     virDrvDomainGetFSInfo domainGetFSInfo;
     virDrvDomainInterfaceAddresses domainInterfaceAddresses;
@@ -51,6 +51,9 @@ typedef int
 typedef int
 (*virDrvStateShutdownWait)(void);
 
+typedef int
+(*virDrvStateGetStats)(virTypedParamList *params);
+
 typedef struct _virStateDriver virStateDriver;
 struct _virStateDriver {
     const char *name;
@@ -61,4 +64,5 @@ struct _virStateDriver {
     virDrvStateStop stateStop;
     virDrvStateShutdownPrepare stateShutdownPrepare;
     virDrvStateShutdownWait stateShutdownWait;
+    virDrvStateGetStats stateGetStats;
 };
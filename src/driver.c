@@ -350,6 +350,11 @@ virDriverFeatureIsGlobal(virDrvFeature feat,
      * for them. */
     case VIR_DRV_FEATURE_REMOTE_CLOSE_CALLBACK:
     case VIR_DRV_FEATURE_REMOTE_EVENT_CALLBACK:
+    /* Stream payload size and compression negotiation only make sense
+     * over RPC */
+    case VIR_DRV_FEATURE_REMOTE_STREAM_LARGE_PAYLOAD:
+    case VIR_DRV_FEATURE_REMOTE_COMPRESSION:
+    case VIR_DRV_FEATURE_REMOTE_EVENT_BATCH:
         *supported = 0;
         return true;
 
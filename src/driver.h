@@ -26,6 +26,7 @@
 #include "internal.h"
 #include "libvirt_internal.h"
 #include "viruri.h"
+#include "virtypedparam.h"
 
 
 /* Status codes returned from driver open call. */
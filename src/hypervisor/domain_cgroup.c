@@ -537,19 +537,18 @@ virDomainCgroupSetupCgroup(const char *prefix,
     if (!*cgroup)
         return 0;
 
-    if (virDomainCgroupSetupBlkioCgroup(vm, *cgroup) < 0)
+    if (virCgroupBeginChanges(*cgroup) < 0)
         return -1;
 
-    if (virDomainCgroupSetupMemoryCgroup(vm, *cgroup) < 0)
-        return -1;
-
-    if (virDomainCgroupSetupCpuCgroup(vm, *cgroup) < 0)
-        return -1;
-
-    if (virDomainCgroupSetupCpusetCgroup(*cgroup) < 0)
+    if (virDomainCgroupSetupBlkioCgroup(vm, *cgroup) < 0 ||
+        virDomainCgroupSetupMemoryCgroup(vm, *cgroup) < 0 ||
+        virDomainCgroupSetupCpuCgroup(vm, *cgroup) < 0 ||
+        virDomainCgroupSetupCpusetCgroup(*cgroup) < 0) {
+        virCgroupAbortChanges(*cgroup);
         return -1;
+    }
 
-    return 0;
+    return virCgroupCommitChanges(*cgroup);
 }
 
 
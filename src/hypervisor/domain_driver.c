@@ -29,6 +29,7 @@
 #include "viraccessapicheck.h"
 #include "datatypes.h"
 #include "driver.h"
+#include "virtypedparam.h"
 
 #define VIR_FROM_THIS VIR_FROM_DOMAIN
 
@@ -641,3 +642,64 @@ virDomainDriverGetIOThreadsConfig(virDomainDef *targetDef,
 
     return ret;
 }
+
+
+/**
+ * virDomainDriverListInfoRecord:
+ * @conn: connection the record is for
+ * @vm: locked domain object
+ * @fields: binary-OR of virDomainListInfoFields
+ * @info: basic domain info, used with VIR_DOMAIN_LIST_INFO_BASIC
+ * @xml: domain XML, used with VIR_DOMAIN_LIST_INFO_XML
+ * @record: filled with the new record
+ *
+ * Builds a record returned by virDomainListGetInfo from data the driver
+ * gathered for @vm. The domain state is taken from @vm directly.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virDomainDriverListInfoRecord(virConnectPtr conn,
+                              virDomainObj *vm,
+                              unsigned int fields,
+                              virDomainInfoPtr info,
+                              const char *xml,
+                              virDomainStatsRecordPtr *record)
+{
+    g_autofree virDomainStatsRecordPtr tmp = NULL;
+    g_autoptr(virTypedParamList) params = g_new0(virTypedParamList, 1);
+
+    if (fields & VIR_DOMAIN_LIST_INFO_BASIC) {
+        if (virTypedParamListAddInt(params, info->state, "info.state") < 0 ||
+            virTypedParamListAddULLong(params, info->maxMem, "info.max_mem") < 0 ||
+            virTypedParamListAddULLong(params, info->memory, "info.memory") < 0 ||
+            virTypedParamListAddUInt(params, info->nrVirtCpu, "info.nr_virt_cpu") < 0 ||
+            virTypedParamListAddULLong(params, info->cpuTime, "info.cpu_time") < 0)
+            return -1;
+    }
+
+    if (fields & VIR_DOMAIN_LIST_INFO_STATE) {
+        int state;
+        int reason;
+
+        state = virDomainObjGetState(vm, &reason);
+
+        if (virTypedParamListAddInt(params, state, "state.state") < 0 ||
+            virTypedParamListAddInt(params, reason, "state.reason") < 0)
+            return -1;
+    }
+
+    if (fields & VIR_DOMAIN_LIST_INFO_XML &&
+        virTypedParamListAddString(params, xml, "xml") < 0)
+        return -1;
+
+    tmp = g_new0(virDomainStatsRecord, 1);
+
+    if (!(tmp->dom = virGetDomain(conn, vm->def->name,
+                                  vm->def->uuid, vm->def->id)))
+        return -1;
+
+    tmp->nparams = virTypedParamListStealParams(params, &tmp->params);
+    *record = g_steal_pointer(&tmp);
+    return 0;
+}
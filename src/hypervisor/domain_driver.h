@@ -69,3 +69,15 @@ int virDomainDriverDelIOThreadCheck(virDomainDef *def,
 int virDomainDriverGetIOThreadsConfig(virDomainDef *targetDef,
                                       virDomainIOThreadInfoPtr **info,
                                       unsigned int bitmap_size);
+
+#define VIR_DOMAIN_DRIVER_LIST_INFO_ALL \
+    (VIR_DOMAIN_LIST_INFO_BASIC | \
+     VIR_DOMAIN_LIST_INFO_STATE | \
+     VIR_DOMAIN_LIST_INFO_XML)
+
+int virDomainDriverListInfoRecord(virConnectPtr conn,
+                                  virDomainObj *vm,
+                                  unsigned int fields,
+                                  virDomainInfoPtr info,
+                                  const char *xml,
+                                  virDomainStatsRecordPtr *record);
@@ -12481,6 +12481,19 @@ virConnectGetDomainCapabilities(virConnectPtr conn,
  *                                                   rate for a virtual cpu as
  *                                                   unsigned long long.
  *
+ * VIR_DOMAIN_STATS_VCPU_HYPERVISOR:
+ *     Return hypervisor specific statistics of virtual CPUs. The typed
+ *     parameter keys are in this format:
+ *
+ *     "vcpu.<num>.<provider>.<name>" - statistic <name> of the virtual CPU
+ *                                      <num> as reported by <provider>, as
+ *                                      unsigned long long or boolean.
+ *
+ *     For the QEMU driver the only provider is "kvm", whose statistics are
+ *     fetched with the 'query-stats' QMP command, e.g.
+ *     "vcpu.<num>.kvm.halt_poll_success_ns". Their set depends on the host
+ *     kernel.
+ *
  * Note that entire stats groups or individual stat fields may be missing from
  * the output in case they are not supported by the given hypervisor, are not
  * applicable for the current state of the guest domain, or their retrieval
@@ -12666,12 +12679,135 @@ virDomainListGetStats(virDomainPtr *doms,
 }
 
 
+/**
+ * virDomainListGetInfo:
+ * @doms: NULL terminated array of domains
+ * @fields: information to return, binary-OR of virDomainListInfoFields
+ * @retInfo: Pointer that will be filled with the array of returned records
+ * @flags: bitwise-OR of virDomainXMLFlags, used with VIR_DOMAIN_LIST_INFO_XML
+ *
+ * Query basic information about all domains provided by @doms at once.
+ * Note that all domains in @doms must share the same connection. This
+ * returns the same data as calling virDomainGetInfo, virDomainGetState
+ * and virDomainGetXMLDesc for every domain, but with a single call into
+ * the driver, which for remote connections means far fewer round trips.
+ *
+ * The information is returned as an array of virDomainStatsRecord
+ * structures, one for each domain, holding an array of typed parameters.
+ * Which parameters are present is controlled by @fields:
+ *
+ * VIR_DOMAIN_LIST_INFO_BASIC:
+ *     "info.state" - state of the domain as int, one of virDomainState
+ *     "info.max_mem" - maximum memory in KiB as unsigned long long
+ *     "info.memory" - memory used by the domain in KiB as unsigned long long
+ *     "info.nr_virt_cpu" - number of virtual CPUs as unsigned int
+ *     "info.cpu_time" - CPU time used in nanoseconds as unsigned long long
+ *
+ * VIR_DOMAIN_LIST_INFO_STATE:
+ *     "state.state" - state of the domain as int, one of virDomainState
+ *     "state.reason" - reason for entering the state as int, one of the
+ *                      virDomain*Reason enums corresponding to the state
+ *
+ * VIR_DOMAIN_LIST_INFO_XML:
+ *     "xml" - XML description of the domain as string, formatted
+ *             according to @flags as with virDomainGetXMLDesc
+ *
+ * Using 0 for @fields returns all of the above. Unknown bits in @fields
+ * are rejected with VIR_ERR_INVALID_ARG.
+ *
+ * Domains which disappear before they are queried are silently left out,
+ * so the count of returned records may be less than the count of domains
+ * in @doms.
+ *
+ * Returns the count of returned records on success, -1 on error. The
+ * requested data are returned in the @retInfo parameter. The returned
+ * array should be freed by the caller. See virDomainStatsRecordListFree.
+ *
+ * Since: 8.6.0
+ */
+int
+virDomainListGetInfo(virDomainPtr *doms,
+                     unsigned int fields,
+                     virDomainStatsRecordPtr **retInfo,
+                     unsigned int flags)
+{
+    virConnectPtr conn = NULL;
+    virDomainPtr *nextdom = doms;
+    unsigned int ndoms = 0;
+    int ret = -1;
+
+    VIR_DEBUG("doms=%p, fields=0x%x, retInfo=%p, flags=0x%x",
+              doms, fields, retInfo, flags);
+
+    virResetLastError();
+
+    virCheckNonNullArgGoto(doms, cleanup);
+    virCheckNonNullArgGoto(retInfo, cleanup);
+
+    if (fields & ~(VIR_DOMAIN_LIST_INFO_BASIC |
+                   VIR_DOMAIN_LIST_INFO_STATE |
+                   VIR_DOMAIN_LIST_INFO_XML)) {
+        virReportError(VIR_ERR_INVALID_ARG,
+                       _("unsupported fields (0x%x) in function %s"),
+                       fields, __FUNCTION__);
+        goto cleanup;
+    }
+
+    if (!*doms) {
+        virReportError(VIR_ERR_INVALID_ARG,
+                       _("doms array in %s must contain at least one domain"),
+                       __FUNCTION__);
+        goto cleanup;
+    }
+
+    conn = doms[0]->conn;
+    virCheckConnectReturn(conn, -1);
+
+    if ((conn->flags & VIR_CONNECT_RO) &&
+        (flags & (VIR_DOMAIN_XML_SECURE | VIR_DOMAIN_XML_MIGRATABLE))) {
+        virReportError(VIR_ERR_OPERATION_DENIED, "%s",
+                       _("virDomainListGetInfo with secure flag"));
+        goto cleanup;
+    }
+
+    if (!conn->driver->domainListGetInfo) {
+        virReportUnsupportedError();
+        goto cleanup;
+    }
+
+    while (*nextdom) {
+        virDomainPtr dom = *nextdom;
+
+        virCheckDomainGoto(dom, cleanup);
+
+        if (dom->conn != conn) {
+            virReportError(VIR_ERR_INVALID_ARG, "%s",
+                           _("domains in 'doms' array must belong to a "
+                             "single connection"));
+            goto cleanup;
+        }
+
+        ndoms++;
+        nextdom++;
+    }
+
+    ret = conn->driver->domainListGetInfo(conn, doms, ndoms,
+                                          fields, retInfo, flags);
+
+ cleanup:
+    if (ret < 0)
+        virDispatchError(conn);
+    return ret;
+}
+
+
 /**
  * virDomainStatsRecordListFree:
  * @stats: NULL terminated array of virDomainStatsRecords to free
  *
  * Convenience function to free a list of domain stats returned by
- * virDomainListGetStats and virConnectGetAllDomainStats.
+ * virDomainListGetStats, virConnectGetAllDomainStats and
+ * virDomainListGetInfo.
  *
  * Since: 1.2.8
  */
@@ -1613,7 +1613,7 @@ virNodeGetCPUMap(virConnectPtr conn,
  * @cellCount: maximum number of cells for which free pages
  *             information can be returned.
  * @counts: returned counts of free pages
- * @flags: extra flags; not used yet, so callers should always pass 0
+ * @flags: bitwise-OR of virNodeGetFreePagesFlags
  *
  * This calls queries the host system on free pages of
  * specified size. For the input, @pages is expected to be
@@ -1660,6 +1660,12 @@ virNodeGetCPUMap(virConnectPtr conn,
  *    Page size=2097152 count=20 bytes=41943040
  *    Page size=1073741824 count=0 bytes=0
  *
+ * Huge pages backing the memory of a running domain are free until
+ * the domain touches them. If @flags contains
+ * VIR_NODE_FREE_PAGES_UNRESERVED, drivers which account for the huge
+ * pages of their domains don't count such pages as free, so that
+ * @counts tells how many pages are left for new domains.
+ *
  * Returns: the number of entries filled in @counts or -1 in case of error.
  *
  * Since: 1.2.6
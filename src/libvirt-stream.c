@@ -29,9 +29,45 @@ VIR_LOG_INIT("libvirt.stream");
 #define VIR_FROM_THIS VIR_FROM_STREAMS
 
 /* To avoid dragging in RPC code (which may be not compiled in),
- * redefine this constant. Its value can't ever change, so we're
- * safe to do so. */
+ * redefine these constants. Their values can't ever change, so
+ * we're safe to do so. */
 #define VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX 262120
+#define VIR_NET_MESSAGE_STREAM_PAYLOAD_MAX 4194304
+
+
+/*
+ * Returns the largest chunk of data the *All helpers may move through
+ * @stream at once, or 0 on error.
+ */
+static size_t
+virStreamGetChunkMax(virStreamPtr stream)
+{
+    int rc = VIR_DRV_SUPPORTS_FEATURE(stream->conn->driver, stream->conn,
+                                      VIR_DRV_FEATURE_REMOTE_STREAM_LARGE_PAYLOAD);
+
+    if (rc < 0)
+        return 0;
+
+    if (rc)
+        return VIR_NET_MESSAGE_STREAM_PAYLOAD_MAX;
+
+    return VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX;
+}
+
+
+/*
+ * Doubles @chunk, up to @chunkMax, whenever a full chunk was
+ * transferred, so that bulk transfers quickly settle on the
+ * largest packets the connection allows.
+ */
+static void
+virStreamGrowChunk(size_t *chunk,
+                   size_t chunkMax,
+                   int got)
+{
+    if (got > 0 && (size_t) got == *chunk)
+        *chunk = MIN(*chunk * 2, chunkMax);
+}
 
 
 /**
@@ -601,6 +637,7 @@ virStreamSendAll(virStreamPtr stream,
 {
     g_autofree char *bytes = NULL;
     size_t want = VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX;
+    size_t wantMax;
     int ret = -1;
     VIR_DEBUG("stream=%p, handler=%p, opaque=%p", stream, handler, opaque);
 
@@ -615,7 +652,10 @@ virStreamSendAll(virStreamPtr stream,
         goto cleanup;
     }
 
-    bytes = g_new0(char, want);
+    if ((wantMax = virStreamGetChunkMax(stream)) == 0)
+        goto cleanup;
+
+    bytes = g_new0(char, wantMax);
 
     errno = 0;
     for (;;) {
@@ -630,6 +670,7 @@ virStreamSendAll(virStreamPtr stream,
         }
         if (got == 0)
             break;
+        virStreamGrowChunk(&want, wantMax, got);
         while (offset < got) {
             int done;
             done = virStreamSend(stream, bytes + offset, got - offset);
@@ -733,6 +774,7 @@ int virStreamSparseSendAll(virStreamPtr stream,
 {
     g_autofree char *bytes = NULL;
     size_t bufLen = VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX;
+    size_t bufLenMax;
     int ret = -1;
     unsigned long long dataLen = 0;
 
@@ -752,7 +794,10 @@ int virStreamSparseSendAll(virStreamPtr stream,
         goto cleanup;
     }
 
-    bytes = g_new0(char, bufLen);
+    if ((bufLenMax = virStreamGetChunkMax(stream)) == 0)
+        goto cleanup;
+
+    bytes = g_new0(char, bufLenMax);
 
     errno = 0;
     for (;;) {
@@ -799,6 +844,7 @@ int virStreamSparseSendAll(virStreamPtr stream,
         }
         if (got == 0)
             break;
+        virStreamGrowChunk(&bufLen, bufLenMax, got);
         while (offset < got) {
             int done;
             done = virStreamSend(stream, bytes + offset, got - offset);
@@ -873,6 +919,7 @@ virStreamRecvAll(virStreamPtr stream,
 {
     g_autofree char *bytes = NULL;
     size_t want = VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX;
+    size_t wantMax;
     int ret = -1;
     VIR_DEBUG("stream=%p, handler=%p, opaque=%p", stream, handler, opaque);
 
@@ -887,8 +934,10 @@ virStreamRecvAll(virStreamPtr stream,
         goto cleanup;
     }
 
+    if ((wantMax = virStreamGetChunkMax(stream)) == 0)
+        goto cleanup;
 
-    bytes = g_new0(char, want);
+    bytes = g_new0(char, wantMax);
 
     errno = 0;
     for (;;) {
@@ -899,6 +948,7 @@ virStreamRecvAll(virStreamPtr stream,
             goto cleanup;
         if (got == 0)
             break;
+        virStreamGrowChunk(&want, wantMax, got);
         while (offset < got) {
             int done;
             done = (handler)(stream, bytes + offset, got - offset, opaque);
@@ -989,6 +1039,7 @@ virStreamSparseRecvAll(virStreamPtr stream,
 {
     g_autofree char *bytes = NULL;
     size_t want = VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX;
+    size_t wantMax;
     const unsigned int flags = VIR_STREAM_RECV_STOP_AT_HOLE;
     int ret = -1;
 
@@ -1007,7 +1058,10 @@ virStreamSparseRecvAll(virStreamPtr stream,
         goto cleanup;
     }
 
-    bytes = g_new0(char, want);
+    if ((wantMax = virStreamGetChunkMax(stream)) == 0)
+        goto cleanup;
+
+    bytes = g_new0(char, wantMax);
 
     errno = 0;
     for (;;) {
@@ -1032,6 +1086,7 @@ virStreamSparseRecvAll(virStreamPtr stream,
         } else if (got == 0) {
             break;
         }
+        virStreamGrowChunk(&want, wantMax, got);
         while (offset < got) {
             int done;
             done = (handler)(stream, bytes + offset, got - offset, opaque);
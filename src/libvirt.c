@@ -778,6 +778,35 @@ virStateStop(void)
 }
 
 
+/**
+ * virStateGetStats:
+ * @params: pointer to a list of typed parameters to be allocated
+ * @nparams: pointer to the number of parameters returned in @params
+ *
+ * Collect the statistics of each virtualization driver which reports
+ * them. The names of the parameters are prefixed with the name of the
+ * driver.
+ *
+ * Returns 0 on success, -1 upon any failure.
+ */
+int
+virStateGetStats(virTypedParameterPtr *params,
+                 int *nparams)
+{
+    g_autoptr(virTypedParamList) list = g_new0(virTypedParamList, 1);
+    size_t i;
+
+    for (i = 0; i < virStateDriverTabCount; i++) {
+        if (virStateDriverTab[i]->stateGetStats &&
+            virStateDriverTab[i]->stateGetStats(list) < 0)
+            return -1;
+    }
+
+    *nparams = virTypedParamListStealParams(list, params);
+    return 0;
+}
+
+
 /**
  * virGetVersion:
  * @libVer: return value for the library version (OUT)
@@ -39,6 +39,8 @@ int virStateShutdownWait(void);
 int virStateCleanup(void);
 int virStateReload(void);
 int virStateStop(void);
+int virStateGetStats(virTypedParameterPtr *params,
+                     int *nparams);
 
 /* Feature detection.  This is a libvirt-private interface for determining
  * what features are supported by the driver.
@@ -131,6 +133,22 @@ typedef enum {
      * Whether the virNetworkUpdate() API implementation passes arguments to
      * the driver's callback in correct order. */
     VIR_DRV_FEATURE_NETWORK_UPDATE_HAS_CORRECT_ORDER = 16,
+
+    /*
+     * Remote party accepts stream data packets with a payload larger
+     * than VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX
+     */
+    VIR_DRV_FEATURE_REMOTE_STREAM_LARGE_PAYLOAD = 17,
+
+    /*
+     * Remote party accepts compressed calls, replies and events
+     */
+    VIR_DRV_FEATURE_REMOTE_COMPRESSION = 18,
+
+    /*
+     * Remote party can batch domain events and coalesce superseded ones
+     */
+    VIR_DRV_FEATURE_REMOTE_EVENT_BATCH = 19,
 } virDrvFeature;
 
 
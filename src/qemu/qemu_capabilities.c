@@ -672,6 +672,7 @@ VIR_ENUM_IMPL(virQEMUCaps,
               "display-dbus", /* QEMU_CAPS_DISPLAY_DBUS */
               "iothread.thread-pool-max", /* QEMU_CAPS_IOTHREAD_THREAD_POOL_MAX */
               "usb-host.guest-resets-all", /* QEMU_CAPS_USB_HOST_GUESTS_RESETS_ALL */
+              "query-stats", /* QEMU_CAPS_QUERY_STATS */
     );
 
 
@@ -715,8 +716,8 @@ struct _virQEMUCapsAccel {
 
 
 /*
- * Update the XML parser/formatter when adding more
- * information to this struct so that it gets cached
+ * Update the XML and binary parser/formatter when adding
+ * more information to this struct so that it gets cached
  * correctly. It does not have to be ABI-stable, as
  * the cache will be discarded & repopulated if the
  * timestamp on the libvirtd binary changes.
@@ -1226,6 +1227,7 @@ struct virQEMUCapsStringFlags virQEMUCapsCommands[] = {
     { "query-dirty-rate", QEMU_CAPS_QUERY_DIRTY_RATE },
     { "sev-inject-launch-secret", QEMU_CAPS_SEV_INJECT_LAUNCH_SECRET },
     { "calc-dirty-rate", QEMU_CAPS_CALC_DIRTY_RATE },
+    { "query-stats", QEMU_CAPS_QUERY_STATS },
 };
 
 struct virQEMUCapsStringFlags virQEMUCapsMigration[] = {
@@ -4375,6 +4377,36 @@ virQEMUCapsValidateArch(virQEMUCaps *qemuCaps, xmlXPathContextPtr ctxt)
 }
 
 
+static bool
+virQEMUCapsCacheLibvirtChanged(virQEMUCaps *qemuCaps)
+{
+    if (qemuCaps->libvirtCtime == virGetSelfLastChanged() &&
+        qemuCaps->libvirtVersion == LIBVIR_VERSION_NUMBER)
+        return false;
+
+    VIR_DEBUG("Outdated capabilities in %s: libvirt changed "
+              "(%lld vs %lld, %lu vs %lu), stopping load",
+              qemuCaps->binary,
+              (long long)qemuCaps->libvirtCtime,
+              (long long)virGetSelfLastChanged(),
+              (unsigned long)qemuCaps->libvirtVersion,
+              (unsigned long)LIBVIR_VERSION_NUMBER);
+    return true;
+}
+
+
+static void
+virQEMUCapsInitHostCPUModels(virQEMUCaps *qemuCaps,
+                             virArch hostArch)
+{
+    if (virQEMUCapsGet(qemuCaps, QEMU_CAPS_KVM))
+        virQEMUCapsInitHostCPUModel(qemuCaps, hostArch, VIR_DOMAIN_VIRT_KVM);
+    if (virQEMUCapsGet(qemuCaps, QEMU_CAPS_HVF))
+        virQEMUCapsInitHostCPUModel(qemuCaps, hostArch, VIR_DOMAIN_VIRT_HVF);
+    virQEMUCapsInitHostCPUModel(qemuCaps, hostArch, VIR_DOMAIN_VIRT_QEMU);
+}
+
+
 /*
  * Parsing a doc that looks like
  *
@@ -4433,18 +4465,8 @@ virQEMUCapsLoadCache(virArch hostArch,
     if (virXPathULong("string(./selfvers)", ctxt, &lu) == 0)
         qemuCaps->libvirtVersion = lu;
 
-    if (!skipInvalidation &&
-        (qemuCaps->libvirtCtime != virGetSelfLastChanged() ||
-         qemuCaps->libvirtVersion != LIBVIR_VERSION_NUMBER)) {
-        VIR_DEBUG("Outdated capabilities in %s: libvirt changed "
-                  "(%lld vs %lld, %lu vs %lu), stopping load",
-                  qemuCaps->binary,
-                  (long long)qemuCaps->libvirtCtime,
-                  (long long)virGetSelfLastChanged(),
-                  (unsigned long)qemuCaps->libvirtVersion,
-                  (unsigned long)LIBVIR_VERSION_NUMBER);
+    if (!skipInvalidation && virQEMUCapsCacheLibvirtChanged(qemuCaps))
         return 1;
-    }
 
     if (virQEMUCapsValidateEmulator(qemuCaps, ctxt) < 0)
         return -1;
@@ -4521,11 +4543,7 @@ virQEMUCapsLoadCache(virArch hostArch,
     if (virQEMUCapsParseSEVInfo(qemuCaps, ctxt) < 0)
         return -1;
 
-    if (virQEMUCapsGet(qemuCaps, QEMU_CAPS_KVM))
-        virQEMUCapsInitHostCPUModel(qemuCaps, hostArch, VIR_DOMAIN_VIRT_KVM);
-    if (virQEMUCapsGet(qemuCaps, QEMU_CAPS_HVF))
-        virQEMUCapsInitHostCPUModel(qemuCaps, hostArch, VIR_DOMAIN_VIRT_HVF);
-    virQEMUCapsInitHostCPUModel(qemuCaps, hostArch, VIR_DOMAIN_VIRT_QEMU);
+    virQEMUCapsInitHostCPUModels(qemuCaps, hostArch);
 
     if (virXPathBoolean("boolean(./kvmSupportsNesting)", ctxt) > 0)
         qemuCaps->kvmSupportsNesting = true;
@@ -4826,6 +4844,707 @@ virQEMUCapsSaveFile(void *data,
 }
 
 
+/*
+ * Binary capabilities cache
+ *
+ * The binary cache stores exactly the same data as the XML produced by
+ * virQEMUCapsFormatCache, field by field, in a form which can be loaded
+ * without parsing any XML. Just like the XML it doesn't have to be stable
+ * as it is thrown away whenever libvirt changes, the magic and version
+ * only protect against files written by an incompatible libvirt build
+ * sharing the cache directory.
+ */
+#define QEMU_CAPS_CACHE_BINARY_MAGIC "LIBVIRT-QEMUCAPS"
+#define QEMU_CAPS_CACHE_BINARY_VERSION 1
+#define QEMU_CAPS_CACHE_BINARY_MAX_SIZE (16 * 1024 * 1024)
+#define QEMU_CAPS_CACHE_BINARY_NULL_STRING UINT32_MAX
+
+typedef struct _virQEMUCapsBinaryReader virQEMUCapsBinaryReader;
+struct _virQEMUCapsBinaryReader {
+    const char *data;
+    size_t len;
+    size_t pos;
+};
+
+
+static void
+virQEMUCapsBinaryAddUInt(GByteArray *buf,
+                         uint32_t val)
+{
+    g_byte_array_append(buf, (const guint8 *)&val, sizeof(val));
+}
+
+
+static void
+virQEMUCapsBinaryAddLongLong(GByteArray *buf,
+                             int64_t val)
+{
+    g_byte_array_append(buf, (const guint8 *)&val, sizeof(val));
+}
+
+
+static void
+virQEMUCapsBinaryAddBool(GByteArray *buf,
+                         bool val)
+{
+    guint8 byte = val ? 1 : 0;
+
+    g_byte_array_append(buf, &byte, 1);
+}
+
+
+static void
+virQEMUCapsBinaryAddString(GByteArray *buf,
+                           const char *str)
+{
+    size_t len;
+
+    if (!str) {
+        virQEMUCapsBinaryAddUInt(buf, QEMU_CAPS_CACHE_BINARY_NULL_STRING);
+        return;
+    }
+
+    len = strlen(str);
+    virQEMUCapsBinaryAddUInt(buf, len);
+    g_byte_array_append(buf, (const guint8 *)str, len);
+}
+
+
+static int
+virQEMUCapsBinaryGet(virQEMUCapsBinaryReader *reader,
+                     void *val,
+                     size_t size)
+{
+    if (reader->len - reader->pos < size) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("truncated binary QEMU capabilities cache"));
+        return -1;
+    }
+
+    memcpy(val, reader->data + reader->pos, size);
+    reader->pos += size;
+    return 0;
+}
+
+
+static int
+virQEMUCapsBinaryGetUInt(virQEMUCapsBinaryReader *reader,
+                         unsigned int *val)
+{
+    uint32_t tmp;
+
+    if (virQEMUCapsBinaryGet(reader, &tmp, sizeof(tmp)) < 0)
+        return -1;
+
+    *val = tmp;
+    return 0;
+}
+
+
+static int
+virQEMUCapsBinaryGetLongLong(virQEMUCapsBinaryReader *reader,
+                             long long *val)
+{
+    int64_t tmp;
+
+    if (virQEMUCapsBinaryGet(reader, &tmp, sizeof(tmp)) < 0)
+        return -1;
+
+    *val = tmp;
+    return 0;
+}
+
+
+static int
+virQEMUCapsBinaryGetBool(virQEMUCapsBinaryReader *reader,
+                         bool *val)
+{
+    guint8 byte;
+
+    if (virQEMUCapsBinaryGet(reader, &byte, 1) < 0)
+        return -1;
+
+    *val = !!byte;
+    return 0;
+}
+
+
+static int
+virQEMUCapsBinaryGetString(virQEMUCapsBinaryReader *reader,
+                           char **str)
+{
+    unsigned int len;
+
+    *str = NULL;
+
+    if (virQEMUCapsBinaryGetUInt(reader, &len) < 0)
+        return -1;
+
+    if (len == QEMU_CAPS_CACHE_BINARY_NULL_STRING)
+        return 0;
+
+    if (reader->len - reader->pos < len) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("truncated binary QEMU capabilities cache"));
+        return -1;
+    }
+
+    *str = g_strndup(reader->data + reader->pos, len);
+    reader->pos += len;
+    return 0;
+}
+
+
+static void
+virQEMUCapsFormatCacheBinaryAccel(virQEMUCaps *qemuCaps,
+                                  GByteArray *buf,
+                                  virDomainVirtType type)
+{
+    virQEMUCapsAccel *caps = virQEMUCapsGetAccel(qemuCaps, type);
+    qemuMonitorCPUModelInfo *model = caps->hostCPU.info;
+    qemuMonitorCPUDefs *defs = caps->cpuModels;
+    size_t i;
+    size_t j;
+
+    virQEMUCapsBinaryAddBool(buf, !!model);
+    if (model) {
+        virQEMUCapsBinaryAddString(buf, model->name);
+        virQEMUCapsBinaryAddBool(buf, model->migratability);
+        virQEMUCapsBinaryAddUInt(buf, model->nprops);
+
+        for (i = 0; i < model->nprops; i++) {
+            qemuMonitorCPUProperty *prop = model->props + i;
+
+            virQEMUCapsBinaryAddString(buf, prop->name);
+            virQEMUCapsBinaryAddUInt(buf, prop->type);
+
+            switch (prop->type) {
+            case QEMU_MONITOR_CPU_PROPERTY_BOOLEAN:
+                virQEMUCapsBinaryAddBool(buf, prop->value.boolean);
+                break;
+
+            case QEMU_MONITOR_CPU_PROPERTY_STRING:
+                virQEMUCapsBinaryAddString(buf, prop->value.string);
+                break;
+
+            case QEMU_MONITOR_CPU_PROPERTY_NUMBER:
+                virQEMUCapsBinaryAddLongLong(buf, prop->value.number);
+                break;
+
+            case QEMU_MONITOR_CPU_PROPERTY_LAST:
+                break;
+            }
+
+            virQEMUCapsBinaryAddUInt(buf, prop->migratable);
+        }
+    }
+
+    virQEMUCapsBinaryAddUInt(buf, defs ? defs->ncpus : 0);
+    for (i = 0; defs && i < defs->ncpus; i++) {
+        qemuMonitorCPUDefInfo *cpu = defs->cpus + i;
+        size_t nblockers = cpu->blockers ? g_strv_length(cpu->blockers) : 0;
+
+        virQEMUCapsBinaryAddString(buf, cpu->name);
+        virQEMUCapsBinaryAddString(buf, cpu->type);
+        virQEMUCapsBinaryAddUInt(buf, cpu->usable);
+        virQEMUCapsBinaryAddBool(buf, cpu->deprecated);
+        virQEMUCapsBinaryAddUInt(buf, nblockers);
+        for (j = 0; j < nblockers; j++)
+            virQEMUCapsBinaryAddString(buf, cpu->blockers[j]);
+    }
+
+    virQEMUCapsBinaryAddUInt(buf, caps->nmachineTypes);
+    for (i = 0; i < caps->nmachineTypes; i++) {
+        virQEMUCapsMachineType *machine = caps->machineTypes + i;
+
+        virQEMUCapsBinaryAddString(buf, machine->name);
+        virQEMUCapsBinaryAddString(buf, machine->alias);
+        virQEMUCapsBinaryAddUInt(buf, machine->maxCpus);
+        virQEMUCapsBinaryAddBool(buf, machine->hotplugCpus);
+        virQEMUCapsBinaryAddBool(buf, machine->qemuDefault);
+        virQEMUCapsBinaryAddString(buf, machine->defaultCPU);
+        virQEMUCapsBinaryAddBool(buf, machine->numaMemSupported);
+        virQEMUCapsBinaryAddString(buf, machine->defaultRAMid);
+        virQEMUCapsBinaryAddBool(buf, machine->deprecated);
+    }
+}
+
+
+/**
+ * virQEMUCapsFormatCacheBinary:
+ * @qemuCaps: capabilities to format
+ * @len: filled with the length of the returned data
+ *
+ * Formats @qemuCaps into the binary capabilities cache format which can
+ * be loaded back using virQEMUCapsLoadCacheBinary.
+ *
+ * Returns the binary data.
+ */
+char *
+virQEMUCapsFormatCacheBinary(virQEMUCaps *qemuCaps,
+                             size_t *len)
+{
+    g_autoptr(GByteArray) buf = g_byte_array_new();
+    size_t nflags = 0;
+    size_t i;
+
+    g_byte_array_append(buf, (const guint8 *)QEMU_CAPS_CACHE_BINARY_MAGIC,
+                        strlen(QEMU_CAPS_CACHE_BINARY_MAGIC));
+    virQEMUCapsBinaryAddUInt(buf, QEMU_CAPS_CACHE_BINARY_VERSION);
+    virQEMUCapsBinaryAddLongLong(buf, qemuCaps->libvirtCtime);
+    virQEMUCapsBinaryAddUInt(buf, qemuCaps->libvirtVersion);
+
+    virQEMUCapsBinaryAddString(buf, qemuCaps->binary);
+    virQEMUCapsBinaryAddLongLong(buf, qemuCaps->ctime);
+    virQEMUCapsBinaryAddLongLong(buf, qemuCaps->modDirMtime);
+
+    for (i = 0; i < QEMU_CAPS_LAST; i++) {
+        if (virQEMUCapsGet(qemuCaps, i))
+            nflags++;
+    }
+    virQEMUCapsBinaryAddUInt(buf, nflags);
+    for (i = 0; i < QEMU_CAPS_LAST; i++) {
+        if (virQEMUCapsGet(qemuCaps, i))
+            virQEMUCapsBinaryAddUInt(buf, i);
+    }
+
+    virQEMUCapsBinaryAddUInt(buf, qemuCaps->version);
+    virQEMUCapsBinaryAddUInt(buf, qemuCaps->kvmVersion);
+    virQEMUCapsBinaryAddUInt(buf, qemuCaps->microcodeVersion);
+    virQEMUCapsBinaryAddString(buf, qemuCaps->hostCPUSignature);
+    virQEMUCapsBinaryAddString(buf, qemuCaps->package);
+    virQEMUCapsBinaryAddString(buf, qemuCaps->kernelVersion);
+
+    if (qemuCaps->cpuData) {
+        g_autofree char *cpudata = virCPUDataFormat(qemuCaps->cpuData);
+
+        virQEMUCapsBinaryAddString(buf, cpudata);
+    } else {
+        virQEMUCapsBinaryAddString(buf, NULL);
+    }
+
+    virQEMUCapsBinaryAddUInt(buf, qemuCaps->arch);
+
+    if (virQEMUCapsGet(qemuCaps, QEMU_CAPS_KVM))
+        virQEMUCapsFormatCacheBinaryAccel(qemuCaps, buf, VIR_DOMAIN_VIRT_KVM);
+    if (virQEMUCapsGet(qemuCaps, QEMU_CAPS_HVF))
+        virQEMUCapsFormatCacheBinaryAccel(qemuCaps, buf, VIR_DOMAIN_VIRT_HVF);
+    virQEMUCapsFormatCacheBinaryAccel(qemuCaps, buf, VIR_DOMAIN_VIRT_QEMU);
+
+    virQEMUCapsBinaryAddUInt(buf, qemuCaps->ngicCapabilities);
+    for (i = 0; i < qemuCaps->ngicCapabilities; i++) {
+        virQEMUCapsBinaryAddUInt(buf, qemuCaps->gicCapabilities[i].version);
+        virQEMUCapsBinaryAddUInt(buf, qemuCaps->gicCapabilities[i].implementation);
+    }
+
+    virQEMUCapsBinaryAddBool(buf, !!qemuCaps->sevCapabilities);
+    if (qemuCaps->sevCapabilities) {
+        virSEVCapability *sev = qemuCaps->sevCapabilities;
+
+        virQEMUCapsBinaryAddUInt(buf, sev->cbitpos);
+        virQEMUCapsBinaryAddUInt(buf, sev->reduced_phys_bits);
+        virQEMUCapsBinaryAddString(buf, sev->pdh);
+        virQEMUCapsBinaryAddString(buf, sev->cert_chain);
+    }
+
+    virQEMUCapsBinaryAddBool(buf, qemuCaps->kvmSupportsNesting);
+    virQEMUCapsBinaryAddBool(buf, qemuCaps->kvmSupportsSecureGuest);
+
+    *len = buf->len;
+    return (char *)g_byte_array_free(g_steal_pointer(&buf), FALSE);
+}
+
+
+static int
+virQEMUCapsLoadCacheBinaryAccel(virQEMUCaps *qemuCaps,
+                                virQEMUCapsBinaryReader *reader,
+                                virDomainVirtType type)
+{
+    virQEMUCapsAccel *caps = virQEMUCapsGetAccel(qemuCaps, type);
+    unsigned int n;
+    unsigned int val;
+    bool present;
+    size_t i;
+    size_t j;
+
+    if (virQEMUCapsBinaryGetBool(reader, &present) < 0)
+        return -1;
+
+    if (present) {
+        g_autoptr(qemuMonitorCPUModelInfo) hostCPU = g_new0(qemuMonitorCPUModelInfo, 1);
+
+        if (virQEMUCapsBinaryGetString(reader, &hostCPU->name) < 0 ||
+            virQEMUCapsBinaryGetBool(reader, &hostCPU->migratability) < 0 ||
+            virQEMUCapsBinaryGetUInt(reader, &n) < 0)
+            return -1;
+
+        if (!hostCPU->name || n > reader->len) {
+            virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                           _("malformed host CPU model in binary QEMU "
+                             "capabilities cache"));
+            return -1;
+        }
+
+        hostCPU->props = g_new0(qemuMonitorCPUProperty, n);
+        hostCPU->nprops = n;
+
+        for (i = 0; i < n; i++) {
+            qemuMonitorCPUProperty *prop = hostCPU->props + i;
+
+            if (virQEMUCapsBinaryGetString(reader, &prop->name) < 0 ||
+                virQEMUCapsBinaryGetUInt(reader, &val) < 0)
+                return -1;
+
+            if (val >= QEMU_MONITOR_CPU_PROPERTY_LAST) {
+                virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                               _("invalid CPU model property type in binary "
+                                 "QEMU capabilities cache"));
+                return -1;
+            }
+            prop->type = val;
+
+            switch (prop->type) {
+            case QEMU_MONITOR_CPU_PROPERTY_BOOLEAN:
+                if (virQEMUCapsBinaryGetBool(reader, &prop->value.boolean) < 0)
+                    return -1;
+                break;
+
+            case QEMU_MONITOR_CPU_PROPERTY_STRING:
+                if (virQEMUCapsBinaryGetString(reader, &prop->value.string) < 0)
+                    return -1;
+                break;
+
+            case QEMU_MONITOR_CPU_PROPERTY_NUMBER:
+                if (virQEMUCapsBinaryGetLongLong(reader, &prop->value.number) < 0)
+                    return -1;
+                break;
+
+            case QEMU_MONITOR_CPU_PROPERTY_LAST:
+                break;
+            }
+
+            if (virQEMUCapsBinaryGetUInt(reader, &val) < 0)
+                return -1;
+            prop->migratable = val;
+        }
+
+        caps->hostCPU.info = g_steal_pointer(&hostCPU);
+    }
+
+    if (virQEMUCapsBinaryGetUInt(reader, &n) < 0)
+        return -1;
+
+    if (n > reader->len) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("malformed CPU models in binary QEMU capabilities cache"));
+        return -1;
+    }
+
+    if (n > 0) {
+        g_autoptr(qemuMonitorCPUDefs) defs = NULL;
+
+        if (!(defs = qemuMonitorCPUDefsNew(n)))
+            return -1;
+
+        for (i = 0; i < n; i++) {
+            qemuMonitorCPUDefInfo *cpu = defs->cpus + i;
+            unsigned int nblockers;
+
+            if (virQEMUCapsBinaryGetString(reader, &cpu->name) < 0 ||
+                virQEMUCapsBinaryGetString(reader, &cpu->type) < 0 ||
+                virQEMUCapsBinaryGetUInt(reader, &val) < 0 ||
+                virQEMUCapsBinaryGetBool(reader, &cpu->deprecated) < 0 ||
+                virQEMUCapsBinaryGetUInt(reader, &nblockers) < 0)
+                return -1;
+            cpu->usable = val;
+
+            if (nblockers > reader->len) {
+                virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                               _("malformed CPU blockers in binary QEMU "
+                                 "capabilities cache"));
+                return -1;
+            }
+
+            if (nblockers > 0) {
+                cpu->blockers = g_new0(char *, nblockers + 1);
+
+                for (j = 0; j < nblockers; j++) {
+                    if (virQEMUCapsBinaryGetString(reader, &cpu->blockers[j]) < 0)
+                        return -1;
+                }
+            }
+        }
+
+        caps->cpuModels = g_steal_pointer(&defs);
+    }
+
+    if (virQEMUCapsBinaryGetUInt(reader, &n) < 0)
+        return -1;
+
+    if (n > reader->len) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("malformed machine types in binary QEMU "
+                         "capabilities cache"));
+        return -1;
+    }
+
+    if (n > 0) {
+        caps->nmachineTypes = n;
+        caps->machineTypes = g_new0(virQEMUCapsMachineType, n);
+
+        for (i = 0; i < n; i++) {
+            virQEMUCapsMachineType *machine = caps->machineTypes + i;
+
+            if (virQEMUCapsBinaryGetString(reader, &machine->name) < 0 ||
+                virQEMUCapsBinaryGetString(reader, &machine->alias) < 0 ||
+                virQEMUCapsBinaryGetUInt(reader, &machine->maxCpus) < 0 ||
+                virQEMUCapsBinaryGetBool(reader, &machine->hotplugCpus) < 0 ||
+                virQEMUCapsBinaryGetBool(reader, &machine->qemuDefault) < 0 ||
+                virQEMUCapsBinaryGetString(reader, &machine->defaultCPU) < 0 ||
+                virQEMUCapsBinaryGetBool(reader, &machine->numaMemSupported) < 0 ||
+                virQEMUCapsBinaryGetString(reader, &machine->defaultRAMid) < 0 ||
+                virQEMUCapsBinaryGetBool(reader, &machine->deprecated) < 0)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+/**
+ * virQEMUCapsLoadCacheBinary:
+ * @hostArch: host architecture
+ * @qemuCaps: capabilities object to fill in
+ * @data: binary data created by virQEMUCapsFormatCacheBinary
+ * @len: length of @data
+ * @skipInvalidation: don't check whether the data was written by this libvirt
+ *
+ * Binary counterpart of virQEMUCapsLoadCache.
+ *
+ * Returns 0 on success, 1 if outdated, -1 on error
+ */
+int
+virQEMUCapsLoadCacheBinary(virArch hostArch,
+                           virQEMUCaps *qemuCaps,
+                           const char *data,
+                           size_t len,
+                           bool skipInvalidation)
+{
+    virQEMUCapsBinaryReader reader = { .data = data, .len = len };
+    size_t magiclen = strlen(QEMU_CAPS_CACHE_BINARY_MAGIC);
+    g_autofree char *binary = NULL;
+    g_autofree char *cpudata = NULL;
+    unsigned int version;
+    unsigned int val;
+    unsigned int n;
+    long long l;
+    bool sev;
+    size_t i;
+
+    if (len < magiclen ||
+        memcmp(data, QEMU_CAPS_CACHE_BINARY_MAGIC, magiclen) != 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("missing magic in binary QEMU capabilities cache"));
+        return -1;
+    }
+    reader.pos = magiclen;
+
+    if (virQEMUCapsBinaryGetUInt(&reader, &version) < 0)
+        return -1;
+
+    if (version != QEMU_CAPS_CACHE_BINARY_VERSION) {
+        VIR_DEBUG("Unsupported binary capabilities cache version %u for %s",
+                  version, qemuCaps->binary);
+        return 1;
+    }
+
+    if (virQEMUCapsBinaryGetLongLong(&reader, &l) < 0 ||
+        virQEMUCapsBinaryGetUInt(&reader, &qemuCaps->libvirtVersion) < 0)
+        return -1;
+    qemuCaps->libvirtCtime = (time_t)l;
+
+    if (!skipInvalidation && virQEMUCapsCacheLibvirtChanged(qemuCaps))
+        return 1;
+
+    if (virQEMUCapsBinaryGetString(&reader, &binary) < 0)
+        return -1;
+
+    if (STRNEQ_NULLABLE(binary, qemuCaps->binary)) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Expected caps for '%s' but saw '%s'"),
+                       qemuCaps->binary, NULLSTR(binary));
+        return -1;
+    }
+
+    if (virQEMUCapsBinaryGetLongLong(&reader, &l) < 0)
+        return -1;
+    qemuCaps->ctime = (time_t)l;
+
+    if (virQEMUCapsBinaryGetLongLong(&reader, &l) < 0)
+        return -1;
+    qemuCaps->modDirMtime = (time_t)l;
+
+    if (virQEMUCapsBinaryGetUInt(&reader, &n) < 0)
+        return -1;
+
+    for (i = 0; i < n; i++) {
+        if (virQEMUCapsBinaryGetUInt(&reader, &val) < 0)
+            return -1;
+
+        if (val >= QEMU_CAPS_LAST) {
+            virReportError(VIR_ERR_INTERNAL_ERROR,
+                           _("Unknown qemu capabilities flag %u"), val);
+            return -1;
+        }
+
+        virQEMUCapsSet(qemuCaps, val);
+    }
+
+    if (virQEMUCapsBinaryGetUInt(&reader, &qemuCaps->version) < 0 ||
+        virQEMUCapsBinaryGetUInt(&reader, &qemuCaps->kvmVersion) < 0 ||
+        virQEMUCapsBinaryGetUInt(&reader, &qemuCaps->microcodeVersion) < 0 ||
+        virQEMUCapsBinaryGetString(&reader, &qemuCaps->hostCPUSignature) < 0 ||
+        virQEMUCapsBinaryGetString(&reader, &qemuCaps->package) < 0 ||
+        virQEMUCapsBinaryGetString(&reader, &qemuCaps->kernelVersion) < 0 ||
+        virQEMUCapsBinaryGetString(&reader, &cpudata) < 0 ||
+        virQEMUCapsBinaryGetUInt(&reader, &val) < 0)
+        return -1;
+
+    if (val == VIR_ARCH_NONE || val >= VIR_ARCH_LAST) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("unknown arch %u in binary QEMU capabilities cache"),
+                       val);
+        return -1;
+    }
+    qemuCaps->arch = val;
+
+    if (cpudata &&
+        !(qemuCaps->cpuData = virCPUDataParse(cpudata)))
+        return -1;
+
+    if (virQEMUCapsGet(qemuCaps, QEMU_CAPS_KVM) &&
+        virQEMUCapsLoadCacheBinaryAccel(qemuCaps, &reader, VIR_DOMAIN_VIRT_KVM) < 0)
+        return -1;
+    if (virQEMUCapsGet(qemuCaps, QEMU_CAPS_HVF) &&
+        virQEMUCapsLoadCacheBinaryAccel(qemuCaps, &reader, VIR_DOMAIN_VIRT_HVF) < 0)
+        return -1;
+    if (virQEMUCapsLoadCacheBinaryAccel(qemuCaps, &reader, VIR_DOMAIN_VIRT_QEMU) < 0)
+        return -1;
+
+    if (virQEMUCapsBinaryGetUInt(&reader, &n) < 0)
+        return -1;
+
+    if (n > reader.len) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("malformed GIC capabilities in binary QEMU "
+                         "capabilities cache"));
+        return -1;
+    }
+
+    if (n > 0) {
+        qemuCaps->ngicCapabilities = n;
+        qemuCaps->gicCapabilities = g_new0(virGICCapability, n);
+
+        for (i = 0; i < n; i++) {
+            virGICCapability *cap = &qemuCaps->gicCapabilities[i];
+
+            if (virQEMUCapsBinaryGetUInt(&reader, &val) < 0)
+                return -1;
+            cap->version = val;
+
+            if (virQEMUCapsBinaryGetUInt(&reader, &val) < 0)
+                return -1;
+            cap->implementation = val;
+        }
+    }
+
+    if (virQEMUCapsBinaryGetBool(&reader, &sev) < 0)
+        return -1;
+
+    if (sev) {
+        g_autoptr(virSEVCapability) sevCaps = g_new0(virSEVCapability, 1);
+
+        if (virQEMUCapsBinaryGetUInt(&reader, &sevCaps->cbitpos) < 0 ||
+            virQEMUCapsBinaryGetUInt(&reader, &sevCaps->reduced_phys_bits) < 0 ||
+            virQEMUCapsBinaryGetString(&reader, &sevCaps->pdh) < 0 ||
+            virQEMUCapsBinaryGetString(&reader, &sevCaps->cert_chain) < 0)
+            return -1;
+
+        /* See virQEMUCapsParseSEVInfo */
+        virQEMUCapsGetSEVMaxGuests(sevCaps);
+
+        qemuCaps->sevCapabilities = g_steal_pointer(&sevCaps);
+    }
+
+    if (virQEMUCapsBinaryGetBool(&reader, &qemuCaps->kvmSupportsNesting) < 0 ||
+        virQEMUCapsBinaryGetBool(&reader, &qemuCaps->kvmSupportsSecureGuest) < 0)
+        return -1;
+
+    if (reader.pos != reader.len) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("trailing data in binary QEMU capabilities cache"));
+        return -1;
+    }
+
+    virQEMUCapsInitHostCPUModels(qemuCaps, hostArch);
+
+    if (skipInvalidation)
+        qemuCaps->invalidation = false;
+
+    return 0;
+}
+
+
+struct virQEMUCapsBinaryFileData {
+    const char *data;
+    size_t len;
+};
+
+
+static int
+virQEMUCapsSaveBinaryFileHelper(int fd,
+                                const char *path,
+                                const void *opaque)
+{
+    const struct virQEMUCapsBinaryFileData *bin = opaque;
+
+    if (safewrite(fd, bin->data, bin->len) < 0) {
+        virReportSystemError(errno,
+                             _("cannot write data to file '%s'"),
+                             path);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+virQEMUCapsSaveBinaryFile(void *data,
+                          const char *filename,
+                          void *privData G_GNUC_UNUSED)
+{
+    virQEMUCaps *qemuCaps = data;
+    g_autofree char *bin = NULL;
+    struct virQEMUCapsBinaryFileData binData = { 0 };
+
+    bin = virQEMUCapsFormatCacheBinary(qemuCaps, &binData.len);
+    binData.data = bin;
+
+    if (virFileRewrite(filename, 0600, -1, -1,
+                       virQEMUCapsSaveBinaryFileHelper, &binData) < 0)
+        return -1;
+
+    VIR_DEBUG("Saved binary caps '%s' for '%s' with (%lld, %lld)",
+              filename, qemuCaps->binary,
+              (long long)qemuCaps->ctime,
+              (long long)qemuCaps->libvirtCtime);
+
+    return 0;
+}
+
+
 /*
  * Check whether IBM Secure Execution (S390) is enabled
  */
@@ -5676,6 +6395,37 @@ virQEMUCapsLoadFile(const char *filename,
 }
 
 
+static void *
+virQEMUCapsLoadBinaryFile(const char *filename,
+                          const char *binary,
+                          void *privData,
+                          bool *outdated)
+{
+    g_autoptr(virQEMUCaps) qemuCaps = virQEMUCapsNewBinary(binary);
+    virQEMUCapsCachePriv *priv = privData;
+    g_autofree char *data = NULL;
+    int len;
+    int ret;
+
+    if (!qemuCaps)
+        return NULL;
+
+    if ((len = virFileReadAll(filename, QEMU_CAPS_CACHE_BINARY_MAX_SIZE,
+                              &data)) < 0)
+        return NULL;
+
+    ret = virQEMUCapsLoadCacheBinary(priv->hostArch, qemuCaps, data, len, false);
+    if (ret < 0)
+        return NULL;
+    if (ret == 1) {
+        *outdated = true;
+        return NULL;
+    }
+
+    return g_steal_pointer(&qemuCaps);
+}
+
+
 struct virQEMUCapsMachineTypeFilter {
     const char *machineType;
     virQEMUCapsFlags *flags;
@@ -5720,6 +6470,8 @@ virFileCacheHandlers qemuCapsCacheHandlers = {
     .newData = virQEMUCapsNewData,
     .loadFile = virQEMUCapsLoadFile,
     .saveFile = virQEMUCapsSaveFile,
+    .loadBinaryFile = virQEMUCapsLoadBinaryFile,
+    .saveBinaryFile = virQEMUCapsSaveBinaryFile,
     .privFree = virQEMUCapsCachePrivFree,
 };
 
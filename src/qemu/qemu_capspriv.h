@@ -44,6 +44,14 @@ int virQEMUCapsLoadCache(virArch hostArch,
                          bool skipInvalidation);
 char *virQEMUCapsFormatCache(virQEMUCaps *qemuCaps);
 
+int virQEMUCapsLoadCacheBinary(virArch hostArch,
+                               virQEMUCaps *qemuCaps,
+                               const char *data,
+                               size_t len,
+                               bool skipInvalidation);
+char *virQEMUCapsFormatCacheBinary(virQEMUCaps *qemuCaps,
+                                   size_t *len);
+
 int
 virQEMUCapsInitQMPMonitor(virQEMUCaps *qemuCaps,
                           qemuMonitor *mon);
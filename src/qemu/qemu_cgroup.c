@@ -671,6 +671,11 @@ qemuSetupDevicesCgroup(virDomainObj *vm)
         return -1;
     }
 
+    /* Allowing devices is hundreds of writes with cgroups v1, make them
+     * at once. The caller commits or aborts the changes. */
+    if (virCgroupBeginChanges(priv->cgroup) < 0)
+        return -1;
+
     if (qemuSetupFirmwareCgroup(vm) < 0)
         return -1;
 
@@ -819,7 +824,12 @@ qemuSetupCgroup(virDomainObj *vm,
     if (!priv->cgroup)
         return 0;
 
-    if (qemuSetupDevicesCgroup(vm) < 0)
+    if (qemuSetupDevicesCgroup(vm) < 0) {
+        virCgroupAbortChanges(priv->cgroup);
+        return -1;
+    }
+
+    if (virCgroupCommitChanges(priv->cgroup) < 0)
         return -1;
 
     if (qemuSetupCgroupAppid(vm) < 0)
@@ -256,6 +256,8 @@ virQEMUDriverConfig *virQEMUDriverConfigNew(bool privileged,
     cfg->slirpHelperName = g_strdup(QEMU_SLIRP_HELPER);
     cfg->dbusDaemonName = g_strdup(QEMU_DBUS_DAEMON);
 
+    cfg->hugepagesCheck = true;
+
     cfg->securityDefaultConfined = true;
     cfg->securityRequireConfined = false;
 
@@ -653,6 +655,11 @@ virQEMUDriverConfigLoadProcessEntry(virQEMUDriverConfig *cfg,
         }
     }
 
+    if (virConfGetValueBool(conf, "hugepages_check", &cfg->hugepagesCheck) < 0)
+        return -1;
+    if (virConfGetValueBool(conf, "hugepages_grow_pool", &cfg->hugepagesGrowPool) < 0)
+        return -1;
+
     if (virConfGetValueString(conf, "bridge_helper", &cfg->bridgeHelperName) < 0)
         return -1;
 
@@ -751,6 +758,80 @@ virQEMUDriverConfigLoadRPCEntry(virQEMUDriverConfig *cfg,
 }
 
 
+static int
+virQEMUDriverConfigLoadStatsEntry(virQEMUDriverConfig *cfg,
+                                  virConf *conf)
+{
+    if (virConfGetValueUInt(conf, "stats_workers", &cfg->statsWorkers) < 0)
+        return -1;
+    if (virConfGetValueUInt(conf, "stats_timeout", &cfg->statsTimeout) < 0)
+        return -1;
+    if (virConfGetValueUInt(conf, "stats_sample_interval",
+                            &cfg->statsSampleInterval) < 0)
+        return -1;
+
+    return 0;
+}
+
+
+static int
+virQEMUDriverConfigLoadStatusEntry(virQEMUDriverConfig *cfg,
+                                   virConf *conf)
+{
+    if (virConfGetValueUInt(conf, "status_save_delay", &cfg->statusSaveDelay) < 0)
+        return -1;
+
+    if (cfg->statusSaveDelay > INT_MAX) {
+        virReportError(VIR_ERR_CONF_SYNTAX, "%s",
+                       _("status_save_delay is too large"));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+virQEMUDriverConfigLoadReconnectEntry(virQEMUDriverConfig *cfg,
+                                      virConf *conf)
+{
+    if (virConfGetValueUInt(conf, "reconnect_workers", &cfg->reconnectWorkers) < 0)
+        return -1;
+
+    return 0;
+}
+
+
+static int
+virQEMUDriverConfigLoadNumaEntry(virQEMUDriverConfig *cfg,
+                                 virConf *conf)
+{
+    g_autofree char *placement = NULL;
+
+    if (virConfGetValueString(conf, "numa_placement", &placement) < 0)
+        return -1;
+
+    if (placement &&
+        (cfg->numaPlacement = qemuPlacementPolicyTypeFromString(placement)) < 0) {
+        virReportError(VIR_ERR_CONF_SYNTAX,
+                       _("Unknown numa_placement policy '%s'"), placement);
+        return -1;
+    }
+
+    if (virConfGetValueUInt(conf, "numa_rebalance_interval",
+                            &cfg->numaRebalanceInterval) < 0)
+        return -1;
+
+    if (cfg->numaRebalanceInterval > INT_MAX / 1000) {
+        virReportError(VIR_ERR_CONF_SYNTAX, "%s",
+                       _("numa_rebalance_interval is too large"));
+        return -1;
+    }
+
+    return 0;
+}
+
+
 static int
 virQEMUDriverConfigLoadNetworkEntry(virQEMUDriverConfig *cfg,
                                     virConf *conf,
@@ -1083,6 +1164,18 @@ int virQEMUDriverConfigLoadFile(virQEMUDriverConfig *cfg,
     if (virQEMUDriverConfigLoadRPCEntry(cfg, conf) < 0)
         return -1;
 
+    if (virQEMUDriverConfigLoadStatsEntry(cfg, conf) < 0)
+        return -1;
+
+    if (virQEMUDriverConfigLoadStatusEntry(cfg, conf) < 0)
+        return -1;
+
+    if (virQEMUDriverConfigLoadReconnectEntry(cfg, conf) < 0)
+        return -1;
+
+    if (virQEMUDriverConfigLoadNumaEntry(cfg, conf) < 0)
+        return -1;
+
     if (virQEMUDriverConfigLoadNetworkEntry(cfg, conf, filename) < 0)
         return -1;
 
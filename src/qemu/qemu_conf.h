@@ -36,6 +36,8 @@
 #include "virthreadpool.h"
 #include "locking/lock_manager.h"
 #include "qemu_capabilities.h"
+#include "qemu_hugepages.h"
+#include "qemu_placement.h"
 #include "virclosecallbacks.h"
 #include "virhostdev.h"
 #include "virfile.h"
@@ -154,6 +156,8 @@ struct _virQEMUDriverConfig {
 
     virHugeTLBFS *hugetlbfs;
     size_t nhugetlbfs;
+    bool hugepagesCheck;
+    bool hugepagesGrowPool;
 
     char *bridgeHelperName;
     char *prHelperName;
@@ -192,6 +196,17 @@ struct _virQEMUDriverConfig {
     int keepAliveInterval;
     unsigned int keepAliveCount;
 
+    unsigned int statsWorkers;
+    unsigned int statsTimeout;
+    unsigned int statsSampleInterval;
+
+    unsigned int statusSaveDelay;
+
+    unsigned int reconnectWorkers;
+
+    int numaPlacement; /* qemuPlacementPolicy */
+    unsigned int numaRebalanceInterval;
+
     int seccompSandbox;
 
     char *migrateHost;
@@ -235,6 +250,39 @@ struct _virQEMUDriver {
     /* Immutable pointer, self-locking APIs */
     virThreadPool *workerPool;
 
+    /* Immutable pointer, self-locking APIs. NULL unless parallel
+     * collection of domain statistics is enabled in qemu.conf */
+    virThreadPool *statsPool;
+
+    /* Atomic access only, self-locking APIs. NULL unless reconnecting to
+     * running domains on startup is limited to a pool of workers in
+     * qemu.conf, freed once the reconnects are finished. Use
+     * qemuProcessReconnectPoolSteal to take it over. */
+    virThreadPool *reconnectPool;
+
+    /* Atomic access only. Reconnects queued in reconnectPool which didn't
+     * finish yet */
+    int reconnectPending;
+
+    /* Atomic access only. Progress of reconnecting to the domains which
+     * were running when the daemon started */
+    int reconnectTotal;
+    int reconnectDone;
+    int reconnectFailed;
+
+    /* Immutable pointer, self-locking APIs. Domains placed automatically
+     * on host NUMA nodes */
+    qemuPlacement *placement;
+
+    /* Timer rebalancing automatic NUMA placement, -1 if disabled or
+     * removed. Set while the driver is initialized and reset by
+     * qemuStateShutdownPrepare or qemuStateCleanup, whichever runs first */
+    int placementTimer;
+
+    /* Immutable pointer, self-locking APIs. Huge pages held by running
+     * domains */
+    qemuHugepages *hugepages;
+
     /* Atomic increment only */
     int lastvmid;
 
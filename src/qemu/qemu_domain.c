@@ -36,6 +36,7 @@
 #include "qemu_checkpoint.h"
 #include "qemu_validate.h"
 #include "qemu_namespace.h"
+#include "qemu_process.h"
 #include "viralloc.h"
 #include "virlog.h"
 #include "virerror.h"
@@ -1677,6 +1678,8 @@ qemuDomainObjPrivateDataClear(qemuDomainObjPrivate *priv)
     /* remove automatic pinning data */
     g_clear_pointer(&priv->autoNodeset, virBitmapFree);
     g_clear_pointer(&priv->autoCpuset, virBitmapFree);
+    priv->placementCpuTime = 0;
+    priv->placementCheckTime = 0;
     g_clear_pointer(&priv->pciaddrs, virDomainPCIAddressSetFree);
     g_clear_pointer(&priv->usbaddrs, virDomainUSBAddressSetFree);
     g_clear_pointer(&priv->origCPU, virCPUDefFree);
@@ -1769,6 +1772,7 @@ qemuDomainObjPrivateAlloc(void *opaque)
     /* agent commands block by default, user can choose different behavior */
     priv->agentTimeout = VIR_DOMAIN_AGENT_RESPONSE_TIMEOUT_BLOCK;
     priv->migMaxBandwidth = QEMU_DOMAIN_MIG_BANDWIDTH_MAX;
+    priv->statusSaveTimer = -1;
     priv->driver = opaque;
 
     return g_steal_pointer(&priv);
@@ -6048,17 +6052,152 @@ virDomainDefParserConfig virQEMUDriverDomainDefParserConfig = {
 };
 
 
+static void
+qemuDomainSaveStatusNow(virDomainObj *obj,
+                        virQEMUDriverConfig *cfg)
+{
+    qemuDomainObjPrivate *priv = obj->privateData;
+    unsigned long long generation = priv->statusGeneration;
+
+    if (!virDomainObjIsActive(obj))
+        return;
+
+    if (virDomainObjSave(obj, priv->driver->xmlopt, cfg->stateDir) < 0) {
+        VIR_WARN("Failed to save status on vm %s", obj->def->name);
+        return;
+    }
+
+    priv->statusSavedGeneration = generation;
+}
+
+
+static void
+qemuDomainSaveStatusTimer(int timer,
+                          void *opaque)
+{
+    virDomainObj *obj = opaque;
+
+    /* The timer is one-shot. Formatting and writing the status XML is left
+     * to a worker thread so that it doesn't stall the event loop; the domain
+     * object must not be locked here either. */
+    virEventRemoveTimeout(timer);
+    qemuProcessEventSubmit(obj, QEMU_PROCESS_EVENT_SAVE_STATUS, timer, 0, NULL);
+}
+
+
+/**
+ * qemuDomainSaveStatus:
+ * @obj: domain object
+ *
+ * Records that the runtime state of @obj changed and writes its status XML
+ * right away, together with any change whose write was deferred.
+ */
 void
 qemuDomainSaveStatus(virDomainObj *obj)
 {
     qemuDomainObjPrivate *priv = obj->privateData;
-    virQEMUDriver *driver = priv->driver;
-    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
 
-    if (virDomainObjIsActive(obj)) {
-        if (virDomainObjSave(obj, driver->xmlopt, cfg->stateDir) < 0)
-            VIR_WARN("Failed to save status on vm %s", obj->def->name);
+    if (!virDomainObjIsActive(obj))
+        return;
+
+    priv->statusGeneration++;
+    qemuDomainSaveStatusFlush(obj);
+}
+
+
+/**
+ * qemuDomainSaveStatusDeferrable:
+ * @obj: domain object
+ *
+ * Same as qemuDomainSaveStatus, but if 'status_save_delay' is configured
+ * the write may be deferred and coalesced with other changes done in the
+ * meantime. Only for changes whose loss in a daemon crash is harmless, such
+ * as the balloon size or RTC offset reported by QEMU. The status is written
+ * right away while any job or block job is active, since recovering those
+ * relies on the saved state matching QEMU's.
+ */
+void
+qemuDomainSaveStatusDeferrable(virDomainObj *obj)
+{
+    qemuDomainObjPrivate *priv = obj->privateData;
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(priv->driver);
+
+    if (!virDomainObjIsActive(obj))
+        return;
+
+    priv->statusGeneration++;
+
+    if (cfg->statusSaveDelay == 0 ||
+        priv->job.active != VIR_JOB_NONE ||
+        priv->job.asyncJob != VIR_ASYNC_JOB_NONE ||
+        virHashSize(priv->blockjobs) > 0) {
+        qemuDomainSaveStatusFlush(obj);
+        return;
     }
+
+    /* the pending save will pick up this change as well */
+    if (priv->statusSaveTimer >= 0)
+        return;
+
+    virObjectRef(obj);
+    if ((priv->statusSaveTimer = virEventAddTimeout(cfg->statusSaveDelay,
+                                                    qemuDomainSaveStatusTimer,
+                                                    obj,
+                                                    virObjectUnref)) < 0) {
+        virObjectUnref(obj);
+        qemuDomainSaveStatusNow(obj, cfg);
+    }
+}
+
+
+/**
+ * qemuDomainSaveStatusFlush:
+ * @obj: domain object
+ *
+ * Cancels a pending deferred save of the status XML of @obj and writes it
+ * right away if it changed since the last write.
+ */
+void
+qemuDomainSaveStatusFlush(virDomainObj *obj)
+{
+    qemuDomainObjPrivate *priv = obj->privateData;
+    g_autoptr(virQEMUDriverConfig) cfg = NULL;
+
+    if (priv->statusSaveTimer >= 0) {
+        virEventRemoveTimeout(priv->statusSaveTimer);
+        priv->statusSaveTimer = -1;
+    }
+
+    if (priv->statusSavedGeneration == priv->statusGeneration)
+        return;
+
+    cfg = virQEMUDriverGetConfig(priv->driver);
+    qemuDomainSaveStatusNow(obj, cfg);
+}
+
+
+/**
+ * qemuDomainSaveStatusDeferred:
+ * @obj: domain object
+ * @timer: ID of the timer which scheduled the save
+ *
+ * Performs the save of the status XML scheduled by
+ * qemuDomainSaveStatusDeferrable.
+ * Called from the event worker thread with @obj locked.
+ */
+void
+qemuDomainSaveStatusDeferred(virDomainObj *obj,
+                             int timer)
+{
+    qemuDomainObjPrivate *priv = obj->privateData;
+
+    /* the save was flushed or cancelled in the meantime */
+    if (priv->statusSaveTimer != timer)
+        return;
+
+    priv->statusSaveTimer = -1;
+
+    qemuDomainSaveStatusFlush(obj);
 }
 
 
@@ -11160,6 +11299,8 @@ qemuProcessEventFree(struct qemuProcessEvent *event)
         break;
     case QEMU_PROCESS_EVENT_PR_DISCONNECT:
     case QEMU_PROCESS_EVENT_UNATTENDED_MIGRATION:
+    case QEMU_PROCESS_EVENT_SAVE_STATUS:
+    case QEMU_PROCESS_EVENT_NUMA_REBALANCE:
     case QEMU_PROCESS_EVENT_LAST:
         break;
     }
@@ -59,6 +59,10 @@ typedef void (*qemuDomainCleanupCallback)(virQEMUDriver *driver,
 #define QEMU_DOMAIN_MASTER_KEY_LEN 32  /* 32 bytes for 256 bit random key */
 
 void qemuDomainSaveStatus(virDomainObj *obj);
+void qemuDomainSaveStatusDeferrable(virDomainObj *obj);
+void qemuDomainSaveStatusFlush(virDomainObj *obj);
+void qemuDomainSaveStatusDeferred(virDomainObj *obj,
+                                  int timer);
 void qemuDomainSaveConfig(virDomainObj *obj);
 
 
@@ -244,6 +248,16 @@ struct _qemuDomainObjPrivate {
 
     unsigned long long originalMemlock; /* Original RLIMIT_MEMLOCK, zero if no
                                          * restore will be required later */
+
+    /* Coalescing of status XML saves, see qemuDomainSaveStatusDeferrable */
+    unsigned long long statusGeneration; /* bumped on every status change */
+    unsigned long long statusSavedGeneration; /* last generation written */
+    int statusSaveTimer; /* pending save timer, -1 if none */
+
+    /* CPU time used by the domain when its NUMA placement was last
+     * checked and the monotonic time of the check in microseconds */
+    unsigned long long placementCpuTime;
+    long long placementCheckTime;
 };
 
 #define QEMU_DOMAIN_PRIVATE(vm) \
@@ -426,6 +440,8 @@ typedef enum {
     QEMU_PROCESS_EVENT_GUEST_CRASHLOADED,
     QEMU_PROCESS_EVENT_MEMORY_DEVICE_SIZE_CHANGE,
     QEMU_PROCESS_EVENT_UNATTENDED_MIGRATION,
+    QEMU_PROCESS_EVENT_SAVE_STATUS,
+    QEMU_PROCESS_EVENT_NUMA_REBALANCE,
 
     QEMU_PROCESS_EVENT_LAST
 } qemuProcessEventType;
@@ -819,6 +819,24 @@ qemuDomainObjReleaseAsyncJob(virDomainObj *obj)
     priv->job.asyncOwner = 0;
 }
 
+/*
+ * Makes the current thread the owner of a normal job started by another
+ * thread, which handed the domain over to us.
+ */
+void
+qemuDomainObjClaimJob(virDomainObj *obj)
+{
+    qemuDomainObjPrivate *priv = obj->privateData;
+
+    VIR_DEBUG("Claiming '%s' job owned by thread %llu",
+              virDomainJobTypeToString(priv->job.active),
+              priv->job.owner);
+
+    priv->job.owner = virThreadSelfID();
+    g_free(priv->job.ownerAPI);
+    priv->job.ownerAPI = g_strdup(virThreadJobGet());
+}
+
 static bool
 qemuDomainNestedJobAllowed(qemuDomainJobObj *jobs, virDomainJob newJob)
 {
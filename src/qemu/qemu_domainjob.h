@@ -174,6 +174,7 @@ qemuDomainObjRestoreAsyncJob(virDomainObj *vm,
                              unsigned long long allowedJobs);
 void qemuDomainObjDiscardAsyncJob(virDomainObj *obj);
 void qemuDomainObjReleaseAsyncJob(virDomainObj *obj);
+void qemuDomainObjClaimJob(virDomainObj *obj);
 
 int qemuDomainJobDataUpdateTime(virDomainJobData *jobData)
     ATTRIBUTE_NONNULL(1);
@@ -50,6 +50,7 @@
 #include "qemu_namespace.h"
 #include "qemu_saveimage.h"
 #include "qemu_snapshot.h"
+#include "qemu_stats.h"
 #include "qemu_validate.h"
 
 #include "virerror.h"
@@ -72,6 +73,7 @@
 #include "virpci.h"
 #include "virpidfile.h"
 #include "virprocess.h"
+#include "virprocessstats.h"
 #include "libvirt_internal.h"
 #include "virxml.h"
 #include "cpu/cpu.h"
@@ -541,6 +543,34 @@ qemuDomainFindMaxID(virDomainObj *vm,
 }
 
 
+static int
+qemuDomainRebalanceIter(virDomainObj *vm,
+                        void *opaque G_GNUC_UNUSED)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(vm);
+    qemuDomainObjPrivate *priv = vm->privateData;
+
+    if (virDomainObjIsActive(vm) && priv->autoNodeset)
+        qemuProcessEventSubmit(vm, QEMU_PROCESS_EVENT_NUMA_REBALANCE,
+                               0, 0, NULL);
+
+    return 0;
+}
+
+
+static void
+qemuDomainRebalanceTimer(int timer G_GNUC_UNUSED,
+                         void *opaque)
+{
+    virQEMUDriver *driver = opaque;
+
+    /* The placement of every domain is checked by its event worker, in a
+     * job, so that it doesn't interfere with any API */
+    virDomainObjListForEach(driver->domains, false,
+                            qemuDomainRebalanceIter, NULL);
+}
+
+
 /**
  * qemuStateInitialize:
  *
@@ -565,6 +595,7 @@ qemuStateInitialize(bool privileged,
     qemu_driver = g_new0(virQEMUDriver, 1);
 
     qemu_driver->lockFD = -1;
+    qemu_driver->placementTimer = -1;
 
     if (virMutexInit(&qemu_driver->lock) < 0) {
         virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
@@ -584,6 +615,12 @@ qemuStateInitialize(bool privileged,
     if (!(qemu_driver->domains = virDomainObjListNew()))
         goto error;
 
+    if (!(qemu_driver->placement = qemuPlacementNew()))
+        goto error;
+
+    if (!(qemu_driver->hugepages = qemuHugepagesNew()))
+        goto error;
+
     /* Init domain events */
     qemu_driver->domainEventState = virObjectEventStateNew();
     if (!qemu_driver->domainEventState)
@@ -917,8 +954,31 @@ qemuStateInitialize(bool privileged,
     if (!qemu_driver->workerPool)
         goto error;
 
+    if (cfg->statsWorkers > 0 &&
+        !(qemu_driver->statsPool = virThreadPoolNewFull(0, cfg->statsWorkers, 0,
+                                                        qemuStatsWorker,
+                                                        "qemu-stats",
+                                                        identity,
+                                                        qemu_driver)))
+        goto error;
+
+    if (cfg->statsSampleInterval > 0 &&
+        virProcessStatsSamplerStart(cfg->statsSampleInterval) < 0)
+        goto error;
+
     qemuProcessReconnectAll(qemu_driver);
 
+    if (cfg->numaPlacement != QEMU_PLACEMENT_POLICY_NUMAD &&
+        cfg->numaRebalanceInterval > 0 &&
+        (qemu_driver->placementTimer = virEventAddTimeout(cfg->numaRebalanceInterval * 1000,
+                                                          qemuDomainRebalanceTimer,
+                                                          qemu_driver,
+                                                          NULL)) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Unable to add NUMA rebalancing timer"));
+        goto error;
+    }
+
     if (virDriverShouldAutostart(cfg->stateDir, &autostart) < 0)
         goto error;
 
@@ -1029,7 +1089,18 @@ qemuStateStop(void)
 static int
 qemuStateShutdownPrepare(void)
 {
+    virThreadPool *reconnectPool = g_atomic_pointer_get(&qemu_driver->reconnectPool);
+
+    if (qemu_driver->placementTimer >= 0) {
+        virEventRemoveTimeout(qemu_driver->placementTimer);
+        qemu_driver->placementTimer = -1;
+    }
+
     virThreadPoolStop(qemu_driver->workerPool);
+    /* The pool is only ever freed from the event loop which runs this
+     * function as well */
+    if (reconnectPool)
+        virThreadPoolStop(reconnectPool);
     return 0;
 }
 
@@ -1039,6 +1110,7 @@ qemuDomainObjStopWorkerIter(virDomainObj *vm,
                             void *opaque G_GNUC_UNUSED)
 {
     virObjectLock(vm);
+    qemuDomainSaveStatusFlush(vm);
     qemuDomainObjStopWorker(vm);
     virObjectUnlock(vm);
     return 0;
@@ -1050,11 +1122,33 @@ qemuStateShutdownWait(void)
 {
     virDomainObjListForEach(qemu_driver->domains, false,
                             qemuDomainObjStopWorkerIter, NULL);
+    virThreadPoolFree(qemuProcessReconnectPoolSteal(qemu_driver));
     virThreadPoolDrain(qemu_driver->workerPool);
     return 0;
 }
 
 
+static int
+qemuStateGetStats(virTypedParamList *params)
+{
+    if (!qemu_driver)
+        return 0;
+
+    if (virTypedParamListAddUInt(params,
+                                 g_atomic_int_get(&qemu_driver->reconnectTotal),
+                                 "qemu.reconnect.total") < 0 ||
+        virTypedParamListAddUInt(params,
+                                 g_atomic_int_get(&qemu_driver->reconnectDone),
+                                 "qemu.reconnect.done") < 0 ||
+        virTypedParamListAddUInt(params,
+                                 g_atomic_int_get(&qemu_driver->reconnectFailed),
+                                 "qemu.reconnect.failed") < 0)
+        return -1;
+
+    return 0;
+}
+
+
 /**
  * qemuStateCleanup:
  *
@@ -1066,6 +1160,11 @@ qemuStateCleanup(void)
     if (!qemu_driver)
         return -1;
 
+    /* The timer holds qemu_driver if initialization failed after adding
+     * it, as qemuStateShutdownPrepare didn't run then */
+    if (qemu_driver->placementTimer >= 0)
+        virEventRemoveTimeout(qemu_driver->placementTimer);
+
     virObjectUnref(qemu_driver->migrationErrors);
     virObjectUnref(qemu_driver->closeCallbacks);
     virLockManagerPluginUnref(qemu_driver->lockManager);
@@ -1083,7 +1182,12 @@ qemuStateCleanup(void)
     ebtablesContextFree(qemu_driver->ebtables);
     VIR_FREE(qemu_driver->qemuImgBinary);
     virObjectUnref(qemu_driver->domains);
+    virObjectUnref(qemu_driver->placement);
+    virObjectUnref(qemu_driver->hugepages);
+    virThreadPoolFree(qemuProcessReconnectPoolSteal(qemu_driver));
     virThreadPoolFree(qemu_driver->workerPool);
+    virThreadPoolFree(qemu_driver->statsPool);
+    virProcessStatsSamplerStop();
 
     if (qemu_driver->lockFD != -1)
         virPidFileRelease(qemu_driver->config->stateDir, "driver", qemu_driver->lockFD);
@@ -1185,6 +1289,9 @@ qemuConnectSupportsFeature(virConnectPtr conn, int feature)
     case VIR_DRV_FEATURE_PROGRAM_KEEPALIVE:
     case VIR_DRV_FEATURE_REMOTE_CLOSE_CALLBACK:
     case VIR_DRV_FEATURE_REMOTE_EVENT_CALLBACK:
+    case VIR_DRV_FEATURE_REMOTE_STREAM_LARGE_PAYLOAD:
+    case VIR_DRV_FEATURE_REMOTE_COMPRESSION:
+    case VIR_DRV_FEATURE_REMOTE_EVENT_BATCH:
     case VIR_DRV_FEATURE_TYPED_PARAM_STRING:
     case VIR_DRV_FEATURE_NETWORK_UPDATE_HAS_CORRECT_ORDER:
     case VIR_DRV_FEATURE_FD_PASSING:
@@ -1290,36 +1397,6 @@ static char *qemuConnectGetCapabilities(virConnectPtr conn) {
 }
 
 
-static int
-qemuGetSchedstatDelay(unsigned long long *cpudelay,
-                      pid_t pid,
-                      pid_t tid)
-{
-    g_autofree char *path = NULL;
-    g_autofree char *buf = NULL;
-
-    if (tid)
-        path = g_strdup_printf("/proc/%d/task/%d/schedstat", (int)pid, (int)tid);
-    else
-        path = g_strdup_printf("/proc/%d/schedstat", (int)pid);
-
-    /* This file might not exist (needs CONFIG_SCHED_INFO) */
-    if (!virFileExists(path))
-        return 0;
-
-    if (virFileReadAll(path, 1024, &buf) < 0)
-        return -1;
-
-    if (sscanf(buf, "%*u %llu", cpudelay) != 1) {
-        virReportError(VIR_ERR_INTERNAL_ERROR,
-                       _("Unable to parse schedstat info at '%s'"),
-                       path);
-        return -1;
-    }
-
-    return 0;
-}
-
 static int
 qemuDomainHelperGetVcpus(virDomainObj *vm,
                          virVcpuInfoPtr info,
@@ -1329,12 +1406,21 @@ qemuDomainHelperGetVcpus(virDomainObj *vm,
                          unsigned char *cpumaps,
                          int maplen)
 {
+    qemuDomainObjPrivate *priv = vm->privateData;
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(priv->driver);
+    unsigned int statsFlags = 0;
+    unsigned int statsMaxAge;
     size_t ncpuinfo = 0;
     size_t i;
 
     if (maxinfo == 0)
         return 0;
 
+    /* A sample is refreshed only after the whole interval plus the time
+     * the sampler takes, so allow for a full interval of slack rather than
+     * reading the files whenever a query comes just before the refresh */
+    statsMaxAge = cfg->statsSampleInterval * 2;
+
     if (!qemuDomainHasVcpuPids(vm)) {
         virReportError(VIR_ERR_OPERATION_INVALID,
                        "%s", _("cpu affinity is not supported"));
@@ -1347,25 +1433,28 @@ qemuDomainHelperGetVcpus(virDomainObj *vm,
     if (cpumaps)
         memset(cpumaps, 0, sizeof(*cpumaps) * maxinfo);
 
+    if (cpuwait || cpudelay)
+        statsFlags |= VIR_PROCESS_STATS_SCHED;
+
     for (i = 0; i < virDomainDefGetVcpusMax(vm->def) && ncpuinfo < maxinfo; i++) {
         virDomainVcpuDef *vcpu = virDomainDefGetVcpu(vm->def, i);
         pid_t vcpupid = qemuDomainGetVcpuPid(vm, i);
         virVcpuInfoPtr vcpuinfo = info + ncpuinfo;
+        virProcessStats stats;
 
         if (!vcpu->online)
             continue;
 
+        if ((info || cpuwait || cpudelay) &&
+            virProcessGetStats(vm->pid, vcpupid, statsMaxAge,
+                               statsFlags, &stats) < 0)
+            return -1;
+
         if (info) {
             vcpuinfo->number = i;
             vcpuinfo->state = VIR_VCPU_RUNNING;
-
-            if (virProcessGetStatInfo(&vcpuinfo->cpuTime,
-                                      &vcpuinfo->cpu, NULL,
-                                      vm->pid, vcpupid) < 0) {
-                virReportSystemError(errno, "%s",
-                                     _("cannot get vCPU placement & pCPU time"));
-                return -1;
-            }
+            vcpuinfo->cpuTime = stats.cpuTime;
+            vcpuinfo->cpu = stats.lastCpu;
         }
 
         if (cpumaps) {
@@ -1378,15 +1467,11 @@ qemuDomainHelperGetVcpus(virDomainObj *vm,
             virBitmapToDataBuf(map, cpumap, maplen);
         }
 
-        if (cpuwait) {
-            if (virProcessGetSchedInfo(&(cpuwait[ncpuinfo]), vm->pid, vcpupid) < 0)
-                return -1;
-        }
+        if (cpuwait)
+            cpuwait[ncpuinfo] = stats.cpuWait;
 
-        if (cpudelay) {
-            if (qemuGetSchedstatDelay(&(cpudelay[ncpuinfo]), vm->pid, vcpupid) < 0)
-                return -1;
-        }
+        if (cpudelay)
+            cpudelay[ncpuinfo] = stats.cpuDelay;
 
         ncpuinfo++;
     }
@@ -2495,18 +2580,10 @@ static int qemuDomainSendKey(virDomainPtr domain,
 
 
 static int
-qemuDomainGetInfo(virDomainPtr dom,
-                  virDomainInfoPtr info)
+qemuDomainObjGetInfo(virDomainObj *vm,
+                     virDomainInfoPtr info)
 {
     unsigned long long maxmem;
-    virDomainObj *vm;
-    int ret = -1;
-
-    if (!(vm = qemuDomainObjFromDomain(dom)))
-        goto cleanup;
-
-    if (virDomainGetInfoEnsureACL(dom->conn, vm->def) < 0)
-        goto cleanup;
 
     qemuDomainUpdateCurrentMemorySize(vm);
 
@@ -2518,13 +2595,13 @@ qemuDomainGetInfo(virDomainPtr dom,
     if (VIR_ASSIGN_IS_OVERFLOW(info->maxMem, maxmem)) {
         virReportError(VIR_ERR_OVERFLOW, "%s",
                        _("Initial memory size too large"));
-        goto cleanup;
+        return -1;
     }
 
     if (VIR_ASSIGN_IS_OVERFLOW(info->memory, vm->def->mem.cur_balloon)) {
         virReportError(VIR_ERR_OVERFLOW, "%s",
                        _("Current memory size too large"));
-        goto cleanup;
+        return -1;
     }
 
     if (virDomainObjIsActive(vm)) {
@@ -2532,16 +2609,33 @@ qemuDomainGetInfo(virDomainPtr dom,
                                   vm->pid, 0) < 0) {
             virReportError(VIR_ERR_OPERATION_FAILED, "%s",
                            _("cannot read cputime for domain"));
-            goto cleanup;
+            return -1;
         }
     }
 
     if (VIR_ASSIGN_IS_OVERFLOW(info->nrVirtCpu, virDomainDefGetVcpus(vm->def))) {
         virReportError(VIR_ERR_OVERFLOW, "%s", _("cpu count too large"));
-        goto cleanup;
+        return -1;
     }
 
-    ret = 0;
+    return 0;
+}
+
+
+static int
+qemuDomainGetInfo(virDomainPtr dom,
+                  virDomainInfoPtr info)
+{
+    virDomainObj *vm;
+    int ret = -1;
+
+    if (!(vm = qemuDomainObjFromDomain(dom)))
+        goto cleanup;
+
+    if (virDomainGetInfoEnsureACL(dom->conn, vm->def) < 0)
+        goto cleanup;
+
+    ret = qemuDomainObjGetInfo(vm, info);
 
  cleanup:
     virDomainObjEndAPI(&vm);
@@ -4208,6 +4302,149 @@ processGuestCrashloadedEvent(virQEMUDriver *driver,
 }
 
 
+static virObjectEvent *
+qemuDomainPlacementEventNew(virDomainObj *vm)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    virTypedParameterPtr eventParams = NULL;
+    int eventNparams = 0;
+    int eventMaxparams = 0;
+    char paramField[VIR_TYPED_PARAM_FIELD_LENGTH] = "";
+    g_autofree char *nodeset = NULL;
+    g_autofree char *cpuset = NULL;
+    size_t i;
+
+    if (!(nodeset = virBitmapFormat(priv->autoNodeset)) ||
+        !(cpuset = virBitmapFormat(priv->autoCpuset)))
+        return NULL;
+
+    if (virTypedParamsAddString(&eventParams, &eventNparams, &eventMaxparams,
+                                VIR_DOMAIN_TUNABLE_NUMA_NODESET, nodeset) < 0)
+        goto error;
+
+    /* Threads pinned explicitly or following <vcpu cpuset> didn't move */
+    if (vm->def->placement_mode == VIR_DOMAIN_CPU_PLACEMENT_MODE_AUTO) {
+        if (!vm->def->cputune.emulatorpin &&
+            virTypedParamsAddString(&eventParams, &eventNparams,
+                                    &eventMaxparams,
+                                    VIR_DOMAIN_TUNABLE_CPU_EMULATORPIN,
+                                    cpuset) < 0)
+            goto error;
+
+        for (i = 0; i < virDomainDefGetVcpusMax(vm->def); i++) {
+            virDomainVcpuDef *vcpu = virDomainDefGetVcpu(vm->def, i);
+
+            if (!vcpu->online || vcpu->cpumask)
+                continue;
+
+            g_snprintf(paramField, VIR_TYPED_PARAM_FIELD_LENGTH,
+                       VIR_DOMAIN_TUNABLE_CPU_VCPUPIN, (unsigned int) i);
+
+            if (virTypedParamsAddString(&eventParams, &eventNparams,
+                                        &eventMaxparams, paramField,
+                                        cpuset) < 0)
+                goto error;
+        }
+
+        for (i = 0; i < vm->def->niothreadids; i++) {
+            virDomainIOThreadIDDef *iothread = vm->def->iothreadids[i];
+
+            if (iothread->cpumask)
+                continue;
+
+            g_snprintf(paramField, VIR_TYPED_PARAM_FIELD_LENGTH,
+                       VIR_DOMAIN_TUNABLE_CPU_IOTHREADSPIN,
+                       iothread->iothread_id);
+
+            if (virTypedParamsAddString(&eventParams, &eventNparams,
+                                        &eventMaxparams, paramField,
+                                        cpuset) < 0)
+                goto error;
+        }
+    }
+
+    return virDomainEventTunableNewFromObj(vm, eventParams, eventNparams);
+
+ error:
+    virTypedParamsFree(eventParams, eventNparams);
+    return NULL;
+}
+
+
+static void
+processNumaRebalanceEvent(virQEMUDriver *driver,
+                          virDomainObj *vm)
+{
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+    qemuDomainObjPrivate *priv = vm->privateData;
+    g_autoptr(virBitmap) nodeset = NULL;
+    g_autofree char *nodesetStr = NULL;
+    virObjectEvent *event = NULL;
+    unsigned long long cpuTime;
+    long long now;
+    double load;
+
+    if (qemuDomainObjBeginJob(driver, vm, VIR_JOB_MODIFY) < 0)
+        return;
+
+    if (!virDomainObjIsActive(vm) || !priv->autoNodeset) {
+        VIR_DEBUG("Domain is not running or not placed automatically");
+        goto endjob;
+    }
+
+    if (!virCgroupHasController(priv->cgroup, VIR_CGROUP_CONTROLLER_CPUACCT) ||
+        virCgroupGetCpuacctUsage(priv->cgroup, &cpuTime) < 0) {
+        VIR_DEBUG("Unable to get CPU usage of domain %s", vm->def->name);
+        goto endjob;
+    }
+
+    now = g_get_monotonic_time();
+
+    /* The load is measured over the interval since the previous check */
+    if (priv->placementCheckTime == 0 ||
+        now <= priv->placementCheckTime ||
+        cpuTime < priv->placementCpuTime)
+        goto record;
+
+    load = (double) (cpuTime - priv->placementCpuTime) / 1000 /
+        (now - priv->placementCheckTime);
+
+    switch (qemuPlacementRebalance(driver->placement, vm->def,
+                                   cfg->numaPlacement, priv->autoNodeset,
+                                   load, &nodeset)) {
+    case -1:
+        VIR_WARN("Unable to check NUMA placement of domain %s: %s",
+                 vm->def->name, virGetLastErrorMessage());
+        break;
+
+    case 1:
+        nodesetStr = virBitmapFormat(nodeset);
+        VIR_INFO("Moving domain %s with load %.2f to NUMA nodes %s",
+                 vm->def->name, load, NULLSTR(nodesetStr));
+
+        if (qemuProcessUpdateAutoPlacement(vm, nodeset) < 0) {
+            VIR_WARN("Unable to move domain %s to NUMA nodes %s: %s",
+                     vm->def->name, NULLSTR(nodesetStr),
+                     virGetLastErrorMessage());
+            qemuPlacementAddDomain(driver->placement, vm->def,
+                                   priv->autoNodeset, load);
+            break;
+        }
+
+        event = qemuDomainPlacementEventNew(vm);
+        break;
+    }
+
+ record:
+    priv->placementCpuTime = cpuTime;
+    priv->placementCheckTime = now;
+
+ endjob:
+    qemuDomainObjEndJob(vm);
+    virObjectEventStateQueue(driver->domainEventState, event);
+}
+
+
 static void
 processMemoryDeviceSizeChange(virQEMUDriver *driver,
                               virDomainObj *vm,
@@ -4308,6 +4545,12 @@ static void qemuProcessEventHandler(void *data, void *opaque)
                                        processEvent->action,
                                        processEvent->status);
         break;
+    case QEMU_PROCESS_EVENT_SAVE_STATUS:
+        qemuDomainSaveStatusDeferred(vm, processEvent->action);
+        break;
+    case QEMU_PROCESS_EVENT_NUMA_REBALANCE:
+        processNumaRebalanceEvent(driver, vm);
+        break;
     case QEMU_PROCESS_EVENT_LAST:
         break;
     }
@@ -6385,6 +6628,27 @@ qemuDomainObjRestore(virConnectPtr conn,
 }
 
 
+static char *
+qemuDomainObjGetXMLDesc(virQEMUDriver *driver,
+                        virDomainObj *vm,
+                        unsigned int flags)
+{
+    qemuDomainUpdateCurrentMemorySize(vm);
+
+    if ((flags & VIR_DOMAIN_XML_MIGRATABLE))
+        flags |= QEMU_DOMAIN_FORMAT_LIVE_FLAGS;
+
+    /* The CPU is already updated in the domain's live definition, we need to
+     * ignore the VIR_DOMAIN_XML_UPDATE_CPU flag.
+     */
+    if (virDomainObjIsActive(vm) &&
+        !(flags & VIR_DOMAIN_XML_INACTIVE))
+        flags &= ~VIR_DOMAIN_XML_UPDATE_CPU;
+
+    return qemuDomainFormatXML(driver, vm, flags);
+}
+
+
 static char
 *qemuDomainGetXMLDesc(virDomainPtr dom,
                       unsigned int flags)
@@ -6402,19 +6666,7 @@ static char
     if (virDomainGetXMLDescEnsureACL(dom->conn, vm->def, flags) < 0)
         goto cleanup;
 
-    qemuDomainUpdateCurrentMemorySize(vm);
-
-    if ((flags & VIR_DOMAIN_XML_MIGRATABLE))
-        flags |= QEMU_DOMAIN_FORMAT_LIVE_FLAGS;
-
-    /* The CPU is already updated in the domain's live definition, we need to
-     * ignore the VIR_DOMAIN_XML_UPDATE_CPU flag.
-     */
-    if (virDomainObjIsActive(vm) &&
-        !(flags & VIR_DOMAIN_XML_INACTIVE))
-        flags &= ~VIR_DOMAIN_XML_UPDATE_CPU;
-
-    ret = qemuDomainFormatXML(driver, vm, flags);
+    ret = qemuDomainObjGetXMLDesc(driver, vm, flags);
 
  cleanup:
     virDomainObjEndAPI(&vm);
@@ -17638,8 +17890,9 @@ qemuNodeGetFreePages(virConnectPtr conn,
     virQEMUDriver *driver = conn->privateData;
     g_autoptr(virCaps) caps = NULL;
     int lastCell;
+    int ncounts;
 
-    virCheckFlags(0, -1);
+    virCheckFlags(VIR_NODE_FREE_PAGES_UNRESERVED, -1);
 
     if (virNodeGetFreePagesEnsureACL(conn) < 0)
         return -1;
@@ -17649,8 +17902,16 @@ qemuNodeGetFreePages(virConnectPtr conn,
 
     lastCell = virCapabilitiesHostNUMAGetMaxNode(caps->host.numa);
 
-    return virHostMemGetFreePages(npages, pages, startCell, cellCount,
-                                  lastCell, counts);
+    if ((ncounts = virHostMemGetFreePages(npages, pages, startCell, cellCount,
+                                          lastCell, counts)) < 0)
+        return -1;
+
+    if ((flags & VIR_NODE_FREE_PAGES_UNRESERVED) &&
+        qemuHugepagesAdjustFreePages(driver->hugepages, npages, pages,
+                                     startCell, counts, ncounts) < 0)
+        return -1;
+
+    return ncounts;
 }
 
 
@@ -18854,6 +19115,106 @@ qemuDomainGetStatsDirtyRate(virQEMUDriver *driver,
     return 0;
 }
 
+
+static int
+qemuDomainGetStatsVcpuHypervisorMon(virQEMUDriver *driver,
+                                    virDomainObj *vm,
+                                    virJSONValue **queried)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+
+    qemuDomainObjEnterMonitor(driver, vm);
+    *queried = qemuMonitorQueryStats(priv->mon,
+                                     QEMU_MONITOR_QUERY_STATS_TARGET_VCPU,
+                                     NULL,
+                                     QEMU_MONITOR_QUERY_STATS_PROVIDER_KVM);
+    qemuDomainObjExitMonitor(vm);
+
+    return *queried ? 0 : -1;
+}
+
+
+static int
+qemuDomainAddStatsFromQueryStats(virTypedParamList *params,
+                                 virJSONValue *queried,
+                                 const char *qomPath,
+                                 size_t vcpu)
+{
+    const char *provider = qemuMonitorQueryStatsProviderTypeToString(QEMU_MONITOR_QUERY_STATS_PROVIDER_KVM);
+    size_t i;
+
+    for (i = 0; i < virJSONValueArraySize(queried); i++) {
+        virJSONValue *result = virJSONValueArrayGet(queried, i);
+        g_autoptr(GHashTable) stats = NULL;
+        g_autofree virHashKeyValuePair *items = NULL;
+        size_t nitems;
+        size_t j;
+
+        if (STRNEQ_NULLABLE(virJSONValueObjectGetString(result, "qom-path"),
+                            qomPath))
+            continue;
+
+        if (!(stats = qemuMonitorExtractQueryStats(result)))
+            return -1;
+
+        items = virHashGetItems(stats, &nitems, true);
+
+        /* The names come from QEMU, hence they are kept in the namespace
+         * of the provider so that they can't clash with libvirt's own */
+        for (j = 0; j < nitems; j++) {
+            virJSONValue *value = (virJSONValue *) items[j].value;
+            const char *name = items[j].key;
+            unsigned long long num;
+            bool b;
+
+            if (virJSONValueGetNumberUlong(value, &num) == 0) {
+                if (virTypedParamListAddULLong(params, num, "vcpu.%zu.%s.%s",
+                                               vcpu, provider, name) < 0)
+                    return -1;
+            } else if (virJSONValueGetBoolean(value, &b) == 0) {
+                if (virTypedParamListAddBoolean(params, b, "vcpu.%zu.%s.%s",
+                                                vcpu, provider, name) < 0)
+                    return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+static int
+qemuDomainGetStatsVcpuHypervisor(virQEMUDriver *driver,
+                                 virDomainObj *dom,
+                                 virTypedParamList *params,
+                                 unsigned int privflags)
+{
+    g_autoptr(virJSONValue) queried = NULL;
+    size_t i;
+
+    if (!HAVE_JOB(privflags) || !virDomainObjIsActive(dom))
+        return 0;
+
+    if (qemuDomainGetStatsVcpuHypervisorMon(driver, dom, &queried) < 0) {
+        virResetLastError();
+        return 0;
+    }
+
+    for (i = 0; i < virDomainDefGetVcpusMax(dom->def); i++) {
+        virDomainVcpuDef *vcpu = virDomainDefGetVcpu(dom->def, i);
+        qemuDomainVcpuPrivate *vcpupriv = QEMU_DOMAIN_VCPU_PRIVATE(vcpu);
+
+        if (!vcpu->online || !vcpupriv->qomPath)
+            continue;
+
+        if (qemuDomainAddStatsFromQueryStats(params, queried,
+                                             vcpupriv->qomPath, i) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
 typedef int
 (*qemuDomainGetStatsFunc)(virQEMUDriver *driver,
                           virDomainObj *dom,
@@ -18878,6 +19239,11 @@ static virQEMUCapsFlags queryDirtyRateRequired[] = {
     QEMU_CAPS_LAST
 };
 
+static virQEMUCapsFlags queryStatsRequired[] = {
+    QEMU_CAPS_QUERY_STATS,
+    QEMU_CAPS_LAST
+};
+
 static struct qemuDomainGetStatsWorker qemuDomainGetStatsWorkers[] = {
     { qemuDomainGetStatsState, VIR_DOMAIN_STATS_STATE, false, NULL },
     { qemuDomainGetStatsCpu, VIR_DOMAIN_STATS_CPU_TOTAL, false, NULL },
@@ -18889,6 +19255,7 @@ static struct qemuDomainGetStatsWorker qemuDomainGetStatsWorkers[] = {
     { qemuDomainGetStatsIOThread, VIR_DOMAIN_STATS_IOTHREAD, true, queryIOThreadRequired },
     { qemuDomainGetStatsMemory, VIR_DOMAIN_STATS_MEMORY, false, NULL },
     { qemuDomainGetStatsDirtyRate, VIR_DOMAIN_STATS_DIRTYRATE, true, queryDirtyRateRequired },
+    { qemuDomainGetStatsVcpuHypervisor, VIR_DOMAIN_STATS_VCPU_HYPERVISOR, true, queryStatsRequired },
     { NULL, 0, false, NULL }
 };
 
@@ -18985,6 +19352,182 @@ qemuDomainGetStats(virConnectPtr conn,
 }
 
 
+/**
+ * qemuDomainGetStatsOne:
+ * @conn: connection object
+ * @vm: domain object (unlocked, caller holds a reference)
+ * @stats: requested stats groups
+ * @flags: virConnectGetAllDomainStatsFlags
+ * @record: filled with the gathered statistics record
+ *
+ * Gathers statistics for a single domain, acquiring a job if any of the
+ * requested groups needs to talk to the monitor.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int
+qemuDomainGetStatsOne(virConnectPtr conn,
+                      virDomainObj *vm,
+                      unsigned int stats,
+                      unsigned int flags,
+                      virDomainStatsRecordPtr *record)
+{
+    virQEMUDriver *driver = conn->privateData;
+    bool enforce = !!(flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS);
+    unsigned int privflags = 0;
+    unsigned int requestedStats = stats;
+    unsigned int domflags = 0;
+    int rc;
+
+    if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_BACKING)
+        domflags |= QEMU_DOMAIN_STATS_BACKING;
+
+    virObjectLock(vm);
+
+    if (qemuDomainGetStatsCheckSupport(&requestedStats, enforce, vm) < 0) {
+        virObjectUnlock(vm);
+        return -1;
+    }
+
+    if (qemuDomainGetStatsNeedMonitor(requestedStats))
+        privflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
+
+    if (HAVE_JOB(privflags)) {
+        int rv;
+
+        if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT)
+            rv = qemuDomainObjBeginJobNowait(driver, vm, VIR_JOB_QUERY);
+        else
+            rv = qemuDomainObjBeginJob(driver, vm, VIR_JOB_QUERY);
+
+        if (rv == 0)
+            domflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
+    }
+    /* else: without a job it's still possible to gather some data */
+
+    rc = qemuDomainGetStats(conn, vm, requestedStats, record, domflags);
+
+    if (HAVE_JOB(domflags))
+        qemuDomainObjEndJob(vm);
+
+    virObjectUnlock(vm);
+
+    return rc;
+}
+
+
+/**
+ * qemuDomainGetStatsPartial:
+ *
+ * Gathers the statistics of @vm which don't require talking to the
+ * monitor. Used for domains which didn't finish within the deadline
+ * set by 'stats_timeout'. The stats worker may still be holding the job
+ * and waiting for the monitor, but that doesn't prevent us from locking
+ * the domain object.
+ */
+static int
+qemuDomainGetStatsPartial(virConnectPtr conn,
+                          virDomainObj *vm,
+                          unsigned int stats,
+                          unsigned int flags,
+                          virDomainStatsRecordPtr *record)
+{
+    unsigned int requestedStats = stats;
+    unsigned int domflags = 0;
+    int rc;
+
+    if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_BACKING)
+        domflags |= QEMU_DOMAIN_STATS_BACKING;
+
+    virObjectLock(vm);
+
+    ignore_value(qemuDomainGetStatsCheckSupport(&requestedStats, false, vm));
+
+    rc = qemuDomainGetStats(conn, vm, requestedStats, record, domflags);
+
+    virObjectUnlock(vm);
+
+    return rc;
+}
+
+
+typedef struct _qemuDomainGetStatsParallelArgs qemuDomainGetStatsParallelArgs;
+struct _qemuDomainGetStatsParallelArgs {
+    virConnectPtr conn;
+    unsigned int stats;
+    unsigned int flags;
+};
+
+
+static void
+qemuDomainGetStatsParallelArgsFree(void *opaque)
+{
+    qemuDomainGetStatsParallelArgs *args = opaque;
+
+    virObjectUnref(args->conn);
+    g_free(args);
+}
+
+
+static int
+qemuDomainGetStatsParallelCollect(virDomainObj *vm,
+                                  virDomainStatsRecordPtr *record,
+                                  void *opaque)
+{
+    qemuDomainGetStatsParallelArgs *args = opaque;
+
+    return qemuDomainGetStatsOne(args->conn, vm, args->stats,
+                                 args->flags, record);
+}
+
+
+static int
+qemuDomainGetStatsParallelPartial(virDomainObj *vm,
+                                  virDomainStatsRecordPtr *record,
+                                  void *opaque)
+{
+    qemuDomainGetStatsParallelArgs *args = opaque;
+
+    return qemuDomainGetStatsPartial(args->conn, vm, args->stats,
+                                     args->flags, record);
+}
+
+
+/**
+ * qemuConnectGetAllDomainStatsParallel:
+ *
+ * Gathers statistics of @vms using the stats worker pool. Domains which
+ * aren't done within 'stats_timeout' milliseconds after the call started
+ * are reported with partial statistics only.
+ *
+ * Returns number of records stored into @retStats (which must be able to
+ * hold @nvms records) or -1 on error.
+ */
+static int
+qemuConnectGetAllDomainStatsParallel(virConnectPtr conn,
+                                     virDomainObj **vms,
+                                     size_t nvms,
+                                     unsigned int stats,
+                                     unsigned int flags,
+                                     virDomainStatsRecordPtr *retStats)
+{
+    virQEMUDriver *driver = conn->privateData;
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+    qemuDomainGetStatsParallelArgs *args = g_new0(qemuDomainGetStatsParallelArgs, 1);
+
+    args->conn = virObjectRef(conn);
+    args->stats = stats;
+    args->flags = flags;
+
+    return qemuStatsCollectParallel(driver->statsPool, vms, nvms,
+                                    cfg->statsTimeout,
+                                    qemuDomainGetStatsParallelCollect,
+                                    qemuDomainGetStatsParallelPartial,
+                                    args, qemuDomainGetStatsParallelArgsFree,
+                                    retStats);
+}
+
+
 static int
 qemuConnectGetAllDomainStats(virConnectPtr conn,
                              virDomainPtr *doms,
@@ -18998,7 +19541,6 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
     virDomainObj **vms = NULL;
     size_t nvms;
     virDomainStatsRecordPtr *tmpstats = NULL;
-    bool enforce = !!(flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_ENFORCE_STATS);
     int nstats = 0;
     size_t i;
     int ret = -1;
@@ -19030,62 +19572,118 @@ qemuConnectGetAllDomainStats(virConnectPtr conn,
 
     tmpstats = g_new0(virDomainStatsRecordPtr, nvms + 1);
 
-    for (i = 0; i < nvms; i++) {
-        virDomainObj *vm = vms[i];
-        virDomainStatsRecordPtr tmp = NULL;
-        unsigned int privflags = 0;
-        unsigned int requestedStats = stats;
-        unsigned int domflags = 0;
-        int rc;
-
-        if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_BACKING)
-            domflags |= QEMU_DOMAIN_STATS_BACKING;
+    if (driver->statsPool && nvms > 1) {
+        if ((nstats = qemuConnectGetAllDomainStatsParallel(conn, vms, nvms,
+                                                           stats, flags,
+                                                           tmpstats)) < 0)
+            goto cleanup;
+    } else {
+        for (i = 0; i < nvms; i++) {
+            virDomainStatsRecordPtr tmp = NULL;
 
-        virObjectLock(vm);
+            if (qemuDomainGetStatsOne(conn, vms[i], stats, flags, &tmp) < 0)
+                goto cleanup;
 
-        if (qemuDomainGetStatsCheckSupport(&requestedStats, enforce, vm) < 0) {
-            virObjectUnlock(vm);
-            goto cleanup;
+            tmpstats[nstats++] = tmp;
         }
+    }
 
-        if (qemuDomainGetStatsNeedMonitor(requestedStats))
-            privflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
+    *retStats = g_steal_pointer(&tmpstats);
 
-        if (HAVE_JOB(privflags)) {
-            int rv;
+    ret = nstats;
 
-            if (flags & VIR_CONNECT_GET_ALL_DOMAINS_STATS_NOWAIT)
-                rv = qemuDomainObjBeginJobNowait(driver, vm, VIR_JOB_QUERY);
-            else
-                rv = qemuDomainObjBeginJob(driver, vm, VIR_JOB_QUERY);
+ cleanup:
+    virErrorPreserveLast(&orig_err);
+    virDomainStatsRecordListFree(tmpstats);
+    virObjectListFreeCount(vms, nvms);
+    virErrorRestore(&orig_err);
 
-            if (rv == 0)
-                domflags |= QEMU_DOMAIN_STATS_HAVE_JOB;
-        }
-        /* else: without a job it's still possible to gather some data */
+    return ret;
+}
+
+
+static int
+qemuDomainListGetInfoOne(virConnectPtr conn,
+                         virQEMUDriver *driver,
+                         virDomainObj *vm,
+                         unsigned int fields,
+                         unsigned int flags,
+                         virDomainStatsRecordPtr *record)
+{
+    virDomainInfo info = { 0 };
+    g_autofree char *xml = NULL;
+
+    if ((fields & VIR_DOMAIN_LIST_INFO_BASIC) &&
+        qemuDomainObjGetInfo(vm, &info) < 0)
+        return -1;
+
+    if ((fields & VIR_DOMAIN_LIST_INFO_XML) &&
+        !(xml = qemuDomainObjGetXMLDesc(driver, vm, flags)))
+        return -1;
+
+    return virDomainDriverListInfoRecord(conn, vm, fields, &info, xml, record);
+}
+
+
+static int
+qemuDomainListGetInfo(virConnectPtr conn,
+                      virDomainPtr *doms,
+                      unsigned int ndoms,
+                      unsigned int fields,
+                      virDomainStatsRecordPtr **retInfo,
+                      unsigned int flags)
+{
+    virQEMUDriver *driver = conn->privateData;
+    virDomainObj **vms = NULL;
+    size_t nvms;
+    virDomainStatsRecordPtr *tmpinfo = NULL;
+    int ninfo = 0;
+    size_t i;
+    int ret = -1;
+
+    virCheckFlags(VIR_DOMAIN_XML_COMMON_FLAGS | VIR_DOMAIN_XML_UPDATE_CPU, -1);
 
-        rc = qemuDomainGetStats(conn, vm, requestedStats, &tmp, domflags);
+    if (virDomainListGetInfoEnsureACL(conn) < 0)
+        return -1;
+
+    if (!fields)
+        fields = VIR_DOMAIN_DRIVER_LIST_INFO_ALL;
+
+    if (virDomainObjListConvert(driver->domains, conn, doms, ndoms, &vms,
+                                &nvms, NULL, 0, true) < 0)
+        return -1;
 
-        if (HAVE_JOB(domflags))
-            qemuDomainObjEndJob(vm);
+    tmpinfo = g_new0(virDomainStatsRecordPtr, nvms + 1);
 
+    /* Every domain is locked just once to gather all requested data,
+     * without starting any job. */
+    for (i = 0; i < nvms; i++) {
+        virDomainObj *vm = vms[i];
+        int rc;
+
+        virObjectLock(vm);
+
+        if (!virDomainListGetInfoCheckACL(conn, vm->def, flags)) {
+            virObjectUnlock(vm);
+            continue;
+        }
+
+        rc = qemuDomainListGetInfoOne(conn, driver, vm, fields, flags,
+                                      &tmpinfo[ninfo]);
         virObjectUnlock(vm);
 
         if (rc < 0)
             goto cleanup;
 
-        tmpstats[nstats++] = tmp;
+        ninfo++;
     }
 
-    *retStats = g_steal_pointer(&tmpstats);
-
-    ret = nstats;
+    *retInfo = g_steal_pointer(&tmpinfo);
+    ret = ninfo;
 
  cleanup:
-    virErrorPreserveLast(&orig_err);
-    virDomainStatsRecordListFree(tmpstats);
+    virDomainStatsRecordListFree(tmpinfo);
     virObjectListFreeCount(vms, nvms);
-    virErrorRestore(&orig_err);
 
     return ret;
 }
@@ -21257,6 +21855,7 @@ static virHypervisorDriver qemuHypervisorDriver = {
     .nodeGetFreePages = qemuNodeGetFreePages, /* 1.2.6 */
     .connectGetDomainCapabilities = qemuConnectGetDomainCapabilities, /* 1.2.7 */
     .connectGetAllDomainStats = qemuConnectGetAllDomainStats, /* 1.2.8 */
+    .domainListGetInfo = qemuDomainListGetInfo, /* 8.6.0 */
     .nodeAllocPages = qemuNodeAllocPages, /* 1.2.9 */
     .domainGetFSInfo = qemuDomainGetFSInfo, /* 1.2.11 */
     .domainInterfaceAddresses = qemuDomainInterfaceAddresses, /* 1.2.14 */
@@ -21307,6 +21906,7 @@ static virStateDriver qemuStateDriver = {
     .stateStop = qemuStateStop,
     .stateShutdownPrepare = qemuStateShutdownPrepare,
     .stateShutdownWait = qemuStateShutdownWait,
+    .stateGetStats = qemuStateGetStats,
 };
 
 int qemuRegister(void)
@@ -0,0 +1,606 @@
+/*
+ * qemu_hugepages.c: accounting of huge pages used by QEMU domains
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "qemu_hugepages.h"
+#define LIBVIRT_QEMU_HUGEPAGESPRIV_H_ALLOW
+#include "qemu_hugepagespriv.h"
+#include "virerror.h"
+#include "virlog.h"
+#include "virnuma.h"
+#include "virutil.h"
+#include "viruuid.h"
+
+#define VIR_FROM_THIS VIR_FROM_QEMU
+
+VIR_LOG_INIT("qemu.qemu_hugepages");
+
+
+static virClass *qemuHugepagesClass;
+
+static void qemuHugepagesDispose(void *obj);
+
+static int
+qemuHugepagesOnceInit(void)
+{
+    if (!VIR_CLASS_NEW(qemuHugepages, virClassForObjectLockable()))
+        return -1;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(qemuHugepages);
+
+
+static void
+qemuHugepagesDomainFree(void *opaque)
+{
+    qemuHugepagesDomain *dom = opaque;
+
+    if (!dom)
+        return;
+
+    g_free(dom->reservations);
+    g_free(dom);
+}
+
+
+qemuHugepages *
+qemuHugepagesNew(void)
+{
+    qemuHugepages *hugepages;
+
+    if (qemuHugepagesInitialize() < 0)
+        return NULL;
+
+    if (!(hugepages = virObjectLockableNew(qemuHugepagesClass)))
+        return NULL;
+
+    hugepages->domains = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                               qemuHugepagesDomainFree);
+
+    return hugepages;
+}
+
+
+static void
+qemuHugepagesDispose(void *obj)
+{
+    qemuHugepages *hugepages = obj;
+
+    g_clear_pointer(&hugepages->domains, g_hash_table_unref);
+}
+
+
+/*
+ * Get the size of huge pages backing guest NUMA node @cell (-1 if the
+ * guest has no NUMA nodes) in KiB, or 0 if the node is not backed by
+ * huge pages.
+ */
+static unsigned int
+qemuHugepagesGetPageSize(virDomainDef *def,
+                         int cell,
+                         unsigned int defaultPageSize)
+{
+    virDomainHugePage *master = NULL;
+    virDomainHugePage *hugepage = NULL;
+    size_t i;
+
+    for (i = 0; i < def->mem.nhugepages; i++) {
+        virDomainHugePage *tmp = &def->mem.hugepages[i];
+
+        if (!tmp->nodemask) {
+            master = tmp;
+            continue;
+        }
+
+        if (cell >= 0 && virBitmapIsBitSet(tmp->nodemask, cell)) {
+            hugepage = tmp;
+            break;
+        }
+    }
+
+    if (!hugepage)
+        hugepage = master;
+
+    if (!hugepage ||
+        hugepage->size == virGetSystemPageSizeKB())
+        return 0;
+
+    if (hugepage->size == 0)
+        return defaultPageSize;
+
+    return hugepage->size;
+}
+
+
+/*
+ * Get the host nodes the memory of guest NUMA node @cell (-1 for the
+ * whole guest) is bound to, and whether they are a hard limit. Only the
+ * strict and restrictive modes confine the memory to the nodeset, the
+ * others merely make the kernel prefer it.
+ */
+static int
+qemuHugepagesGetNodeset(virDomainDef *def,
+                        virBitmap *autoNodeset,
+                        int cell,
+                        virBitmap **nodeset,
+                        bool *strict)
+{
+    virDomainNumatuneMemMode mode;
+
+    if (virDomainNumatuneMaybeGetNodeset(def->numa, autoNodeset,
+                                         nodeset, cell) < 0)
+        return -1;
+
+    *strict = virDomainNumatuneGetMode(def->numa, cell, &mode) < 0 ||
+              mode == VIR_DOMAIN_NUMATUNE_MEM_STRICT ||
+              mode == VIR_DOMAIN_NUMATUNE_MEM_RESTRICTIVE;
+
+    return 0;
+}
+
+
+static void
+qemuHugepagesAddDemand(qemuHugepagesDemand **demands,
+                       size_t *ndemands,
+                       unsigned int pagesize,
+                       virBitmap *nodeset,
+                       bool strict,
+                       unsigned long long memory)
+{
+    qemuHugepagesDemand demand = { .pagesize = pagesize, .nodeset = nodeset,
+                                   .strict = strict };
+    size_t i;
+
+    if (pagesize == 0 || memory == 0)
+        return;
+
+    for (i = 0; i < *ndemands; i++) {
+        if ((*demands)[i].pagesize == pagesize &&
+            (*demands)[i].strict == strict &&
+            virBitmapEqual((*demands)[i].nodeset, nodeset)) {
+            (*demands)[i].pages += VIR_DIV_UP(memory, pagesize);
+            return;
+        }
+    }
+
+    demand.pages = VIR_DIV_UP(memory, pagesize);
+    VIR_APPEND_ELEMENT(*demands, *ndemands, demand);
+}
+
+
+/*
+ * Compute the huge pages domain @def needs, grouped by page size and by
+ * the host nodes they may come from. The nodesets of the demands
+ * belong to @def or @autoNodeset.
+ */
+int
+qemuHugepagesGetDemands(virDomainDef *def,
+                        virBitmap *autoNodeset,
+                        unsigned int defaultPageSize,
+                        qemuHugepagesDemand **demands,
+                        size_t *ndemands)
+{
+    size_t ncells = virDomainNumaGetNodeCount(def->numa);
+    virBitmap *nodeset;
+    bool strict;
+    unsigned int pagesize;
+    size_t i;
+
+    if (ncells == 0 &&
+        (pagesize = qemuHugepagesGetPageSize(def, -1, defaultPageSize)) != 0) {
+        if (qemuHugepagesGetNodeset(def, autoNodeset, -1,
+                                    &nodeset, &strict) < 0)
+            return -1;
+
+        qemuHugepagesAddDemand(demands, ndemands, pagesize, nodeset, strict,
+                               virDomainDefGetMemoryInitial(def));
+    }
+
+    for (i = 0; i < ncells; i++) {
+        if ((pagesize = qemuHugepagesGetPageSize(def, i, defaultPageSize)) == 0)
+            continue;
+
+        if (qemuHugepagesGetNodeset(def, autoNodeset, i, &nodeset, &strict) < 0)
+            return -1;
+
+        qemuHugepagesAddDemand(demands, ndemands, pagesize, nodeset, strict,
+                               virDomainNumaGetNodeMemorySize(def->numa, i));
+    }
+
+    for (i = 0; i < def->nmems; i++) {
+        virDomainMemoryDef *mem = def->mems[i];
+
+        if (mem->model != VIR_DOMAIN_MEMORY_MODEL_DIMM)
+            continue;
+
+        if ((pagesize = mem->pagesize) == 0)
+            pagesize = qemuHugepagesGetPageSize(def, mem->targetNode,
+                                                defaultPageSize);
+
+        if (pagesize == 0 || pagesize == virGetSystemPageSizeKB())
+            continue;
+
+        if (qemuHugepagesGetNodeset(def, autoNodeset, mem->targetNode,
+                                    &nodeset, &strict) < 0)
+            return -1;
+
+        /* The source nodes of the module override those of its guest
+         * node, the mode still applies to them */
+        if (mem->sourceNodes)
+            nodeset = mem->sourceNodes;
+
+        qemuHugepagesAddDemand(demands, ndemands, pagesize, nodeset, strict,
+                               mem->size);
+    }
+
+    return 0;
+}
+
+
+/*
+ * List the host NUMA nodes huge pages of @nodeset can come from, or
+ * just -1 if the host has no NUMA. Unless @strict is true the nodes out
+ * of @nodeset follow those in it, as the kernel falls back to them once
+ * the preferred ones are exhausted.
+ */
+static int
+qemuHugepagesGetNodes(virBitmap *nodeset,
+                      bool strict,
+                      int **retnodes,
+                      size_t *retnnodes)
+{
+    g_autofree int *nodes = NULL;
+    size_t nnodes = 0;
+    int maxnode;
+    int n;
+
+    if (!virNumaIsAvailable()) {
+        nodes = g_new0(int, 1);
+        nodes[nnodes++] = -1;
+        goto done;
+    }
+
+    if ((maxnode = virNumaGetMaxNode()) < 0)
+        return -1;
+
+    nodes = g_new0(int, maxnode + 1);
+
+    for (n = 0; n <= maxnode; n++) {
+        if (!virNumaNodeIsAvailable(n))
+            continue;
+
+        if (nodeset && !virBitmapIsBitSet(nodeset, n))
+            continue;
+
+        nodes[nnodes++] = n;
+    }
+
+    for (n = 0; nodeset && !strict && n <= maxnode; n++) {
+        if (virNumaNodeIsAvailable(n) && !virBitmapIsBitSet(nodeset, n))
+            nodes[nnodes++] = n;
+    }
+
+    if (nnodes == 0) {
+        virReportError(VIR_ERR_OPERATION_FAILED, "%s",
+                       _("no host NUMA node to allocate huge pages from"));
+        return -1;
+    }
+
+ done:
+    *retnodes = g_steal_pointer(&nodes);
+    *retnnodes = nnodes;
+    return 0;
+}
+
+
+/* Must be called with @hugepages locked */
+static unsigned long long
+qemuHugepagesGetReservedLocked(qemuHugepages *hugepages,
+                               int node,
+                               unsigned int pagesize)
+{
+    unsigned long long ret = 0;
+    GHashTableIter iter;
+    gpointer value;
+    size_t i;
+
+    g_hash_table_iter_init(&iter, hugepages->domains);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        qemuHugepagesDomain *dom = value;
+
+        for (i = 0; i < dom->nreservations; i++) {
+            qemuHugepagesReservation *res = &dom->reservations[i];
+
+            if (res->pagesize == pagesize &&
+                (node == -1 || res->node == node))
+                ret += res->pages;
+        }
+    }
+
+    return ret;
+}
+
+
+/*
+ * Get how many pages of @pagesize the pool of @node holds that no
+ * domain was given yet. Pages of running domains are not free once
+ * the domains touch them, while pages of the pool taken by anything
+ * else are not reserved, so the smaller of the two counts is what can
+ * be given to a new domain. If @fresh is false the free pages of the
+ * pool are not looked at, e.g. because the domain being accounted for
+ * already holds its pages.
+ */
+static int
+qemuHugepagesGetUnreserved(qemuHugepages *hugepages,
+                           int node,
+                           unsigned int pagesize,
+                           bool fresh,
+                           unsigned long long *unreserved)
+{
+    unsigned long long pool = 0;
+    unsigned long long nfree = 0;
+    unsigned long long reserved;
+
+    if (virNumaGetPageInfo(node, pagesize, 0, &pool, &nfree) < 0)
+        return -1;
+
+    reserved = qemuHugepagesGetReservedLocked(hugepages, node, pagesize);
+
+    *unreserved = pool > reserved ? pool - reserved : 0;
+    if (fresh)
+        *unreserved = MIN(*unreserved, nfree);
+
+    return 0;
+}
+
+
+static void
+qemuHugepagesDomainAdd(qemuHugepagesDomain *dom,
+                       int node,
+                       unsigned int pagesize,
+                       unsigned long long pages)
+{
+    qemuHugepagesReservation res = { .node = node, .pagesize = pagesize,
+                                     .pages = pages };
+    size_t i;
+
+    if (pages == 0)
+        return;
+
+    for (i = 0; i < dom->nreservations; i++) {
+        if (dom->reservations[i].node == node &&
+            dom->reservations[i].pagesize == pagesize) {
+            dom->reservations[i].pages += pages;
+            return;
+        }
+    }
+
+    VIR_APPEND_ELEMENT(dom->reservations, dom->nreservations, res);
+}
+
+
+/* Must be called with @hugepages locked and @dom in its record */
+static int
+qemuHugepagesReserveDemand(qemuHugepages *hugepages,
+                           virDomainDef *def,
+                           qemuHugepagesDomain *dom,
+                           qemuHugepagesDemand *demand,
+                           unsigned int flags)
+{
+    bool check = !!(flags & QEMU_HUGEPAGES_RESERVE_CHECK);
+    g_autofree int *nodes = NULL;
+    g_autofree char *nodesetstr = NULL;
+    unsigned long long left = demand->pages;
+    unsigned long long unreserved;
+    size_t nnodes = 0;
+    size_t i;
+
+    if (qemuHugepagesGetNodes(demand->nodeset, demand->strict,
+                              &nodes, &nnodes) < 0)
+        return -1;
+
+    for (i = 0; i < nnodes && left > 0; i++) {
+        unsigned long long pages;
+
+        if (qemuHugepagesGetUnreserved(hugepages, nodes[i], demand->pagesize,
+                                       check, &unreserved) < 0)
+            return -1;
+
+        pages = MIN(left, unreserved);
+        qemuHugepagesDomainAdd(dom, nodes[i], demand->pagesize, pages);
+        left -= pages;
+    }
+
+    if (left > 0 && check && (flags & QEMU_HUGEPAGES_RESERVE_GROW)) {
+        for (i = 0; i < nnodes && left > 0; i++) {
+            unsigned long long pages;
+
+            /* The kernel may allocate fewer pages than asked for, take
+             * whatever made it into the pool */
+            if (virNumaSetPagePoolSize(nodes[i], demand->pagesize,
+                                       left, true) < 0) {
+                VIR_WARN("Unable to grow pool of %u KiB huge pages on node %d: %s",
+                         demand->pagesize, nodes[i], virGetLastErrorMessage());
+                virResetLastError();
+            }
+
+            if (qemuHugepagesGetUnreserved(hugepages, nodes[i], demand->pagesize,
+                                           check, &unreserved) < 0)
+                return -1;
+
+            pages = MIN(left, unreserved);
+            qemuHugepagesDomainAdd(dom, nodes[i], demand->pagesize, pages);
+            left -= pages;
+        }
+    }
+
+    if (left == 0)
+        return 0;
+
+    if (!check) {
+        /* The domain holds its pages already, even if the pools were
+         * shrunk or something else took them meanwhile */
+        qemuHugepagesDomainAdd(dom, nodes[0], demand->pagesize, left);
+        return 0;
+    }
+
+    if (demand->nodeset && demand->strict)
+        nodesetstr = virBitmapFormat(demand->nodeset);
+
+    virReportError(VIR_ERR_OPERATION_FAILED,
+                   _("not enough free huge pages of size %u KiB for domain '%s' on host NUMA nodes '%s': %llu more needed"),
+                   demand->pagesize, def->name,
+                   NULLSTR_STAR(nodesetstr), left);
+    return -1;
+}
+
+
+/**
+ * qemuHugepagesReserve:
+ * @hugepages: huge pages record
+ * @def: domain definition
+ * @autoNodeset: nodeset of automatic NUMA placement, may be NULL
+ * @defaultPageSize: size of default huge pages in KiB
+ * @flags: bitwise-OR of qemuHugepagesReserveFlags
+ *
+ * Records the huge pages domain @def is backed by as given to it from
+ * the pools of the host NUMA nodes its memory is bound to, replacing any
+ * previous record of it. With QEMU_HUGEPAGES_RESERVE_CHECK an error is
+ * reported if the pools don't hold enough pages no other domain was
+ * given, unless QEMU_HUGEPAGES_RESERVE_GROW is passed as well and the
+ * pools can be grown. Without QEMU_HUGEPAGES_RESERVE_CHECK the domain
+ * is assumed to hold its pages already, e.g. when reconnecting to it.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+qemuHugepagesReserve(qemuHugepages *hugepages,
+                     virDomainDef *def,
+                     virBitmap *autoNodeset,
+                     unsigned int defaultPageSize,
+                     unsigned int flags)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(hugepages);
+    char uuidstr[VIR_UUID_STRING_BUFLEN];
+    g_autofree qemuHugepagesDemand *demands = NULL;
+    size_t ndemands = 0;
+    qemuHugepagesDomain *dom;
+    size_t i;
+
+    virUUIDFormat(def->uuid, uuidstr);
+    g_hash_table_remove(hugepages->domains, uuidstr);
+
+    if (qemuHugepagesGetDemands(def, autoNodeset, defaultPageSize,
+                                &demands, &ndemands) < 0)
+        return -1;
+
+    if (ndemands == 0)
+        return 0;
+
+    /* Pages given to the domain for one demand must not be counted as
+     * unreserved for the next one, so record the domain right away */
+    dom = g_new0(qemuHugepagesDomain, 1);
+    g_hash_table_insert(hugepages->domains, g_strdup(uuidstr), dom);
+
+    for (i = 0; i < ndemands; i++) {
+        if (qemuHugepagesReserveDemand(hugepages, def, dom,
+                                       &demands[i], flags) < 0) {
+            g_hash_table_remove(hugepages->domains, uuidstr);
+            return -1;
+        }
+    }
+
+    for (i = 0; i < dom->nreservations; i++) {
+        VIR_DEBUG("Domain '%s' holds %llu huge pages of %u KiB on node %d",
+                  def->name, dom->reservations[i].pages,
+                  dom->reservations[i].pagesize, dom->reservations[i].node);
+    }
+
+    return 0;
+}
+
+
+/**
+ * qemuHugepagesRelease:
+ * @hugepages: huge pages record
+ * @def: domain definition
+ *
+ * Drops the record of huge pages held by domain @def, e.g. because it
+ * stopped. Pools grown for the domain are left as they are.
+ */
+void
+qemuHugepagesRelease(qemuHugepages *hugepages,
+                     virDomainDef *def)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(hugepages);
+    char uuidstr[VIR_UUID_STRING_BUFLEN];
+
+    virUUIDFormat(def->uuid, uuidstr);
+
+    g_hash_table_remove(hugepages->domains, uuidstr);
+}
+
+
+/**
+ * qemuHugepagesAdjustFreePages:
+ * @hugepages: huge pages record
+ * @npages: number of page sizes in @pages
+ * @pages: page sizes in KiB
+ * @startCell: host NUMA node the first of @counts are for
+ * @counts: free pages as returned by virHostMemGetFreePages()
+ * @ncounts: number of items in @counts
+ *
+ * Lowers @counts, holding the free pages of every size in @pages for
+ * each node from @startCell on, so that pages running domains hold but
+ * didn't touch yet are not counted as free.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+qemuHugepagesAdjustFreePages(qemuHugepages *hugepages,
+                             unsigned int npages,
+                             unsigned int *pages,
+                             int startCell,
+                             unsigned long long *counts,
+                             size_t ncounts)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(hugepages);
+    size_t i;
+
+    for (i = 0; i < ncounts; i++) {
+        /* Without NUMA the pages are accounted for the whole host */
+        int node = virNumaIsAvailable() ? startCell + i / npages : -1;
+        unsigned int pagesize = pages[i % npages];
+        unsigned long long reserved;
+        unsigned long long pool;
+
+        if ((reserved = qemuHugepagesGetReservedLocked(hugepages, node,
+                                                       pagesize)) == 0)
+            continue;
+
+        if (virNumaGetPageInfo(node, pagesize, 0, &pool, NULL) < 0)
+            return -1;
+
+        counts[i] = MIN(counts[i], pool > reserved ? pool - reserved : 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * qemu_hugepages.h: accounting of huge pages used by QEMU domains
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "internal.h"
+#include "virbitmap.h"
+#include "domain_conf.h"
+
+typedef enum {
+    /* fail if the pools can't hold the pages of the domain */
+    QEMU_HUGEPAGES_RESERVE_CHECK = 1 << 0,
+    /* grow the pools which can't hold the pages of the domain */
+    QEMU_HUGEPAGES_RESERVE_GROW = 1 << 1,
+} qemuHugepagesReserveFlags;
+
+typedef struct _qemuHugepages qemuHugepages;
+
+qemuHugepages *qemuHugepagesNew(void);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(qemuHugepages, virObjectUnref);
+
+int qemuHugepagesReserve(qemuHugepages *hugepages,
+                         virDomainDef *def,
+                         virBitmap *autoNodeset,
+                         unsigned int defaultPageSize,
+                         unsigned int flags);
+void qemuHugepagesRelease(qemuHugepages *hugepages,
+                          virDomainDef *def);
+
+int qemuHugepagesAdjustFreePages(qemuHugepages *hugepages,
+                                 unsigned int npages,
+                                 unsigned int *pages,
+                                 int startCell,
+                                 unsigned long long *counts,
+                                 size_t ncounts);
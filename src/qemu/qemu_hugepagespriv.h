@@ -0,0 +1,73 @@
+/*
+ * qemu_hugepagespriv.h: private declarations for huge pages accounting
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBVIRT_QEMU_HUGEPAGESPRIV_H_ALLOW
+# error "qemu_hugepagespriv.h may only be included by qemu_hugepages.c or test suites"
+#endif /* LIBVIRT_QEMU_HUGEPAGESPRIV_H_ALLOW */
+
+#pragma once
+
+#include "qemu_hugepages.h"
+
+/*
+ * This header file should never be used outside unit tests.
+ */
+
+typedef struct _qemuHugepagesReservation qemuHugepagesReservation;
+struct _qemuHugepagesReservation {
+    int node; /* -1 if the host has no NUMA */
+    unsigned int pagesize; /* in KiB */
+    unsigned long long pages;
+};
+
+
+typedef struct _qemuHugepagesDomain qemuHugepagesDomain;
+struct _qemuHugepagesDomain {
+    qemuHugepagesReservation *reservations;
+    size_t nreservations;
+};
+
+
+/* Huge pages a domain needs from a set of host NUMA nodes */
+typedef struct _qemuHugepagesDemand qemuHugepagesDemand;
+struct _qemuHugepagesDemand {
+    unsigned int pagesize; /* in KiB */
+    virBitmap *nodeset; /* NULL if any node will do */
+    bool strict; /* false if @nodeset is merely preferred */
+    unsigned long long pages;
+};
+
+
+/*
+ * Record of the huge pages every running domain was given from the
+ * pools of the host, so that starting a domain can tell whether the
+ * pools still hold enough pages for it even if the domains already
+ * running didn't touch all of theirs yet.
+ */
+struct _qemuHugepages {
+    virObjectLockable parent;
+
+    GHashTable *domains; /* UUID string -> qemuHugepagesDomain */
+};
+
+
+int qemuHugepagesGetDemands(virDomainDef *def,
+                            virBitmap *autoNodeset,
+                            unsigned int defaultPageSize,
+                            qemuHugepagesDemand **demands,
+                            size_t *ndemands);
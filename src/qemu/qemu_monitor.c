@@ -4447,6 +4447,94 @@ qemuMonitorQueryDirtyRate(qemuMonitor *mon,
 }
 
 
+VIR_ENUM_IMPL(qemuMonitorQueryStatsTarget,
+              QEMU_MONITOR_QUERY_STATS_TARGET_LAST,
+              "vm",
+              "vcpu",
+);
+
+
+VIR_ENUM_IMPL(qemuMonitorQueryStatsProvider,
+              QEMU_MONITOR_QUERY_STATS_PROVIDER_LAST,
+              "kvm",
+);
+
+
+/**
+ * qemuMonitorQueryStats:
+ * @mon: monitor object
+ * @target: the type of object to query statistics of
+ * @vcpus: NULL-terminated list of vCPU QOM paths, NULL for all vCPUs
+ * @provider: statistics provider
+ *
+ * Retrieves statistics of all objects of @target type from a single
+ * 'query-stats' command.
+ *
+ * Returns the array of StatsResult objects or NULL on error.
+ */
+virJSONValue *
+qemuMonitorQueryStats(qemuMonitor *mon,
+                      qemuMonitorQueryStatsTargetType target,
+                      char **vcpus,
+                      qemuMonitorQueryStatsProviderType provider)
+{
+    VIR_DEBUG("target=%u vcpus=%p provider=%u", target, vcpus, provider);
+
+    QEMU_CHECK_MONITOR_NULL(mon);
+
+    if (target != QEMU_MONITOR_QUERY_STATS_TARGET_VCPU && vcpus) {
+        virReportError(VIR_ERR_INVALID_ARG, "%s",
+                       _("Cannot query vCPU statistics for a non-vCPU target"));
+        return NULL;
+    }
+
+    return qemuMonitorJSONQueryStats(mon, target, vcpus, provider);
+}
+
+
+/**
+ * qemuMonitorExtractQueryStats:
+ * @info: a single StatsResult object returned by 'query-stats'
+ *
+ * Returns a hash table mapping names of the statistics in @info to their
+ * values. The values are borrowed from @info. Histograms (array values)
+ * are omitted as libvirt doesn't report them.
+ */
+GHashTable *
+qemuMonitorExtractQueryStats(virJSONValue *info)
+{
+    g_autoptr(GHashTable) ret = virHashNew(NULL);
+    virJSONValue *stats;
+    size_t i;
+
+    if (!(stats = virJSONValueObjectGetArray(info, "stats"))) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("query-stats reply was missing 'stats' data"));
+        return NULL;
+    }
+
+    for (i = 0; i < virJSONValueArraySize(stats); i++) {
+        virJSONValue *stat = virJSONValueArrayGet(stats, i);
+        virJSONValue *value;
+        const char *name;
+
+        if (!(name = virJSONValueObjectGetString(stat, "name")) ||
+            !(value = virJSONValueObjectGet(stat, "value"))) {
+            virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                           _("query-stats reply was malformed"));
+            return NULL;
+        }
+
+        if (virJSONValueGetType(value) == VIR_JSON_TYPE_ARRAY)
+            continue;
+
+        g_hash_table_insert(ret, g_strdup(name), value);
+    }
+
+    return g_steal_pointer(&ret);
+}
+
+
 int
 qemuMonitorSetAction(qemuMonitor *mon,
                      qemuMonitorActionShutdown shutdown,
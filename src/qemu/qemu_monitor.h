@@ -1528,6 +1528,32 @@ int
 qemuMonitorQueryDirtyRate(qemuMonitor *mon,
                           qemuMonitorDirtyRateInfo *info);
 
+typedef enum {
+    QEMU_MONITOR_QUERY_STATS_TARGET_VM,
+    QEMU_MONITOR_QUERY_STATS_TARGET_VCPU,
+
+    QEMU_MONITOR_QUERY_STATS_TARGET_LAST
+} qemuMonitorQueryStatsTargetType;
+
+VIR_ENUM_DECL(qemuMonitorQueryStatsTarget);
+
+typedef enum {
+    QEMU_MONITOR_QUERY_STATS_PROVIDER_KVM,
+
+    QEMU_MONITOR_QUERY_STATS_PROVIDER_LAST
+} qemuMonitorQueryStatsProviderType;
+
+VIR_ENUM_DECL(qemuMonitorQueryStatsProvider);
+
+virJSONValue *
+qemuMonitorQueryStats(qemuMonitor *mon,
+                      qemuMonitorQueryStatsTargetType target,
+                      char **vcpus,
+                      qemuMonitorQueryStatsProviderType provider);
+
+GHashTable *
+qemuMonitorExtractQueryStats(virJSONValue *info);
+
 int
 qemuMonitorSetAction(qemuMonitor *mon,
                      qemuMonitorActionShutdown shutdown,
@@ -194,7 +194,20 @@ qemuMonitorJSONIOProcessLine(qemuMonitor *mon,
 
     VIR_DEBUG("Line [%s]", line);
 
-    if (!(obj = virJSONValueFromString(line)))
+    if (msg && msg->rxFilter) {
+        /* Only the reply to the command can be parsed selectively. Events
+         * and the greeting don't contain 'return' or 'error' and need to
+         * be parsed in full. */
+        if (!(obj = virJSONValueFromStringFiltered(line, msg->rxFilter)))
+            return -1;
+
+        if (virJSONValueObjectHasKey(obj, "return") != 1 &&
+            virJSONValueObjectHasKey(obj, "error") != 1)
+            g_clear_pointer(&obj, virJSONValueFree);
+    }
+
+    if (!obj &&
+        !(obj = virJSONValueFromString(line)))
         return -1;
 
     if (virJSONValueGetType(obj) != VIR_JSON_TYPE_OBJECT) {
@@ -257,10 +270,11 @@ int qemuMonitorJSONIOProcess(qemuMonitor *mon,
 }
 
 static int
-qemuMonitorJSONCommandWithFd(qemuMonitor *mon,
-                             virJSONValue *cmd,
-                             int scm_fd,
-                             virJSONValue **reply)
+qemuMonitorJSONCommandFull(qemuMonitor *mon,
+                           virJSONValue *cmd,
+                           int scm_fd,
+                           const char *const *filter,
+                           virJSONValue **reply)
 {
     int ret = -1;
     qemuMonitorMessage msg;
@@ -269,6 +283,7 @@ qemuMonitorJSONCommandWithFd(qemuMonitor *mon,
     *reply = NULL;
 
     memset(&msg, 0, sizeof(msg));
+    msg.rxFilter = filter;
 
     if (virJSONValueObjectHasKey(cmd, "execute") == 1) {
         g_autofree char *id = qemuMonitorNextCommandID(mon);
@@ -304,6 +319,16 @@ qemuMonitorJSONCommandWithFd(qemuMonitor *mon,
 }
 
 
+static int
+qemuMonitorJSONCommandWithFd(qemuMonitor *mon,
+                             virJSONValue *cmd,
+                             int scm_fd,
+                             virJSONValue **reply)
+{
+    return qemuMonitorJSONCommandFull(mon, cmd, scm_fd, NULL, reply);
+}
+
+
 static int
 qemuMonitorJSONCommand(qemuMonitor *mon,
                        virJSONValue *cmd,
@@ -312,6 +337,32 @@ qemuMonitorJSONCommand(qemuMonitor *mon,
     return qemuMonitorJSONCommandWithFd(mon, cmd, -1, reply);
 }
 
+
+/* Members of a reply needed to report errors. Filters passed to
+ * qemuMonitorJSONCommandFiltered must include these. */
+#define QEMU_MONITOR_JSON_REPLY_FILTER_BASE \
+    "return", "error", "id", "class", "desc"
+
+/**
+ * qemuMonitorJSONCommandFiltered:
+ * @mon: monitor object
+ * @cmd: command to execute
+ * @filter: NULL-terminated list of object member names to keep in the reply
+ * @reply: filled with the reply
+ *
+ * Same as qemuMonitorJSONCommand, but the reply is parsed selectively via
+ * virJSONValueFromStringFiltered. Useful for frequently polled commands
+ * whose replies contain many members which libvirt doesn't use.
+ */
+static int
+qemuMonitorJSONCommandFiltered(qemuMonitor *mon,
+                               virJSONValue *cmd,
+                               const char *const *filter,
+                               virJSONValue **reply)
+{
+    return qemuMonitorJSONCommandFull(mon, cmd, -1, filter, reply);
+}
+
 /* Ignoring OOM in this method, since we're already reporting
  * a more important error
  *
@@ -1988,6 +2039,25 @@ qemuMonitorJSONGetBalloonInfo(qemuMonitor *mon,
 }
 
 
+/* Members of the guest-stats reply used by qemuMonitorJSONGetMemoryStats */
+static const char *const qemuMonitorJSONMemoryStatsFilter[] = {
+    QEMU_MONITOR_JSON_REPLY_FILTER_BASE,
+    "stats",
+    "last-update",
+    "stat-swap-in",
+    "stat-swap-out",
+    "stat-major-faults",
+    "stat-minor-faults",
+    "stat-free-memory",
+    "stat-total-memory",
+    "stat-available-memory",
+    "stat-disk-caches",
+    "stat-htlb-pgalloc",
+    "stat-htlb-pgfail",
+    NULL
+};
+
+
 /* Process the balloon driver statistics.  The request and data returned
  * will be as follows (although the 'child[#]' entry will differ based on
  * where it's run).
@@ -2055,7 +2125,9 @@ qemuMonitorJSONGetMemoryStats(qemuMonitor *mon,
                                            NULL)))
         return got;
 
-    if (qemuMonitorJSONCommand(mon, cmd, &reply) < 0)
+    if (qemuMonitorJSONCommandFiltered(mon, cmd,
+                                       qemuMonitorJSONMemoryStatsFilter,
+                                       &reply) < 0)
         return got;
 
     if ((data = virJSONValueObjectGetObject(reply, "error"))) {
@@ -2440,9 +2512,33 @@ qemuMonitorJSONGetOneBlockStatsNodeInfo(virJSONValue *dev,
 }
 
 
-virJSONValue *
-qemuMonitorJSONQueryBlockstats(qemuMonitor *mon,
-                               bool queryNodes)
+/* Members of the query-blockstats reply used by
+ * qemuMonitorJSONGetAllBlockStatsInfo */
+static const char *const qemuMonitorJSONBlockStatsFilter[] = {
+    QEMU_MONITOR_JSON_REPLY_FILTER_BASE,
+    "device",
+    "qdev",
+    "node-name",
+    "stats",
+    "parent",
+    "backing",
+    "rd_bytes",
+    "wr_bytes",
+    "rd_operations",
+    "wr_operations",
+    "rd_total_time_ns",
+    "wr_total_time_ns",
+    "flush_operations",
+    "flush_total_time_ns",
+    "wr_highest_offset",
+    NULL
+};
+
+
+static virJSONValue *
+qemuMonitorJSONQueryBlockstatsFull(qemuMonitor *mon,
+                                   bool queryNodes,
+                                   const char *const *filter)
 {
     g_autoptr(virJSONValue) cmd = NULL;
     g_autoptr(virJSONValue) reply = NULL;
@@ -2452,7 +2548,7 @@ qemuMonitorJSONQueryBlockstats(qemuMonitor *mon,
                                            NULL)))
         return NULL;
 
-    if (qemuMonitorJSONCommand(mon, cmd, &reply) < 0)
+    if (qemuMonitorJSONCommandFiltered(mon, cmd, filter, &reply) < 0)
         return NULL;
 
     if (qemuMonitorJSONCheckReply(cmd, reply, VIR_JSON_TYPE_ARRAY) < 0)
@@ -2462,6 +2558,14 @@ qemuMonitorJSONQueryBlockstats(qemuMonitor *mon,
 }
 
 
+virJSONValue *
+qemuMonitorJSONQueryBlockstats(qemuMonitor *mon,
+                               bool queryNodes)
+{
+    return qemuMonitorJSONQueryBlockstatsFull(mon, queryNodes, NULL);
+}
+
+
 int
 qemuMonitorJSONGetAllBlockStatsInfo(qemuMonitor *mon,
                                     GHashTable *hash)
@@ -2472,7 +2576,8 @@ qemuMonitorJSONGetAllBlockStatsInfo(qemuMonitor *mon,
     g_autoptr(virJSONValue) blockstatsDevices = NULL;
     g_autoptr(virJSONValue) blockstatsNodes = NULL;
 
-    if (!(blockstatsDevices = qemuMonitorJSONQueryBlockstats(mon, false)))
+    if (!(blockstatsDevices = qemuMonitorJSONQueryBlockstatsFull(mon, false,
+                                                                 qemuMonitorJSONBlockStatsFilter)))
         return -1;
 
     for (i = 0; i < virJSONValueArraySize(blockstatsDevices); i++) {
@@ -2500,7 +2605,8 @@ qemuMonitorJSONGetAllBlockStatsInfo(qemuMonitor *mon,
             nstats = rc;
     }
 
-    if (!(blockstatsNodes = qemuMonitorJSONQueryBlockstats(mon, true)))
+    if (!(blockstatsNodes = qemuMonitorJSONQueryBlockstatsFull(mon, true,
+                                                               qemuMonitorJSONBlockStatsFilter)))
         return -1;
 
     for (i = 0; i < virJSONValueArraySize(blockstatsNodes); i++) {
@@ -8824,6 +8930,54 @@ qemuMonitorJSONQueryDirtyRate(qemuMonitor *mon,
 }
 
 
+virJSONValue *
+qemuMonitorJSONQueryStats(qemuMonitor *mon,
+                          qemuMonitorQueryStatsTargetType target,
+                          char **vcpus,
+                          qemuMonitorQueryStatsProviderType provider)
+{
+    g_autoptr(virJSONValue) cmd = NULL;
+    g_autoptr(virJSONValue) reply = NULL;
+    g_autoptr(virJSONValue) vcpuList = NULL;
+    g_autoptr(virJSONValue) providerObj = NULL;
+    g_autoptr(virJSONValue) providerList = virJSONValueNewArray();
+
+    if (vcpus) {
+        char **tmp;
+
+        vcpuList = virJSONValueNewArray();
+
+        for (tmp = vcpus; *tmp; tmp++) {
+            if (virJSONValueArrayAppendString(vcpuList, *tmp) < 0)
+                return NULL;
+        }
+    }
+
+    if (virJSONValueObjectAdd(&providerObj,
+                              "s:provider", qemuMonitorQueryStatsProviderTypeToString(provider),
+                              NULL) < 0)
+        return NULL;
+
+    if (virJSONValueArrayAppend(providerList, &providerObj) < 0)
+        return NULL;
+
+    if (!(cmd = qemuMonitorJSONMakeCommand("query-stats",
+                                           "s:target", qemuMonitorQueryStatsTargetTypeToString(target),
+                                           "A:vcpus", &vcpuList,
+                                           "a:providers", &providerList,
+                                           NULL)))
+        return NULL;
+
+    if (qemuMonitorJSONCommand(mon, cmd, &reply) < 0)
+        return NULL;
+
+    if (qemuMonitorJSONCheckReply(cmd, reply, VIR_JSON_TYPE_ARRAY) < 0)
+        return NULL;
+
+    return virJSONValueObjectStealArray(reply, "return");
+}
+
+
 VIR_ENUM_DECL(qemuMonitorActionShutdown);
 VIR_ENUM_IMPL(qemuMonitorActionShutdown,
               QEMU_MONITOR_ACTION_SHUTDOWN_LAST,
@@ -848,6 +848,12 @@ int
 qemuMonitorJSONQueryDirtyRate(qemuMonitor *mon,
                               qemuMonitorDirtyRateInfo *info);
 
+virJSONValue *
+qemuMonitorJSONQueryStats(qemuMonitor *mon,
+                          qemuMonitorQueryStatsTargetType target,
+                          char **vcpus,
+                          qemuMonitorQueryStatsProviderType provider);
+
 int
 qemuMonitorJSONSetAction(qemuMonitor *mon,
                          qemuMonitorActionShutdown shutdown,
@@ -37,6 +37,10 @@ struct _qemuMonitorMessage {
     /* Used by the JSON monitor to hold reply / error */
     void *rxObject;
 
+    /* If non-NULL only object members listed in this NULL-terminated
+     * list are kept when parsing the reply */
+    const char *const *rxFilter;
+
     /* True if rxObject is ready, or a fatal error occurred on the monitor channel */
     bool finished;
 };
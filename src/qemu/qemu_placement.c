@@ -0,0 +1,583 @@
+/*
+ * qemu_placement.c: NUMA placement of QEMU domains
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "qemu_placement.h"
+#include "virerror.h"
+#include "virlog.h"
+#include "virnuma.h"
+#include "viruuid.h"
+
+#define VIR_FROM_THIS VIR_FROM_QEMU
+
+VIR_LOG_INIT("qemu.qemu_placement");
+
+/* A running domain is moved only if that lowers the utilization of the
+ * nodes it runs on by at least this fraction */
+#define QEMU_PLACEMENT_REBALANCE_MARGIN 0.25
+
+VIR_ENUM_IMPL(qemuPlacementPolicy,
+              QEMU_PLACEMENT_POLICY_LAST,
+              "numad",
+              "spread",
+              "pack",
+);
+
+
+typedef struct _qemuPlacementDomain qemuPlacementDomain;
+struct _qemuPlacementDomain {
+    virBitmap *nodeset;
+    double load;
+};
+
+
+/*
+ * Record of the nodes every domain placed automatically runs on and of
+ * the load it puts on them, so that placing a domain doesn't need to
+ * look at the other domains.
+ */
+struct _qemuPlacement {
+    virObjectLockable parent;
+
+    GHashTable *domains; /* UUID string -> qemuPlacementDomain */
+};
+
+static virClass *qemuPlacementClass;
+
+static void qemuPlacementDispose(void *obj);
+
+static int
+qemuPlacementOnceInit(void)
+{
+    if (!VIR_CLASS_NEW(qemuPlacement, virClassForObjectLockable()))
+        return -1;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(qemuPlacement);
+
+
+static void
+qemuPlacementDomainFree(void *opaque)
+{
+    qemuPlacementDomain *dom = opaque;
+
+    if (!dom)
+        return;
+
+    virBitmapFree(dom->nodeset);
+    g_free(dom);
+}
+
+
+qemuPlacement *
+qemuPlacementNew(void)
+{
+    qemuPlacement *placement;
+
+    if (qemuPlacementInitialize() < 0)
+        return NULL;
+
+    if (!(placement = virObjectLockableNew(qemuPlacementClass)))
+        return NULL;
+
+    placement->domains = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                               qemuPlacementDomainFree);
+
+    return placement;
+}
+
+
+static void
+qemuPlacementDispose(void *obj)
+{
+    qemuPlacement *placement = obj;
+
+    g_clear_pointer(&placement->domains, g_hash_table_unref);
+}
+
+
+/**
+ * qemuPlacementAddDomain:
+ * @placement: placement record
+ * @def: domain definition
+ * @nodeset: host NUMA nodes the domain runs on
+ * @load: number of host CPUs the domain keeps busy
+ *
+ * Records that domain @def runs on @nodeset, replacing any previous
+ * record of it.
+ */
+void
+qemuPlacementAddDomain(qemuPlacement *placement,
+                       virDomainDef *def,
+                       virBitmap *nodeset,
+                       double load)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(placement);
+    char uuidstr[VIR_UUID_STRING_BUFLEN];
+    qemuPlacementDomain *dom = g_new0(qemuPlacementDomain, 1);
+
+    virUUIDFormat(def->uuid, uuidstr);
+
+    dom->nodeset = virBitmapNewCopy(nodeset);
+    dom->load = load;
+
+    g_hash_table_insert(placement->domains, g_strdup(uuidstr), dom);
+}
+
+
+/**
+ * qemuPlacementRemoveDomain:
+ * @placement: placement record
+ * @def: domain definition
+ *
+ * Drops the record of domain @def, e.g. because it stopped.
+ */
+void
+qemuPlacementRemoveDomain(qemuPlacement *placement,
+                          virDomainDef *def)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(placement);
+    char uuidstr[VIR_UUID_STRING_BUFLEN];
+
+    virUUIDFormat(def->uuid, uuidstr);
+
+    g_hash_table_remove(placement->domains, uuidstr);
+}
+
+
+void
+qemuPlacementNodesFree(qemuPlacementNode *nodes,
+                       size_t nnodes)
+{
+    size_t i;
+
+    for (i = 0; i < nnodes; i++)
+        g_free(nodes[i].distances);
+    g_free(nodes);
+}
+
+
+/*
+ * Spread @load over those nodes of @nodeset which have any CPUs, in
+ * proportion to the number of their CPUs.
+ */
+static void
+qemuPlacementNodesAddLoad(qemuPlacementNode *nodes,
+                          size_t nnodes,
+                          virBitmap *nodeset,
+                          double load)
+{
+    unsigned int ncpus = 0;
+    size_t i;
+
+    for (i = 0; i < nnodes; i++) {
+        if (virBitmapIsBitSet(nodeset, nodes[i].id))
+            ncpus += nodes[i].ncpus;
+    }
+
+    if (ncpus == 0)
+        return;
+
+    for (i = 0; i < nnodes; i++) {
+        if (virBitmapIsBitSet(nodeset, nodes[i].id))
+            nodes[i].load += load * nodes[i].ncpus / ncpus;
+    }
+}
+
+
+static unsigned long long
+qemuPlacementGetPageSize(virDomainDef *def)
+{
+    if (def->mem.nhugepages == 0)
+        return 0;
+
+    return def->mem.hugepages[0].size;
+}
+
+
+/*
+ * Get the NUMA nodes of the host along with the load put on them by all
+ * the recorded domains except for @exclude. If @pagesize is not 0 the
+ * free memory of every node is the free memory in huge pages of that
+ * size (in KiB).
+ */
+static int
+qemuPlacementGetNodes(qemuPlacement *placement,
+                      virDomainDef *exclude,
+                      unsigned long long pagesize,
+                      qemuPlacementNode **retnodes,
+                      size_t *retnnodes)
+{
+    qemuPlacementNode *nodes = NULL;
+    size_t nnodes = 0;
+    char uuidstr[VIR_UUID_STRING_BUFLEN] = "";
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    int maxnode;
+    int n;
+
+    if ((maxnode = virNumaGetMaxNode()) < 0)
+        return -1;
+
+    for (n = 0; n <= maxnode; n++) {
+        g_autoptr(virBitmap) cpus = NULL;
+        qemuPlacementNode node = { .id = n };
+        int ncpus;
+
+        if (!virNumaNodeIsAvailable(n))
+            continue;
+
+        if ((ncpus = virNumaGetNodeCPUs(n, &cpus)) == -1)
+            goto error;
+        node.ncpus = MAX(ncpus, 0);
+
+        if (pagesize) {
+            unsigned long long pageFree;
+
+            if (virNumaGetPageInfo(n, pagesize, 0, NULL, &pageFree) < 0)
+                goto error;
+
+            node.memFree = pageFree * pagesize;
+        } else {
+            unsigned long long memFree;
+
+            if (virNumaGetNodeMemory(n, NULL, &memFree) < 0) {
+                virReportError(VIR_ERR_INTERNAL_ERROR,
+                               _("unable to get free memory of NUMA node %d"), n);
+                goto error;
+            }
+
+            node.memFree = memFree / 1024;
+        }
+
+        if (virNumaGetDistances(n, &node.distances, &node.ndistances) < 0)
+            goto error;
+
+        VIR_APPEND_ELEMENT(nodes, nnodes, node);
+    }
+
+    if (nnodes == 0) {
+        virReportError(VIR_ERR_OPERATION_UNSUPPORTED, "%s",
+                       _("NUMA topology of the host is not available"));
+        return -1;
+    }
+
+    if (exclude)
+        virUUIDFormat(exclude->uuid, uuidstr);
+
+    VIR_WITH_OBJECT_LOCK_GUARD(placement) {
+        g_hash_table_iter_init(&iter, placement->domains);
+        while (g_hash_table_iter_next(&iter, &key, &value)) {
+            qemuPlacementDomain *dom = value;
+
+            if (exclude && STREQ(key, uuidstr))
+                continue;
+
+            qemuPlacementNodesAddLoad(nodes, nnodes, dom->nodeset, dom->load);
+        }
+    }
+
+    *retnodes = g_steal_pointer(&nodes);
+    *retnnodes = nnodes;
+    return 0;
+
+ error:
+    qemuPlacementNodesFree(nodes, nnodes);
+    return -1;
+}
+
+
+static int
+qemuPlacementNodeDistance(qemuPlacementNode *a,
+                          qemuPlacementNode *b)
+{
+    if (a->distances && b->id < a->ndistances && a->distances[b->id] > 0)
+        return a->distances[b->id];
+
+    /* the usual distances of a local and a remote node */
+    return a->id == b->id ? 10 : 20;
+}
+
+
+static double
+qemuPlacementNodeUtilization(qemuPlacementNode *node,
+                             unsigned int vcpus)
+{
+    if (node->ncpus == 0)
+        return 0;
+
+    return (node->load + vcpus) / node->ncpus;
+}
+
+
+static bool
+qemuPlacementNodeFits(qemuPlacementNode *node,
+                      unsigned int vcpus,
+                      unsigned long long memory)
+{
+    return node->memFree >= memory &&
+        node->load + vcpus <= node->ncpus;
+}
+
+
+/*
+ * Whether @a is a better node to start placing a domain with @vcpus and
+ * @memory on than @b.
+ */
+static bool
+qemuPlacementNodeIsBetter(qemuPlacementNode *a,
+                          qemuPlacementNode *b,
+                          qemuPlacementPolicy policy,
+                          unsigned int vcpus,
+                          unsigned long long memory)
+{
+    bool aFits = qemuPlacementNodeFits(a, vcpus, memory);
+    bool bFits = qemuPlacementNodeFits(b, vcpus, memory);
+    double aUtil = qemuPlacementNodeUtilization(a, vcpus);
+    double bUtil = qemuPlacementNodeUtilization(b, vcpus);
+
+    if (aFits != bFits)
+        return aFits;
+
+    /* Packing only makes sense among nodes the domain fits on, otherwise
+     * the domain is better off on the least loaded node */
+    if (policy == QEMU_PLACEMENT_POLICY_PACK && aFits && aUtil != bUtil)
+        return aUtil > bUtil;
+
+    if (aUtil != bUtil)
+        return aUtil < bUtil;
+
+    return a->memFree > b->memFree;
+}
+
+
+/**
+ * qemuPlacementChooseNodes:
+ * @nodes: NUMA nodes of the host
+ * @nnodes: number of @nodes
+ * @policy: placement policy
+ * @vcpus: number of host CPUs the domain needs
+ * @memory: memory the domain needs in KiB
+ *
+ * Chooses the node the domain is going to run on according to @policy,
+ * and adds the nodes closest to it until the chosen nodes have enough
+ * CPUs and free memory for the domain, or no more nodes are left.
+ *
+ * Returns the nodeset, or NULL with an error reported.
+ */
+virBitmap *
+qemuPlacementChooseNodes(qemuPlacementNode *nodes,
+                         size_t nnodes,
+                         qemuPlacementPolicy policy,
+                         unsigned int vcpus,
+                         unsigned long long memory)
+{
+    g_autoptr(virBitmap) nodeset = virBitmapNew(0);
+    qemuPlacementNode *start = NULL;
+    unsigned long long memFree;
+    unsigned int ncpus;
+    size_t i;
+
+    for (i = 0; i < nnodes; i++) {
+        /* nodes without CPUs may only provide extra memory */
+        if (nodes[i].ncpus == 0)
+            continue;
+
+        if (!start ||
+            qemuPlacementNodeIsBetter(&nodes[i], start, policy, vcpus, memory))
+            start = &nodes[i];
+    }
+
+    if (!start) {
+        virReportError(VIR_ERR_OPERATION_FAILED, "%s",
+                       _("no NUMA node with any CPUs found"));
+        return NULL;
+    }
+
+    virBitmapSetBitExpand(nodeset, start->id);
+    ncpus = start->ncpus;
+    memFree = start->memFree;
+
+    while (ncpus < vcpus || memFree < memory) {
+        qemuPlacementNode *next = NULL;
+
+        for (i = 0; i < nnodes; i++) {
+            qemuPlacementNode *node = &nodes[i];
+            int dist;
+            int nextDist;
+
+            if (virBitmapIsBitSet(nodeset, node->id))
+                continue;
+
+            if (!next) {
+                next = node;
+                continue;
+            }
+
+            dist = qemuPlacementNodeDistance(start, node);
+            nextDist = qemuPlacementNodeDistance(start, next);
+
+            if (dist < nextDist ||
+                (dist == nextDist &&
+                 qemuPlacementNodeUtilization(node, 0) <
+                 qemuPlacementNodeUtilization(next, 0)))
+                next = node;
+        }
+
+        if (!next)
+            break;
+
+        virBitmapSetBitExpand(nodeset, next->id);
+        ncpus += next->ncpus;
+        memFree += next->memFree;
+    }
+
+    return g_steal_pointer(&nodeset);
+}
+
+
+/**
+ * qemuPlacementGetAdvice:
+ * @placement: placement record
+ * @def: definition of a domain about to start
+ * @policy: placement policy
+ * @nodeset: filled with the chosen host NUMA nodes
+ *
+ * Chooses the host NUMA nodes domain @def should run on, taking the load
+ * of the already running domains into account.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+qemuPlacementGetAdvice(qemuPlacement *placement,
+                       virDomainDef *def,
+                       qemuPlacementPolicy policy,
+                       virBitmap **nodeset)
+{
+    qemuPlacementNode *nodes = NULL;
+    size_t nnodes = 0;
+
+    if (qemuPlacementGetNodes(placement, def, qemuPlacementGetPageSize(def),
+                              &nodes, &nnodes) < 0)
+        return -1;
+
+    *nodeset = qemuPlacementChooseNodes(nodes, nnodes, policy,
+                                        virDomainDefGetVcpus(def),
+                                        virDomainDefGetMemoryTotal(def));
+
+    qemuPlacementNodesFree(nodes, nnodes);
+
+    return *nodeset ? 0 : -1;
+}
+
+
+/**
+ * qemuPlacementRebalance:
+ * @placement: placement record
+ * @def: definition of a running domain
+ * @policy: placement policy
+ * @current: host NUMA nodes the domain runs on
+ * @load: number of host CPUs the domain currently keeps busy
+ * @nodeset: filled with the nodes to move the domain to
+ *
+ * Records the current @load of domain @def and checks whether it should
+ * move. A domain is moved only if the nodes it runs on are busier than
+ * they have CPUs and moving lowers their utilization considerably, so
+ * that domains don't keep moving back and forth.
+ *
+ * Returns 1 if the domain should move to @nodeset, 0 if it should stay,
+ * -1 on error.
+ */
+int
+qemuPlacementRebalance(qemuPlacement *placement,
+                       virDomainDef *def,
+                       qemuPlacementPolicy policy,
+                       virBitmap *current,
+                       double load,
+                       virBitmap **nodeset)
+{
+    qemuPlacementNode *nodes = NULL;
+    size_t nnodes = 0;
+    g_autoptr(virBitmap) candidate = NULL;
+    unsigned long long memory = virDomainDefGetMemoryTotal(def);
+    unsigned int vcpus;
+    size_t ncurrent = virBitmapCountBits(current);
+    double curLoad = load;
+    double newLoad = load;
+    unsigned int curCpus = 0;
+    unsigned int newCpus = 0;
+    int ret = -1;
+    size_t i;
+
+    qemuPlacementAddDomain(placement, def, current, load);
+
+    if (qemuPlacementGetNodes(placement, def, qemuPlacementGetPageSize(def),
+                              &nodes, &nnodes) < 0)
+        return -1;
+
+    /* The memory of the domain is already allocated on the nodes it runs
+     * on, count it as free there */
+    for (i = 0; i < nnodes; i++) {
+        if (virBitmapIsBitSet(current, nodes[i].id))
+            nodes[i].memFree += memory / ncurrent;
+    }
+
+    /* The domain needs as many CPUs as it keeps busy, but at most one
+     * per vCPU */
+    vcpus = MIN(virDomainDefGetVcpus(def), (unsigned int) load + 1);
+
+    if (!(candidate = qemuPlacementChooseNodes(nodes, nnodes, policy,
+                                               vcpus, memory)))
+        goto cleanup;
+
+    for (i = 0; i < nnodes; i++) {
+        if (virBitmapIsBitSet(current, nodes[i].id)) {
+            curLoad += nodes[i].load;
+            curCpus += nodes[i].ncpus;
+        }
+        if (virBitmapIsBitSet(candidate, nodes[i].id)) {
+            newLoad += nodes[i].load;
+            newCpus += nodes[i].ncpus;
+        }
+    }
+
+    ret = 0;
+
+    if (curCpus == 0 || newCpus == 0 ||
+        virBitmapEqual(current, candidate))
+        goto cleanup;
+
+    VIR_DEBUG("domain %s: utilization %.2f on current nodes, %.2f on candidate nodes",
+              def->name, curLoad / curCpus, newLoad / newCpus);
+
+    if (curLoad / curCpus <= 1 ||
+        newLoad / newCpus > curLoad / curCpus * (1 - QEMU_PLACEMENT_REBALANCE_MARGIN))
+        goto cleanup;
+
+    qemuPlacementAddDomain(placement, def, candidate, load);
+    *nodeset = g_steal_pointer(&candidate);
+    ret = 1;
+
+ cleanup:
+    qemuPlacementNodesFree(nodes, nnodes);
+    return ret;
+}
@@ -0,0 +1,75 @@
+/*
+ * qemu_placement.h: NUMA placement of QEMU domains
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "internal.h"
+#include "virbitmap.h"
+#include "virenum.h"
+#include "domain_conf.h"
+
+typedef enum {
+    QEMU_PLACEMENT_POLICY_NUMAD = 0, /* ask numad */
+    QEMU_PLACEMENT_POLICY_SPREAD, /* prefer the least loaded nodes */
+    QEMU_PLACEMENT_POLICY_PACK, /* prefer the most loaded nodes that fit */
+
+    QEMU_PLACEMENT_POLICY_LAST
+} qemuPlacementPolicy;
+
+VIR_ENUM_DECL(qemuPlacementPolicy);
+
+typedef struct _qemuPlacementNode qemuPlacementNode;
+struct _qemuPlacementNode {
+    int id;
+    unsigned int ncpus;
+    unsigned long long memFree; /* in KiB */
+    double load; /* host CPUs kept busy by domains placed on the node */
+    int *distances; /* indexed by node id, may be NULL */
+    int ndistances;
+};
+
+void qemuPlacementNodesFree(qemuPlacementNode *nodes,
+                            size_t nnodes);
+
+virBitmap *qemuPlacementChooseNodes(qemuPlacementNode *nodes,
+                                    size_t nnodes,
+                                    qemuPlacementPolicy policy,
+                                    unsigned int vcpus,
+                                    unsigned long long memory);
+
+typedef struct _qemuPlacement qemuPlacement;
+
+qemuPlacement *qemuPlacementNew(void);
+
+void qemuPlacementAddDomain(qemuPlacement *placement,
+                            virDomainDef *def,
+                            virBitmap *nodeset,
+                            double load);
+void qemuPlacementRemoveDomain(qemuPlacement *placement,
+                               virDomainDef *def);
+
+int qemuPlacementGetAdvice(qemuPlacement *placement,
+                           virDomainDef *def,
+                           qemuPlacementPolicy policy,
+                           virBitmap **nodeset);
+int qemuPlacementRebalance(qemuPlacement *placement,
+                           virDomainDef *def,
+                           qemuPlacementPolicy policy,
+                           virBitmap *current,
+                           double load,
+                           virBitmap **nodeset);
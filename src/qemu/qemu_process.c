@@ -61,6 +61,7 @@
 #include "qemu_backup.h"
 #include "qemu_dbus.h"
 #include "qemu_snapshot.h"
+#include "qemu_placement.h"
 
 #include "cpu/cpu.h"
 #include "cpu/cpu_x86.h"
@@ -272,7 +273,7 @@ qemuConnectAgent(virQEMUDriver *driver, virDomainObj *vm)
  *
  * Submits @eventType to be processed by the asynchronous event handling thread.
  */
-static void
+void
 qemuProcessEventSubmit(virDomainObj *vm,
                        qemuProcessEventType eventType,
                        int action,
@@ -753,7 +754,7 @@ qemuProcessHandleRTCChange(qemuMonitor *mon G_GNUC_UNUSED,
         offset += vm->def->clock.data.variable.adjustment0;
         vm->def->clock.data.variable.adjustment = offset;
 
-        qemuDomainSaveStatus(vm);
+        qemuDomainSaveStatusDeferrable(vm);
     }
 
     event = virDomainEventRTCChangeNewFromObj(vm, offset);
@@ -1142,7 +1143,7 @@ qemuProcessHandleBalloonChange(qemuMonitor *mon G_GNUC_UNUSED,
               vm->def->mem.cur_balloon, actual);
     vm->def->mem.cur_balloon = actual;
 
-    qemuDomainSaveStatus(vm);
+    qemuDomainSaveStatusDeferrable(vm);
     virObjectUnlock(vm);
 
     virObjectEventStateQueue(driver->domainEventState, event);
@@ -6015,6 +6016,110 @@ qemuProcessSetupIOThreads(virDomainObj *vm)
 }
 
 
+/*
+ * Set the automatic placement of @vm to @nodeset and the CPUs of those
+ * nodes.
+ */
+static int
+qemuProcessSetAutoPlacement(virDomainObj *vm,
+                            virBitmap *nodeset)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    g_autoptr(virBitmap) autoNodeset = virBitmapNewCopy(nodeset);
+    g_autoptr(virBitmap) autoCpuset = NULL;
+    g_autoptr(virBitmap) hostMemoryNodeset = NULL;
+    g_autoptr(virCapsHostNUMA) caps = NULL;
+
+    if (!(hostMemoryNodeset = virNumaGetHostMemoryNodeset()))
+        return -1;
+
+    if (!(caps = virCapabilitiesHostNUMANewHost()))
+        return -1;
+
+    /* numad may return a nodeset that only contains cpus but cgroups don't play
+     * well with that. Set the autoCpuset from all cpus from that nodeset, but
+     * assign autoNodeset only with nodes containing memory. */
+    if (!(autoCpuset = virCapabilitiesHostNUMAGetCpus(caps, autoNodeset)))
+        return -1;
+
+    virBitmapIntersect(autoNodeset, hostMemoryNodeset);
+
+    virBitmapFree(priv->autoNodeset);
+    priv->autoNodeset = g_steal_pointer(&autoNodeset);
+    virBitmapFree(priv->autoCpuset);
+    priv->autoCpuset = g_steal_pointer(&autoCpuset);
+
+    return 0;
+}
+
+
+static int
+qemuProcessSetupThreadsPlacement(virDomainObj *vm)
+{
+    size_t i;
+
+    if (qemuProcessSetupEmulator(vm) < 0)
+        return -1;
+
+    if (qemuDomainHasVcpuPids(vm)) {
+        for (i = 0; i < virDomainDefGetVcpusMax(vm->def); i++) {
+            if (!virDomainDefGetVcpu(vm->def, i)->online)
+                continue;
+
+            if (qemuProcessSetupVcpu(vm, i) < 0)
+                return -1;
+        }
+    }
+
+    return qemuProcessSetupIOThreads(vm);
+}
+
+
+/**
+ * qemuProcessUpdateAutoPlacement:
+ * @vm: domain object
+ * @nodeset: host NUMA nodes to move the domain to
+ *
+ * Moves a running domain with automatic placement to @nodeset. All vCPU,
+ * emulator and I/O threads which are not pinned explicitly are pinned to
+ * the CPUs of @nodeset and the memory of the domain is bound to it as far
+ * as its numatune mode allows.
+ *
+ * Returns 0 on success, -1 on error, in which case the original placement
+ * is restored as far as possible.
+ */
+int
+qemuProcessUpdateAutoPlacement(virDomainObj *vm,
+                               virBitmap *nodeset)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    g_autoptr(virBitmap) origNodeset = g_steal_pointer(&priv->autoNodeset);
+    g_autoptr(virBitmap) origCpuset = g_steal_pointer(&priv->autoCpuset);
+    virErrorPtr orig_err = NULL;
+
+    if (qemuProcessSetAutoPlacement(vm, nodeset) < 0 ||
+        qemuProcessSetupThreadsPlacement(vm) < 0)
+        goto error;
+
+    qemuDomainSaveStatus(vm);
+
+    return 0;
+
+ error:
+    virErrorPreserveLast(&orig_err);
+
+    virBitmapFree(priv->autoNodeset);
+    priv->autoNodeset = g_steal_pointer(&origNodeset);
+    virBitmapFree(priv->autoCpuset);
+    priv->autoCpuset = g_steal_pointer(&origCpuset);
+
+    ignore_value(qemuProcessSetupThreadsPlacement(vm));
+
+    virErrorRestore(&orig_err);
+    return -1;
+}
+
+
 static int
 qemuProcessValidateHotpluggableVcpus(virDomainDef *def)
 {
@@ -6290,46 +6395,44 @@ qemuProcessUpdateGuestCPU(virDomainDef *def,
 
 
 static int
-qemuProcessPrepareDomainNUMAPlacement(virDomainObj *vm)
+qemuProcessPrepareDomainNUMAPlacement(virQEMUDriver *driver,
+                                      virDomainObj *vm)
 {
-    qemuDomainObjPrivate *priv = vm->privateData;
-    g_autofree char *nodeset = NULL;
-    g_autoptr(virBitmap) numadNodeset = NULL;
-    g_autoptr(virBitmap) hostMemoryNodeset = NULL;
-    g_autoptr(virCapsHostNUMA) caps = NULL;
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+    g_autoptr(virBitmap) nodeset = NULL;
 
-    /* Get the advisory nodeset from numad if 'placement' of
-     * either <vcpu> or <numatune> is 'auto'.
+    /* Get the advisory nodeset from numad or our own placement engine if
+     * 'placement' of either <vcpu> or <numatune> is 'auto'.
      */
     if (!virDomainDefNeedsPlacementAdvice(vm->def))
         return 0;
 
-    nodeset = virNumaGetAutoPlacementAdvice(virDomainDefGetVcpus(vm->def),
-                                            virDomainDefGetMemoryTotal(vm->def));
+    if (cfg->numaPlacement == QEMU_PLACEMENT_POLICY_NUMAD) {
+        g_autofree char *advice = NULL;
 
-    if (!nodeset)
-        return -1;
+        advice = virNumaGetAutoPlacementAdvice(virDomainDefGetVcpus(vm->def),
+                                               virDomainDefGetMemoryTotal(vm->def));
 
-    if (!(hostMemoryNodeset = virNumaGetHostMemoryNodeset()))
-        return -1;
+        if (!advice)
+            return -1;
 
-    VIR_DEBUG("Nodeset returned from numad: %s", nodeset);
+        VIR_DEBUG("Nodeset returned from numad: %s", advice);
 
-    if (virBitmapParse(nodeset, &numadNodeset, VIR_DOMAIN_CPUMASK_LEN) < 0)
-        return -1;
+        if (virBitmapParse(advice, &nodeset, VIR_DOMAIN_CPUMASK_LEN) < 0)
+            return -1;
+    } else {
+        if (qemuPlacementGetAdvice(driver->placement, vm->def,
+                                   cfg->numaPlacement, &nodeset) < 0)
+            return -1;
+    }
 
-    if (!(caps = virCapabilitiesHostNUMANewHost()))
+    if (qemuProcessSetAutoPlacement(vm, nodeset) < 0)
         return -1;
 
-    /* numad may return a nodeset that only contains cpus but cgroups don't play
-     * well with that. Set the autoCpuset from all cpus from that nodeset, but
-     * assign autoNodeset only with nodes containing memory. */
-    if (!(priv->autoCpuset = virCapabilitiesHostNUMAGetCpus(caps, numadNodeset)))
-        return -1;
-
-    virBitmapIntersect(numadNodeset, hostMemoryNodeset);
-
-    priv->autoNodeset = g_steal_pointer(&numadNodeset);
+    /* Until the load of the domain is measured assume it keeps all its
+     * vCPUs busy */
+    qemuPlacementAddDomain(driver->placement, vm->def, nodeset,
+                           virDomainDefGetVcpus(vm->def));
 
     return 0;
 }
@@ -6640,7 +6743,7 @@ qemuProcessPrepareDomain(virQEMUDriver *driver,
         }
         virDomainAuditSecurityLabel(vm, true);
 
-        if (qemuProcessPrepareDomainNUMAPlacement(vm) < 0)
+        if (qemuProcessPrepareDomainNUMAPlacement(driver, vm) < 0)
             return -1;
     }
 
@@ -7127,6 +7230,43 @@ qemuProcessPrepareHostBackendChardevHotplug(virDomainObj *vm,
     return 0;
 }
 
+
+/*
+ * Account for the huge pages backing the memory of @vm. If @start is
+ * true the domain is about to start and is given its pages only if the
+ * pools of the host can still provide them, otherwise it holds them
+ * already.
+ */
+static int
+qemuProcessReserveHugepages(virQEMUDriver *driver,
+                            virDomainObj *vm,
+                            bool start)
+{
+    qemuDomainObjPrivate *priv = vm->privateData;
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
+    unsigned int defaultPageSize = 0;
+    unsigned int flags = 0;
+
+    if (cfg->nhugetlbfs) {
+        virHugeTLBFS *p;
+
+        if (!(p = virFileGetDefaultHugepage(cfg->hugetlbfs, cfg->nhugetlbfs)))
+            p = &cfg->hugetlbfs[0];
+
+        defaultPageSize = p->size;
+    }
+
+    if (start && cfg->hugepagesCheck) {
+        flags |= QEMU_HUGEPAGES_RESERVE_CHECK;
+        if (cfg->hugepagesGrowPool)
+            flags |= QEMU_HUGEPAGES_RESERVE_GROW;
+    }
+
+    return qemuHugepagesReserve(driver->hugepages, vm->def, priv->autoNodeset,
+                                defaultPageSize, flags);
+}
+
+
 /**
  * qemuProcessPrepareHost:
  * @driver: qemu driver
@@ -7185,6 +7325,10 @@ qemuProcessPrepareHost(virQEMUDriver *driver,
     if (qemuProcessPrepareHostBackendChardev(vm) < 0)
         return -1;
 
+    VIR_DEBUG("Reserving huge pages");
+    if (qemuProcessReserveHugepages(driver, vm, true) < 0)
+        return -1;
+
     if (qemuProcessBuildDestroyMemoryPaths(driver, vm, NULL, true) < 0)
         return -1;
 
@@ -8283,6 +8427,9 @@ void qemuProcessStop(virQEMUDriver *driver,
 
     vm->def->id = -1;
 
+    /* drop any pending deferred save of the status XML */
+    qemuDomainSaveStatusFlush(vm);
+
     /* Wake up anything waiting on domain condition */
     virDomainObjBroadcast(vm);
 
@@ -8484,6 +8631,11 @@ void qemuProcessStop(virQEMUDriver *driver,
 
     qemuSecurityReleaseLabel(driver->securityManager, vm->def);
 
+    if (priv->autoNodeset)
+        qemuPlacementRemoveDomain(driver->placement, vm->def);
+
+    qemuHugepagesRelease(driver->hugepages, vm->def);
+
     /* clear all private data entries which are no longer needed */
     qemuDomainObjPrivateDataClear(priv);
 
@@ -8840,7 +8992,86 @@ struct qemuProcessReconnectData {
     virQEMUDriver *driver;
     virDomainObj *obj;
     virIdentity *identity;
+
+    /* Set when the job was already started by qemuProcessReconnectHelper
+     * on behalf of a reconnect worker (see reconnect_workers) */
+    bool jobStarted;
+    qemuDomainJobObj oldjob;
+
+    /* only domains with (or without) an async job to recover */
+    bool priority;
 };
+
+
+/**
+ * qemuProcessReconnectPoolSteal:
+ * @driver: qemu driver
+ *
+ * Takes the reconnect worker pool away from @driver. Whoever gets a non-NULL
+ * pool is responsible for freeing it.
+ */
+virThreadPool *
+qemuProcessReconnectPoolSteal(virQEMUDriver *driver)
+{
+    virThreadPool *pool;
+
+    do {
+        pool = g_atomic_pointer_get(&driver->reconnectPool);
+    } while (pool &&
+             !g_atomic_pointer_compare_and_exchange(&driver->reconnectPool,
+                                                    pool, NULL));
+
+    return pool;
+}
+
+
+static void
+qemuProcessReconnectPoolFree(int timer,
+                             void *opaque)
+{
+    virQEMUDriver *driver = opaque;
+
+    virEventRemoveTimeout(timer);
+
+    VIR_DEBUG("Finished reconnecting to running domains");
+    virThreadPoolFree(qemuProcessReconnectPoolSteal(driver));
+}
+
+
+static void
+qemuProcessReconnectPoolRelease(virQEMUDriver *driver)
+{
+    if (!g_atomic_int_dec_and_test(&driver->reconnectPending))
+        return;
+
+    /* The pool can't be freed from one of its own workers as freeing waits
+     * for all of them to exit. If this fails the pool is left for
+     * qemuStateCleanup. */
+    if (virEventAddTimeout(0, qemuProcessReconnectPoolFree, driver, NULL) < 0)
+        VIR_WARN("Failed to schedule freeing of the reconnect worker pool");
+}
+
+
+static void
+qemuProcessReconnectFinished(virQEMUDriver *driver,
+                             bool failed)
+{
+    int total = g_atomic_int_get(&driver->reconnectTotal);
+    int done;
+
+    if (failed)
+        g_atomic_int_inc(&driver->reconnectFailed);
+    done = g_atomic_int_add(&driver->reconnectDone, 1) + 1;
+
+    VIR_DEBUG("Reconnected %d of %d domains", done, total);
+
+    if (done == total) {
+        VIR_INFO("Finished reconnecting to %d running domains, %d failed",
+                 total, g_atomic_int_get(&driver->reconnectFailed));
+    }
+}
+
+
 /*
  * Open an existing VM's monitor, re-detect VCPU threads
  * and re-reserve the security labels in use
@@ -8874,26 +9105,37 @@ qemuProcessReconnect(void *opaque)
     g_autoptr(virQEMUDriverConfig) cfg = NULL;
     size_t i;
     unsigned int stopFlags = 0;
-    bool jobStarted = false;
+    bool jobStarted = data->jobStarted;
     bool retry = false;
     bool tryMonReconn = false;
+    bool failed = false;
 
     virIdentitySetCurrent(data->identity);
     g_clear_object(&data->identity);
-    VIR_FREE(data);
 
     cfg = virQEMUDriverGetConfig(driver);
     priv = obj->privateData;
 
-    qemuDomainObjPreserveJob(obj, &oldjob);
+    if (jobStarted) {
+        oldjob = data->oldjob;
+        memset(&data->oldjob, 0, sizeof(data->oldjob));
+    } else {
+        qemuDomainObjPreserveJob(obj, &oldjob);
+    }
+    VIR_FREE(data);
+
     if (oldjob.asyncJob == VIR_ASYNC_JOB_MIGRATION_IN)
         stopFlags |= VIR_QEMU_PROCESS_STOP_MIGRATED;
     if (oldjob.asyncJob == VIR_ASYNC_JOB_BACKUP && priv->backup)
         priv->backup->apiFlags = oldjob.apiFlags;
 
-    if (qemuDomainObjBeginJob(driver, obj, VIR_JOB_MODIFY) < 0)
-        goto error;
-    jobStarted = true;
+    if (jobStarted) {
+        qemuDomainObjClaimJob(obj);
+    } else {
+        if (qemuDomainObjBeginJob(driver, obj, VIR_JOB_MODIFY) < 0)
+            goto error;
+        jobStarted = true;
+    }
 
     /* XXX If we ever gonna change pid file pattern, come up with
      * some intelligence here to deal with old paths. */
@@ -9028,6 +9270,16 @@ qemuProcessReconnect(void *opaque)
     if (qemuSecurityReserveLabel(driver->securityManager, obj->def, obj->pid) < 0)
         goto error;
 
+    if (priv->autoNodeset)
+        qemuPlacementAddDomain(driver->placement, obj->def, priv->autoNodeset,
+                               virDomainDefGetVcpus(obj->def));
+
+    if (qemuProcessReserveHugepages(driver, obj, false) < 0) {
+        VIR_WARN("Unable to account for huge pages of domain %s: %s",
+                 obj->def->name, virGetLastErrorMessage());
+        virResetLastError();
+    }
+
     qemuProcessNotifyNets(obj->def);
 
     qemuProcessFiltersInstantiate(obj->def);
@@ -9126,10 +9378,12 @@ qemuProcessReconnect(void *opaque)
     if (!virDomainObjIsActive(obj))
         qemuDomainRemoveInactive(driver, obj);
     virDomainObjEndAPI(&obj);
+    qemuProcessReconnectFinished(driver, failed);
     virIdentitySetCurrent(NULL);
     return;
 
  error:
+    failed = true;
     if (virDomainObjIsActive(obj)) {
         /* We can't get the monitor back, so must kill the VM
          * to remove danger of it ending up running twice if
@@ -9158,6 +9412,19 @@ qemuProcessReconnect(void *opaque)
     goto cleanup;
 }
 
+static void
+qemuProcessReconnectWorker(void *jobdata,
+                           void *opaque)
+{
+    struct qemuProcessReconnectData *data = jobdata;
+    virQEMUDriver *driver = opaque;
+
+    virObjectLock(data->obj);
+    qemuProcessReconnect(data);
+    qemuProcessReconnectPoolRelease(driver);
+}
+
+
 static int
 qemuProcessReconnectHelper(virDomainObj *obj,
                            void *opaque)
@@ -9165,60 +9432,168 @@ qemuProcessReconnectHelper(virDomainObj *obj,
     virThread thread;
     struct qemuProcessReconnectData *src = opaque;
     struct qemuProcessReconnectData *data;
+    virThreadPool *pool = src->driver->reconnectPool;
     g_autofree char *name = NULL;
 
     /* If the VM was inactive, we don't need to reconnect */
     if (obj->pid == 0)
         return 0;
 
-    data = g_new0(struct qemuProcessReconnectData, 1);
-
-    memcpy(data, src, sizeof(*data));
-    data->obj = obj;
-    data->identity = virIdentityGetCurrent();
-
     /* this lock and reference will be eventually transferred to the thread
      * that handles the reconnect */
     virObjectLock(obj);
+
+    if (pool) {
+        qemuDomainObjPrivate *priv = obj->privateData;
+        bool priority = priv->job.asyncJob != VIR_ASYNC_JOB_NONE;
+
+        if (priority != src->priority) {
+            virObjectUnlock(obj);
+            return 0;
+        }
+    }
+
     virObjectRef(obj);
 
-    name = g_strdup_printf("init-%s", obj->def->name);
+    data = g_new0(struct qemuProcessReconnectData, 1);
+    data->driver = src->driver;
+    data->obj = obj;
+    data->identity = virIdentityGetCurrent();
 
-    if (virThreadCreateFull(&thread, false, qemuProcessReconnect,
-                            name, false, data) < 0) {
-        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
-                       _("Could not create thread. QEMU initialization "
-                         "might be incomplete"));
-        /* We can't spawn a thread and thus connect to monitor. Kill qemu.
-         * It's safe to call qemuProcessStop without a job here since there
-         * is no thread that could be doing anything else with the same domain
-         * object.
-         */
-        qemuProcessStop(src->driver, obj, VIR_DOMAIN_SHUTOFF_FAILED,
-                        VIR_ASYNC_JOB_NONE, 0);
-        qemuDomainRemoveInactiveLocked(src->driver, obj);
+    if (pool) {
+        /* The domain waits in the queue unlocked. Start the job for the
+         * worker right away so that APIs called on the domain meanwhile
+         * wait for the reconnect rather than finding no monitor. Once the
+         * job recorded in the status XML is preserved nobody else can hold
+         * one, so this doesn't wait. */
+        qemuDomainObjPreserveJob(obj, &data->oldjob);
+        if (qemuDomainObjBeginJobNowait(src->driver, obj, VIR_JOB_MODIFY) < 0) {
+            virReportError(VIR_ERR_OPERATION_FAILED,
+                           _("cannot acquire job to reconnect to domain '%s'"),
+                           obj->def->name);
+            goto error;
+        }
+        data->jobStarted = true;
 
-        virDomainObjEndAPI(&obj);
-        g_clear_object(&data->identity);
-        VIR_FREE(data);
-        return -1;
+        virObjectUnlock(obj);
+
+        g_atomic_int_inc(&src->driver->reconnectPending);
+        if (virThreadPoolSendJob(pool, src->priority, data) == 0)
+            return 0;
+
+        qemuProcessReconnectPoolRelease(src->driver);
+        virObjectLock(obj);
+        qemuDomainObjEndJob(obj);
+    } else {
+        name = g_strdup_printf("init-%s", obj->def->name);
+
+        if (virThreadCreateFull(&thread, false, qemuProcessReconnect,
+                                name, false, data) == 0)
+            return 0;
     }
 
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("Could not create thread. QEMU initialization "
+                     "might be incomplete"));
+
+ error:
+    /* We can't hand the domain over to a thread and thus connect to
+     * monitor. Kill qemu.
+     * It's safe to call qemuProcessStop without a job here since there
+     * is no thread that could be doing anything else with the same domain
+     * object.
+     */
+    qemuProcessStop(src->driver, obj, VIR_DOMAIN_SHUTOFF_FAILED,
+                    VIR_ASYNC_JOB_NONE, 0);
+    qemuDomainRemoveInactiveLocked(src->driver, obj);
+
+    virDomainObjEndAPI(&obj);
+    qemuDomainObjClearJob(&data->oldjob);
+    g_clear_object(&data->identity);
+    VIR_FREE(data);
+    qemuProcessReconnectFinished(src->driver, true);
+    return -1;
+}
+
+
+static int
+qemuProcessReconnectCount(virDomainObj *obj,
+                          void *opaque)
+{
+    int *count = opaque;
+
+    if (obj->pid != 0)
+        (*count)++;
+
     return 0;
 }
 
+
 /**
  * qemuProcessReconnectAll
  *
  * Try to re-open the resources for live VMs that we care
  * about.
+ *
+ * Unless reconnect_workers is set in qemu.conf, each domain is handled by
+ * its own thread. Otherwise the domains are handed over to a pool of
+ * workers, those with an async job to recover first. The pool is freed
+ * once all of them are reconnected.
  */
 void
 qemuProcessReconnectAll(virQEMUDriver *driver)
 {
+    g_autoptr(virQEMUDriverConfig) cfg = virQEMUDriverGetConfig(driver);
     struct qemuProcessReconnectData data = {.driver = driver};
+    bool pooled = false;
+    int total = 0;
+
+    virDomainObjListForEach(driver->domains, false,
+                            qemuProcessReconnectCount, &total);
+
+    g_atomic_int_set(&driver->reconnectTotal, total);
+    g_atomic_int_set(&driver->reconnectDone, 0);
+    g_atomic_int_set(&driver->reconnectFailed, 0);
+
+    if (total == 0)
+        return;
+
+    VIR_INFO("Reconnecting to %d running domains", total);
+
+    if (cfg->reconnectWorkers > 0) {
+        g_autoptr(virIdentity) identity = virIdentityGetCurrent();
+
+        /* The priority worker makes sure domains with an async job are not
+         * stuck behind the rest of the queue. */
+        driver->reconnectPool = virThreadPoolNewFull(0, cfg->reconnectWorkers, 1,
+                                                     qemuProcessReconnectWorker,
+                                                     "qemu-reconnect",
+                                                     identity,
+                                                     driver);
+        if (!driver->reconnectPool) {
+            VIR_WARN("Failed to create reconnect worker pool, using a thread "
+                     "per domain");
+            virResetLastError();
+        }
+    }
+
+    pooled = !!driver->reconnectPool;
+
+    if (pooled) {
+        /* Keep the pool around until all domains are queued */
+        g_atomic_int_set(&driver->reconnectPending, 1);
+
+        data.priority = true;
+        virDomainObjListForEach(driver->domains, true,
+                                qemuProcessReconnectHelper, &data);
+        data.priority = false;
+    }
+
     virDomainObjListForEach(driver->domains, true,
                             qemuProcessReconnectHelper, &data);
+
+    if (pooled)
+        qemuProcessReconnectPoolRelease(driver);
 }
 
 
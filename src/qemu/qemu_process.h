@@ -47,6 +47,7 @@ int qemuProcessDestroyMemoryBackingPath(virQEMUDriver *driver,
                                         virDomainMemoryDef *mem);
 
 void qemuProcessReconnectAll(virQEMUDriver *driver);
+virThreadPool *qemuProcessReconnectPoolSteal(virQEMUDriver *driver);
 
 typedef struct _qemuProcessIncomingDef qemuProcessIncomingDef;
 struct _qemuProcessIncomingDef {
@@ -152,6 +153,12 @@ int qemuProcessBeginStopJob(virQEMUDriver *driver,
                             virDomainObj *vm,
                             virDomainJob job,
                             bool forceKill);
+void qemuProcessEventSubmit(virDomainObj *vm,
+                            qemuProcessEventType eventType,
+                            int action,
+                            int status,
+                            void *data);
+
 void qemuProcessStop(virQEMUDriver *driver,
                      virDomainObj *vm,
                      virDomainShutoffReason reason,
@@ -192,6 +199,8 @@ int qemuProcessSetupVcpu(virDomainObj *vm,
                          unsigned int vcpuid);
 int qemuProcessSetupIOThread(virDomainObj *vm,
                              virDomainIOThreadIDDef *iothread);
+int qemuProcessUpdateAutoPlacement(virDomainObj *vm,
+                                   virBitmap *nodeset);
 
 int qemuRefreshVirtioChannelState(virQEMUDriver *driver,
                                   virDomainObj *vm,
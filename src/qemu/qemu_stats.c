@@ -0,0 +1,295 @@
+/*
+ * qemu_stats.c: parallel collection of domain statistics
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "qemu_stats.h"
+#include "virerror.h"
+#include "virlog.h"
+#include "virthread.h"
+#include "virtime.h"
+
+#define VIR_FROM_THIS VIR_FROM_QEMU
+
+VIR_LOG_INIT("qemu.qemu_stats");
+
+
+typedef struct _qemuStatsItem qemuStatsItem;
+typedef struct _qemuStatsData qemuStatsData;
+
+struct _qemuStatsItem {
+    qemuStatsData *data;
+    virDomainObj *vm;
+
+    /* All of the following is protected by data->lock */
+    bool done;
+    bool abandoned; /* the deadline passed, results are discarded */
+    int rc;
+    virErrorPtr err;
+    virDomainStatsRecordPtr record;
+};
+
+/* Shared by the API thread and the stats workers. The API thread may
+ * return before workers which are stuck on a monitor finish, therefore
+ * the structure is reference counted and freed by whoever is last. */
+struct _qemuStatsData {
+    int refs; /* atomic */
+
+    virMutex lock;
+    virCond cond;
+    size_t pending; /* items neither done nor abandoned */
+    unsigned long long deadline; /* 0 if there is none */
+
+    qemuStatsCollectFunc collect;
+    void *opaque;
+    virFreeCallback opaqueFree;
+
+    qemuStatsItem *items;
+    size_t nitems;
+};
+
+
+static void
+qemuStatsDataUnref(qemuStatsData *data)
+{
+    size_t i;
+
+    if (!g_atomic_int_dec_and_test(&data->refs))
+        return;
+
+    for (i = 0; i < data->nitems; i++) {
+        virObjectUnref(data->items[i].vm);
+        virFreeError(data->items[i].err);
+        if (data->items[i].record) {
+            virDomainStatsRecordPtr *list = g_new0(virDomainStatsRecordPtr, 2);
+
+            list[0] = data->items[i].record;
+            virDomainStatsRecordListFree(list);
+        }
+    }
+
+    if (data->opaqueFree)
+        data->opaqueFree(data->opaque);
+    virMutexDestroy(&data->lock);
+    virCondDestroy(&data->cond);
+    g_free(data->items);
+    g_free(data);
+}
+
+
+/**
+ * qemuStatsWorker:
+ *
+ * Job function of the thread pool passed to qemuStatsCollectParallel.
+ */
+void
+qemuStatsWorker(void *jobdata,
+                void *opaque G_GNUC_UNUSED)
+{
+    qemuStatsItem *item = jobdata;
+    qemuStatsData *data = item->data;
+    virDomainStatsRecordPtr record = NULL;
+    bool abandoned;
+    int rc;
+
+    /* Don't bother with domains the API thread gave up on while they were
+     * waiting in the queue */
+    virMutexLock(&data->lock);
+    abandoned = item->abandoned;
+    virMutexUnlock(&data->lock);
+
+    if (abandoned)
+        goto cleanup;
+
+    rc = data->collect(item->vm, &record, data->opaque);
+
+    virMutexLock(&data->lock);
+    item->rc = rc;
+    item->record = g_steal_pointer(&record);
+    if (rc < 0)
+        virErrorPreserveLast(&item->err);
+    item->done = true;
+    if (!item->abandoned) {
+        data->pending--;
+        virCondSignal(&data->cond);
+    }
+    virMutexUnlock(&data->lock);
+
+ cleanup:
+    virResetLastError();
+    qemuStatsDataUnref(data);
+}
+
+
+/**
+ * qemuStatsCollectParallel:
+ * @pool: thread pool running qemuStatsWorker
+ * @vms: domains to gather statistics of
+ * @nvms: number of domains in @vms
+ * @timeout: time limit for the whole call in milliseconds, 0 for none
+ * @collect: gathers all statistics of a domain, run in the pool
+ * @partial: gathers the statistics which don't need the monitor
+ * @opaque: data passed to @collect and @partial
+ * @opaqueFree: frees @opaque once no worker uses it anymore
+ * @retStats: array of at least @nvms records filled in
+ *
+ * Gathers statistics of @vms using @pool. The deadline is set when the
+ * domains are queued, so domains which are not done within @timeout
+ * milliseconds are reported by @partial whether a worker already picked
+ * them up or not. Workers stuck in @collect may outlive the call, hence
+ * @opaque is owned by this function and freed by @opaqueFree.
+ *
+ * Returns number of records stored into @retStats or -1 on error.
+ */
+int
+qemuStatsCollectParallel(virThreadPool *pool,
+                         virDomainObj **vms,
+                         size_t nvms,
+                         unsigned int timeout,
+                         qemuStatsCollectFunc collect,
+                         qemuStatsCollectFunc partial,
+                         void *opaque,
+                         virFreeCallback opaqueFree,
+                         virDomainStatsRecordPtr *retStats)
+{
+    qemuStatsData *data;
+    g_autofree bool *usePartial = g_new0(bool, nvms);
+    virErrorPtr err = NULL;
+    bool failed = false;
+    int nstats = 0;
+    size_t i;
+
+    data = g_new0(qemuStatsData, 1);
+    data->refs = 1;
+    data->collect = collect;
+    data->opaque = opaque;
+    data->opaqueFree = opaqueFree;
+    data->items = g_new0(qemuStatsItem, nvms);
+    data->nitems = nvms;
+    data->pending = nvms;
+
+    if (virMutexInit(&data->lock) < 0 ||
+        virCondInit(&data->cond) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("cannot initialize stats collection"));
+        if (opaqueFree)
+            opaqueFree(opaque);
+        g_free(data->items);
+        g_free(data);
+        return -1;
+    }
+
+    for (i = 0; i < nvms; i++) {
+        data->items[i].data = data;
+        data->items[i].vm = virObjectRef(vms[i]);
+    }
+
+    if (timeout > 0) {
+        unsigned long long now = 0;
+
+        ignore_value(virTimeMillisNow(&now));
+        data->deadline = now + timeout;
+    }
+
+    for (i = 0; i < nvms; i++) {
+        g_atomic_int_inc(&data->refs);
+
+        /* If the pool is shutting down process the domain ourselves */
+        if (virThreadPoolSendJob(pool, 0, &data->items[i]) < 0)
+            qemuStatsWorker(&data->items[i], NULL);
+    }
+
+    virMutexLock(&data->lock);
+    while (data->pending > 0) {
+        unsigned long long now = 0;
+
+        if (data->deadline == 0) {
+            ignore_value(virCondWait(&data->cond, &data->lock));
+            continue;
+        }
+
+        ignore_value(virTimeMillisNow(&now));
+
+        if (now < data->deadline) {
+            ignore_value(virCondWaitUntil(&data->cond, &data->lock,
+                                          data->deadline));
+            continue;
+        }
+
+        for (i = 0; i < nvms; i++) {
+            qemuStatsItem *item = &data->items[i];
+
+            if (item->done || item->abandoned)
+                continue;
+
+            VIR_WARN("Statistics for domain '%s' not gathered within %ums, "
+                     "reporting partial results",
+                     item->vm->def->name, timeout);
+            item->abandoned = true;
+            data->pending--;
+        }
+    }
+
+    /* Take over the results of finished workers. Abandoned workers which
+     * are still running will discard theirs once they finish. */
+    for (i = 0; i < nvms; i++) {
+        qemuStatsItem *item = &data->items[i];
+
+        if (!item->done) {
+            usePartial[i] = true;
+            continue;
+        }
+
+        if (item->rc < 0) {
+            if (!failed)
+                err = g_steal_pointer(&item->err);
+            failed = true;
+            continue;
+        }
+
+        retStats[i] = g_steal_pointer(&item->record);
+    }
+    virMutexUnlock(&data->lock);
+
+    for (i = 0; i < nvms && !failed; i++) {
+        if (!usePartial[i])
+            continue;
+
+        if (partial(vms[i], &retStats[i], data->opaque) < 0) {
+            virErrorPreserveLast(&err);
+            failed = true;
+        }
+    }
+
+    qemuStatsDataUnref(data);
+
+    /* compact the array in case some domain failed */
+    for (i = 0; i < nvms; i++) {
+        if (retStats[i])
+            retStats[nstats++] = retStats[i];
+    }
+    for (i = nstats; i < nvms; i++)
+        retStats[i] = NULL;
+
+    if (failed) {
+        virErrorRestore(&err);
+        return -1;
+    }
+
+    return nstats;
+}
@@ -0,0 +1,44 @@
+/*
+ * qemu_stats.h: parallel collection of domain statistics
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "internal.h"
+#include "domain_conf.h"
+#include "virthreadpool.h"
+
+typedef int (*qemuStatsCollectFunc)(virDomainObj *vm,
+                                    virDomainStatsRecordPtr *record,
+                                    void *opaque);
+
+void
+qemuStatsWorker(void *jobdata,
+                void *opaque);
+
+int
+qemuStatsCollectParallel(virThreadPool *pool,
+                         virDomainObj **vms,
+                         size_t nvms,
+                         unsigned int timeout,
+                         qemuStatsCollectFunc collect,
+                         qemuStatsCollectFunc partial,
+                         void *opaque,
+                         virFreeCallback opaqueFree,
+                         virDomainStatsRecordPtr *retStats)
+    ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(5) ATTRIBUTE_NONNULL(6)
+    ATTRIBUTE_NONNULL(9);
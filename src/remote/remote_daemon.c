@@ -361,6 +361,12 @@ daemonSetupNetworking(virNetServer *srv,
                 return -1;
         }
 
+        if (virNetTLSContextSetSessionTickets(ctxt, config->tls_session_tickets) < 0 ||
+            virNetTLSContextSetKTLS(ctxt, config->tls_ktls) < 0) {
+            virObjectUnref(ctxt);
+            return -1;
+        }
+
         VIR_DEBUG("Registering TLS socket %s:%s",
                   config->listen_addr, config->tls_port);
         if (virNetServerAddServiceTCP(srv,
@@ -1038,6 +1044,21 @@ int main(int argc, char **argv) {
         goto cleanup;
     }
 
+    virNetMessagePoolSetLimit((size_t)config->message_pool_size * 1024 * 1024);
+
+    if (virNetServerSetIOLoops(srv, config->io_loops) < 0) {
+        ret = VIR_DAEMON_ERR_INIT;
+        goto cleanup;
+    }
+
+    if (virNetServerSetSchedulerParameters(srv,
+                                           config->fair_scheduling ? 1 : 0,
+                                           config->fair_weight_readonly,
+                                           config->fair_weight_readwrite) < 0) {
+        ret = VIR_DAEMON_ERR_INIT;
+        goto cleanup;
+    }
+
     if (virNetDaemonAddServer(dmn, srv) < 0) {
         ret = VIR_DAEMON_ERR_INIT;
         goto cleanup;
@@ -37,6 +37,7 @@
 typedef struct daemonClientStream daemonClientStream;
 typedef struct daemonClientPrivate daemonClientPrivate;
 typedef struct daemonClientEventCallback daemonClientEventCallback;
+typedef struct daemonClientEventBatch daemonClientEventBatch;
 
 /* Stores the per-client connection state */
 struct daemonClientPrivate {
@@ -55,7 +56,9 @@ struct daemonClientPrivate {
     size_t nnodeDeviceEventCallbacks;
     daemonClientEventCallback **secretEventCallbacks;
     size_t nsecretEventCallbacks;
+    daemonClientEventBatch *eventBatch; /* NULL unless batching was requested */
     bool closeRegistered;
+    bool streamLargePayload; /* client accepts large stream data packets */
 
 #if WITH_SASL
     virNetSASLSession *sasl;
@@ -105,6 +105,7 @@ daemonConfigNew(bool privileged G_GNUC_UNUSED)
 
     data->tls_port = g_strdup(LIBVIRTD_TLS_PORT);
     data->tcp_port = g_strdup(LIBVIRTD_TCP_PORT);
+    data->tls_session_tickets = true;
 #endif /* !WITH_IP */
 
     /* Only default to PolicyKit if running as root */
@@ -144,9 +145,15 @@ daemonConfigNew(bool privileged G_GNUC_UNUSED)
     data->max_anonymous_clients = 20;
 
     data->prio_workers = 5;
+    data->io_loops = 0;
+    data->fair_scheduling = 0;
+    data->fair_weight_readonly = 1;
+    data->fair_weight_readwrite = 1;
 
     data->max_client_requests = 5;
 
+    data->message_pool_size = 16;
+
     data->audit_level = 1;
     data->audit_logging = false;
 
@@ -303,6 +310,10 @@ daemonConfigLoadOptions(struct daemonConfig *data,
 
     if (virConfGetValueString(conf, "tls_priority", &data->tls_priority) < 0)
         return -1;
+    if (virConfGetValueBool(conf, "tls_session_tickets", &data->tls_session_tickets) < 0)
+        return -1;
+    if (virConfGetValueBool(conf, "tls_ktls", &data->tls_ktls) < 0)
+        return -1;
 
     if ((rc = virConfGetValueUInt(conf, "tcp_min_ssf", &data->tcp_min_ssf)) < 0) {
         return -1;
@@ -338,9 +349,22 @@ daemonConfigLoadOptions(struct daemonConfig *data,
     if (virConfGetValueUInt(conf, "prio_workers", &data->prio_workers) < 0)
         return -1;
 
+    if (virConfGetValueUInt(conf, "io_loops", &data->io_loops) < 0)
+        return -1;
+
+    if (virConfGetValueUInt(conf, "fair_scheduling", &data->fair_scheduling) < 0)
+        return -1;
+    if (virConfGetValueUInt(conf, "fair_weight_readonly", &data->fair_weight_readonly) < 0)
+        return -1;
+    if (virConfGetValueUInt(conf, "fair_weight_readwrite", &data->fair_weight_readwrite) < 0)
+        return -1;
+
     if (virConfGetValueUInt(conf, "max_client_requests", &data->max_client_requests) < 0)
         return -1;
 
+    if (virConfGetValueUInt(conf, "message_pool_size", &data->message_pool_size) < 0)
+        return -1;
+
     if (virConfGetValueUInt(conf, "admin_min_workers", &data->admin_min_workers) < 0)
         return -1;
     if (virConfGetValueUInt(conf, "admin_max_workers", &data->admin_max_workers) < 0)
@@ -56,6 +56,8 @@ struct daemonConfig {
     bool tls_no_sanity_certificate;
     char **tls_allowed_dn_list;
     char *tls_priority;
+    bool tls_session_tickets;
+    bool tls_ktls;
     unsigned int tcp_min_ssf;
 
     char *key_file;
@@ -74,8 +76,16 @@ struct daemonConfig {
 
     unsigned int prio_workers;
 
+    unsigned int io_loops;
+
+    unsigned int fair_scheduling;
+    unsigned int fair_weight_readonly;
+    unsigned int fair_weight_readwrite;
+
     unsigned int max_client_requests;
 
+    unsigned int message_pool_size;
+
     unsigned int log_level;
     char *log_filters;
     char *log_outputs;
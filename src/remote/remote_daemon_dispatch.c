@@ -32,6 +32,7 @@
 #include "remote_daemon_stream.h"
 #include "virnetserverservice.h"
 #include "virnetserver.h"
+#include "virneteventbatch.h"
 #include "virfile.h"
 #include "virtypedparam.h"
 #include "remote_protocol.h"
@@ -75,8 +76,21 @@ struct daemonClientEventCallback {
     int eventID;
     int callbackID;
     bool legacy;
+    bool batch; /* queue events in daemonClientPrivate's eventBatch */
+    bool coalesce; /* drop superseded events from the batch */
 };
 
+/* Domain events waiting to be sent in a single
+ * REMOTE_PROC_DOMAIN_EVENT_CALLBACK_BATCH message */
+struct daemonClientEventBatch {
+    int timer;
+    unsigned int window; /* delay of the first queued event, in ms */
+    virNetEventBatch queue;
+};
+
+/* Send a batch as soon as its payload grows beyond this */
+#define REMOTE_EVENT_BATCH_SIZE_MAX (256 * 1024)
+
 static virDomainPtr get_nonnull_domain(virConnectPtr conn, remote_nonnull_domain domain);
 static virNetworkPtr get_nonnull_network(virConnectPtr conn, remote_nonnull_network network);
 static virNetworkPortPtr get_nonnull_network_port(virConnectPtr conn, remote_nonnull_network_port port);
@@ -137,6 +151,12 @@ remoteDispatchObjectEventSend(virNetServerClient *client,
                               int procnr,
                               xdrproc_t proc,
                               void *data);
+static void
+remoteDispatchDomainEventSend(daemonClientEventCallback *callback,
+                              virDomainPtr dom,
+                              int procnr,
+                              xdrproc_t proc,
+                              void *data);
 
 static void
 remoteEventCallbackFree(void *opaque)
@@ -338,7 +358,7 @@ remoteRelayDomainEventLifecycle(virConnectPtr conn,
         remote_domain_event_callback_lifecycle_msg msg = { callback->callbackID,
                                                            data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_LIFECYCLE,
                                       (xdrproc_t)xdr_remote_domain_event_callback_lifecycle_msg,
                                       &msg);
@@ -374,7 +394,7 @@ remoteRelayDomainEventReboot(virConnectPtr conn,
         remote_domain_event_callback_reboot_msg msg = { callback->callbackID,
                                                         data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_REBOOT,
                                       (xdrproc_t)xdr_remote_domain_event_callback_reboot_msg, &msg);
     }
@@ -413,7 +433,7 @@ remoteRelayDomainEventRTCChange(virConnectPtr conn,
         remote_domain_event_callback_rtc_change_msg msg = { callback->callbackID,
                                                             data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_RTC_CHANGE,
                                       (xdrproc_t)xdr_remote_domain_event_callback_rtc_change_msg, &msg);
     }
@@ -451,7 +471,7 @@ remoteRelayDomainEventWatchdog(virConnectPtr conn,
         remote_domain_event_callback_watchdog_msg msg = { callback->callbackID,
                                                           data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_WATCHDOG,
                                       (xdrproc_t)xdr_remote_domain_event_callback_watchdog_msg, &msg);
     }
@@ -494,7 +514,7 @@ remoteRelayDomainEventIOError(virConnectPtr conn,
         remote_domain_event_callback_io_error_msg msg = { callback->callbackID,
                                                           data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_IO_ERROR,
                                       (xdrproc_t)xdr_remote_domain_event_callback_io_error_msg, &msg);
     }
@@ -539,7 +559,7 @@ remoteRelayDomainEventIOErrorReason(virConnectPtr conn,
         remote_domain_event_callback_io_error_reason_msg msg = { callback->callbackID,
                                                                  data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_IO_ERROR_REASON,
                                       (xdrproc_t)xdr_remote_domain_event_callback_io_error_reason_msg, &msg);
     }
@@ -609,7 +629,7 @@ remoteRelayDomainEventGraphics(virConnectPtr conn,
         remote_domain_event_callback_graphics_msg msg = { callback->callbackID,
                                                           data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_GRAPHICS,
                                       (xdrproc_t)xdr_remote_domain_event_callback_graphics_msg, &msg);
     }
@@ -650,7 +670,7 @@ remoteRelayDomainEventBlockJob(virConnectPtr conn,
         remote_domain_event_callback_block_job_msg msg = { callback->callbackID,
                                                            data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_BLOCK_JOB,
                                       (xdrproc_t)xdr_remote_domain_event_callback_block_job_msg, &msg);
     }
@@ -686,7 +706,7 @@ remoteRelayDomainEventControlError(virConnectPtr conn,
         remote_domain_event_callback_control_error_msg msg = { callback->callbackID,
                                                                data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_CONTROL_ERROR,
                                       (xdrproc_t)xdr_remote_domain_event_callback_control_error_msg, &msg);
     }
@@ -739,7 +759,7 @@ remoteRelayDomainEventDiskChange(virConnectPtr conn,
         remote_domain_event_callback_disk_change_msg msg = { callback->callbackID,
                                                              data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_DISK_CHANGE,
                                       (xdrproc_t)xdr_remote_domain_event_callback_disk_change_msg, &msg);
     }
@@ -780,7 +800,7 @@ remoteRelayDomainEventTrayChange(virConnectPtr conn,
         remote_domain_event_callback_tray_change_msg msg = { callback->callbackID,
                                                              data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_TRAY_CHANGE,
                                       (xdrproc_t)xdr_remote_domain_event_callback_tray_change_msg, &msg);
     }
@@ -816,7 +836,7 @@ remoteRelayDomainEventPMWakeup(virConnectPtr conn,
         remote_domain_event_callback_pmwakeup_msg msg = { callback->callbackID,
                                                           reason, data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_PMWAKEUP,
                                       (xdrproc_t)xdr_remote_domain_event_callback_pmwakeup_msg, &msg);
     }
@@ -852,7 +872,7 @@ remoteRelayDomainEventPMSuspend(virConnectPtr conn,
         remote_domain_event_callback_pmsuspend_msg msg = { callback->callbackID,
                                                            reason, data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_PMSUSPEND,
                                       (xdrproc_t)xdr_remote_domain_event_callback_pmsuspend_msg, &msg);
     }
@@ -889,7 +909,7 @@ remoteRelayDomainEventBalloonChange(virConnectPtr conn,
         remote_domain_event_callback_balloon_change_msg msg = { callback->callbackID,
                                                                 data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_BALLOON_CHANGE,
                                       (xdrproc_t)xdr_remote_domain_event_callback_balloon_change_msg, &msg);
     }
@@ -926,7 +946,7 @@ remoteRelayDomainEventPMSuspendDisk(virConnectPtr conn,
         remote_domain_event_callback_pmsuspend_disk_msg msg = { callback->callbackID,
                                                                 reason, data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_PMSUSPEND_DISK,
                                       (xdrproc_t)xdr_remote_domain_event_callback_pmsuspend_disk_msg, &msg);
     }
@@ -966,7 +986,7 @@ remoteRelayDomainEventDeviceRemoved(virConnectPtr conn,
         remote_domain_event_callback_device_removed_msg msg = { callback->callbackID,
                                                                 data };
 
-        remoteDispatchObjectEventSend(callback->client, callback->program,
+        remoteDispatchDomainEventSend(callback, dom,
                                       REMOTE_PROC_DOMAIN_EVENT_CALLBACK_DEVICE_REMOVED,
                                       (xdrproc_t)xdr_remote_domain_event_callback_device_removed_msg,
                                       &msg);
@@ -1002,7 +1022,7 @@ remoteRelayDomainEventBlockJob2(virConnectPtr conn,
     data.status = status;
     make_nonnull_domain(&data.dom, dom);
 
-    remoteDispatchObjectEventSend(callback->client, callback->program,
+    remoteDispatchDomainEventSend(callback, dom,
                                   REMOTE_PROC_DOMAIN_EVENT_BLOCK_JOB_2,
                                   (xdrproc_t)xdr_remote_domain_event_block_job_2_msg, &data);
 
@@ -1041,7 +1061,7 @@ remoteRelayDomainEventTunable(virConnectPtr conn,
     make_nonnull_domain(&data.dom, dom);
 
 
-    remoteDispatchObjectEventSend(callback->client, callback->program,
+    remoteDispatchDomainEventSend(callback, dom,
                                   REMOTE_PROC_DOMAIN_EVENT_CALLBACK_TUNABLE,
                                   (xdrproc_t)xdr_remote_domain_event_callback_tunable_msg,
                                   &data);
@@ -1075,7 +1095,7 @@ remoteRelayDomainEventAgentLifecycle(virConnectPtr conn,
     data.state = state;
     data.reason = reason;
 
-    remoteDispatchObjectEventSend(callback->client, callback->program,
+    remoteDispatchDomainEventSend(callback, dom,
                                   REMOTE_PROC_DOMAIN_EVENT_CALLBACK_AGENT_LIFECYCLE,
                                   (xdrproc_t)xdr_remote_domain_event_callback_agent_lifecycle_msg,
                                   &data);
@@ -1107,7 +1127,7 @@ remoteRelayDomainEventDeviceAdded(virConnectPtr conn,
     make_nonnull_domain(&data.dom, dom);
     data.callbackID = callback->callbackID;
 
-    remoteDispatchObjectEventSend(callback->client, callback->program,
+    remoteDispatchDomainEventSend(callback, dom,
                                   REMOTE_PROC_DOMAIN_EVENT_CALLBACK_DEVICE_ADDED,
                                   (xdrproc_t)xdr_remote_domain_event_callback_device_added_msg,
                                   &data);
@@ -1140,7 +1160,7 @@ remoteRelayDomainEventMigrationIteration(virConnectPtr conn,
 
     data.iteration = iteration;
 
-    remoteDispatchObjectEventSend(callback->client, callback->program,
+    remoteDispatchDomainEventSend(callback, dom,
                                   REMOTE_PROC_DOMAIN_EVENT_CALLBACK_MIGRATION_ITERATION,
                                   (xdrproc_t)xdr_remote_domain_event_callback_migration_iteration_msg,
                                   &data);
@@ -1180,7 +1200,7 @@ remoteRelayDomainEventJobCompleted(virConnectPtr conn,
     data.callbackID = callback->callbackID;
     make_nonnull_domain(&data.dom, dom);
 
-    remoteDispatchObjectEventSend(callback->client, callback->program,
+    remoteDispatchDomainEventSend(callback, dom,
                                   REMOTE_PROC_DOMAIN_EVENT_CALLBACK_JOB_COMPLETED,
                                   (xdrproc_t)xdr_remote_domain_event_callback_job_completed_msg,
                                   &data);
@@ -1212,7 +1232,7 @@ remoteRelayDomainEventDeviceRemovalFailed(virConnectPtr conn,
     make_nonnull_domain(&data.dom, dom);
     data.callbackID = callback->callbackID;
 
-    remoteDispatchObjectEventSend(callback->client, callback->program,
+    remoteDispatchDomainEventSend(callback, dom,
                                   REMOTE_PROC_DOMAIN_EVENT_CALLBACK_DEVICE_REMOVAL_FAILED,
                                   (xdrproc_t)xdr_remote_domain_event_callback_device_removal_failed_msg,
                                   &data);
@@ -1250,7 +1270,7 @@ remoteRelayDomainEventMetadataChange(virConnectPtr conn,
     make_nonnull_domain(&data.dom, dom);
     data.callbackID = callback->callbackID;
 
-    remoteDispatchObjectEventSend(callback->client, callback->program,
+    remoteDispatchDomainEventSend(callback, dom,
                                   REMOTE_PROC_DOMAIN_EVENT_CALLBACK_METADATA_CHANGE,
                                   (xdrproc_t)xdr_remote_domain_event_callback_metadata_change_msg,
                                   &data);
@@ -1290,7 +1310,7 @@ remoteRelayDomainEventBlockThreshold(virConnectPtr conn,
     data.excess = excess;
     make_nonnull_domain(&data.dom, dom);
 
-    remoteDispatchObjectEventSend(callback->client, callback->program,
+    remoteDispatchDomainEventSend(callback, dom,
                                   REMOTE_PROC_DOMAIN_EVENT_BLOCK_THRESHOLD,
                                   (xdrproc_t)xdr_remote_domain_event_block_threshold_msg, &data);
 
@@ -1321,7 +1341,7 @@ remoteRelayDomainEventMemoryFailure(virConnectPtr conn,
     data.flags = flags;
     make_nonnull_domain(&data.dom, dom);
 
-    remoteDispatchObjectEventSend(callback->client, remoteProgram,
+    remoteDispatchDomainEventSend(callback, dom,
                                   REMOTE_PROC_DOMAIN_EVENT_MEMORY_FAILURE,
                                   (xdrproc_t)xdr_remote_domain_event_memory_failure_msg, &data);
 
@@ -1350,7 +1370,7 @@ remoteRelayDomainEventMemoryDeviceSizeChange(virConnectPtr conn,
     data.size = size;
     make_nonnull_domain(&data.dom, dom);
 
-    remoteDispatchObjectEventSend(callback->client, remoteProgram,
+    remoteDispatchDomainEventSend(callback, dom,
                                   REMOTE_PROC_DOMAIN_EVENT_MEMORY_DEVICE_SIZE_CHANGE,
                                   (xdrproc_t)xdr_remote_domain_event_memory_device_size_change_msg,
                                   &data);
@@ -1772,6 +1792,20 @@ void remoteClientFree(void *data)
 }
 
 
+static void
+remoteClientFreeEventBatch(daemonClientEventBatch *batch)
+{
+    if (!batch)
+        return;
+
+    if (batch->timer != -1)
+        virEventRemoveTimeout(batch->timer);
+
+    virNetEventBatchClear(&batch->queue);
+    g_free(batch);
+}
+
+
 static void remoteClientCloseFunc(virNetServerClient *client)
 {
     struct daemonClientPrivate *priv = virNetServerClientGetPrivateData(client);
@@ -1779,6 +1813,10 @@ static void remoteClientCloseFunc(virNetServerClient *client)
     daemonRemoveAllClientStreams(priv->streams);
 
     remoteClientFreePrivateCallbacks(priv);
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&priv->lock) {
+        remoteClientFreeEventBatch(g_steal_pointer(&priv->eventBatch));
+    }
 }
 
 
@@ -4291,6 +4329,144 @@ remoteDispatchObjectEventSend(virNetServerClient *client,
     xdr_free(proc, data);
 }
 
+
+/* Events which only report the current value of some property of the
+ * domain, so that a later one makes an earlier one useless */
+static bool
+remoteDomainEventIsCoalescable(int procnr)
+{
+    switch (procnr) {
+    case REMOTE_PROC_DOMAIN_EVENT_CALLBACK_RTC_CHANGE:
+    case REMOTE_PROC_DOMAIN_EVENT_CALLBACK_BALLOON_CHANGE:
+    case REMOTE_PROC_DOMAIN_EVENT_CALLBACK_MIGRATION_ITERATION:
+        return true;
+    }
+
+    return false;
+}
+
+
+/* Must be called with priv->lock held. The batch is sent before the lock
+ * is released so that no event queued or sent on its own later can get
+ * to the client first. */
+static void
+remoteDispatchDomainEventBatchFlushLocked(virNetServerClient *client,
+                                          daemonClientEventBatch *batch)
+{
+    remote_domain_event_callback_batch_msg data;
+    g_autofree virNetEventBatchItem *items = NULL;
+    size_t nitems;
+    size_t i;
+
+    if (!batch || !(nitems = virNetEventBatchSteal(&batch->queue, &items)))
+        return;
+
+    virEventUpdateTimeout(batch->timer, -1);
+
+    memset(&data, 0, sizeof(data));
+    data.events.events_val = g_new0(remote_domain_event_batch_entry, nitems);
+    data.events.events_len = nitems;
+    for (i = 0; i < nitems; i++) {
+        remote_domain_event_batch_entry *entry = &data.events.events_val[i];
+
+        entry->procedure = items[i].procnr;
+        entry->payload.payload_val = g_steal_pointer(&items[i].payload);
+        entry->payload.payload_len = items[i].len;
+    }
+
+    VIR_DEBUG("Flushing batch of %zu events", nitems);
+    remoteDispatchObjectEventSend(client, remoteProgram,
+                                  REMOTE_PROC_DOMAIN_EVENT_CALLBACK_BATCH,
+                                  (xdrproc_t)xdr_remote_domain_event_callback_batch_msg, &data);
+}
+
+
+static void
+remoteDispatchDomainEventBatchTimer(int timer G_GNUC_UNUSED,
+                                    void *opaque)
+{
+    virNetServerClient *client = opaque;
+    struct daemonClientPrivate *priv = virNetServerClientGetPrivateData(client);
+    VIR_LOCK_GUARD lock = virLockGuardLock(&priv->lock);
+
+    remoteDispatchDomainEventBatchFlushLocked(client, priv->eventBatch);
+}
+
+
+/**
+ * remoteDispatchDomainEventSend:
+ * @callback: the callback the event is for
+ * @dom: the domain the event is about
+ * @procnr: REMOTE_PROC_DOMAIN_EVENT_* number of the event
+ * @proc: XDR filter of the event message
+ * @data: the event message
+ *
+ * Like remoteDispatchObjectEventSend(), but if @callback was registered
+ * with a batching window, queue the event to be sent along with any
+ * other events arriving within the window. Frees @data.
+ */
+static void
+remoteDispatchDomainEventSend(daemonClientEventCallback *callback,
+                              virDomainPtr dom,
+                              int procnr,
+                              xdrproc_t proc,
+                              void *data)
+{
+    struct daemonClientPrivate *priv;
+    virNetEventBatchItem item = { 0 };
+    daemonClientEventBatch *batch;
+    XDR xdr;
+    VIR_LOCK_GUARD lock = { NULL };
+
+    if (!callback->batch) {
+        remoteDispatchObjectEventSend(callback->client, callback->program,
+                                      procnr, proc, data);
+        return;
+    }
+
+    priv = virNetServerClientGetPrivateData(callback->client);
+
+    item.procnr = procnr;
+    item.callbackID = callback->callbackID;
+    memcpy(item.uuid, dom->uuid, VIR_UUID_BUFLEN);
+    item.payload = g_new0(char, REMOTE_DOMAIN_EVENT_BATCH_PAYLOAD_MAX);
+
+    /* Events too large for a batch are sent on their own */
+    xdrmem_create(&xdr, item.payload, REMOTE_DOMAIN_EVENT_BATCH_PAYLOAD_MAX,
+                  XDR_ENCODE);
+    if ((*proc)(&xdr, data, 0)) {
+        item.len = xdr_getpos(&xdr);
+        item.payload = g_realloc(item.payload, item.len);
+    }
+    xdr_destroy(&xdr);
+
+    /* Both queueing and sending happen with the lock held, which keeps the
+     * events in order even when a batch is flushed concurrently by its
+     * timer */
+    lock = virLockGuardLock(&priv->lock);
+    batch = priv->eventBatch;
+
+    if (!batch || !item.len) {
+        g_free(item.payload);
+        remoteDispatchDomainEventBatchFlushLocked(callback->client, batch);
+        remoteDispatchObjectEventSend(callback->client, callback->program,
+                                      procnr, proc, data);
+        return;
+    }
+
+    virNetEventBatchAdd(&batch->queue, &item,
+                        callback->coalesce &&
+                        remoteDomainEventIsCoalescable(procnr));
+    xdr_free(proc, data);
+
+    if (batch->queue.nitems == REMOTE_DOMAIN_EVENT_BATCH_MAX ||
+        batch->queue.size >= REMOTE_EVENT_BATCH_SIZE_MAX)
+        remoteDispatchDomainEventBatchFlushLocked(callback->client, batch);
+    else if (batch->queue.nitems == 1)
+        virEventUpdateTimeout(batch->timer, batch->window);
+}
+
+
 static int
 remoteDispatchSecretGetValue(virNetServer *server G_GNUC_UNUSED,
                              virNetServerClient *client,
@@ -4432,15 +4608,25 @@ remoteDispatchConnectDomainEventRegisterAny(virNetServer *server G_GNUC_UNUSED,
 }
 
 
+/**
+ * remoteConnectDomainEventCallbackRegister:
+ * @client: the client registering the callback
+ * @eventID: the event to register for
+ * @domain: limit events to this domain if non-NULL
+ * @window: batch events for this many milliseconds, or 0
+ * @flags: bitwise-OR of remote_domain_event_callback_register_flags
+ * @callbackID: filled with the ID of the callback
+ *
+ * Returns 0 on success, -1 on error.
+ */
 static int
-remoteDispatchConnectDomainEventCallbackRegisterAny(virNetServer *server G_GNUC_UNUSED,
-                                                    virNetServerClient *client,
-                                                    virNetMessage *msg G_GNUC_UNUSED,
-                                                    struct virNetMessageError *rerr G_GNUC_UNUSED,
-                                                    remote_connect_domain_event_callback_register_any_args *args,
-                                                    remote_connect_domain_event_callback_register_any_ret *ret)
+remoteConnectDomainEventCallbackRegister(virNetServerClient *client,
+                                         int eventID,
+                                         remote_domain domain,
+                                         unsigned int window,
+                                         unsigned int flags,
+                                         int *callbackID)
 {
-    int callbackID;
     int rv = -1;
     daemonClientEventCallback *callback = NULL;
     daemonClientEventCallback *ref;
@@ -4453,16 +4639,51 @@ remoteDispatchConnectDomainEventCallbackRegisterAny(virNetServer *server G_GNUC_
     if (!conn)
         goto cleanup;
 
-    if (args->dom &&
-        !(dom = get_nonnull_domain(conn, *args->dom)))
+    if (flags & ~REMOTE_DOMAIN_EVENT_CALLBACK_COALESCE) {
+        virReportError(VIR_ERR_INVALID_ARG,
+                       _("unsupported flags (0x%x)"),
+                       flags & ~REMOTE_DOMAIN_EVENT_CALLBACK_COALESCE);
+        goto cleanup;
+    }
+
+    if (window > REMOTE_DOMAIN_EVENT_BATCH_WINDOW_MAX) {
+        virReportError(VIR_ERR_INVALID_ARG,
+                       _("event batch window %u ms is larger than %u ms"),
+                       window, REMOTE_DOMAIN_EVENT_BATCH_WINDOW_MAX);
         goto cleanup;
+    }
 
-    if (args->eventID >= VIR_DOMAIN_EVENT_ID_LAST || args->eventID < 0) {
+    if (domain &&
+        !(dom = get_nonnull_domain(conn, *domain)))
+        goto cleanup;
+
+    if (eventID >= VIR_DOMAIN_EVENT_ID_LAST || eventID < 0) {
         virReportError(VIR_ERR_INTERNAL_ERROR, _("unsupported event ID %d"),
-                       args->eventID);
+                       eventID);
         goto cleanup;
     }
 
+    if (window > 0 && !priv->eventBatch) {
+        g_autofree daemonClientEventBatch *batch = g_new0(daemonClientEventBatch, 1);
+
+        if ((batch->timer = virEventAddTimeout(-1,
+                                               remoteDispatchDomainEventBatchTimer,
+                                               client,
+                                               virObjectUnref)) < 0) {
+            virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                           _("could not initialize event batch timer"));
+            goto cleanup;
+        }
+        virObjectRef(client);
+        batch->window = window;
+        priv->eventBatch = g_steal_pointer(&batch);
+    }
+
+    /* Events of all callbacks go in a single batch, so the shortest
+     * window wins */
+    if (window > 0 && window < priv->eventBatch->window)
+        priv->eventBatch->window = window;
+
     /* If we call register first, we could append a complete callback
      * to our array, but on OOM append failure, we'd have to then hope
      * deregister works to undo our register.  So instead we append an
@@ -4472,39 +4693,77 @@ remoteDispatchConnectDomainEventCallbackRegisterAny(virNetServer *server G_GNUC_
     callback = g_new0(daemonClientEventCallback, 1);
     callback->client = virObjectRef(client);
     callback->program = virObjectRef(remoteProgram);
-    callback->eventID = args->eventID;
+    callback->eventID = eventID;
     callback->callbackID = -1;
+    callback->batch = window > 0;
+    callback->coalesce = !!(flags & REMOTE_DOMAIN_EVENT_CALLBACK_COALESCE);
     ref = callback;
     VIR_APPEND_ELEMENT(priv->domainEventCallbacks,
                        priv->ndomainEventCallbacks,
                        callback);
 
-    if ((callbackID = virConnectDomainEventRegisterAny(conn,
-                                                       dom,
-                                                       args->eventID,
-                                                       domainEventCallbacks[args->eventID],
-                                                       ref,
-                                                       remoteEventCallbackFree)) < 0) {
+    if ((*callbackID = virConnectDomainEventRegisterAny(conn,
+                                                        dom,
+                                                        eventID,
+                                                        domainEventCallbacks[eventID],
+                                                        ref,
+                                                        remoteEventCallbackFree)) < 0) {
         VIR_SHRINK_N(priv->domainEventCallbacks,
                      priv->ndomainEventCallbacks, 1);
         callback = ref;
         goto cleanup;
     }
 
-    ref->callbackID = callbackID;
-    ret->callbackID = callbackID;
+    ref->callbackID = *callbackID;
 
     rv = 0;
 
  cleanup:
     remoteEventCallbackFree(callback);
-    if (rv < 0)
-        virNetMessageSaveError(rerr);
     virObjectUnref(dom);
     return rv;
 }
 
 
+static int
+remoteDispatchConnectDomainEventCallbackRegisterAny(virNetServer *server G_GNUC_UNUSED,
+                                                    virNetServerClient *client,
+                                                    virNetMessage *msg G_GNUC_UNUSED,
+                                                    struct virNetMessageError *rerr G_GNUC_UNUSED,
+                                                    remote_connect_domain_event_callback_register_any_args *args,
+                                                    remote_connect_domain_event_callback_register_any_ret *ret)
+{
+    if (remoteConnectDomainEventCallbackRegister(client, args->eventID,
+                                                 args->dom, 0, 0,
+                                                 &ret->callbackID) < 0) {
+        virNetMessageSaveError(rerr);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+remoteDispatchConnectDomainEventCallbackRegisterAnyFlags(virNetServer *server G_GNUC_UNUSED,
+                                                         virNetServerClient *client,
+                                                         virNetMessage *msg G_GNUC_UNUSED,
+                                                         struct virNetMessageError *rerr G_GNUC_UNUSED,
+                                                         remote_connect_domain_event_callback_register_any_flags_args *args,
+                                                         remote_connect_domain_event_callback_register_any_flags_ret *ret)
+{
+    if (remoteConnectDomainEventCallbackRegister(client, args->eventID,
+                                                 args->dom, args->window,
+                                                 args->flags,
+                                                 &ret->callbackID) < 0) {
+        virNetMessageSaveError(rerr);
+        return -1;
+    }
+
+    return 0;
+}
+
+
 static int
 remoteDispatchConnectDomainEventDeregisterAny(virNetServer *server G_GNUC_UNUSED,
                                               virNetServerClient *client,
@@ -4941,6 +5200,7 @@ static int remoteDispatchConnectSupportsFeature(virNetServer *server G_GNUC_UNUS
     int rv = -1;
     int supported = -1;
     virConnectPtr conn = NULL;
+    struct daemonClientPrivate *priv = virNetServerClientGetPrivateData(client);
 
     /* This feature is checked before opening the connection, thus we must
      * check it first.
@@ -4961,6 +5221,21 @@ static int remoteDispatchConnectSupportsFeature(virNetServer *server G_GNUC_UNUS
     case VIR_DRV_FEATURE_FD_PASSING:
     case VIR_DRV_FEATURE_REMOTE_EVENT_CALLBACK:
     case VIR_DRV_FEATURE_REMOTE_CLOSE_CALLBACK:
+    case VIR_DRV_FEATURE_REMOTE_EVENT_BATCH:
+        supported = 1;
+        break;
+    case VIR_DRV_FEATURE_REMOTE_STREAM_LARGE_PAYLOAD:
+        /* A client asking about this feature is able to cope with
+         * the larger packets, so start sending them on new streams */
+        VIR_WITH_MUTEX_LOCK_GUARD(&priv->lock) {
+            priv->streamLargePayload = true;
+        }
+        supported = 1;
+        break;
+    case VIR_DRV_FEATURE_REMOTE_COMPRESSION:
+        /* A client asking about this feature is able to decompress
+         * messages, so start compressing the large ones */
+        virNetServerClientSetCompression(client, true);
         supported = 1;
         break;
     case VIR_DRV_FEATURE_MIGRATION_V1:
@@ -6782,6 +7057,78 @@ remoteDispatchConnectGetAllDomainStats(virNetServer *server G_GNUC_UNUSED,
 }
 
 
+static int
+remoteDispatchDomainListGetInfo(virNetServer *server G_GNUC_UNUSED,
+                                virNetServerClient *client,
+                                virNetMessage *msg G_GNUC_UNUSED,
+                                struct virNetMessageError *rerr,
+                                remote_domain_list_get_info_args *args,
+                                remote_domain_list_get_info_ret *ret)
+{
+    int rv = -1;
+    size_t i;
+    virDomainStatsRecordPtr *retInfo = NULL;
+    int nrecords = 0;
+    virDomainPtr *doms = NULL;
+    virConnectPtr conn = remoteGetHypervisorConn(client);
+
+    if (!conn)
+        goto cleanup;
+
+    doms = g_new0(virDomainPtr, args->doms.doms_len + 1);
+
+    for (i = 0; i < args->doms.doms_len; i++) {
+        if (!(doms[i] = get_nonnull_domain(conn, args->doms.doms_val[i])))
+            goto cleanup;
+    }
+
+    if ((nrecords = virDomainListGetInfo(doms,
+                                         args->fields,
+                                         &retInfo,
+                                         args->flags)) < 0)
+        goto cleanup;
+
+    if (nrecords > REMOTE_DOMAIN_LIST_MAX) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Number of domain info records is %d, "
+                         "which exceeds max limit: %d"),
+                       nrecords, REMOTE_DOMAIN_LIST_MAX);
+        goto cleanup;
+    }
+
+    ret->retInfo.retInfo_val = g_new0(remote_domain_stats_record, nrecords);
+    ret->retInfo.retInfo_len = nrecords;
+
+    for (i = 0; i < nrecords; i++) {
+        remote_domain_stats_record *dst = ret->retInfo.retInfo_val + i;
+
+        make_nonnull_domain(&dst->dom, retInfo[i]->dom);
+
+        if (virTypedParamsSerialize(retInfo[i]->params,
+                                    retInfo[i]->nparams,
+                                    REMOTE_CONNECT_GET_ALL_DOMAIN_STATS_MAX,
+                                    (struct _virTypedParameterRemote **) &dst->params.params_val,
+                                    &dst->params.params_len,
+                                    VIR_TYPED_PARAM_STRING_OKAY) < 0)
+            goto cleanup;
+    }
+
+    rv = 0;
+
+ cleanup:
+    if (rv < 0) {
+        virNetMessageSaveError(rerr);
+        xdr_free((xdrproc_t)xdr_remote_domain_list_get_info_ret,
+                 (char *) ret);
+    }
+
+    virDomainStatsRecordListFree(retInfo);
+    virObjectListFree(doms);
+
+    return rv;
+}
+
+
 static int
 remoteDispatchNodeAllocPages(virNetServer *server G_GNUC_UNUSED,
                              virNetServerClient *client,
@@ -53,6 +53,9 @@ struct daemonClientStream {
     bool allowSkip;
     size_t dataLen; /* How much data is there remaining until we see a hole */
 
+    size_t chunkLen; /* Size of the next data packet read from the stream */
+    size_t chunkMax; /* Upper limit of chunkLen agreed upon with the client */
+
     daemonClientStream *next;
 };
 
@@ -367,6 +370,13 @@ daemonCreateClientStream(virNetServerClient *client,
     stream->filterID = -1;
     stream->st = st;
     stream->allowSkip = allowSkip;
+    stream->chunkLen = VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX;
+    stream->chunkMax = VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&priv->lock) {
+        if (priv->streamLargePayload)
+            stream->chunkMax = VIR_NET_MESSAGE_STREAM_PAYLOAD_MAX;
+    }
 
     return stream;
 }
@@ -805,6 +815,30 @@ daemonStreamHandleWrite(virNetServerClient *client,
 
 
 
+/*
+ * Grow the size of data packets while the stream keeps filling
+ * them up completely, so that bulk transfers need fewer round
+ * trips through the event loop, and shrink it again once the
+ * source is not able to keep up.
+ */
+static void
+daemonStreamAdjustChunk(daemonClientStream *stream,
+                        size_t want,
+                        size_t got)
+{
+    /* Reads cut short by an upcoming hole say nothing about the source */
+    if (want < stream->chunkLen)
+        return;
+
+    if (got == want) {
+        stream->chunkLen = MIN(stream->chunkLen * 2, stream->chunkMax);
+    } else if (got < want / 2) {
+        stream->chunkLen = MAX(stream->chunkLen / 2,
+                               VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX);
+    }
+}
+
+
 /*
  * Invoked when a stream is signalled as having data
  * available to read. This reads up to one message
@@ -822,7 +856,7 @@ daemonStreamHandleRead(virNetServerClient *client,
     virNetMessage *msg = NULL;
     virNetMessageError rerr;
     char *buffer;
-    size_t bufferLen = VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX;
+    size_t bufferLen = stream->chunkLen;
     int ret = -1;
     int rv;
     int inData = 0;
@@ -845,8 +879,6 @@ daemonStreamHandleRead(virNetServerClient *client,
 
     memset(&rerr, 0, sizeof(rerr));
 
-    buffer = g_new0(char, bufferLen);
-
     if (!(msg = virNetMessageNew(false)))
         goto cleanup;
 
@@ -904,6 +936,14 @@ daemonStreamHandleRead(virNetServerClient *client,
         bufferLen > stream->dataLen)
         bufferLen = stream->dataLen;
 
+    /* Read the data straight into the message buffer to avoid copying it */
+    if (!(buffer = virNetServerProgramPrepareStreamData(stream->prog,
+                                                        msg,
+                                                        stream->procedure,
+                                                        stream->serial,
+                                                        bufferLen)))
+        goto cleanup;
+
     rv = virStreamRecv(stream->st, buffer, bufferLen);
     if (rv == -2) {
         /* Should never get this, since we're only called when we know
@@ -921,6 +961,8 @@ daemonStreamHandleRead(virNetServerClient *client,
         if (stream->allowSkip)
             stream->dataLen -= rv;
 
+        daemonStreamAdjustChunk(stream, bufferLen, rv);
+
         stream->tx = false;
         if (rv == 0)
             stream->recvEOF = true;
@@ -928,12 +970,7 @@ daemonStreamHandleRead(virNetServerClient *client,
         msg->cb = daemonStreamMessageFinished;
         msg->opaque = stream;
         stream->refs++;
-        if (virNetServerProgramSendStreamData(stream->prog,
-                                              client,
-                                              msg,
-                                              stream->procedure,
-                                              stream->serial,
-                                              buffer, rv) < 0)
+        if (virNetServerProgramSendPreparedStreamData(client, msg, rv) < 0)
             goto cleanup;
         msg = NULL;
     }
@@ -941,7 +978,6 @@ daemonStreamHandleRead(virNetServerClient *client,
  done:
     ret = 0;
  cleanup:
-    VIR_FREE(buffer);
     virNetMessageFree(msg);
     return ret;
 }
@@ -93,6 +93,9 @@ struct private_data {
     bool serverKeepAlive;       /* Does server support keepalive protocol? */
     bool serverEventFilter;     /* Does server support modern event filtering */
     bool serverCloseCallback;   /* Does server support driver close callback */
+    bool serverStreamLargePayload; /* Does server accept large stream packets */
+    bool serverCompression;     /* Are both sides compressing large messages */
+    unsigned int eventBatch;    /* Window for batching domain events, in ms */
 
     virObjectEventState *eventState;
     virConnectCloseCallbackData *closeCallback;
@@ -125,6 +128,10 @@ static int callFull(virConnectPtr conn, struct private_data *priv,
                     int proc_nr,
                     xdrproc_t args_filter, char *args,
                     xdrproc_t ret_filter, char *ret);
+static int callMany(virConnectPtr conn, struct private_data *priv,
+                    unsigned int flags,
+                    virNetClientProgramCallData *calls,
+                    size_t ncalls);
 static int remoteAuthenticate(virConnectPtr conn, struct private_data *priv,
                               virConnectAuthPtr auth, const char *authtype);
 #if WITH_SASL
@@ -411,6 +418,11 @@ static void
 remoteDomainBuildEventMemoryDeviceSizeChange(virNetClientProgram *prog,
                                              virNetClient *client,
                                              void *evdata, void *opaque);
+
+static void
+remoteDomainBuildEventCallbackBatch(virNetClientProgram *prog,
+                                    virNetClient *client,
+                                    void *evdata, void *opaque);
 static void
 remoteConnectNotifyEventConnectionClosed(virNetClientProgram *prog G_GNUC_UNUSED,
                                          virNetClient *client G_GNUC_UNUSED,
@@ -630,6 +642,10 @@ static virNetClientProgramEvent remoteEvents[] = {
       remoteDomainBuildEventMemoryDeviceSizeChange,
       sizeof(remote_domain_event_memory_device_size_change_msg),
       (xdrproc_t)xdr_remote_domain_event_memory_device_size_change_msg },
+    { REMOTE_PROC_DOMAIN_EVENT_CALLBACK_BATCH,
+      remoteDomainBuildEventCallbackBatch,
+      sizeof(remote_domain_event_callback_batch_msg),
+      (xdrproc_t)xdr_remote_domain_event_callback_batch_msg },
 };
 
 static void
@@ -682,6 +698,41 @@ remoteConnectSupportsFeatureUnlocked(virConnectPtr conn,
     return rc != -1 && ret.supported;
 }
 
+/* Probe several features with a single round trip */
+static void
+remoteConnectSupportsFeaturesUnlocked(virConnectPtr conn,
+                                      struct private_data *priv,
+                                      const int *features,
+                                      bool *supported,
+                                      size_t nfeatures)
+{
+    g_autofree virNetClientProgramCallData *calls = NULL;
+    g_autofree remote_connect_supports_feature_args *args = NULL;
+    g_autofree remote_connect_supports_feature_ret *ret = NULL;
+    size_t i;
+    int rc;
+
+    calls = g_new0(virNetClientProgramCallData, nfeatures);
+    args = g_new0(remote_connect_supports_feature_args, nfeatures);
+    ret = g_new0(remote_connect_supports_feature_ret, nfeatures);
+
+    for (i = 0; i < nfeatures; i++) {
+        args[i].feature = features[i];
+        calls[i].proc = REMOTE_PROC_CONNECT_SUPPORTS_FEATURE;
+        calls[i].args_filter = (xdrproc_t)xdr_remote_connect_supports_feature_args;
+        calls[i].args = &args[i];
+        calls[i].ret_filter = (xdrproc_t)xdr_remote_connect_supports_feature_ret;
+        calls[i].ret = &ret[i];
+    }
+
+    rc = callMany(conn, priv, 0, calls, nfeatures);
+
+    for (i = 0; i < nfeatures; i++) {
+        supported[i] = rc != -1 && !calls[i].error && ret[i].supported;
+        virFreeError(calls[i].error);
+    }
+}
+
 /* helper macro to ease extraction of arguments from the URI */
 #define EXTRACT_URI_ARG_STR(ARG_NAME, ARG_VAR) \
     if (STRCASEEQ(var->name, ARG_NAME)) { \
@@ -705,6 +756,18 @@ remoteConnectSupportsFeatureUnlocked(virConnectPtr conn,
         continue; \
     }
 
+#define EXTRACT_URI_ARG_UINT(ARG_NAME, ARG_VAR) \
+    if (STRCASEEQ(var->name, ARG_NAME)) { \
+        if (virStrToLong_ui(var->value, NULL, 10, &ARG_VAR) < 0) { \
+            virReportError(VIR_ERR_INVALID_ARG, \
+                           _("Failed to parse value of URI component %s"), \
+                           var->name); \
+            goto failed; \
+        } \
+        var->ignore = 1; \
+        continue; \
+    }
+
 
 /*
  * URIs that this driver needs to handle:
@@ -756,6 +819,7 @@ doRemoteOpen(virConnectPtr conn,
 #ifndef WIN32
     bool tty = true;
 #endif
+    int compress = -1;
     int mode;
     size_t i;
     int proxy;
@@ -800,6 +864,8 @@ doRemoteOpen(virConnectPtr conn,
             EXTRACT_URI_ARG_STR("proxy", proxy_str);
             EXTRACT_URI_ARG_BOOL("no_sanity", sanity);
             EXTRACT_URI_ARG_BOOL("no_verify", verify);
+            EXTRACT_URI_ARG_BOOL("no_compress", compress);
+            EXTRACT_URI_ARG_UINT("event_batch", priv->eventBatch);
 #ifndef WIN32
             EXTRACT_URI_ARG_BOOL("no_tty", tty);
 #endif
@@ -1170,20 +1236,60 @@ doRemoteOpen(virConnectPtr conn,
     if (!(priv->eventState = virObjectEventStateNew()))
         goto failed;
 
-    priv->serverEventFilter = remoteConnectSupportsFeatureUnlocked(conn,
-                                priv, VIR_DRV_FEATURE_REMOTE_EVENT_CALLBACK);
+    /* Compressing messages on a local socket costs more than it saves */
+    if (compress < 0)
+        compress = transport != REMOTE_DRIVER_TRANSPORT_UNIX;
+
+    {
+        /* Asking about compression turns it on in the server, so it
+         * must be kept last and only asked about if we want it */
+        const int features[] = {
+            VIR_DRV_FEATURE_REMOTE_EVENT_CALLBACK,
+            VIR_DRV_FEATURE_REMOTE_CLOSE_CALLBACK,
+            VIR_DRV_FEATURE_REMOTE_STREAM_LARGE_PAYLOAD,
+            VIR_DRV_FEATURE_REMOTE_EVENT_BATCH,
+            VIR_DRV_FEATURE_REMOTE_COMPRESSION,
+        };
+        bool supported[G_N_ELEMENTS(features)] = { 0 };
+        size_t nfeatures = G_N_ELEMENTS(features);
+
+        /* The server may compress messages as soon as it was asked */
+        if (compress)
+            virNetClientSetDecompression(priv->client, true);
+        else
+            nfeatures--;
+
+        remoteConnectSupportsFeaturesUnlocked(conn, priv, features, supported,
+                                              nfeatures);
+        priv->serverEventFilter = supported[0];
+        priv->serverCloseCallback = supported[1];
+        priv->serverStreamLargePayload = supported[2];
+        if (priv->eventBatch && !supported[3]) {
+            VIR_INFO("Not batching events since it is not supported "
+                     "by the server");
+            priv->eventBatch = 0;
+        }
+        priv->serverCompression = supported[4];
+    }
+
+    if (priv->serverCompression)
+        virNetClientSetCompression(priv->client, true);
+
     if (!priv->serverEventFilter) {
         VIR_INFO("Avoiding server event filtering since it is not "
                  "supported by the server");
     }
 
-    priv->serverCloseCallback = remoteConnectSupportsFeatureUnlocked(conn,
-                                    priv, VIR_DRV_FEATURE_REMOTE_CLOSE_CALLBACK);
     if (!priv->serverCloseCallback) {
         VIR_INFO("Close callback registering isn't supported "
                  "by the remote side.");
     }
 
+    if (!priv->serverStreamLargePayload) {
+        VIR_INFO("Limiting stream packets to legacy size since larger "
+                 "ones are not supported by the server");
+    }
+
     return VIR_DRV_OPEN_SUCCESS;
 
  failed:
@@ -1200,6 +1306,7 @@ doRemoteOpen(virConnectPtr conn,
 }
 #undef EXTRACT_URI_ARG_STR
 #undef EXTRACT_URI_ARG_BOOL
+#undef EXTRACT_URI_ARG_UINT
 
 static struct private_data *
 remoteAllocPrivateData(void)
@@ -4223,6 +4330,71 @@ remoteAuthPolkit(virConnectPtr conn, struct private_data *priv,
 
 /*----------------------------------------------------------------------*/
 
+/**
+ * remoteDomainEventCallbackRegister:
+ * @conn: the connection
+ * @priv: the connection's private data
+ * @eventID: the event to register for
+ * @dom: limit events to this domain if non-NULL
+ * @remoteID: filled with the callback ID on the server
+ *
+ * Ask the server to send us events of type @eventID. If the user asked
+ * for it with the event_batch URI parameter, the server sends them in
+ * batches and drops the superseded ones.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+static int
+remoteDomainEventCallbackRegister(virConnectPtr conn,
+                                  struct private_data *priv,
+                                  int eventID,
+                                  virDomainPtr dom,
+                                  int *remoteID)
+{
+    remote_nonnull_domain domain;
+    remote_domain rdom = NULL;
+
+    if (dom) {
+        make_nonnull_domain(&domain, dom);
+        rdom = &domain;
+    }
+
+    if (priv->eventBatch > 0) {
+        remote_connect_domain_event_callback_register_any_flags_args args;
+        remote_connect_domain_event_callback_register_any_flags_ret ret;
+
+        args.eventID = eventID;
+        args.dom = rdom;
+        args.window = priv->eventBatch;
+        args.flags = REMOTE_DOMAIN_EVENT_CALLBACK_COALESCE;
+
+        memset(&ret, 0, sizeof(ret));
+        if (call(conn, priv, 0, REMOTE_PROC_CONNECT_DOMAIN_EVENT_CALLBACK_REGISTER_ANY_FLAGS,
+                 (xdrproc_t) xdr_remote_connect_domain_event_callback_register_any_flags_args, (char *) &args,
+                 (xdrproc_t) xdr_remote_connect_domain_event_callback_register_any_flags_ret, (char *) &ret) == -1)
+            return -1;
+
+        *remoteID = ret.callbackID;
+    } else {
+        remote_connect_domain_event_callback_register_any_args args;
+        remote_connect_domain_event_callback_register_any_ret ret;
+
+        args.eventID = eventID;
+        args.dom = rdom;
+
+        memset(&ret, 0, sizeof(ret));
+        if (call(conn, priv, 0, REMOTE_PROC_CONNECT_DOMAIN_EVENT_CALLBACK_REGISTER_ANY,
+                 (xdrproc_t) xdr_remote_connect_domain_event_callback_register_any_args, (char *) &args,
+                 (xdrproc_t) xdr_remote_connect_domain_event_callback_register_any_ret, (char *) &ret) == -1)
+            return -1;
+
+        *remoteID = ret.callbackID;
+    }
+
+    return 0;
+}
+
+
 static int
 remoteConnectDomainEventRegister(virConnectPtr conn,
                                  virConnectDomainEventCallback callback,
@@ -4248,23 +4420,17 @@ remoteConnectDomainEventRegister(virConnectPtr conn,
     if (count == 1) {
         /* Tell the server when we are the first callback registering */
         if (priv->serverEventFilter) {
-            remote_connect_domain_event_callback_register_any_args args;
-            remote_connect_domain_event_callback_register_any_ret ret;
+            int remoteID;
 
-            args.eventID = VIR_DOMAIN_EVENT_ID_LIFECYCLE;
-            args.dom = NULL;
-
-            memset(&ret, 0, sizeof(ret));
-            if (call(conn, priv, 0,
-                     REMOTE_PROC_CONNECT_DOMAIN_EVENT_CALLBACK_REGISTER_ANY,
-                     (xdrproc_t) xdr_remote_connect_domain_event_callback_register_any_args, (char *) &args,
-                     (xdrproc_t) xdr_remote_connect_domain_event_callback_register_any_ret, (char *) &ret) == -1) {
+            if (remoteDomainEventCallbackRegister(conn, priv,
+                                                  VIR_DOMAIN_EVENT_ID_LIFECYCLE,
+                                                  NULL, &remoteID) < 0) {
                 virObjectEventStateDeregisterID(conn, priv->eventState,
                                                 callbackID, false);
                 goto done;
             }
             virObjectEventStateSetRemote(conn, priv->eventState, callbackID,
-                                         ret.callbackID);
+                                         remoteID);
         } else {
             if (call(conn, priv, 0, REMOTE_PROC_CONNECT_DOMAIN_EVENT_REGISTER,
                      (xdrproc_t) xdr_void, (char *) NULL,
@@ -5464,6 +5630,30 @@ remoteDomainBuildEventMemoryDeviceSizeChange(virNetClientProgram *prog G_GNUC_UN
 }
 
 
+static void
+remoteDomainBuildEventCallbackBatch(virNetClientProgram *prog,
+                                    virNetClient *client,
+                                    void *evdata, void *opaque G_GNUC_UNUSED)
+{
+    remote_domain_event_callback_batch_msg *msg = evdata;
+    size_t i;
+
+    for (i = 0; i < msg->events.events_len; i++) {
+        remote_domain_event_batch_entry *entry = &msg->events.events_val[i];
+
+        if (entry->procedure == REMOTE_PROC_DOMAIN_EVENT_CALLBACK_BATCH) {
+            VIR_WARN("Ignoring nested batch of events");
+            continue;
+        }
+
+        ignore_value(virNetClientProgramDispatchPayload(prog, client,
+                                                        entry->procedure,
+                                                        entry->payload.payload_val,
+                                                        entry->payload.payload_len));
+    }
+}
+
+
 static int
 remoteStreamSend(virStreamPtr st,
                  const char *data,
@@ -5782,7 +5972,6 @@ remoteConnectDomainEventRegisterAny(virConnectPtr conn,
     struct private_data *priv = conn->privateData;
     int callbackID;
     int count;
-    remote_nonnull_domain domain;
 
     remoteDriverLock(priv);
 
@@ -5797,27 +5986,16 @@ remoteConnectDomainEventRegisterAny(virConnectPtr conn,
      * events on the server */
     if (count == 1) {
         if (priv->serverEventFilter) {
-            remote_connect_domain_event_callback_register_any_args args;
-            remote_connect_domain_event_callback_register_any_ret ret;
+            int remoteID;
 
-            args.eventID = eventID;
-            if (dom) {
-                make_nonnull_domain(&domain, dom);
-                args.dom = &domain;
-            } else {
-                args.dom = NULL;
-            }
-
-            memset(&ret, 0, sizeof(ret));
-            if (call(conn, priv, 0, REMOTE_PROC_CONNECT_DOMAIN_EVENT_CALLBACK_REGISTER_ANY,
-                     (xdrproc_t) xdr_remote_connect_domain_event_callback_register_any_args, (char *) &args,
-                     (xdrproc_t) xdr_remote_connect_domain_event_callback_register_any_ret, (char *) &ret) == -1) {
+            if (remoteDomainEventCallbackRegister(conn, priv, eventID,
+                                                  dom, &remoteID) < 0) {
                 virObjectEventStateDeregisterID(conn, priv->eventState,
                                                 callbackID, false);
                 goto done;
             }
             virObjectEventStateSetRemote(conn, priv->eventState, callbackID,
-                                         ret.callbackID);
+                                         remoteID);
         } else {
             remote_connect_domain_event_register_any_args args;
 
@@ -6635,6 +6813,42 @@ call(virConnectPtr conn,
                     ret_filter, ret);
 }
 
+/*
+ * Pipeline several calls on the connection. The caller fills in
+ * everything in @calls but the serial. Per-call failures are left
+ * in @calls[i].error, only a failure of the whole batch is reported.
+ */
+static int
+callMany(virConnectPtr conn G_GNUC_UNUSED,
+         struct private_data *priv,
+         unsigned int flags,
+         virNetClientProgramCallData *calls,
+         size_t ncalls)
+{
+    int rv;
+    size_t i;
+    virNetClientProgram *prog;
+    virNetClient *client = priv->client;
+    priv->localUses++;
+
+    if (flags & REMOTE_CALL_QEMU)
+        prog = priv->qemuProgram;
+    else if (flags & REMOTE_CALL_LXC)
+        prog = priv->lxcProgram;
+    else
+        prog = priv->remoteProgram;
+
+    for (i = 0; i < ncalls; i++)
+        calls[i].serial = priv->counter++;
+
+    remoteDriverUnlock(priv);
+    rv = virNetClientProgramCallMany(prog, client, calls, ncalls);
+    remoteDriverLock(priv);
+    priv->localUses--;
+
+    return rv;
+}
+
 
 static int
 remoteDomainGetInterfaceParameters(virDomainPtr domain,
@@ -7646,6 +7860,162 @@ remoteConnectGetAllDomainStats(virConnectPtr conn,
 }
 
 
+/* Domains per call of virDomainListGetInfo when XML is requested. Chunks
+ * whose reply still doesn't fit into a single RPC message are split and
+ * queried again */
+#define REMOTE_DOMAIN_LIST_GET_INFO_XML_CHUNK 256
+
+static int
+remoteDomainListGetInfoChunks(virConnectPtr conn,
+                              remote_nonnull_domain *rdoms,
+                              size_t ndoms,
+                              size_t chunk,
+                              unsigned int fields,
+                              unsigned int flags,
+                              virDomainStatsRecordPtr *records,
+                              size_t *nrecords)
+{
+    struct private_data *priv = conn->privateData;
+    int rv = -1;
+    size_t i;
+    size_t j;
+    size_t ncalls;
+    g_autofree virNetClientProgramCallData *calls = NULL;
+    g_autofree remote_domain_list_get_info_args *args = NULL;
+    g_autofree remote_domain_list_get_info_ret *ret = NULL;
+    virDomainStatsRecordPtr elem = NULL;
+
+    /* The domains are split into chunks which are all sent at once,
+     * so the whole query still takes a single round trip */
+    ncalls = (ndoms + chunk - 1) / chunk;
+    calls = g_new0(virNetClientProgramCallData, ncalls);
+    args = g_new0(remote_domain_list_get_info_args, ncalls);
+    ret = g_new0(remote_domain_list_get_info_ret, ncalls);
+
+    for (i = 0; i < ncalls; i++) {
+        args[i].doms.doms_val = rdoms + i * chunk;
+        args[i].doms.doms_len = MIN(chunk, ndoms - i * chunk);
+        args[i].fields = fields;
+        args[i].flags = flags;
+
+        calls[i].proc = REMOTE_PROC_DOMAIN_LIST_GET_INFO;
+        calls[i].args_filter = (xdrproc_t)xdr_remote_domain_list_get_info_args;
+        calls[i].args = &args[i];
+        calls[i].ret_filter = (xdrproc_t)xdr_remote_domain_list_get_info_ret;
+        calls[i].ret = &ret[i];
+    }
+
+    remoteDriverLock(priv);
+    if (callMany(conn, priv, 0, calls, ncalls) < 0) {
+        remoteDriverUnlock(priv);
+        goto cleanup;
+    }
+    remoteDriverUnlock(priv);
+
+    for (i = 0; i < ncalls; i++) {
+        size_t nchunk = args[i].doms.doms_len;
+
+        if (calls[i].error) {
+            /* The daemon fails to encode a reply exceeding the RPC message
+             * size limit, e.g. because of large domain XMLs. Query the
+             * domains of such a chunk in two halves instead. */
+            if (calls[i].error->code == VIR_ERR_RPC && nchunk > 1) {
+                VIR_DEBUG("Splitting chunk of %zu domains", nchunk);
+
+                if (remoteDomainListGetInfoChunks(conn, args[i].doms.doms_val,
+                                                  nchunk, (nchunk + 1) / 2,
+                                                  fields, flags,
+                                                  records, nrecords) < 0)
+                    goto cleanup;
+                continue;
+            }
+
+            virSetError(calls[i].error);
+            goto cleanup;
+        }
+
+        if (ret[i].retInfo.retInfo_len > nchunk) {
+            virReportError(VIR_ERR_INTERNAL_ERROR,
+                           _("Number of info entries is %d, which exceeds max limit: %zu"),
+                           ret[i].retInfo.retInfo_len, nchunk);
+            goto cleanup;
+        }
+
+        for (j = 0; j < ret[i].retInfo.retInfo_len; j++) {
+            remote_domain_stats_record *rec = ret[i].retInfo.retInfo_val + j;
+
+            elem = g_new0(virDomainStatsRecord, 1);
+
+            if (!(elem->dom = get_nonnull_domain(conn, rec->dom)))
+                goto cleanup;
+
+            if (virTypedParamsDeserialize((struct _virTypedParameterRemote *) rec->params.params_val,
+                                          rec->params.params_len,
+                                          REMOTE_CONNECT_GET_ALL_DOMAIN_STATS_MAX,
+                                          &elem->params,
+                                          &elem->nparams))
+                goto cleanup;
+
+            records[(*nrecords)++] = g_steal_pointer(&elem);
+        }
+    }
+
+    rv = 0;
+
+ cleanup:
+    if (elem) {
+        virObjectUnref(elem->dom);
+        VIR_FREE(elem);
+    }
+    for (i = 0; i < ncalls; i++) {
+        virFreeError(calls[i].error);
+        xdr_free((xdrproc_t)xdr_remote_domain_list_get_info_ret,
+                 (char *) &ret[i]);
+    }
+
+    return rv;
+}
+
+
+static int
+remoteDomainListGetInfo(virConnectPtr conn,
+                        virDomainPtr *doms,
+                        unsigned int ndoms,
+                        unsigned int fields,
+                        virDomainStatsRecordPtr **retInfo,
+                        unsigned int flags)
+{
+    int rv = -1;
+    size_t i;
+    size_t chunk = REMOTE_DOMAIN_LIST_MAX;
+    size_t nrecords = 0;
+    remote_nonnull_domain *rdoms = NULL;
+    virDomainStatsRecordPtr *tmpret = NULL;
+
+    if (fields == 0 || fields & VIR_DOMAIN_LIST_INFO_XML)
+        chunk = REMOTE_DOMAIN_LIST_GET_INFO_XML_CHUNK;
+
+    rdoms = g_new0(remote_nonnull_domain, ndoms);
+    for (i = 0; i < ndoms; i++)
+        make_nonnull_domain(rdoms + i, doms[i]);
+
+    tmpret = g_new0(virDomainStatsRecordPtr, ndoms + 1);
+
+    if (remoteDomainListGetInfoChunks(conn, rdoms, ndoms, chunk, fields, flags,
+                                      tmpret, &nrecords) < 0)
+        goto cleanup;
+
+    *retInfo = g_steal_pointer(&tmpret);
+    rv = nrecords;
+
+ cleanup:
+    virDomainStatsRecordListFree(tmpret);
+    VIR_FREE(rdoms);
+
+    return rv;
+}
+
+
 static int
 remoteNodeAllocPages(virConnectPtr conn,
                      unsigned int npages,
@@ -8619,6 +8989,7 @@ static virHypervisorDriver hypervisor_driver = {
     .nodeGetFreePages = remoteNodeGetFreePages, /* 1.2.6 */
     .connectGetDomainCapabilities = remoteConnectGetDomainCapabilities, /* 1.2.7 */
     .connectGetAllDomainStats = remoteConnectGetAllDomainStats, /* 1.2.8 */
+    .domainListGetInfo = remoteDomainListGetInfo, /* 8.6.0 */
     .nodeAllocPages = remoteNodeAllocPages, /* 1.2.9 */
     .domainGetFSInfo = remoteDomainGetFSInfo, /* 1.2.11 */
     .domainInterfaceAddresses = remoteDomainInterfaceAddresses, /* 1.2.14 */
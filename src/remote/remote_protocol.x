@@ -2565,6 +2565,45 @@ struct remote_connect_domain_event_callback_deregister_any_args {
     int callbackID;
 };
 
+/* Upper limit on the delay of a batch of events, in milliseconds. */
+const REMOTE_DOMAIN_EVENT_BATCH_WINDOW_MAX = 10000;
+
+/* Upper limit on number of events in a batch. */
+const REMOTE_DOMAIN_EVENT_BATCH_MAX = 1024;
+
+/* Upper limit on the size of a single event in a batch. Larger events
+ * are sent on their own. */
+const REMOTE_DOMAIN_EVENT_BATCH_PAYLOAD_MAX = 65536;
+
+enum remote_domain_event_callback_register_flags {
+    /* Drop events which are superseded by a later event of the same
+     * type for the same domain in the same batch */
+    REMOTE_DOMAIN_EVENT_CALLBACK_COALESCE = 1
+};
+
+struct remote_connect_domain_event_callback_register_any_flags_args {
+    int eventID;
+    remote_domain dom;
+    unsigned int window; /* batch events for this long, 0 to disable */
+    unsigned int flags;
+};
+
+struct remote_connect_domain_event_callback_register_any_flags_ret {
+    int callbackID;
+};
+
+/* An event as it would be sent on its own, with procedure being the
+ * REMOTE_PROC_DOMAIN_EVENT_CALLBACK_* number and payload the encoded
+ * remote_domain_event_callback_*_msg. */
+struct remote_domain_event_batch_entry {
+    int procedure;
+    opaque payload<REMOTE_DOMAIN_EVENT_BATCH_PAYLOAD_MAX>;
+};
+
+struct remote_domain_event_callback_batch_msg {
+    remote_domain_event_batch_entry events<REMOTE_DOMAIN_EVENT_BATCH_MAX>;
+};
+
 struct remote_domain_event_reboot_msg {
     remote_nonnull_domain dom;
 };
@@ -3463,6 +3502,16 @@ struct remote_connect_get_all_domain_stats_ret {
     remote_domain_stats_record retStats<REMOTE_DOMAIN_LIST_MAX>;
 };
 
+struct remote_domain_list_get_info_args {
+    remote_nonnull_domain doms<REMOTE_DOMAIN_LIST_MAX>;
+    unsigned int fields;
+    unsigned int flags;
+};
+
+struct remote_domain_list_get_info_ret {
+    remote_domain_stats_record retInfo<REMOTE_DOMAIN_LIST_MAX>;
+};
+
 struct remote_domain_fsinfo {
     remote_nonnull_string mountpoint;
     remote_nonnull_string name;
@@ -6959,5 +7008,28 @@ enum remote_procedure {
      * @generate: both
      * @acl: domain:write
      */
-    REMOTE_PROC_DOMAIN_ABORT_JOB_FLAGS = 442
+    REMOTE_PROC_DOMAIN_ABORT_JOB_FLAGS = 442,
+
+    /**
+     * @generate: none
+     * @acl: connect:search_domains
+     * @aclfilter: domain:read
+     * @aclfilter: domain:read_secure:VIR_DOMAIN_XML_SECURE
+     * @aclfilter: domain:read_secure:VIR_DOMAIN_XML_MIGRATABLE
+     */
+    REMOTE_PROC_DOMAIN_LIST_GET_INFO = 443,
+
+    /**
+     * @generate: none
+     * @priority: high
+     * @acl: connect:search_domains
+     * @aclfilter: domain:getattr
+     */
+    REMOTE_PROC_CONNECT_DOMAIN_EVENT_CALLBACK_REGISTER_ANY_FLAGS = 444,
+
+    /**
+     * @generate: both
+     * @acl: none
+     */
+    REMOTE_PROC_DOMAIN_EVENT_CALLBACK_BATCH = 445
 };
@@ -1847,6 +1847,13 @@ elsif ($mode eq "client") {
             print "        rv = 1;\n";
             print "        goto done;\n";
             print "    }\n";
+
+            # SPECIAL: stream payload size was negotiated when opening
+            print "\n";
+            print "    if (feature == VIR_DRV_FEATURE_REMOTE_STREAM_LARGE_PAYLOAD) {\n";
+            print "        rv = priv->serverStreamLargePayload;\n";
+            print "        goto done;\n";
+            print "    }\n";
         }
 
         foreach my $args_check (@args_check_list) {
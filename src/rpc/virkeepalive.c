@@ -20,6 +20,7 @@
 
 #include <config.h>
 
+#include "viralloc.h"
 #include "virthread.h"
 #include "virlog.h"
 #include "virerror.h"
@@ -39,7 +40,14 @@ struct _virKeepAlive {
     unsigned int countToDeath;
     gint64 lastPacketReceived;
     gint64 intervalStart;
-    int timer;
+    gint64 due; /* when the next keepalive request may be due */
+
+    /* Protected by the wheel's lock */
+    bool armed; /* keepalive checks were started */
+    gint64 wheelDue; /* when the wheel checks this keepalive */
+    int slot; /* index into the wheel, -1 if not in the wheel */
+    virKeepAlive *prev;
+    virKeepAlive *next;
 
     virKeepAliveSendFunc sendCB;
     virKeepAliveDeadFunc deadCB;
@@ -48,6 +56,27 @@ struct _virKeepAlive {
 };
 
 
+/* Number of one second slots in the wheel. A keepalive due further in
+ * the future is kept in the slot of its due time modulo the wheel size
+ * and skipped until then. */
+#define VIR_KEEPALIVE_WHEEL_SLOTS 64
+
+/* Instead of a timer per connection, the keepalives of all connections
+ * in the process are kept in a timer wheel. A single timer wakes up
+ * when the earliest slot becomes due and checks just the keepalives
+ * in the slots which have become due since the last wake up. */
+typedef struct _virKeepAliveWheel virKeepAliveWheel;
+struct _virKeepAliveWheel {
+    virMutex lock;
+    int timer; /* -1 if not registered */
+    size_t count; /* keepalives in the wheel */
+    gint64 last; /* the last second the slots were checked for */
+    virKeepAlive *slots[VIR_KEEPALIVE_WHEEL_SLOTS];
+    unsigned long long wakeups;
+};
+
+static virKeepAliveWheel virKeepAliveWheelData = { .timer = -1 };
+
 static virClass *virKeepAliveClass;
 static void virKeepAliveDispose(void *obj);
 
@@ -56,6 +85,12 @@ static int virKeepAliveOnceInit(void)
     if (!VIR_CLASS_NEW(virKeepAlive, virClassForObjectLockable()))
         return -1;
 
+    if (virMutexInit(&virKeepAliveWheelData.lock) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("unable to init keepalive wheel mutex"));
+        return -1;
+    }
+
     return 0;
 }
 
@@ -117,8 +152,7 @@ virKeepAliveTimerInternal(virKeepAlive *ka,
         return false;
 
     if (now - ka->intervalStart < ka->interval) {
-        timeval = ka->interval - (now - ka->intervalStart);
-        virEventUpdateTimeout(ka->timer, timeval * 1000);
+        ka->due = ka->intervalStart + ka->interval;
         return false;
     }
 
@@ -137,41 +171,151 @@ virKeepAliveTimerInternal(virKeepAlive *ka,
     } else {
         ka->countToDeath--;
         ka->intervalStart = now;
+        ka->due = now + ka->interval;
         *msg = virKeepAliveMessage(ka, KEEPALIVE_PROC_PING);
-        virEventUpdateTimeout(ka->timer, ka->interval * 1000);
         return false;
     }
 }
 
 
+/* Must be called with the wheel locked */
 static void
-virKeepAliveTimer(int timer G_GNUC_UNUSED, void *opaque)
+virKeepAliveWheelInsert(virKeepAliveWheel *wheel,
+                        virKeepAlive *ka,
+                        gint64 due)
 {
-    virKeepAlive *ka = opaque;
-    virNetMessage *msg = NULL;
-    bool dead;
-    void *client;
+    /* Slots up to wheel->last were already checked */
+    ka->wheelDue = MAX(due, wheel->last + 1);
+    ka->slot = ka->wheelDue % VIR_KEEPALIVE_WHEEL_SLOTS;
+    ka->prev = NULL;
+    ka->next = wheel->slots[ka->slot];
+    if (ka->next)
+        ka->next->prev = ka;
+    wheel->slots[ka->slot] = ka;
+}
 
-    virObjectRef(ka);
-    virObjectLock(ka);
 
-    client = ka->client;
-    dead = virKeepAliveTimerInternal(ka, &msg);
+/* Must be called with the wheel locked */
+static void
+virKeepAliveWheelRemove(virKeepAliveWheel *wheel,
+                        virKeepAlive *ka)
+{
+    if (ka->prev)
+        ka->prev->next = ka->next;
+    else
+        wheel->slots[ka->slot] = ka->next;
+    if (ka->next)
+        ka->next->prev = ka->prev;
 
-    virObjectUnlock(ka);
+    ka->prev = ka->next = NULL;
+    ka->slot = -1;
+}
 
-    if (!dead && !msg)
-        goto cleanup;
 
-    if (dead) {
-        ka->deadCB(client);
-    } else if (ka->sendCB(client, msg) < 0) {
-        VIR_WARN("Failed to send keepalive request to client %p", client);
-        virNetMessageFree(msg);
+/* Must be called with the wheel locked. Arms the timer to wake up
+ * when the first non-empty slot becomes due, or disarms it if the
+ * wheel is empty. */
+static void
+virKeepAliveWheelSchedule(virKeepAliveWheel *wheel)
+{
+    gint64 now = g_get_monotonic_time() / G_USEC_PER_SEC;
+    size_t i;
+
+    if (wheel->timer < 0)
+        return;
+
+    if (wheel->count == 0) {
+        virEventUpdateTimeout(wheel->timer, -1);
+        return;
+    }
+
+    /* Slots up to now which were not checked yet are due right away */
+    for (i = 1; i <= VIR_KEEPALIVE_WHEEL_SLOTS; i++) {
+        gint64 when = wheel->last + i;
+
+        if (wheel->slots[when % VIR_KEEPALIVE_WHEEL_SLOTS]) {
+            virEventUpdateTimeout(wheel->timer,
+                                  when > now ? (when - now) * 1000 : 0);
+            return;
+        }
+    }
+
+    /* All keepalives are being checked by virKeepAliveWheelTick which
+     * reschedules once it puts them back */
+}
+
+
+static void
+virKeepAliveWheelTick(int timer G_GNUC_UNUSED,
+                      void *opaque G_GNUC_UNUSED)
+{
+    virKeepAliveWheel *wheel = &virKeepAliveWheelData;
+    gint64 now = g_get_monotonic_time() / G_USEC_PER_SEC;
+    g_autofree virKeepAlive **due = NULL;
+    size_t ndue = 0;
+    size_t i;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&wheel->lock) {
+        gint64 when;
+
+        wheel->wakeups++;
+
+        /* Take out the keepalives which are due, the wheel's reference
+         * to them is passed on to the 'due' array */
+        for (when = MAX(wheel->last + 1, now - VIR_KEEPALIVE_WHEEL_SLOTS + 1);
+             when <= now; when++) {
+            virKeepAlive *ka = wheel->slots[when % VIR_KEEPALIVE_WHEEL_SLOTS];
+
+            while (ka) {
+                virKeepAlive *next = ka->next;
+
+                if (ka->wheelDue <= now) {
+                    virKeepAliveWheelRemove(wheel, ka);
+                    VIR_APPEND_ELEMENT(due, ndue, ka);
+                }
+                ka = next;
+            }
+        }
+        wheel->last = now;
+    }
+
+    for (i = 0; i < ndue; i++) {
+        virKeepAlive *ka = due[i];
+        virNetMessage *msg = NULL;
+        bool dead;
+        void *client;
+        gint64 nextDue;
+
+        virObjectLock(ka);
+        client = ka->client;
+        dead = virKeepAliveTimerInternal(ka, &msg);
+        /* After a timeout, check again in an interval in case the
+         * connection is not closed by deadCB */
+        nextDue = dead ? now + ka->interval : ka->due;
+        virObjectUnlock(ka);
+
+        if (dead) {
+            ka->deadCB(client);
+        } else if (msg && ka->sendCB(client, msg) < 0) {
+            VIR_WARN("Failed to send keepalive request to client %p", client);
+            virNetMessageFree(msg);
+        }
+
+        VIR_WITH_MUTEX_LOCK_GUARD(&wheel->lock) {
+            /* Unless virKeepAliveStop was called in the meantime, put the
+             * keepalive back along with our reference */
+            if (ka->armed) {
+                virKeepAliveWheelInsert(wheel, ka, nextDue);
+                ka = NULL;
+            }
+        }
+
+        virObjectUnref(ka);
     }
 
- cleanup:
-    virObjectUnref(ka);
+    VIR_WITH_MUTEX_LOCK_GUARD(&wheel->lock) {
+        virKeepAliveWheelSchedule(wheel);
+    }
 }
 
 
@@ -196,7 +340,7 @@ virKeepAliveNew(int interval,
     ka->interval = interval;
     ka->count = count;
     ka->countToDeath = count;
-    ka->timer = -1;
+    ka->slot = -1;
     ka->client = client;
     ka->sendCB = sendCB;
     ka->deadCB = deadCB;
@@ -227,30 +371,30 @@ virKeepAliveStart(virKeepAlive *ka,
                   int interval,
                   unsigned int count)
 {
-    int ret = -1;
+    virKeepAliveWheel *wheel = &virKeepAliveWheelData;
+    VIR_LOCK_GUARD lock = virLockGuardLock(&wheel->lock);
     gint64 delay;
     int timeout;
     gint64 now;
 
     virObjectLock(ka);
 
-    if (ka->timer >= 0) {
+    if (ka->armed) {
         VIR_DEBUG("Keepalive messages already enabled");
-        ret = 0;
-        goto cleanup;
+        goto done;
     }
 
     if (interval > 0) {
         if (ka->interval > 0) {
             virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
                            _("keepalive interval already set"));
-            goto cleanup;
+            goto error;
         }
         /* Guard against overflow */
         if (interval > INT_MAX / 1000) {
             virReportError(VIR_ERR_INTERNAL_ERROR,
                            _("keepalive interval %d too large"), interval);
-            goto cleanup;
+            goto error;
         }
         ka->interval = interval;
         ka->count = count;
@@ -259,14 +403,20 @@ virKeepAliveStart(virKeepAlive *ka,
 
     if (ka->interval <= 0) {
         VIR_DEBUG("Keepalive messages disabled by configuration");
-        ret = 0;
-        goto cleanup;
+        goto done;
     }
 
     PROBE(RPC_KEEPALIVE_START,
           "ka=%p client=%p interval=%d count=%u",
           ka, ka->client, interval, count);
 
+    if (wheel->timer < 0) {
+        if ((wheel->timer = virEventAddTimeout(-1, virKeepAliveWheelTick,
+                                               NULL, NULL)) < 0)
+            goto error;
+        wheel->last = g_get_monotonic_time() / G_USEC_PER_SEC;
+    }
+
     now = g_get_monotonic_time() / G_USEC_PER_SEC;
     delay = now - ka->lastPacketReceived;
     if (delay > ka->interval)
@@ -274,36 +424,83 @@ virKeepAliveStart(virKeepAlive *ka,
     else
         timeout = ka->interval - delay;
     ka->intervalStart = now - (ka->interval - timeout);
-    ka->timer = virEventAddTimeout(timeout * 1000, virKeepAliveTimer,
-                                   ka, virObjectUnref);
-    if (ka->timer < 0)
-        goto cleanup;
+    ka->due = now + timeout;
+    ka->armed = true;
 
-    /* the timer now has another reference to this object */
+    /* the wheel now has another reference to this object */
     virObjectRef(ka);
-    ret = 0;
+    virKeepAliveWheelInsert(wheel, ka, ka->due);
+    wheel->count++;
+    virKeepAliveWheelSchedule(wheel);
 
- cleanup:
+ done:
     virObjectUnlock(ka);
-    return ret;
+    return 0;
+
+ error:
+    virObjectUnlock(ka);
+    return -1;
 }
 
 
 void
 virKeepAliveStop(virKeepAlive *ka)
 {
-    virObjectLock(ka);
+    virKeepAliveWheel *wheel = &virKeepAliveWheelData;
+    bool unref = false;
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&wheel->lock) {
+        virObjectLock(ka);
+
+        PROBE(RPC_KEEPALIVE_STOP,
+              "ka=%p client=%p",
+              ka, ka->client);
+
+        if (ka->armed) {
+            ka->armed = false;
+            wheel->count--;
+
+            /* A keepalive being checked is not in the wheel, the
+             * reference is dropped by virKeepAliveWheelTick then */
+            if (ka->slot >= 0) {
+                virKeepAliveWheelRemove(wheel, ka);
+                unref = true;
+            }
+            virKeepAliveWheelSchedule(wheel);
+        }
 
-    PROBE(RPC_KEEPALIVE_STOP,
-          "ka=%p client=%p",
-          ka, ka->client);
+        virObjectUnlock(ka);
+    }
+
+    if (unref)
+        virObjectUnref(ka);
+}
+
+
+/**
+ * virKeepAliveGetStats:
+ * @nkeepalives: filled with the number of connections checked
+ * @wakeups: filled with the number of wake ups of the keepalive timer
+ *
+ * Report statistics of the keepalive checks of all connections in the
+ * process.
+ */
+void
+virKeepAliveGetStats(size_t *nkeepalives,
+                     unsigned long long *wakeups)
+{
+    virKeepAliveWheel *wheel = &virKeepAliveWheelData;
 
-    if (ka->timer > 0) {
-        virEventRemoveTimeout(ka->timer);
-        ka->timer = -1;
+    if (virKeepAliveInitialize() < 0) {
+        *nkeepalives = 0;
+        *wakeups = 0;
+        return;
     }
 
-    virObjectUnlock(ka);
+    VIR_WITH_MUTEX_LOCK_GUARD(&wheel->lock) {
+        *nkeepalives = wheel->count;
+        *wakeups = wheel->wakeups;
+    }
 }
 
 
@@ -399,10 +596,29 @@ virKeepAliveCheckMessage(virKeepAlive *ka,
         }
     }
 
-    if (ka->timer >= 0)
-        virEventUpdateTimeout(ka->timer, ka->interval * 1000);
-
     virObjectUnlock(ka);
 
     return ret;
 }
+
+
+/**
+ * virKeepAliveTouch:
+ * @ka: keepalive object, may be NULL
+ *
+ * Record that some data was received from the peer. Any traffic proves
+ * the connection is alive, so the next keepalive request is postponed
+ * by a whole interval.
+ */
+void
+virKeepAliveTouch(virKeepAlive *ka)
+{
+    if (!ka)
+        return;
+
+    virObjectLock(ka);
+    ka->countToDeath = ka->count;
+    ka->intervalStart = g_get_monotonic_time() / G_USEC_PER_SEC;
+    ka->lastPacketReceived = ka->intervalStart;
+    virObjectUnlock(ka);
+}
@@ -50,3 +50,7 @@ bool virKeepAliveTrigger(virKeepAlive *ka,
 bool virKeepAliveCheckMessage(virKeepAlive *ka,
                               virNetMessage *msg,
                               virNetMessage **response);
+void virKeepAliveTouch(virKeepAlive *ka);
+
+void virKeepAliveGetStats(size_t *nkeepalives,
+                          unsigned long long *wakeups);
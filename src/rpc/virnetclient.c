@@ -59,6 +59,8 @@ struct _virNetClientCall {
     bool expectReply;
     bool nonBlock;
     bool haveThread;
+    /* Owned by a thread waiting on a whole batch of calls */
+    bool batched;
 
     virCond cond;
 
@@ -106,6 +108,14 @@ struct _virNetClient {
     int closeReason;
     virErrorPtr error;
 
+    /* Whether the server agreed to VIR_DRV_FEATURE_REMOTE_COMPRESSION,
+     * and how many bytes compressing our messages saved so far */
+    bool compression;
+    unsigned long long compressionSaved;
+    /* Whether we asked for VIR_DRV_FEATURE_REMOTE_COMPRESSION, so that
+     * compressed messages from the server are accepted */
+    bool decompression;
+
     virNetClientCloseFunc closeCb;
     void *closeOpaque;
     virFreeCallback closeFf;
@@ -197,6 +207,19 @@ static void virNetClientCallRemove(virNetClientCall **head,
     }
 }
 
+/* Check whether a call is still in the list */
+static bool virNetClientCallIsQueued(virNetClientCall *head,
+                                     virNetClientCall *call)
+{
+    virNetClientCall *tmp = head;
+    while (tmp) {
+        if (tmp == call)
+            return true;
+        tmp = tmp->next;
+    }
+    return false;
+}
+
 /* Predicate returns true if matches */
 typedef bool (*virNetClientCallPredicate)(virNetClientCall *call, void *opaque);
 
@@ -857,6 +880,24 @@ void virNetClientClose(virNetClient *client)
 }
 
 
+void virNetClientSetCompression(virNetClient *client,
+                                bool compression)
+{
+    virObjectLock(client);
+    client->compression = compression;
+    virObjectUnlock(client);
+}
+
+
+void virNetClientSetDecompression(virNetClient *client,
+                                  bool decompression)
+{
+    virObjectLock(client);
+    client->decompression = decompression;
+    virObjectUnlock(client);
+}
+
+
 #if WITH_SASL
 void virNetClientSetSASLSession(virNetClient *client,
                                 virNetSASLSession *sasl)
@@ -1126,6 +1167,8 @@ static int
 virNetClientCallDispatchReply(virNetClient *client)
 {
     virNetClientCall *thecall;
+    char *buffer;
+    size_t bufferSize;
 
     /* Ok, definitely got an RPC reply now find
        out which waiting call is associated with it */
@@ -1143,9 +1186,15 @@ virNetClientCallDispatchReply(virNetClient *client)
         return -1;
     }
 
-    VIR_REALLOC_N(thecall->msg->buffer, client->msg.bufferLength);
+    /* Hand the reply's buffer over to the call rather than copying it,
+     * the call's own buffer is released together with client->msg */
+    buffer = thecall->msg->buffer;
+    bufferSize = thecall->msg->bufferSize;
+    thecall->msg->buffer = client->msg.buffer;
+    thecall->msg->bufferSize = client->msg.bufferSize;
+    client->msg.buffer = buffer;
+    client->msg.bufferSize = bufferSize;
 
-    memcpy(thecall->msg->buffer, client->msg.buffer, client->msg.bufferLength);
     memcpy(&thecall->msg->header, &client->msg.header, sizeof(client->msg.header));
     thecall->msg->bufferLength = client->msg.bufferLength;
     thecall->msg->bufferOffset = client->msg.bufferOffset;
@@ -1408,10 +1457,8 @@ virNetClientIOReadMessage(virNetClient *client)
     ssize_t ret;
 
     /* Start by reading length word */
-    if (client->msg.bufferLength == 0) {
-        client->msg.bufferLength = 4;
-        client->msg.buffer = g_new0(char, client->msg.bufferLength);
-    }
+    if (client->msg.bufferLength == 0)
+        virNetMessageResizeBuffer(&client->msg, VIR_NET_MESSAGE_LEN_MAX);
 
     wantData = client->msg.bufferLength - client->msg.bufferOffset;
 
@@ -1422,6 +1469,7 @@ virNetClientIOReadMessage(virNetClient *client)
         return ret;
 
     client->msg.bufferOffset += ret;
+    virKeepAliveTouch(client->keepalive);
 
     return ret;
 }
@@ -1459,7 +1507,9 @@ virNetClientIOHandleInput(virNetClient *client)
                  * next iteration.
                  */
             } else {
-                if (virNetMessageDecodeHeader(&client->msg) < 0)
+                if (virNetMessageDecodeHeader(&client->msg) < 0 ||
+                    virNetMessageDecompress(&client->msg,
+                                            client->decompression) < 0)
                     return -1;
 
                 if (client->msg.header.type == VIR_NET_REPLY_WITH_FDS) {
@@ -1553,6 +1603,8 @@ static bool virNetClientIOEventLoopRemoveDone(virNetClientCall *call,
     if (call->haveThread) {
         VIR_DEBUG("Waking up sleep %p", call);
         virCondSignal(&call->cond);
+    } else if (call->batched) {
+        VIR_DEBUG("Leaving completed batched call %p to its owner", call);
     } else {
         VIR_DEBUG("Removing completed call %p", call);
         if (call->expectReply)
@@ -1583,6 +1635,13 @@ virNetClientIOEventLoopRemoveAll(virNetClientCall *call,
     if (call == thiscall)
         return false;
 
+    /* The thread waiting for the batch will notice the call was
+     * dropped and free it itself */
+    if (call->batched) {
+        VIR_DEBUG("Dropping batched call %p", call);
+        return true;
+    }
+
     VIR_DEBUG("Removing call %p", call);
     virCondDestroy(&call->cond);
     virNetMessageFree(call->msg);
@@ -1850,79 +1909,18 @@ static void virNetClientIOUpdateCallback(virNetClient *client,
 
 
 /*
- * This function sends a message to remote server and awaits a reply
- *
- * NB. This does not free the args structure (not desirable, since you
- * often want this allocated on the stack or else it contains strings
- * which come from the user).  It does however free any intermediate
- * results, eg. the error structure if there is one.
- *
- * NB(2). Make sure to memset (&ret, 0, sizeof(ret)) before calling,
- * else Bad Things will happen in the XDR code.
- *
- * NB(3) You must have the client lock before calling this
- *
- * NB(4) This is very complicated. Multiple threads are allowed to
- * use the client for RPC at the same time. Obviously only one of
- * them can. So if someone's using the socket, other threads are put
- * to sleep on condition variables. The existing thread may completely
- * send & receive their RPC call/reply while they're asleep. Or it
- * may only get around to dealing with sending the call. Or it may
- * get around to neither. So upon waking up from slumber, the other
- * thread may or may not have more work todo.
- *
- * We call this dance  'passing the buck'
- *
- *      https://en.wikipedia.org/wiki/Passing_the_buck
- *
- *   "Buck passing or passing the buck is the action of transferring
- *    responsibility or blame unto another person. It is also used as
- *    a strategy in power politics when the actions of one country/
- *    nation are blamed on another, providing an opportunity for war."
- *
- * NB(5) If the 'thiscall' has the 'nonBlock' flag set, the caller
- * must *NOT* free it, if this returns '1' (ie partial send).
- *
- * NB(6) The following input states are valid if *no* threads
- *       are currently executing this method
- *
- *   - waitDispatch == NULL,
- *   - waitDispatch != NULL, waitDispatch.nonBlock == true
- *
- * The following input states are valid, if n threads are currently
- * executing
- *
- *   - waitDispatch != NULL
- *   - 0 or 1  waitDispatch.nonBlock == false, without any threads
- *   - 0 or more waitDispatch.nonBlock == false, with threads
- *
- * The following output states are valid when all threads are done
- *
- *   - waitDispatch == NULL,
- *   - waitDispatch != NULL, waitDispatch.nonBlock == true
- *
- * NB(7) Don't Panic!
+ * Wait for @thiscall, which must already be queued on the
+ * dispatch list, to complete. See virNetClientIO for the
+ * details of how the threads cooperate.
  *
  * Returns 1 if the call was queued and will be completed later (only
  * for nonBlock == true), 0 if the call was completed and -1 on error.
  */
-static int virNetClientIO(virNetClient *client,
-                          virNetClientCall *thiscall)
+static int virNetClientIOWait(virNetClient *client,
+                              virNetClientCall *thiscall)
 {
     int rv = -1;
 
-    VIR_DEBUG("Outgoing message prog=%u version=%u serial=%u proc=%d type=%d length=%zu dispatch=%p",
-              thiscall->msg->header.prog,
-              thiscall->msg->header.vers,
-              thiscall->msg->header.serial,
-              thiscall->msg->header.proc,
-              thiscall->msg->header.type,
-              thiscall->msg->bufferLength,
-              client->waitDispatch);
-
-    /* Stick ourselves on the end of the wait queue */
-    virNetClientCallQueue(&client->waitDispatch, thiscall);
-
     /* Check to see if another thread is dispatching */
     if (client->haveTheBuck) {
         /* Force other thread to wakeup from poll */
@@ -2000,6 +1998,82 @@ static int virNetClientIO(virNetClient *client,
 }
 
 
+/*
+ * This function sends a message to remote server and awaits a reply
+ *
+ * NB. This does not free the args structure (not desirable, since you
+ * often want this allocated on the stack or else it contains strings
+ * which come from the user).  It does however free any intermediate
+ * results, eg. the error structure if there is one.
+ *
+ * NB(2). Make sure to memset (&ret, 0, sizeof(ret)) before calling,
+ * else Bad Things will happen in the XDR code.
+ *
+ * NB(3) You must have the client lock before calling this
+ *
+ * NB(4) This is very complicated. Multiple threads are allowed to
+ * use the client for RPC at the same time. Obviously only one of
+ * them can. So if someone's using the socket, other threads are put
+ * to sleep on condition variables. The existing thread may completely
+ * send & receive their RPC call/reply while they're asleep. Or it
+ * may only get around to dealing with sending the call. Or it may
+ * get around to neither. So upon waking up from slumber, the other
+ * thread may or may not have more work todo.
+ *
+ * We call this dance  'passing the buck'
+ *
+ *      https://en.wikipedia.org/wiki/Passing_the_buck
+ *
+ *   "Buck passing or passing the buck is the action of transferring
+ *    responsibility or blame unto another person. It is also used as
+ *    a strategy in power politics when the actions of one country/
+ *    nation are blamed on another, providing an opportunity for war."
+ *
+ * NB(5) If the 'thiscall' has the 'nonBlock' flag set, the caller
+ * must *NOT* free it, if this returns '1' (ie partial send).
+ *
+ * NB(6) The following input states are valid if *no* threads
+ *       are currently executing this method
+ *
+ *   - waitDispatch == NULL,
+ *   - waitDispatch != NULL, waitDispatch.nonBlock == true
+ *
+ * The following input states are valid, if n threads are currently
+ * executing
+ *
+ *   - waitDispatch != NULL
+ *   - 0 or 1  waitDispatch.nonBlock == false, without any threads
+ *   - 0 or more waitDispatch.nonBlock == false, with threads
+ *
+ * The following output states are valid when all threads are done
+ *
+ *   - waitDispatch == NULL,
+ *   - waitDispatch != NULL, waitDispatch.nonBlock == true
+ *
+ * NB(7) Don't Panic!
+ *
+ * Returns 1 if the call was queued and will be completed later (only
+ * for nonBlock == true), 0 if the call was completed and -1 on error.
+ */
+static int virNetClientIO(virNetClient *client,
+                          virNetClientCall *thiscall)
+{
+    VIR_DEBUG("Outgoing message prog=%u version=%u serial=%u proc=%d type=%d length=%zu dispatch=%p",
+              thiscall->msg->header.prog,
+              thiscall->msg->header.vers,
+              thiscall->msg->header.serial,
+              thiscall->msg->header.proc,
+              thiscall->msg->header.type,
+              thiscall->msg->bufferLength,
+              client->waitDispatch);
+
+    /* Stick ourselves on the end of the wait queue */
+    virNetClientCallQueue(&client->waitDispatch, thiscall);
+
+    return virNetClientIOWait(client, thiscall);
+}
+
+
 void virNetClientIncomingEvent(virNetSocket *sock,
                                int events,
                                void *opaque)
@@ -2130,6 +2204,32 @@ virNetClientQueueNonBlocking(virNetClient *client,
 }
 
 
+/*
+ * Compresses @msg if the server agreed to it. Must be called without
+ * @client locked, so that other threads are not blocked meanwhile.
+ */
+static void
+virNetClientCompressMessage(virNetClient *client,
+                            virNetMessage *msg)
+{
+    bool compress;
+    size_t saved;
+
+    virObjectLock(client);
+    compress = client->compression;
+    virObjectUnlock(client);
+
+    if (!compress || (saved = virNetMessageCompress(msg)) == 0)
+        return;
+
+    virObjectLock(client);
+    client->compressionSaved += saved;
+    VIR_DEBUG("Compression saved %zu bytes, %llu bytes in total",
+              saved, client->compressionSaved);
+    virObjectUnlock(client);
+}
+
+
 /*
  * Returns 1 if the call was queued and will be completed later (only
  * for nonBlock == true), 0 if the call was completed and -1 on error.
@@ -2185,6 +2285,9 @@ int virNetClientSendWithReply(virNetClient *client,
                               virNetMessage *msg)
 {
     int ret;
+
+    virNetClientCompressMessage(client, msg);
+
     virObjectLock(client);
     ret = virNetClientSendInternal(client, msg, true, false);
     virObjectUnlock(client);
@@ -2194,6 +2297,116 @@ int virNetClientSendWithReply(virNetClient *client,
 }
 
 
+/*
+ * @msgs: array of messages allocated on heap or stack
+ * @nmsgs: number of messages in @msgs
+ *
+ * Send a batch of messages and wait for all of their replies. All
+ * messages are put on the wire back to back without waiting for any
+ * reply in between, and replies are matched to their calls by serial
+ * in whatever order the server sends them. Each message must have a
+ * distinct serial.
+ *
+ * The caller is responsible for free'ing @msgs if they were allocated
+ * on the heap
+ *
+ * Returns 0 if replies to all messages were received, -1 on failure
+ */
+int virNetClientSendWithReplyMany(virNetClient *client,
+                                  virNetMessage **msgs,
+                                  size_t nmsgs)
+{
+    g_autofree virNetClientCall **calls = NULL;
+    virNetClientCall *tail;
+    size_t i;
+    int ret = -1;
+
+    if (nmsgs == 0)
+        return 0;
+
+    calls = g_new0(virNetClientCall *, nmsgs);
+
+    for (i = 0; i < nmsgs; i++)
+        virNetClientCompressMessage(client, msgs[i]);
+
+    virObjectLock(client);
+
+    if (!client->sock || client->wantClose) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("client socket is closed"));
+        goto cleanup;
+    }
+
+    for (i = 0; i < nmsgs; i++) {
+        PROBE(RPC_CLIENT_MSG_TX_QUEUE,
+              "client=%p len=%zu prog=%u vers=%u proc=%u type=%u status=%u serial=%u",
+              client, msgs[i]->bufferLength,
+              msgs[i]->header.prog, msgs[i]->header.vers, msgs[i]->header.proc,
+              msgs[i]->header.type, msgs[i]->header.status, msgs[i]->header.serial);
+
+        if (!(calls[i] = virNetClientCallNew(msgs[i], true, false)))
+            goto cleanup;
+        calls[i]->batched = true;
+    }
+
+    VIR_DEBUG("Outgoing batch of %zu messages dispatch=%p",
+              nmsgs, client->waitDispatch);
+
+    /* Put the whole batch on the wait queue at once, so that whoever
+     * holds the buck writes all of it before going back to poll() */
+    tail = client->waitDispatch;
+    while (tail && tail->next)
+        tail = tail->next;
+    for (i = 0; i < nmsgs; i++) {
+        if (tail)
+            tail->next = calls[i];
+        else
+            client->waitDispatch = calls[i];
+        tail = calls[i];
+    }
+
+    ret = 0;
+    for (i = 0; i < nmsgs; i++) {
+        virNetClientCall *call = calls[i];
+
+        /* Replies may arrive in any order, so this one may have been
+         * completed while we were waiting for an earlier one */
+        if (call->mode == VIR_NET_CLIENT_MODE_COMPLETE)
+            continue;
+
+        if (!virNetClientCallIsQueued(client->waitDispatch, call) ||
+            !client->sock || client->wantClose) {
+            virNetClientCallRemove(&client->waitDispatch, call);
+            if (ret == 0) {
+                if (client->error)
+                    virSetError(client->error);
+                else
+                    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                                   _("client socket is closed"));
+            }
+            ret = -1;
+            continue;
+        }
+
+        /* Only the call we are actually sleeping on may be handed the
+         * buck, the rest of the batch stays detached until its turn */
+        call->haveThread = true;
+        if (virNetClientIOWait(client, call) < 0)
+            ret = -1;
+        call->haveThread = false;
+    }
+
+ cleanup:
+    for (i = 0; i < nmsgs && calls[i]; i++) {
+        virNetClientCallRemove(&client->waitDispatch, calls[i]);
+        virCondDestroy(&calls[i]->cond);
+        VIR_FREE(calls[i]);
+    }
+    virObjectUnlock(client);
+    return ret;
+}
+
+
 /*
  * @msg: a message allocated on the heap.
  *
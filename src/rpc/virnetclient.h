@@ -129,6 +129,10 @@ void virNetClientRemoveStream(virNetClient *client,
 int virNetClientSendWithReply(virNetClient *client,
                               virNetMessage *msg);
 
+int virNetClientSendWithReplyMany(virNetClient *client,
+                                  virNetMessage **msgs,
+                                  size_t nmsgs);
+
 int virNetClientSendNonBlock(virNetClient *client,
                              virNetMessage *msg);
 
@@ -144,6 +148,11 @@ void virNetClientSetSASLSession(virNetClient *client,
 int virNetClientSetTLSSession(virNetClient *client,
                               virNetTLSContext *tls);
 
+void virNetClientSetCompression(virNetClient *client,
+                                bool compression);
+void virNetClientSetDecompression(virNetClient *client,
+                                  bool decompression);
+
 bool virNetClientIsEncrypted(virNetClient *client);
 bool virNetClientIsOpen(virNetClient *client);
 
@@ -262,27 +262,68 @@ int virNetClientProgramDispatch(virNetClientProgram *prog,
 }
 
 
-int virNetClientProgramCall(virNetClientProgram *prog,
-                            virNetClient *client,
-                            unsigned serial,
-                            int proc,
-                            size_t noutfds,
-                            int *outfds,
-                            size_t *ninfds,
-                            int **infds,
-                            xdrproc_t args_filter, void *args,
-                            xdrproc_t ret_filter, void *ret)
+/**
+ * virNetClientProgramDispatchPayload:
+ * @prog: the program the event belongs to
+ * @client: the client the event arrived on
+ * @proc: procedure number of the event
+ * @payload: the encoded event message
+ * @len: length of @payload
+ *
+ * Decode and dispatch an event which did not arrive in a message of
+ * its own, but embedded in another one, such as a batch of events.
+ *
+ * Returns 0 on success, -1 if the event is unknown or cannot be decoded
+ */
+int virNetClientProgramDispatchPayload(virNetClientProgram *prog,
+                                       virNetClient *client,
+                                       int proc,
+                                       char *payload,
+                                       size_t len)
+{
+    virNetClientProgramEvent *event;
+    g_autofree char *evdata = NULL;
+    XDR xdr;
+    bool ok;
+
+    VIR_DEBUG("prog=%d proc=%d len=%zu", prog->program, proc, len);
+
+    if (!(event = virNetClientProgramGetEvent(prog, proc))) {
+        VIR_ERROR(_("No event expected with procedure 0x%x"), proc);
+        return -1;
+    }
+
+    evdata = g_new0(char, event->msg_len);
+
+    xdrmem_create(&xdr, payload, len, XDR_DECODE);
+    ok = (*event->msg_filter)(&xdr, evdata, 0);
+    xdr_destroy(&xdr);
+
+    if (!ok) {
+        VIR_ERROR(_("Unable to decode event with procedure 0x%x"), proc);
+        return -1;
+    }
+
+    event->func(prog, client, evdata, prog->eventOpaque);
+
+    xdr_free(event->msg_filter, evdata);
+    return 0;
+}
+
+
+static virNetMessage *
+virNetClientProgramCallPrepare(virNetClientProgram *prog,
+                               unsigned serial,
+                               int proc,
+                               size_t noutfds,
+                               int *outfds,
+                               xdrproc_t args_filter, void *args)
 {
     virNetMessage *msg;
     size_t i;
 
-    if (infds)
-        *infds = NULL;
-    if (ninfds)
-        *ninfds = 0;
-
     if (!(msg = virNetMessageNew(false)))
-        return -1;
+        return NULL;
 
     msg->header.prog = prog->program;
     msg->header.vers = prog->version;
@@ -319,8 +360,24 @@ int virNetClientProgramCall(virNetClientProgram *prog,
     if (virNetMessageEncodePayload(msg, args_filter, args) < 0)
         goto error;
 
-    if (virNetClientSendWithReply(client, msg) < 0)
-        goto error;
+    return msg;
+
+ error:
+    virNetMessageFree(msg);
+    return NULL;
+}
+
+
+static int
+virNetClientProgramCallFinish(virNetClientProgram *prog,
+                              virNetMessage *msg,
+                              unsigned serial,
+                              int proc,
+                              size_t *ninfds,
+                              int **infds,
+                              xdrproc_t ret_filter, void *ret)
+{
+    size_t i;
 
     /* None of these 3 should ever happen here, because
      * virNetClientSend should have validated the reply,
@@ -330,19 +387,19 @@ int virNetClientProgramCall(virNetClientProgram *prog,
         msg->header.type != VIR_NET_REPLY_WITH_FDS) {
         virReportError(VIR_ERR_INTERNAL_ERROR,
                        _("Unexpected message type %d"), msg->header.type);
-        goto error;
+        return -1;
     }
     if (msg->header.proc != proc) {
         virReportError(VIR_ERR_INTERNAL_ERROR,
                        _("Unexpected message proc %d != %d"),
                        msg->header.proc, proc);
-        goto error;
+        return -1;
     }
     if (msg->header.serial != serial) {
         virReportError(VIR_ERR_INTERNAL_ERROR,
                        _("Unexpected message serial %d != %d"),
                        msg->header.serial, serial);
-        goto error;
+        return -1;
     }
 
     switch (msg->header.status) {
@@ -358,32 +415,68 @@ int virNetClientProgramCall(virNetClientProgram *prog,
                     virReportSystemError(errno,
                                          _("Cannot duplicate FD %d"),
                                          msg->fds[i]);
-                    goto error;
+                    return -1;
                 }
                 if (virSetInherit((*infds)[i], false) < 0) {
                     virReportSystemError(errno,
                                          _("Cannot set close-on-exec %d"),
                                          (*infds)[i]);
-                    goto error;
+                    return -1;
                 }
             }
 
         }
         if (virNetMessageDecodePayload(msg, ret_filter, ret) < 0)
-            goto error;
+            return -1;
         break;
 
     case VIR_NET_ERROR:
         virNetClientProgramDispatchError(prog, msg);
-        goto error;
+        return -1;
 
     case VIR_NET_CONTINUE:
     default:
         virReportError(VIR_ERR_RPC,
                        _("Unexpected message status %d"), msg->header.status);
-        goto error;
+        return -1;
     }
 
+    return 0;
+}
+
+
+int virNetClientProgramCall(virNetClientProgram *prog,
+                            virNetClient *client,
+                            unsigned serial,
+                            int proc,
+                            size_t noutfds,
+                            int *outfds,
+                            size_t *ninfds,
+                            int **infds,
+                            xdrproc_t args_filter, void *args,
+                            xdrproc_t ret_filter, void *ret)
+{
+    virNetMessage *msg;
+    size_t i;
+
+    if (infds)
+        *infds = NULL;
+    if (ninfds)
+        *ninfds = 0;
+
+    if (!(msg = virNetClientProgramCallPrepare(prog, serial, proc,
+                                               noutfds, outfds,
+                                               args_filter, args)))
+        return -1;
+
+    if (virNetClientSendWithReply(client, msg) < 0)
+        goto error;
+
+    if (virNetClientProgramCallFinish(prog, msg, serial, proc,
+                                      ninfds, infds,
+                                      ret_filter, ret) < 0)
+        goto error;
+
     virNetMessageFree(msg);
 
     return 0;
@@ -396,3 +489,60 @@ int virNetClientProgramCall(virNetClientProgram *prog,
     }
     return -1;
 }
+
+
+/*
+ * Issue all @calls on @client without waiting for each reply in
+ * turn. The requests are pipelined on the connection and the replies
+ * are picked up by serial as they arrive.
+ *
+ * A failure of an individual call does not affect the others, its
+ * error is stored in @calls[i].error for the caller to free.
+ *
+ * Returns 0 if a reply was received for every call, or -1 if the
+ * batch could not be sent or the connection failed.
+ */
+int virNetClientProgramCallMany(virNetClientProgram *prog,
+                                virNetClient *client,
+                                virNetClientProgramCallData *calls,
+                                size_t ncalls)
+{
+    virNetMessage **msgs = NULL;
+    size_t i;
+    int ret = -1;
+
+    msgs = g_new0(virNetMessage *, ncalls);
+
+    for (i = 0; i < ncalls; i++) {
+        calls[i].error = NULL;
+        if (!(msgs[i] = virNetClientProgramCallPrepare(prog,
+                                                       calls[i].serial,
+                                                       calls[i].proc,
+                                                       0, NULL,
+                                                       calls[i].args_filter,
+                                                       calls[i].args)))
+            goto cleanup;
+    }
+
+    if (virNetClientSendWithReplyMany(client, msgs, ncalls) < 0)
+        goto cleanup;
+
+    for (i = 0; i < ncalls; i++) {
+        if (virNetClientProgramCallFinish(prog, msgs[i],
+                                          calls[i].serial, calls[i].proc,
+                                          NULL, NULL,
+                                          calls[i].ret_filter,
+                                          calls[i].ret) < 0) {
+            calls[i].error = virSaveLastError();
+            virResetLastError();
+        }
+    }
+
+    ret = 0;
+
+ cleanup:
+    for (i = 0; i < ncalls; i++)
+        virNetMessageFree(msgs[i]);
+    VIR_FREE(msgs);
+    return ret;
+}
@@ -33,6 +33,8 @@ typedef struct _virNetClientProgramEvent virNetClientProgramEvent;
 
 typedef struct _virNetClientProgramErrorHandler virNetClientProgramErrorHander;
 
+typedef struct _virNetClientProgramCallData virNetClientProgramCallData;
+
 
 typedef void (*virNetClientProgramDispatchFunc)(virNetClientProgram *prog,
                                                 virNetClient *client,
@@ -46,6 +48,17 @@ struct _virNetClientProgramEvent {
     xdrproc_t msg_filter;
 };
 
+struct _virNetClientProgramCallData {
+    unsigned serial;
+    int proc;
+    xdrproc_t args_filter;
+    void *args;
+    xdrproc_t ret_filter;
+    void *ret;
+
+    virErrorPtr error; /* Set if this particular call failed */
+};
+
 virNetClientProgram *virNetClientProgramNew(unsigned program,
                                               unsigned version,
                                               virNetClientProgramEvent *events,
@@ -62,6 +75,12 @@ int virNetClientProgramDispatch(virNetClientProgram *prog,
                                 virNetClient *client,
                                 virNetMessage *msg);
 
+int virNetClientProgramDispatchPayload(virNetClientProgram *prog,
+                                       virNetClient *client,
+                                       int proc,
+                                       char *payload,
+                                       size_t len);
+
 int virNetClientProgramCall(virNetClientProgram *prog,
                             virNetClient *client,
                             unsigned serial,
@@ -72,3 +91,8 @@ int virNetClientProgramCall(virNetClientProgram *prog,
                             int **infds,
                             xdrproc_t args_filter, void *args,
                             xdrproc_t ret_filter, void *ret);
+
+int virNetClientProgramCallMany(virNetClientProgram *prog,
+                                virNetClient *client,
+                                virNetClientProgramCallData *calls,
+                                size_t ncalls);
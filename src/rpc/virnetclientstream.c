@@ -341,7 +341,8 @@ int virNetClientStreamQueuePacket(virNetClientStream *st,
     tmp_msg->buffer = g_steal_pointer(&msg->buffer);
     tmp_msg->bufferLength = msg->bufferLength;
     tmp_msg->bufferOffset = msg->bufferOffset;
-    msg->bufferLength = msg->bufferOffset = 0;
+    tmp_msg->bufferSize = msg->bufferSize;
+    msg->bufferLength = msg->bufferOffset = msg->bufferSize = 0;
 
     virObjectLock(st);
 
@@ -0,0 +1,111 @@
+/*
+ * virneteventbatch.c: queue of events sent to a client in a single message
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "viralloc.h"
+#include "virlog.h"
+#include "virneteventbatch.h"
+
+#define VIR_FROM_THIS VIR_FROM_RPC
+
+VIR_LOG_INIT("rpc.neteventbatch");
+
+
+/**
+ * virNetEventBatchAdd:
+ * @batch: the queue
+ * @item: the event to append
+ * @coalesce: whether @item supersedes a queued event
+ *
+ * Appends @item to @batch, taking over its payload and clearing it. If
+ * @coalesce is true, a queued event with the same procedure number,
+ * callback and domain UUID is dropped first, as @item only reports a
+ * newer value of the same property.
+ */
+void
+virNetEventBatchAdd(virNetEventBatch *batch,
+                    virNetEventBatchItem *item,
+                    bool coalesce)
+{
+    size_t i;
+
+    if (coalesce) {
+        for (i = 0; i < batch->nitems; i++) {
+            virNetEventBatchItem *old = &batch->items[i];
+
+            if (old->procnr != item->procnr ||
+                old->callbackID != item->callbackID ||
+                memcmp(old->uuid, item->uuid, VIR_UUID_BUFLEN) != 0)
+                continue;
+
+            VIR_DEBUG("Dropping superseded event %d", item->procnr);
+            batch->size -= old->len;
+            g_free(old->payload);
+            VIR_DELETE_ELEMENT(batch->items, i, batch->nitems);
+            break;
+        }
+    }
+
+    VIR_DEBUG("Queue event %d %zu", item->procnr, item->len);
+    batch->size += item->len;
+    VIR_APPEND_ELEMENT(batch->items, batch->nitems, *item);
+}
+
+
+/**
+ * virNetEventBatchSteal:
+ * @batch: the queue
+ * @items: filled with the queued events
+ *
+ * Empties @batch, passing its events to the caller in the order they
+ * were queued in.
+ *
+ * Returns the number of events stored in @items.
+ */
+size_t
+virNetEventBatchSteal(virNetEventBatch *batch,
+                      virNetEventBatchItem **items)
+{
+    size_t nitems = batch->nitems;
+
+    *items = g_steal_pointer(&batch->items);
+    batch->nitems = 0;
+    batch->size = 0;
+
+    return nitems;
+}
+
+
+/**
+ * virNetEventBatchClear:
+ * @batch: the queue
+ *
+ * Drops all events queued in @batch.
+ */
+void
+virNetEventBatchClear(virNetEventBatch *batch)
+{
+    size_t i;
+
+    for (i = 0; i < batch->nitems; i++)
+        g_free(batch->items[i].payload);
+    g_clear_pointer(&batch->items, g_free);
+    batch->nitems = 0;
+    batch->size = 0;
+}
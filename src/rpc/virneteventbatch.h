@@ -0,0 +1,47 @@
+/*
+ * virneteventbatch.h: queue of events sent to a client in a single message
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "internal.h"
+#include "viruuid.h"
+
+typedef struct _virNetEventBatchItem virNetEventBatchItem;
+struct _virNetEventBatchItem {
+    int procnr;
+    int callbackID;
+    unsigned char uuid[VIR_UUID_BUFLEN];
+    char *payload; /* encoded event message */
+    size_t len;
+};
+
+typedef struct _virNetEventBatch virNetEventBatch;
+struct _virNetEventBatch {
+    virNetEventBatchItem *items;
+    size_t nitems;
+    size_t size; /* sum of payload lengths */
+};
+
+void virNetEventBatchAdd(virNetEventBatch *batch,
+                         virNetEventBatchItem *item,
+                         bool coalesce);
+
+size_t virNetEventBatchSteal(virNetEventBatch *batch,
+                             virNetEventBatchItem **items);
+
+void virNetEventBatchClear(virNetEventBatch *batch);
@@ -21,6 +21,7 @@
 #include <config.h>
 
 #include <unistd.h>
+#include <gio/gio.h>
 
 #include "virnetmessage.h"
 #include "viralloc.h"
@@ -28,16 +29,217 @@
 #include "virlog.h"
 #include "virfile.h"
 #include "virutil.h"
+#include "virthread.h"
 
 #define VIR_FROM_THIS VIR_FROM_RPC
 
 VIR_LOG_INIT("rpc.netmessage");
 
+/* Payloads smaller than this are not worth compressing */
+#define VIR_NET_MESSAGE_COMPRESS_MIN 4096
+
+/* Number of buffer size classes kept in the pool. Class N holds buffers
+ * of VIR_NET_MESSAGE_INITIAL << N bytes, plus the length word and the
+ * header, so that both the initial buffer of an encoded message and a
+ * stream packet with a payload of VIR_NET_MESSAGE_INITIAL << N bytes
+ * fit into one. */
+#define VIR_NET_MESSAGE_POOL_CLASSES 7
+
+/*
+ * Process wide cache of message structs and buffers, which would
+ * otherwise be allocated and freed for every single call, reply and
+ * event. Free buffers of each size class are chained through their
+ * first bytes. Only up to @limit bytes are kept, a zero @limit
+ * disables the pool.
+ */
+typedef struct _virNetMessagePool virNetMessagePool;
+struct _virNetMessagePool {
+    virMutex lock;
+    size_t limit;
+    size_t size;
+
+    void *buffers[VIR_NET_MESSAGE_POOL_CLASSES];
+    virNetMessage *msgs;
+};
+
+static virNetMessagePool virNetMessagePoolData = {
+    .lock = VIR_MUTEX_INITIALIZER,
+};
+
+
+static size_t
+virNetMessagePoolClassSize(size_t idx)
+{
+    return ((size_t)VIR_NET_MESSAGE_INITIAL << idx) +
+        VIR_NET_MESSAGE_LEN_MAX + VIR_NET_MESSAGE_HEADER_MAX;
+}
+
+
+static void
+virNetMessagePoolTrimLocked(virNetMessagePool *pool)
+{
+    size_t i;
+
+    for (i = VIR_NET_MESSAGE_POOL_CLASSES; i > 0 && pool->size > pool->limit; i--) {
+        while (pool->buffers[i - 1] && pool->size > pool->limit) {
+            void *buffer = pool->buffers[i - 1];
+
+            pool->buffers[i - 1] = *(void **)buffer;
+            pool->size -= virNetMessagePoolClassSize(i - 1);
+            g_free(buffer);
+        }
+    }
+
+    while (pool->msgs && pool->size > pool->limit) {
+        virNetMessage *msg = pool->msgs;
+
+        pool->msgs = msg->next;
+        pool->size -= sizeof(*msg);
+        g_free(msg);
+    }
+}
+
+
+/**
+ * virNetMessagePoolSetLimit:
+ * @limit: maximum number of bytes to keep cached
+ *
+ * Sets how much memory may be kept cached for reuse by future messages
+ * after they are freed. Zero, which is the default, disables caching.
+ */
+void
+virNetMessagePoolSetLimit(size_t limit)
+{
+    virNetMessagePool *pool = &virNetMessagePoolData;
+    VIR_LOCK_GUARD lock = virLockGuardLock(&pool->lock);
+
+    VIR_DEBUG("limit=%zu", limit);
+
+    pool->limit = limit;
+    virNetMessagePoolTrimLocked(pool);
+}
+
+
+/*
+ * Returns a buffer of at least @len bytes and stores its real size
+ * into @size.
+ */
+static char *
+virNetMessageBufferNew(size_t len,
+                       size_t *size)
+{
+    virNetMessagePool *pool = &virNetMessagePoolData;
+    bool pooled = false;
+    size_t i;
+
+    for (i = 0; i < VIR_NET_MESSAGE_POOL_CLASSES; i++) {
+        if (len <= virNetMessagePoolClassSize(i))
+            break;
+    }
+
+    /* Tiny buffers for reading a length word are not worth it */
+    if (len > VIR_NET_MESSAGE_LEN_MAX && i < VIR_NET_MESSAGE_POOL_CLASSES) {
+        VIR_WITH_MUTEX_LOCK_GUARD(&pool->lock) {
+            void *buffer = pool->buffers[i];
+
+            if (buffer) {
+                pool->buffers[i] = *(void **)buffer;
+                pool->size -= virNetMessagePoolClassSize(i);
+                *size = virNetMessagePoolClassSize(i);
+                return buffer;
+            }
+
+            pooled = pool->limit > 0;
+        }
+    }
+
+    /* Allocate the full size class, so that the buffer can be kept
+     * in the pool once it is released */
+    if (pooled)
+        *size = virNetMessagePoolClassSize(i);
+    else
+        *size = len;
+
+    return g_new(char, *size);
+}
+
+
+/*
+ * Releases @buffer of @size bytes, keeping it for reuse if possible.
+ */
+static void
+virNetMessageBufferFree(char *buffer,
+                        size_t size)
+{
+    virNetMessagePool *pool = &virNetMessagePoolData;
+    size_t i;
+
+    if (!buffer)
+        return;
+
+    for (i = 0; i < VIR_NET_MESSAGE_POOL_CLASSES; i++) {
+        if (size != virNetMessagePoolClassSize(i))
+            continue;
+
+        VIR_WITH_MUTEX_LOCK_GUARD(&pool->lock) {
+            if (pool->size + size <= pool->limit) {
+                *(void **)buffer = pool->buffers[i];
+                pool->buffers[i] = buffer;
+                pool->size += size;
+                return;
+            }
+        }
+        break;
+    }
+
+    g_free(buffer);
+}
+
+
+/**
+ * virNetMessageResizeBuffer:
+ * @msg: message whose buffer to resize
+ * @len: new length of the buffer
+ *
+ * Makes sure the buffer of @msg can hold @len bytes and sets its length
+ * accordingly. The current content of the buffer is preserved.
+ */
+void
+virNetMessageResizeBuffer(virNetMessage *msg,
+                          size_t len)
+{
+    char *buffer;
+    size_t size;
+
+    if (len > msg->bufferSize) {
+        buffer = virNetMessageBufferNew(len, &size);
+        if (msg->buffer)
+            memcpy(buffer, msg->buffer, MIN(msg->bufferLength, len));
+        virNetMessageBufferFree(msg->buffer, msg->bufferSize);
+        msg->buffer = buffer;
+        msg->bufferSize = size;
+    }
+
+    msg->bufferLength = len;
+}
+
+
 virNetMessage *virNetMessageNew(bool tracked)
 {
-    virNetMessage *msg;
+    virNetMessagePool *pool = &virNetMessagePoolData;
+    virNetMessage *msg = NULL;
 
-    msg = g_new0(virNetMessage, 1);
+    VIR_WITH_MUTEX_LOCK_GUARD(&pool->lock) {
+        if ((msg = pool->msgs)) {
+            pool->msgs = msg->next;
+            pool->size -= sizeof(*msg);
+        }
+    }
+
+    if (msg)
+        memset(msg, 0, sizeof(*msg));
+    else
+        msg = g_new0(virNetMessage, 1);
 
     msg->tracked = tracked;
     VIR_DEBUG("msg=%p tracked=%d", msg, tracked);
@@ -67,7 +269,8 @@ virNetMessageClearPayload(virNetMessage *msg)
 
     msg->bufferOffset = 0;
     msg->bufferLength = 0;
-    VIR_FREE(msg->buffer);
+    virNetMessageBufferFree(g_steal_pointer(&msg->buffer), msg->bufferSize);
+    msg->bufferSize = 0;
 }
 
 
@@ -85,6 +288,8 @@ void virNetMessageClear(virNetMessage *msg)
 
 void virNetMessageFree(virNetMessage *msg)
 {
+    virNetMessagePool *pool = &virNetMessagePoolData;
+
     if (!msg)
         return;
 
@@ -94,6 +299,16 @@ void virNetMessageFree(virNetMessage *msg)
         msg->cb(msg, msg->opaque);
 
     virNetMessageClearPayload(msg);
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&pool->lock) {
+        if (pool->size + sizeof(*msg) <= pool->limit) {
+            msg->next = pool->msgs;
+            pool->msgs = msg;
+            pool->size += sizeof(*msg);
+            return;
+        }
+    }
+
     g_free(msg);
 }
 
@@ -156,8 +371,7 @@ int virNetMessageDecodeLength(virNetMessage *msg)
 
     /* Extend our declared buffer length and carry
        on reading the header + payload */
-    msg->bufferLength += len;
-    VIR_REALLOC_N(msg->buffer, msg->bufferLength);
+    virNetMessageResizeBuffer(msg, msg->bufferLength + len);
 
     VIR_DEBUG("Got length, now need %zu total (%u more)",
               msg->bufferLength, len);
@@ -170,6 +384,153 @@ int virNetMessageDecodeLength(virNetMessage *msg)
 }
 
 
+/*
+ * Feeds all of @in through @converter, storing the result in @out.
+ *
+ * Returns the number of bytes stored in @out, or -1 if the result
+ * does not fit into @outlen bytes or the data is malformed.
+ */
+static ssize_t
+virNetMessageConvert(GConverter *converter,
+                     const char *in,
+                     size_t inlen,
+                     char *out,
+                     size_t outlen,
+                     GError **error)
+{
+    size_t inpos = 0;
+    size_t outpos = 0;
+
+    while (true) {
+        GConverterResult res;
+        gsize nread = 0;
+        gsize nwritten = 0;
+
+        res = g_converter_convert(converter,
+                                  in + inpos, inlen - inpos,
+                                  out + outpos, outlen - outpos,
+                                  G_CONVERTER_INPUT_AT_END,
+                                  &nread, &nwritten, error);
+        if (res == G_CONVERTER_ERROR)
+            return -1;
+
+        inpos += nread;
+        outpos += nwritten;
+
+        if (res == G_CONVERTER_FINISHED)
+            return inpos == inlen ? outpos : -1;
+
+        if (nread == 0 && nwritten == 0)
+            return -1;
+    }
+}
+
+
+/*
+ * @msg: the incoming message, whose header was just decoded
+ * @negotiated: whether compression was negotiated on the connection
+ *
+ * If the message has one of the compressed types, replaces its
+ * payload with the uncompressed one and restores the plain message
+ * type, so that the rest of the code never sees compressed messages.
+ * Upon return bufferOffset still refers to the start of the payload.
+ *
+ * Compressed messages are refused unless @negotiated is true, so that
+ * a peer which didn't negotiate compression, possibly before being
+ * authenticated, can't make us inflate its payloads.
+ *
+ * returns 0 on success, -1 upon fatal error
+ */
+int
+virNetMessageDecompress(virNetMessage *msg,
+                        bool negotiated)
+{
+    g_autoptr(GZlibDecompressor) decompressor = NULL;
+    g_autoptr(GError) error = NULL;
+    g_autofree char *buffer = NULL;
+    virNetMessageType type;
+    unsigned int rawlen;
+    size_t offset;
+    size_t size;
+    ssize_t len;
+    XDR xdr;
+
+    switch ((virNetMessageType) msg->header.type) {
+    case VIR_NET_CALL_COMPRESSED:
+        type = VIR_NET_CALL;
+        break;
+    case VIR_NET_REPLY_COMPRESSED:
+        type = VIR_NET_REPLY;
+        break;
+    case VIR_NET_MESSAGE_COMPRESSED:
+        type = VIR_NET_MESSAGE;
+        break;
+    case VIR_NET_CALL:
+    case VIR_NET_REPLY:
+    case VIR_NET_MESSAGE:
+    case VIR_NET_STREAM:
+    case VIR_NET_CALL_WITH_FDS:
+    case VIR_NET_REPLY_WITH_FDS:
+    case VIR_NET_STREAM_HOLE:
+    default:
+        return 0;
+    }
+
+    if (!negotiated) {
+        virReportError(VIR_ERR_RPC,
+                       _("compressed message type %d without negotiated compression"),
+                       msg->header.type);
+        return -1;
+    }
+
+    xdrmem_create(&xdr, msg->buffer + msg->bufferOffset,
+                  msg->bufferLength - msg->bufferOffset, XDR_DECODE);
+    if (!xdr_u_int(&xdr, &rawlen)) {
+        virReportError(VIR_ERR_RPC, "%s",
+                       _("Unable to decode uncompressed payload length"));
+        xdr_destroy(&xdr);
+        return -1;
+    }
+    offset = msg->bufferOffset + xdr_getpos(&xdr);
+    xdr_destroy(&xdr);
+
+    if (rawlen > VIR_NET_MESSAGE_MAX -
+        (msg->bufferOffset - VIR_NET_MESSAGE_LEN_MAX)) {
+        virReportError(VIR_ERR_RPC,
+                       _("uncompressed payload %u bytes too large, want %d"),
+                       rawlen, VIR_NET_MESSAGE_MAX);
+        return -1;
+    }
+
+    buffer = virNetMessageBufferNew(msg->bufferOffset + rawlen, &size);
+    memcpy(buffer, msg->buffer, msg->bufferOffset);
+
+    decompressor = g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_RAW);
+    len = virNetMessageConvert(G_CONVERTER(decompressor),
+                               msg->buffer + offset,
+                               msg->bufferLength - offset,
+                               buffer + msg->bufferOffset,
+                               rawlen, &error);
+    if (len < 0 || len != rawlen) {
+        virReportError(VIR_ERR_RPC,
+                       _("Unable to decompress message payload: %s"),
+                       error ? error->message : _("size mismatch"));
+        return -1;
+    }
+
+    VIR_DEBUG("Decompressed payload from %zu to %u bytes",
+              msg->bufferLength - offset, rawlen);
+
+    virNetMessageBufferFree(msg->buffer, msg->bufferSize);
+    msg->buffer = g_steal_pointer(&buffer);
+    msg->bufferSize = size;
+    msg->bufferLength = msg->bufferOffset + rawlen;
+    msg->header.type = type;
+
+    return 0;
+}
+
+
 /*
  * @msg: the complete incoming message, whose header to decode
  *
@@ -232,8 +593,7 @@ int virNetMessageEncodeHeader(virNetMessage *msg)
     int ret = -1;
     unsigned int len = 0;
 
-    msg->bufferLength = VIR_NET_MESSAGE_INITIAL + VIR_NET_MESSAGE_LEN_MAX;
-    VIR_REALLOC_N(msg->buffer, msg->bufferLength);
+    virNetMessageResizeBuffer(msg, VIR_NET_MESSAGE_INITIAL + VIR_NET_MESSAGE_LEN_MAX);
     msg->bufferOffset = 0;
 
     /* Format the header. */
@@ -274,6 +634,104 @@ int virNetMessageEncodeHeader(virNetMessage *msg)
 }
 
 
+/*
+ * @msg: the outgoing message, with the payload fully encoded
+ *
+ * Compresses the payload of a VIR_NET_CALL, VIR_NET_REPLY or
+ * VIR_NET_MESSAGE if it is large enough for it to be worthwhile,
+ * changing the type encoded in the buffer to the matching compressed
+ * type. The header stored in @msg is left untouched. The peer must
+ * have negotiated VIR_DRV_FEATURE_REMOTE_COMPRESSION.
+ *
+ * Compression is best effort, the message is left as is whenever
+ * it can not be compressed or compressing it would not save much.
+ *
+ * returns the number of bytes saved, 0 if the message was left as is
+ */
+size_t
+virNetMessageCompress(virNetMessage *msg)
+{
+    g_autoptr(GZlibCompressor) compressor = NULL;
+    g_autofree char *buffer = NULL;
+    virNetMessageHeader header = msg->header;
+    size_t offset = VIR_NET_MESSAGE_LEN_MAX + VIR_NET_MESSAGE_HEADER_MAX;
+    size_t payloadlen;
+    size_t maxlen;
+    size_t saved;
+    size_t size;
+    unsigned int rawlen;
+    unsigned int len;
+    ssize_t zlen;
+    XDR xdr;
+
+    switch ((virNetMessageType) msg->header.type) {
+    case VIR_NET_CALL:
+        header.type = VIR_NET_CALL_COMPRESSED;
+        break;
+    case VIR_NET_REPLY:
+        header.type = VIR_NET_REPLY_COMPRESSED;
+        break;
+    case VIR_NET_MESSAGE:
+        header.type = VIR_NET_MESSAGE_COMPRESSED;
+        break;
+    case VIR_NET_STREAM:
+    case VIR_NET_CALL_WITH_FDS:
+    case VIR_NET_REPLY_WITH_FDS:
+    case VIR_NET_STREAM_HOLE:
+    case VIR_NET_CALL_COMPRESSED:
+    case VIR_NET_REPLY_COMPRESSED:
+    case VIR_NET_MESSAGE_COMPRESSED:
+    default:
+        return 0;
+    }
+
+    /* Only ever touch messages which were not started to be sent yet */
+    if (msg->bufferOffset != 0 ||
+        msg->bufferLength < offset + VIR_NET_MESSAGE_COMPRESS_MIN)
+        return 0;
+
+    payloadlen = msg->bufferLength - offset;
+
+    /* Require at least 1/8 of the payload to be saved, anything less
+     * is not worth the extra work on the receiving side. */
+    maxlen = payloadlen - payloadlen / 8;
+    buffer = virNetMessageBufferNew(offset + maxlen, &size);
+
+    compressor = g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_RAW, 1);
+    zlen = virNetMessageConvert(G_CONVERTER(compressor),
+                                msg->buffer + offset, payloadlen,
+                                buffer + offset + VIR_NET_MESSAGE_LEN_MAX,
+                                maxlen - VIR_NET_MESSAGE_LEN_MAX, NULL);
+    if (zlen < 0) {
+        VIR_DEBUG("Payload of %zu bytes not compressible enough", payloadlen);
+        return 0;
+    }
+
+    len = offset + VIR_NET_MESSAGE_LEN_MAX + zlen;
+    rawlen = payloadlen;
+
+    xdrmem_create(&xdr, buffer, offset + VIR_NET_MESSAGE_LEN_MAX, XDR_ENCODE);
+    if (!xdr_u_int(&xdr, &len) ||
+        !xdr_virNetMessageHeader(&xdr, &header) ||
+        !xdr_u_int(&xdr, &rawlen)) {
+        VIR_DEBUG("Unable to encode compressed message header");
+        xdr_destroy(&xdr);
+        return 0;
+    }
+    xdr_destroy(&xdr);
+
+    saved = msg->bufferLength - len;
+    VIR_DEBUG("Compressed payload from %zu to %zd bytes", payloadlen, zlen);
+
+    virNetMessageBufferFree(msg->buffer, msg->bufferSize);
+    msg->buffer = g_steal_pointer(&buffer);
+    msg->bufferSize = size;
+    msg->bufferLength = len;
+
+    return saved;
+}
+
+
 int virNetMessageEncodeNumFDs(virNetMessage *msg)
 {
     XDR xdr;
@@ -371,9 +829,7 @@ int virNetMessageEncodePayload(virNetMessage *msg,
 
         xdr_destroy(&xdr);
 
-        msg->bufferLength = newlen + VIR_NET_MESSAGE_LEN_MAX;
-
-        VIR_REALLOC_N(msg->buffer, msg->bufferLength);
+        virNetMessageResizeBuffer(msg, newlen + VIR_NET_MESSAGE_LEN_MAX);
 
         xdrmem_create(&xdr, msg->buffer + msg->bufferOffset,
                       msg->bufferLength - msg->bufferOffset, XDR_ENCODE);
@@ -434,47 +890,68 @@ int virNetMessageDecodePayload(virNetMessage *msg,
 
 
 /**
- * virNetMessageEncodePayloadRaw:
- * @msg: message to encode payload into
- * @data: data to encode into @msg
- * @len: length of @data
+ * virNetMessageReservePayloadRaw:
+ * @msg: message to reserve payload space in
+ * @len: number of bytes to reserve
  *
- * Encodes message payload. If @data is NULL or @len is 0 an empty message is
- * encoded.
+ * Makes room for @len bytes of raw payload after the data already encoded
+ * into @msg and returns a pointer to it. This allows stream data to be
+ * produced directly in the message buffer rather than being copied there
+ * by virNetMessageEncodePayloadRaw. Once filled in, the data must be
+ * committed using virNetMessageCommitPayloadRaw.
+ *
+ * Returns pointer into the message buffer or NULL on error.
  */
-int virNetMessageEncodePayloadRaw(virNetMessage *msg,
-                                  const char *data,
-                                  size_t len)
+char *virNetMessageReservePayloadRaw(virNetMessage *msg,
+                                     size_t len)
 {
-    XDR xdr;
-    unsigned int msglen;
+    /* If the message buffer is too small for the payload increase it accordingly. */
+    if ((msg->bufferLength - msg->bufferOffset) < len) {
+        if ((msg->bufferOffset + len) >
+            (VIR_NET_MESSAGE_MAX + VIR_NET_MESSAGE_LEN_MAX)) {
+            virReportError(VIR_ERR_RPC,
+                           _("Stream data too long to send "
+                             "(%zu bytes needed, %zu bytes available)"),
+                           len,
+                           VIR_NET_MESSAGE_MAX +
+                           VIR_NET_MESSAGE_LEN_MAX -
+                           msg->bufferOffset);
+            return NULL;
+        }
 
-    if (data && len > 0) {
-        /* If the message buffer is too small for the payload increase it accordingly. */
-        if ((msg->bufferLength - msg->bufferOffset) < len) {
-            if ((msg->bufferOffset + len) >
-                (VIR_NET_MESSAGE_MAX + VIR_NET_MESSAGE_LEN_MAX)) {
-                virReportError(VIR_ERR_RPC,
-                               _("Stream data too long to send "
-                                 "(%zu bytes needed, %zu bytes available)"),
-                               len,
-                               VIR_NET_MESSAGE_MAX +
-                               VIR_NET_MESSAGE_LEN_MAX -
-                               msg->bufferOffset);
-                return -1;
-            }
+        virNetMessageResizeBuffer(msg, msg->bufferOffset + len);
 
-            msg->bufferLength = msg->bufferOffset + len;
+        VIR_DEBUG("Increased message buffer length = %zu", msg->bufferLength);
+    }
+
+    return msg->buffer + msg->bufferOffset;
+}
 
-            VIR_REALLOC_N(msg->buffer, msg->bufferLength);
 
-            VIR_DEBUG("Increased message buffer length = %zu", msg->bufferLength);
-        }
+/**
+ * virNetMessageCommitPayloadRaw:
+ * @msg: message to commit payload of
+ * @len: number of bytes filled in
+ *
+ * Finishes encoding of a message whose raw payload was written in place
+ * into the space returned by virNetMessageReservePayloadRaw. @len may be
+ * smaller than the reserved size.
+ */
+int virNetMessageCommitPayloadRaw(virNetMessage *msg,
+                                  size_t len)
+{
+    XDR xdr;
+    unsigned int msglen;
 
-        memcpy(msg->buffer + msg->bufferOffset, data, len);
-        msg->bufferOffset += len;
+    if (len > msg->bufferLength - msg->bufferOffset) {
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Stream payload of %zu bytes exceeds reserved space"),
+                       len);
+        return -1;
     }
 
+    msg->bufferOffset += len;
+
     /* Re-encode the length word. */
     VIR_DEBUG("Encode length as %zu", msg->bufferOffset);
     xdrmem_create(&xdr, msg->buffer, VIR_NET_MESSAGE_HEADER_XDR_LEN, XDR_ENCODE);
@@ -495,6 +972,33 @@ int virNetMessageEncodePayloadRaw(virNetMessage *msg,
 }
 
 
+/**
+ * virNetMessageEncodePayloadRaw:
+ * @msg: message to encode payload into
+ * @data: data to encode into @msg
+ * @len: length of @data
+ *
+ * Encodes message payload. If @data is NULL or @len is 0 an empty message is
+ * encoded.
+ */
+int virNetMessageEncodePayloadRaw(virNetMessage *msg,
+                                  const char *data,
+                                  size_t len)
+{
+    char *payload;
+
+    if (!data || len == 0)
+        return virNetMessageCommitPayloadRaw(msg, 0);
+
+    if (!(payload = virNetMessageReservePayloadRaw(msg, len)))
+        return -1;
+
+    memcpy(payload, data, len);
+
+    return virNetMessageCommitPayloadRaw(msg, len);
+}
+
+
 void virNetMessageSaveError(struct virNetMessageError *rerr)
 {
     virErrorPtr verr;
@@ -33,6 +33,9 @@ struct _virNetMessage {
                   /* Maximum   VIR_NET_MESSAGE_MAX     + VIR_NET_MESSAGE_LEN_MAX */
     size_t bufferLength;
     size_t bufferOffset;
+    size_t bufferSize; /* Allocated size of @buffer, which may exceed
+                        * @bufferLength. Zero if @buffer was assigned
+                        * directly rather than by virNetMessageResizeBuffer */
 
     virNetMessageHeader header;
 
@@ -47,8 +50,14 @@ struct _virNetMessage {
 };
 
 
+void virNetMessagePoolSetLimit(size_t limit);
+
 virNetMessage *virNetMessageNew(bool tracked);
 
+void virNetMessageResizeBuffer(virNetMessage *msg,
+                               size_t len)
+    ATTRIBUTE_NONNULL(1);
+
 void virNetMessageClearFDs(virNetMessage *msg);
 void virNetMessageClearPayload(virNetMessage *msg);
 
@@ -68,6 +77,9 @@ int virNetMessageDecodeLength(virNetMessage *msg)
     ATTRIBUTE_NONNULL(1) G_GNUC_WARN_UNUSED_RESULT;
 int virNetMessageDecodeHeader(virNetMessage *msg)
     ATTRIBUTE_NONNULL(1) G_GNUC_WARN_UNUSED_RESULT;
+int virNetMessageDecompress(virNetMessage *msg,
+                            bool negotiated)
+    ATTRIBUTE_NONNULL(1) G_GNUC_WARN_UNUSED_RESULT;
 
 int virNetMessageEncodePayload(virNetMessage *msg,
                                xdrproc_t filter,
@@ -78,6 +90,9 @@ int virNetMessageDecodePayload(virNetMessage *msg,
                                void *data)
     ATTRIBUTE_NONNULL(1) ATTRIBUTE_NONNULL(2) ATTRIBUTE_NONNULL(2) G_GNUC_WARN_UNUSED_RESULT;
 
+size_t virNetMessageCompress(virNetMessage *msg)
+    ATTRIBUTE_NONNULL(1);
+
 int virNetMessageEncodeNumFDs(virNetMessage *msg);
 int virNetMessageDecodeNumFDs(virNetMessage *msg);
 
@@ -85,6 +100,12 @@ int virNetMessageEncodePayloadRaw(virNetMessage *msg,
                                   const char *buf,
                                   size_t len)
     ATTRIBUTE_NONNULL(1) G_GNUC_WARN_UNUSED_RESULT;
+char *virNetMessageReservePayloadRaw(virNetMessage *msg,
+                                     size_t len)
+    ATTRIBUTE_NONNULL(1) G_GNUC_WARN_UNUSED_RESULT;
+int virNetMessageCommitPayloadRaw(virNetMessage *msg,
+                                  size_t len)
+    ATTRIBUTE_NONNULL(1) G_GNUC_WARN_UNUSED_RESULT;
 
 void virNetMessageSaveError(struct virNetMessageError *rerr)
     ATTRIBUTE_NONNULL(1);
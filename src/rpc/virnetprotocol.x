@@ -37,6 +37,12 @@ const VIR_NET_MESSAGE_INITIAL = 65536;
  */
 const VIR_NET_MESSAGE_LEGACY_PAYLOAD_MAX = 262120;
 
+/*
+ * Maximum payload size of a stream data packet once both
+ * sides have agreed upon VIR_DRV_FEATURE_REMOTE_STREAM_LARGE_PAYLOAD.
+ */
+const VIR_NET_MESSAGE_STREAM_PAYLOAD_MAX = 4194304;
+
 /* Maximum total message size (serialised). */
 const VIR_NET_MESSAGE_MAX = 33554432;
 
@@ -149,6 +155,16 @@ const VIR_NET_MESSAGE_NUM_FDS_MAX = 32;
  *     * status == VIR_NET_OK
  *          <empty>
  *
+ *  - type == VIR_NET_CALL_COMPRESSED, VIR_NET_REPLY_COMPRESSED or
+ *    VIR_NET_MESSAGE_COMPRESSED
+ *          uint32 - length of the uncompressed payload
+ *          byte[]   raw deflate stream of the payload of the
+ *                   corresponding VIR_NET_CALL, VIR_NET_REPLY or
+ *                   VIR_NET_MESSAGE type
+ *
+ *    These types are only ever sent to a peer which negotiated
+ *    VIR_DRV_FEATURE_REMOTE_COMPRESSION.
+ *
  */
 enum virNetMessageType {
     /* client -> server. args from a method call */
@@ -164,7 +180,13 @@ enum virNetMessageType {
     /* server -> client. reply/error from a method call, with passed FDs */
     VIR_NET_REPLY_WITH_FDS = 5,
     /* either direction, stream hole data packet */
-    VIR_NET_STREAM_HOLE = 6
+    VIR_NET_STREAM_HOLE = 6,
+    /* client -> server. compressed VIR_NET_CALL */
+    VIR_NET_CALL_COMPRESSED = 7,
+    /* server -> client. compressed VIR_NET_REPLY */
+    VIR_NET_REPLY_COMPRESSED = 8,
+    /* either direction. compressed VIR_NET_MESSAGE */
+    VIR_NET_MESSAGE_COMPRESSED = 9
 };
 
 enum virNetMessageStatus {
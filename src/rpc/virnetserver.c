@@ -21,24 +21,42 @@
 
 #include <config.h>
 
-#include "virnetserver.h"
+#define LIBVIRT_VIRNETSERVERPRIV_H_ALLOW
+
+#include "virnetserverpriv.h"
 #include "virlog.h"
 #include "viralloc.h"
 #include "virerror.h"
 #include "virthread.h"
 #include "virthreadpool.h"
 #include "virutil.h"
+#include "vireventthread.h"
 
 #define VIR_FROM_THIS VIR_FROM_RPC
 
 VIR_LOG_INIT("rpc.netserver");
 
 
-typedef struct _virNetServerJob virNetServerJob;
-struct _virNetServerJob {
-    virNetServerClient *client;
-    virNetMessage *msg;
-    virNetServerProgram *prog;
+/* Jobs of a single client waiting for the fair scheduler */
+typedef struct _virNetServerFairQueue virNetServerFairQueue;
+struct _virNetServerFairQueue {
+    virNetServerClient *client; /* Kept alive by the queued jobs */
+    unsigned int weight;        /* Jobs served per round */
+    unsigned int deficit;       /* Jobs left to serve in the current round */
+    size_t njobs;
+    virNetServerJob *head;
+    virNetServerJob *tail;
+};
+
+/* Interval of the timer used to measure latency of client I/O loops */
+#define VIR_NET_SERVER_IO_LOOP_TICK 1000
+
+typedef struct _virNetServerIOLoop virNetServerIOLoop;
+struct _virNetServerIOLoop {
+    virEventThread *thread;
+    GSource *ticker;
+    gint64 lastTick;    /* only accessed from @thread once running */
+    int latency;        /* in milliseconds, accessed atomically */
 };
 
 struct _virNetServer {
@@ -49,6 +67,22 @@ struct _virNetServer {
     /* Immutable pointer, self-locking APIs */
     virThreadPool *workers;
 
+    /* Deficit round robin across per-client queues. When enabled, every
+     * job queued here is represented by an empty job in @workers, which
+     * dispatches whichever job is due at the time a worker picks it up.
+     * High priority jobs always bypass these queues. */
+    bool fairScheduling;
+    unsigned int fairWeightReadonly;
+    unsigned int fairWeightReadWrite;
+    size_t nfairQueues;
+    virNetServerFairQueue **fairQueues; /* Queues with jobs in round order */
+    size_t fairCurrent;                 /* Queue being served */
+
+    /* Dedicated event loops doing client socket I/O, if any */
+    size_t nioLoops;
+    virNetServerIOLoop **ioLoops;
+    size_t nextIOLoop;
+
     size_t nservices;
     virNetServerService **services;
 
@@ -142,6 +176,102 @@ virNetServerProcessMsg(virNetServer *srv,
 }
 
 
+static void
+virNetServerJobFree(virNetServerJob *job)
+{
+    virObjectUnref(job->prog);
+    virNetMessageFree(job->msg);
+    virObjectUnref(job->client);
+    g_free(job);
+}
+
+
+/*
+ * Appends @job to the queue of its client. If the client has no jobs
+ * waiting yet, a new queue serving @weight jobs per round is created.
+ * The client is only used to tell the queues apart.
+ */
+void
+virNetServerFairEnqueueLocked(virNetServer *srv,
+                              virNetServerJob *job,
+                              unsigned int weight)
+{
+    virNetServerFairQueue *queue = NULL;
+    size_t i;
+
+    for (i = 0; i < srv->nfairQueues; i++) {
+        if (srv->fairQueues[i]->client == job->client) {
+            queue = srv->fairQueues[i];
+            break;
+        }
+    }
+
+    if (!queue) {
+        virNetServerFairQueue *newqueue = g_new0(virNetServerFairQueue, 1);
+
+        newqueue->client = job->client;
+        newqueue->weight = weight;
+
+        queue = newqueue;
+
+        /* Join the round right before the queue being served so that
+         * the new client has to wait for everyone else's turn */
+        ignore_value(VIR_INSERT_ELEMENT(srv->fairQueues, srv->fairCurrent,
+                                        srv->nfairQueues, newqueue));
+        srv->fairCurrent = (srv->fairCurrent + 1) % srv->nfairQueues;
+    }
+
+    if (queue->tail)
+        queue->tail->next = job;
+    else
+        queue->head = job;
+    queue->tail = job;
+    queue->njobs++;
+}
+
+
+/*
+ * Picks the job to run next from the per-client queues. Each queue
+ * is served up to its weight in jobs before moving on to the next
+ * one, so busy clients can't starve those issuing the odd call.
+ */
+virNetServerJob *
+virNetServerFairDequeueLocked(virNetServer *srv)
+{
+    virNetServerFairQueue *queue;
+    virNetServerJob *job;
+
+    if (srv->nfairQueues == 0)
+        return NULL;
+
+    queue = srv->fairQueues[srv->fairCurrent];
+
+    /* Starting a new turn of this queue */
+    if (queue->deficit == 0)
+        queue->deficit = queue->weight;
+
+    job = queue->head;
+    queue->head = job->next;
+    if (!queue->head)
+        queue->tail = NULL;
+    job->next = NULL;
+    queue->njobs--;
+    queue->deficit--;
+
+    if (queue->njobs == 0) {
+        VIR_DELETE_ELEMENT(srv->fairQueues, srv->fairCurrent, srv->nfairQueues);
+        g_free(queue);
+    } else if (queue->deficit == 0) {
+        srv->fairCurrent++;
+    }
+
+    if (srv->fairCurrent >= srv->nfairQueues)
+        srv->fairCurrent = 0;
+
+    return job;
+}
+
+
 static void
 virNetServerHandleJob(void *jobOpaque,
                       void *opaque)
@@ -149,6 +279,15 @@ virNetServerHandleJob(void *jobOpaque,
     virNetServer *srv = opaque;
     virNetServerJob *job = jobOpaque;
 
+    /* An empty job stands for the next one due in the fair queues */
+    if (!job) {
+        VIR_WITH_OBJECT_LOCK_GUARD(srv) {
+            job = virNetServerFairDequeueLocked(srv);
+        }
+        if (!job)
+            return;
+    }
+
     VIR_DEBUG("server=%p client=%p message=%p prog=%p",
               srv, job->client, job->msg, job->prog);
 
@@ -224,7 +363,25 @@ virNetServerDispatchNewMessage(virNetServerClient *client,
             priority = virNetServerProgramGetPriority(prog, msg->header.proc);
         }
 
-        if (virThreadPoolSendJob(srv->workers, priority, job) < 0) {
+        VIR_WITH_OBJECT_LOCK_GUARD(srv) {
+            if (srv->fairScheduling && !priority) {
+                /* @srv is locked, so the worker can't look for the job
+                 * before it's queued */
+                unsigned int weight = srv->fairWeightReadWrite;
+
+                if (virNetServerClientGetReadonly(client))
+                    weight = srv->fairWeightReadonly;
+
+                if (virThreadPoolSendJob(srv->workers, 0, NULL) == 0) {
+                    virNetServerFairEnqueueLocked(srv, g_steal_pointer(&job),
+                                                  weight);
+                }
+            } else if (virThreadPoolSendJob(srv->workers, priority, job) == 0) {
+                job = NULL;
+            }
+        }
+
+        if (job) {
             virObjectUnref(client);
             VIR_FREE(job);
             virObjectUnref(prog);
@@ -295,11 +452,137 @@ virNetServerCheckLimits(virNetServer *srv)
 }
 
 
+static gboolean
+virNetServerIOLoopTick(gpointer opaque)
+{
+    virNetServerIOLoop *loop = opaque;
+    gint64 now = g_get_monotonic_time();
+    gint64 late = now - loop->lastTick - VIR_NET_SERVER_IO_LOOP_TICK * 1000;
+
+    g_atomic_int_set(&loop->latency, MAX(late, 0) / 1000);
+    loop->lastTick = now;
+
+    return G_SOURCE_CONTINUE;
+}
+
+
+static void
+virNetServerIOLoopFree(virNetServerIOLoop *loop)
+{
+    g_autoptr(GMainContext) context = NULL;
+
+    if (!loop)
+        return;
+
+    if (loop->ticker) {
+        g_source_destroy(loop->ticker);
+        g_source_unref(loop->ticker);
+    }
+
+    context = g_main_context_ref(virEventThreadGetContext(loop->thread));
+
+    /* Stops the thread and waits for it to finish */
+    g_clear_object(&loop->thread);
+
+    /* Handles and timers registered with the loop are freed from idle
+     * callbacks dispatched by the loop. Run those the thread didn't get
+     * to before it stopped, otherwise they would be leaked. */
+    while (g_main_context_pending(context))
+        g_main_context_iteration(context, FALSE);
+
+    g_free(loop);
+}
+
+
+static virNetServerIOLoop *
+virNetServerIOLoopNew(const char *name)
+{
+    virNetServerIOLoop *loop = g_new0(virNetServerIOLoop, 1);
+
+    if (!(loop->thread = virEventThreadNew(name))) {
+        g_free(loop);
+        return NULL;
+    }
+
+    loop->lastTick = g_get_monotonic_time();
+    loop->ticker = g_timeout_source_new(VIR_NET_SERVER_IO_LOOP_TICK);
+    g_source_set_callback(loop->ticker, virNetServerIOLoopTick, loop, NULL);
+    g_source_attach(loop->ticker, virEventThreadGetContext(loop->thread));
+
+    return loop;
+}
+
+
+/*
+ * Fills @load with the number of clients handled by each of the
+ * I/O loops of @srv.
+ */
+static void
+virNetServerIOLoopGetLoadLocked(virNetServer *srv,
+                                size_t *load)
+{
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < srv->nclients; i++) {
+        GMainContext *context = virNetServerClientGetEventContext(srv->clients[i]);
+
+        if (!context)
+            continue;
+
+        for (j = 0; j < srv->nioLoops; j++) {
+            if (virEventThreadGetContext(srv->ioLoops[j]->thread) == context) {
+                load[j]++;
+                break;
+            }
+        }
+    }
+}
+
+
+/*
+ * Picks the I/O loop handling the fewest clients, breaking ties in
+ * a round-robin fashion. Returns NULL if @srv handles all client I/O
+ * in the default event loop.
+ */
+static virNetServerIOLoop *
+virNetServerIOLoopPickLocked(virNetServer *srv)
+{
+    g_autofree size_t *load = NULL;
+    size_t best;
+    size_t i;
+
+    if (srv->nioLoops == 0)
+        return NULL;
+
+    load = g_new0(size_t, srv->nioLoops);
+    virNetServerIOLoopGetLoadLocked(srv, load);
+
+    best = srv->nextIOLoop % srv->nioLoops;
+    for (i = 1; i < srv->nioLoops; i++) {
+        size_t j = (srv->nextIOLoop + i) % srv->nioLoops;
+
+        if (load[j] < load[best])
+            best = j;
+    }
+
+    srv->nextIOLoop = best + 1;
+
+    return srv->ioLoops[best];
+}
+
+
 int
 virNetServerAddClient(virNetServer *srv,
                       virNetServerClient *client)
 {
     VIR_LOCK_GUARD lock = virObjectLockGuard(srv);
+    virNetServerIOLoop *loop;
+
+    if ((loop = virNetServerIOLoopPickLocked(srv)) &&
+        virNetServerClientSetEventContext(client,
+                                          virEventThreadGetContext(loop->thread)) < 0)
+        return -1;
 
     if (virNetServerClientInit(client) < 0)
         return -1;
@@ -386,6 +669,9 @@ virNetServerNew(const char *name,
 
     srv->name = g_strdup(name);
 
+    srv->fairWeightReadonly = 1;
+    srv->fairWeightReadWrite = 1;
+
     srv->next_client_id = next_client_id;
     srv->nclients_max = max_clients;
     srv->nclients_unauth_max = max_anonymous_clients;
@@ -876,6 +1162,23 @@ virNetServerDispose(void *obj)
     for (i = 0; i < srv->nclients; i++)
         virObjectUnref(srv->clients[i]);
     g_free(srv->clients);
+
+    for (i = 0; i < srv->nioLoops; i++)
+        virNetServerIOLoopFree(srv->ioLoops[i]);
+    g_free(srv->ioLoops);
+
+    for (i = 0; i < srv->nfairQueues; i++) {
+        virNetServerFairQueue *queue = srv->fairQueues[i];
+
+        while (queue->head) {
+            virNetServerJob *job = queue->head;
+
+            queue->head = job->next;
+            virNetServerJobFree(job);
+        }
+        g_free(queue);
+    }
+    g_free(srv->fairQueues);
 }
 
 
@@ -999,6 +1302,169 @@ virNetServerGetThreadPoolParameters(virNetServer *srv,
 }
 
 
+/**
+ * virNetServerSetIOLoops:
+ * @srv: server object
+ * @nloops: number of event loops
+ *
+ * Starts @nloops dedicated event loop threads and makes clients connecting
+ * from now on do their socket I/O, including TLS and message framing, in one
+ * of them rather than in the default event loop. New clients are assigned to
+ * the loop handling the fewest clients. This can only be done once.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virNetServerSetIOLoops(virNetServer *srv,
+                       size_t nloops)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(srv);
+    size_t i;
+
+    if (srv->nioLoops > 0) {
+        virReportError(VIR_ERR_OPERATION_INVALID, "%s",
+                       _("I/O loops of the server are already running"));
+        return -1;
+    }
+
+    if (nloops == 0)
+        return 0;
+
+    if (nloops > VIR_NET_SERVER_IO_LOOPS_MAX) {
+        virReportError(VIR_ERR_CONFIG_UNSUPPORTED,
+                       _("number of I/O loops %zu exceeds maximum %d"),
+                       nloops, VIR_NET_SERVER_IO_LOOPS_MAX);
+        return -1;
+    }
+
+    srv->ioLoops = g_new0(virNetServerIOLoop *, nloops);
+
+    for (i = 0; i < nloops; i++) {
+        g_autofree char *name = g_strdup_printf("rpc-io-%zu", i);
+
+        if (!(srv->ioLoops[i] = virNetServerIOLoopNew(name)))
+            goto error;
+        srv->nioLoops++;
+    }
+
+    return 0;
+
+ error:
+    for (i = 0; i < srv->nioLoops; i++)
+        virNetServerIOLoopFree(srv->ioLoops[i]);
+    g_clear_pointer(&srv->ioLoops, g_free);
+    srv->nioLoops = 0;
+    return -1;
+}
+
+
+/**
+ * virNetServerGetIOLoopStats:
+ * @srv: server object
+ * @clients: filled with the number of clients handled by each loop
+ * @latency: filled with the latency of each loop in milliseconds
+ *
+ * Returns the number of dedicated I/O loops of @srv. Unless it's zero
+ * @clients and @latency are allocated and must be freed by the caller.
+ */
+size_t
+virNetServerGetIOLoopStats(virNetServer *srv,
+                           size_t **clients,
+                           unsigned int **latency)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(srv);
+    size_t i;
+
+    *clients = NULL;
+    *latency = NULL;
+
+    if (srv->nioLoops == 0)
+        return 0;
+
+    *clients = g_new0(size_t, srv->nioLoops);
+    *latency = g_new0(unsigned int, srv->nioLoops);
+
+    virNetServerIOLoopGetLoadLocked(srv, *clients);
+
+    for (i = 0; i < srv->nioLoops; i++)
+        (*latency)[i] = g_atomic_int_get(&srv->ioLoops[i]->latency);
+
+    return srv->nioLoops;
+}
+
+
+/**
+ * virNetServerGetSchedulerParameters:
+ * @srv: server object
+ * @fair: whether fair scheduling of jobs is enabled
+ * @weightReadonly: jobs of a read-only client served per round
+ * @weightReadWrite: jobs of a read-write client served per round
+ * @nqueues: number of clients with jobs waiting in fair queues
+ * @queueDepthMax: number of jobs in the longest fair queue
+ */
+void
+virNetServerGetSchedulerParameters(virNetServer *srv,
+                                   bool *fair,
+                                   unsigned int *weightReadonly,
+                                   unsigned int *weightReadWrite,
+                                   size_t *nqueues,
+                                   size_t *queueDepthMax)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(srv);
+    size_t i;
+
+    *fair = srv->fairScheduling;
+    *weightReadonly = srv->fairWeightReadonly;
+    *weightReadWrite = srv->fairWeightReadWrite;
+    *nqueues = srv->nfairQueues;
+    *queueDepthMax = 0;
+
+    for (i = 0; i < srv->nfairQueues; i++)
+        *queueDepthMax = MAX(*queueDepthMax, srv->fairQueues[i]->njobs);
+}
+
+
+/**
+ * virNetServerSetSchedulerParameters:
+ * @srv: server object
+ * @fair: 1 to enable fair scheduling of jobs, 0 to disable, -1 to keep
+ * @weightReadonly: jobs of a read-only client served per round, -1 to keep
+ * @weightReadWrite: jobs of a read-write client served per round, -1 to keep
+ *
+ * With fair scheduling enabled, calls of each client are queued separately
+ * and the queues are served in deficit round robin fashion, running up to
+ * the client's weight of calls in a row. New weights apply to clients
+ * without calls waiting at the time. Disabling fair scheduling doesn't
+ * affect calls which are already queued.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virNetServerSetSchedulerParameters(virNetServer *srv,
+                                   int fair,
+                                   long long int weightReadonly,
+                                   long long int weightReadWrite)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(srv);
+
+    if (weightReadonly == 0 || weightReadWrite == 0 ||
+        weightReadonly > UINT_MAX || weightReadWrite > UINT_MAX) {
+        virReportError(VIR_ERR_INVALID_ARG, "%s",
+                       _("scheduler weights must be greater than 0"));
+        return -1;
+    }
+
+    if (fair >= 0)
+        srv->fairScheduling = !!fair;
+    if (weightReadonly > 0)
+        srv->fairWeightReadonly = weightReadonly;
+    if (weightReadWrite > 0)
+        srv->fairWeightReadWrite = weightReadWrite;
+
+    return 0;
+}
+
+
 int
 virNetServerSetThreadPoolParameters(virNetServer *srv,
                                     long long int minWorkers,
@@ -114,6 +114,30 @@ int virNetServerSetThreadPoolParameters(virNetServer *srv,
                                         long long int maxWorkers,
                                         long long int prioWorkers);
 
+/* Upper limit of dedicated client I/O loops, which keeps their statistics,
+ * reported as a group of their own, within the size limit of the admin
+ * protocol's threadpool parameters */
+#define VIR_NET_SERVER_IO_LOOPS_MAX 12
+
+void virNetServerGetSchedulerParameters(virNetServer *srv,
+                                        bool *fair,
+                                        unsigned int *weightReadonly,
+                                        unsigned int *weightReadWrite,
+                                        size_t *nqueues,
+                                        size_t *queueDepthMax);
+
+int virNetServerSetSchedulerParameters(virNetServer *srv,
+                                       int fair,
+                                       long long int weightReadonly,
+                                       long long int weightReadWrite);
+
+int virNetServerSetIOLoops(virNetServer *srv,
+                           size_t nloops);
+
+size_t virNetServerGetIOLoopStats(virNetServer *srv,
+                                  size_t **clients,
+                                  unsigned int **latency);
+
 unsigned long long virNetServerNextClientID(virNetServer *srv);
 
 virNetServerClient *virNetServerGetClient(virNetServer *srv,
@@ -36,6 +36,7 @@
 #include "virkeepalive.h"
 #include "virprobe.h"
 #include "virutil.h"
+#include "vireventglib.h"
 
 #define VIR_FROM_THIS VIR_FROM_RPC
 
@@ -75,6 +76,8 @@ struct _virNetServerClient
 #endif
     int sockTimer; /* Timer to be fired upon cached data,
                     * so we jump out from poll() immediately */
+    GMainContext *eventContext; /* Event loop handling socket I/O,
+                                 * NULL for the default one */
 
 
     virIdentity *identity;
@@ -114,6 +117,11 @@ struct _virNetServerClient
     virNetServerClientCloseFunc privateDataCloseFunc;
 
     virKeepAlive *keepalive;
+
+    /* Whether the client negotiated VIR_DRV_FEATURE_REMOTE_COMPRESSION,
+     * and how many bytes compressing its messages saved so far */
+    bool compression;
+    unsigned long long compressionSaved;
 };
 
 
@@ -399,8 +407,7 @@ virNetServerClientNewInternal(unsigned long long id,
     /* Prepare one for packet receive */
     if (!(client->rx = virNetMessageNew(true)))
         goto error;
-    client->rx->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
-    client->rx->buffer = g_new0(char, client->rx->bufferLength);
+    virNetMessageResizeBuffer(client->rx, VIR_NET_MESSAGE_LEN_MAX);
     client->nrequests = 1;
 
     PROBE(RPC_SERVER_CLIENT_NEW,
@@ -465,6 +472,7 @@ virNetServerClient *virNetServerClientNewPostExecRestart(virNetServer *srv,
     virNetSocket *sock;
     int auth;
     bool readonly, auth_pending;
+    bool compression = false;
     unsigned int nrequests_max;
     unsigned long long id;
     long long timestamp;
@@ -534,6 +542,13 @@ virNetServerClient *virNetServerClientNewPostExecRestart(virNetServer *srv,
         }
     }
 
+    if (virJSONValueObjectHasKey(object, "compression") &&
+        virJSONValueObjectGetBoolean(object, "compression", &compression) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Malformed compression field in JSON state document"));
+        return NULL;
+    }
+
     if (!(sock = virNetSocketNewPostExecRestart(child))) {
         virObjectUnref(sock);
         return NULL;
@@ -552,6 +567,8 @@ virNetServerClient *virNetServerClientNewPostExecRestart(virNetServer *srv,
     }
     virObjectUnref(sock);
 
+    client->compression = compression;
+
     if (!(child = virJSONValueObjectGet(object, "privateData"))) {
         virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
                        _("Missing privateData field in JSON state document"));
@@ -596,6 +613,10 @@ virJSONValue *virNetServerClientPreExecRestart(virNetServerClient *client)
                                            client->conn_time) < 0)
         return NULL;
 
+    if (client->compression &&
+        virJSONValueObjectAppendBoolean(object, "compression", true) < 0)
+        return NULL;
+
     if (!(sock = virNetSocketPreExecRestart(client->sock)))
         return NULL;
 
@@ -941,6 +962,8 @@ void virNetServerClientDispose(void *obj)
 #endif
     if (client->sockTimer > 0)
         virEventRemoveTimeout(client->sockTimer);
+    if (client->eventContext)
+        g_main_context_unref(client->eventContext);
     virObjectUnref(client->tls);
     virObjectUnref(client->tlsCtxt);
     virObjectUnref(client->sock);
@@ -1050,6 +1073,62 @@ virNetServerClientWantCloseLocked(virNetServerClient *client)
 }
 
 
+/**
+ * virNetServerClientSetEventContext:
+ * @client: a client object not yet initialized by virNetServerClientInit
+ * @context: event loop context to handle the client's socket I/O in
+ *
+ * Moves reading, decoding and writing of messages of @client from the
+ * default event loop to the thread iterating @context.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virNetServerClientSetEventContext(virNetServerClient *client,
+                                  GMainContext *context)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(client);
+    int timer;
+
+    if (!client->sock) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("client socket is already closed"));
+        return -1;
+    }
+
+    if (virNetSocketSetEventContext(client->sock, context) < 0)
+        return -1;
+
+    if ((timer = virEventGLibTimeoutAddContext(context, -1,
+                                               virNetServerClientSockTimerFunc,
+                                               client, NULL)) < 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Unable to register client socket timer"));
+        virNetSocketSetEventContext(client->sock, NULL);
+        return -1;
+    }
+
+    if (client->sockTimer > 0)
+        virEventRemoveTimeout(client->sockTimer);
+    client->sockTimer = timer;
+
+    if (client->eventContext)
+        g_main_context_unref(client->eventContext);
+    client->eventContext = g_main_context_ref(context);
+
+    return 0;
+}
+
+
+GMainContext *
+virNetServerClientGetEventContext(virNetServerClient *client)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(client);
+
+    return client->eventContext;
+}
+
+
 int virNetServerClientInit(virNetServerClient *client)
 {
     VIR_LOCK_GUARD lock = virObjectLockGuard(client);
@@ -1125,6 +1204,7 @@ static ssize_t virNetServerClientRead(virNetServerClient *client)
         return ret;
 
     client->rx->bufferOffset += ret;
+    virKeepAliveTouch(client->keepalive);
     return ret;
 }
 
@@ -1172,7 +1252,8 @@ static virNetMessage *virNetServerClientDispatchRead(virNetServerClient *client)
         size_t i;
 
         /* Decode the header so we can use it for routing decisions */
-        if (virNetMessageDecodeHeader(msg) < 0) {
+        if (virNetMessageDecodeHeader(msg) < 0 ||
+            virNetMessageDecompress(msg, client->compression) < 0) {
             virNetMessageQueueServe(&client->rx);
             virNetMessageFree(msg);
             client->wantClose = true;
@@ -1255,8 +1336,7 @@ static virNetMessage *virNetServerClientDispatchRead(virNetServerClient *client)
             if (!(client->rx = virNetMessageNew(true))) {
                 client->wantClose = true;
             } else {
-                client->rx->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
-                client->rx->buffer = g_new0(char, client->rx->bufferLength);
+                virNetMessageResizeBuffer(client->rx, VIR_NET_MESSAGE_LEN_MAX);
                 client->nrequests++;
             }
         }
@@ -1355,8 +1435,7 @@ virNetServerClientDispatchWrite(virNetServerClient *client)
                     client->nrequests < client->nrequests_max) {
                     /* Ready to recv more messages */
                     virNetMessageClear(msg);
-                    msg->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
-                    msg->buffer = g_new0(char, msg->bufferLength);
+                    virNetMessageResizeBuffer(msg, VIR_NET_MESSAGE_LEN_MAX);
                     client->rx = g_steal_pointer(&msg);
                     client->nrequests++;
                 }
@@ -1463,10 +1542,51 @@ virNetServerClientSendMessageLocked(virNetServerClient *client,
 
 int virNetServerClientSendMessage(virNetServerClient *client,
                                   virNetMessage *msg)
+{
+    bool compress;
+    size_t saved = 0;
+    int ret;
+
+    VIR_WITH_OBJECT_LOCK_GUARD(client) {
+        compress = client->compression;
+    }
+
+    /* Compressing large replies takes a while, don't hold the
+     * lock which the event loop needs meanwhile */
+    if (compress)
+        saved = virNetMessageCompress(msg);
+
+    virObjectLock(client);
+    client->compressionSaved += saved;
+    ret = virNetServerClientSendMessageLocked(client, msg);
+    virObjectUnlock(client);
+
+    return ret;
+}
+
+
+void
+virNetServerClientSetCompression(virNetServerClient *client,
+                                 bool compression)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(client);
+
+    client->compression = compression;
+}
+
+
+/*
+ * Returns whether messages sent to @client are compressed and stores
+ * the number of bytes compression saved so far into @saved.
+ */
+bool
+virNetServerClientGetCompression(virNetServerClient *client,
+                                 unsigned long long *saved)
 {
     VIR_LOCK_GUARD lock = virObjectLockGuard(client);
 
-    return virNetServerClientSendMessageLocked(client, msg);
+    *saved = client->compressionSaved;
+    return client->compression;
 }
 
 
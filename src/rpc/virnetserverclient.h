@@ -147,6 +147,10 @@ void virNetServerClientDelayedClose(virNetServerClient *client);
 void virNetServerClientImmediateClose(virNetServerClient *client);
 bool virNetServerClientWantCloseLocked(virNetServerClient *client);
 
+int virNetServerClientSetEventContext(virNetServerClient *client,
+                                      GMainContext *context);
+GMainContext *virNetServerClientGetEventContext(virNetServerClient *client);
+
 int virNetServerClientInit(virNetServerClient *client);
 
 int virNetServerClientInitKeepAlive(virNetServerClient *client,
@@ -163,6 +167,11 @@ const char *virNetServerClientRemoteAddrStringURI(virNetServerClient *client);
 int virNetServerClientSendMessage(virNetServerClient *client,
                                   virNetMessage *msg);
 
+void virNetServerClientSetCompression(virNetServerClient *client,
+                                      bool compression);
+bool virNetServerClientGetCompression(virNetServerClient *client,
+                                      unsigned long long *saved);
+
 bool virNetServerClientIsAuthenticated(virNetServerClient *client);
 bool virNetServerClientIsAuthPendingLocked(virNetServerClient *client);
 void virNetServerClientSetAuthPendingLocked(virNetServerClient *client, bool auth_pending);
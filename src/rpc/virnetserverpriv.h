@@ -0,0 +1,42 @@
+/*
+ * virnetserverpriv.h: Functions for testing virNetServer scheduling
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBVIRT_VIRNETSERVERPRIV_H_ALLOW
+# error "virnetserverpriv.h may only be included by virnetserver.c or test suites"
+#endif /* LIBVIRT_VIRNETSERVERPRIV_H_ALLOW */
+
+#pragma once
+
+#include "virnetserver.h"
+
+typedef struct _virNetServerJob virNetServerJob;
+struct _virNetServerJob {
+    virNetServerClient *client;
+    virNetMessage *msg;
+    virNetServerProgram *prog;
+
+    virNetServerJob *next;
+};
+
+void
+virNetServerFairEnqueueLocked(virNetServer *srv,
+                              virNetServerJob *job,
+                              unsigned int weight);
+
+virNetServerJob *
+virNetServerFairDequeueLocked(virNetServer *srv);
@@ -527,6 +527,59 @@ int virNetServerProgramSendStreamData(virNetServerProgram *prog,
 }
 
 
+/**
+ * virNetServerProgramPrepareStreamData:
+ * @prog: the program the stream belongs to
+ * @msg: message to prepare
+ * @procedure: procedure of the stream
+ * @serial: serial of the stream
+ * @len: maximum amount of data to be sent
+ *
+ * Prepares @msg for sending up to @len bytes of stream data and returns a
+ * pointer to the message buffer where the data is supposed to be stored,
+ * e.g. by reading them directly from the stream. The message is then sent
+ * using virNetServerProgramSendPreparedStreamData. This saves copying the
+ * data compared to virNetServerProgramSendStreamData.
+ *
+ * Returns pointer to @len bytes of space for the data, NULL on error.
+ */
+char *virNetServerProgramPrepareStreamData(virNetServerProgram *prog,
+                                           virNetMessage *msg,
+                                           int procedure,
+                                           unsigned int serial,
+                                           size_t len)
+{
+    VIR_DEBUG("msg=%p len=%zu", msg, len);
+
+    msg->header.prog = prog->program;
+    msg->header.vers = prog->version;
+    msg->header.proc = procedure;
+    msg->header.type = VIR_NET_STREAM;
+    msg->header.serial = serial;
+    msg->header.status = VIR_NET_CONTINUE;
+
+    if (virNetMessageEncodeHeader(msg) < 0)
+        return NULL;
+
+    return virNetMessageReservePayloadRaw(msg, len);
+}
+
+
+int virNetServerProgramSendPreparedStreamData(virNetServerClient *client,
+                                              virNetMessage *msg,
+                                              size_t len)
+{
+    VIR_DEBUG("client=%p msg=%p len=%zu", client, msg, len);
+
+    if (virNetMessageCommitPayloadRaw(msg, len) < 0)
+        return -1;
+
+    VIR_DEBUG("Total %zu", msg->bufferLength);
+
+    return virNetServerClientSendMessage(client, msg);
+}
+
+
 int virNetServerProgramSendStreamHole(virNetServerProgram *prog,
                                       virNetServerClient *client,
                                       virNetMessage *msg,
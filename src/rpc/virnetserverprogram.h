@@ -93,6 +93,16 @@ int virNetServerProgramSendStreamData(virNetServerProgram *prog,
                                       const char *data,
                                       size_t len);
 
+char *virNetServerProgramPrepareStreamData(virNetServerProgram *prog,
+                                           virNetMessage *msg,
+                                           int procedure,
+                                           unsigned int serial,
+                                           size_t len);
+
+int virNetServerProgramSendPreparedStreamData(virNetServerClient *client,
+                                              virNetMessage *msg,
+                                              size_t len);
+
 int virNetServerProgramSendStreamHole(virNetServerProgram *prog,
                                       virNetServerClient *client,
                                       virNetMessage *msg,
@@ -48,6 +48,7 @@
 #include "virprobe.h"
 #include "virprocess.h"
 #include "virstring.h"
+#include "vireventglib.h"
 
 #if WITH_SSH2
 # include "virnetsshsession.h"
@@ -74,6 +75,7 @@ struct _virNetSocket {
     bool unlinkUNIX;
 
     /* Event callback fields */
+    GMainContext *eventContext;
     virNetSocketIOFunc func;
     void *opaque;
     virFreeCallback ff;
@@ -1333,6 +1335,9 @@ void virNetSocketDispose(void *obj)
     g_free(sock->localAddrStrSASL);
     g_free(sock->remoteAddrStrSASL);
     g_free(sock->remoteAddrStrURI);
+
+    if (sock->eventContext)
+        g_main_context_unref(sock->eventContext);
 }
 
 
@@ -1645,6 +1650,7 @@ void virNetSocketSetTLSSession(virNetSocket *sock,
                                    virNetSocketTLSSessionWrite,
                                    virNetSocketTLSSessionRead,
                                    sock);
+    virNetTLSSessionSetFD(sess, sock->fd);
     virObjectUnlock(sock);
 }
 
@@ -2151,6 +2157,36 @@ static void virNetSocketEventFree(void *opaque)
         ff(eopaque);
 }
 
+/**
+ * virNetSocketSetEventContext:
+ * @sock: socket object
+ * @context: GMainContext to dispatch I/O callbacks from
+ *
+ * Make the I/O callback registered by a subsequent call to
+ * virNetSocketAddIOCallback() run from the thread iterating
+ * @context instead of the default event loop.
+ *
+ * Returns 0 on success, -1 if a callback is already registered
+ */
+int virNetSocketSetEventContext(virNetSocket *sock,
+                                GMainContext *context)
+{
+    VIR_LOCK_GUARD lock = virObjectLockGuard(sock);
+
+    if (sock->watch >= 0) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("Cannot change event context of a watched socket"));
+        return -1;
+    }
+
+    if (sock->eventContext)
+        g_main_context_unref(sock->eventContext);
+    sock->eventContext = context ? g_main_context_ref(context) : NULL;
+
+    return 0;
+}
+
+
 int virNetSocketAddIOCallback(virNetSocket *sock,
                               int events,
                               virNetSocketIOFunc func,
@@ -2166,11 +2202,21 @@ int virNetSocketAddIOCallback(virNetSocket *sock,
         goto cleanup;
     }
 
-    if ((sock->watch = virEventAddHandle(sock->fd,
-                                         events,
-                                         virNetSocketEventHandle,
-                                         sock,
-                                         virNetSocketEventFree)) < 0) {
+    if (sock->eventContext)
+        sock->watch = virEventGLibHandleAddContext(sock->eventContext,
+                                                   sock->fd,
+                                                   events,
+                                                   virNetSocketEventHandle,
+                                                   sock,
+                                                   virNetSocketEventFree);
+    else
+        sock->watch = virEventAddHandle(sock->fd,
+                                        events,
+                                        virNetSocketEventHandle,
+                                        sock,
+                                        virNetSocketEventFree);
+
+    if (sock->watch < 0) {
         VIR_DEBUG("Failed to register watch on socket %p", sock);
         goto cleanup;
     }
@@ -166,6 +166,9 @@ int virNetSocketListen(virNetSocket *sock, int backlog);
 int virNetSocketAccept(virNetSocket *sock,
                        virNetSocket **clientsock);
 
+int virNetSocketSetEventContext(virNetSocket *sock,
+                                GMainContext *context);
+
 int virNetSocketAddIOCallback(virNetSocket *sock,
                               int events,
                               virNetSocketIOFunc func,
@@ -25,6 +25,9 @@
 #include <gnutls/gnutls.h>
 #include <gnutls/crypto.h>
 #include <gnutls/x509.h>
+#if GNUTLS_VERSION_NUMBER >= 0x030703
+# include <gnutls/socket.h>
+#endif
 
 #include "virnettlscontext.h"
 #include "virstring.h"
@@ -46,6 +49,10 @@
 #define LIBVIRT_SERVERKEY LIBVIRT_PKI_DIR "/libvirt/private/serverkey.pem"
 #define LIBVIRT_SERVERCERT LIBVIRT_PKI_DIR "/libvirt/servercert.pem"
 
+/* Upper bound on the number of servers whose session resumption
+ * data is remembered by clients. */
+#define VIR_NET_TLS_RESUME_CACHE_MAX 64
+
 #define VIR_FROM_THIS VIR_FROM_RPC
 
 VIR_LOG_INIT("rpc.nettlscontext");
@@ -59,6 +66,14 @@ struct _virNetTLSContext {
     bool requireValidCert;
     const char *const *x509dnACL;
     char *priority;
+
+    /* Key used by servers to encrypt session tickets. Empty if
+     * session tickets are disabled. */
+    gnutls_datum_t ticketKey;
+    /* Identifies the credentials of a client context in the
+     * resumption cache. */
+    char *resumeID;
+    bool ktls;
 };
 
 struct _virNetTLSSession {
@@ -73,6 +88,11 @@ struct _virNetTLSSession {
     virNetTLSSessionReadFunc readFunc;
     void *opaque;
     char *x509dname;
+
+    bool ktls;
+    /* Key of the resumption cache entry, clients only */
+    char *resumeKey;
+    bool resumeSaved;
 };
 
 static virClass *virNetTLSContextClass;
@@ -80,6 +100,12 @@ static virClass *virNetTLSSessionClass;
 static void virNetTLSContextDispose(void *obj);
 static void virNetTLSSessionDispose(void *obj);
 
+/* Session resumption data received by clients, keyed by server
+ * hostname and client credentials. Shared by all client contexts,
+ * since a new context is created for every connection. */
+static virMutex virNetTLSResumeLock = VIR_MUTEX_INITIALIZER;
+static GHashTable *virNetTLSResumeCache;
+
 
 static int virNetTLSContextOnceInit(void)
 {
@@ -89,6 +115,10 @@ static int virNetTLSContextOnceInit(void)
     if (!VIR_CLASS_NEW(virNetTLSSession, virClassForObjectLockable()))
         return -1;
 
+    virNetTLSResumeCache = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                 g_free,
+                                                 (GDestroyNotify)g_bytes_unref);
+
     return 0;
 }
 
@@ -665,6 +695,37 @@ static int virNetTLSContextLoadCredentials(virNetTLSContext *ctxt,
 }
 
 
+static void
+virNetTLSContextClearTicketKey(virNetTLSContext *ctxt)
+{
+    if (!ctxt->ticketKey.data)
+        return;
+
+    gnutls_memset(ctxt->ticketKey.data, 0, ctxt->ticketKey.size);
+    gnutls_free(ctxt->ticketKey.data);
+    ctxt->ticketKey.data = NULL;
+    ctxt->ticketKey.size = 0;
+}
+
+
+static int
+virNetTLSContextGenerateTicketKey(virNetTLSContext *ctxt)
+{
+    int err;
+
+    virNetTLSContextClearTicketKey(ctxt);
+
+    if ((err = gnutls_session_ticket_key_generate(&ctxt->ticketKey)) < 0) {
+        virReportError(VIR_ERR_SYSTEM_ERROR,
+                       _("Unable to generate TLS session ticket key: %s"),
+                       gnutls_strerror(err));
+        return -1;
+    }
+
+    return 0;
+}
+
+
 static virNetTLSContext *virNetTLSContextNew(const char *cacert,
                                                const char *cacrl,
                                                const char *cert,
@@ -708,6 +769,15 @@ static virNetTLSContext *virNetTLSContextNew(const char *cacert,
     if (virNetTLSContextLoadCredentials(ctxt, isServer, cacert, cacrl, cert, key) < 0)
         goto error;
 
+    if (isServer) {
+        if (virNetTLSContextGenerateTicketKey(ctxt) < 0)
+            goto error;
+    } else {
+        ctxt->resumeID = g_strdup_printf("%s\n%s\n%s\n%s",
+                                         cacert, NULLSTR(cert), NULLSTR(key),
+                                         NULLSTR(priority));
+    }
+
     ctxt->requireValidCert = requireValidCert;
     ctxt->x509dnACL = x509dnACL;
     ctxt->isServer = isServer;
@@ -913,6 +983,12 @@ int virNetTLSContextReloadForServer(virNetTLSContext *ctxt,
     if (virNetTLSContextLoadCredentials(ctxt, true, cacert, cacrl, cert, key))
         goto error;
 
+    /* Tickets issued with the old credentials must not be usable
+     * to resume sessions any more */
+    if (ctxt->ticketKey.data &&
+        virNetTLSContextGenerateTicketKey(ctxt) < 0)
+        goto error;
+
     gnutls_certificate_free_credentials(x509credBak);
 
     return 0;
@@ -938,6 +1014,79 @@ virNetTLSContext *virNetTLSContextNewClient(const char *cacert,
 }
 
 
+/**
+ * virNetTLSContextSetSessionTickets:
+ * @ctxt: server TLS context
+ * @enable: whether to issue session tickets
+ *
+ * Session tickets allow clients to resume a previous session,
+ * skipping the certificate exchange and key agreement of a full
+ * handshake. They are enabled by default for server contexts.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int virNetTLSContextSetSessionTickets(virNetTLSContext *ctxt,
+                                      bool enable)
+{
+    int ret = -1;
+
+    virObjectLock(ctxt);
+
+    if (!ctxt->isServer) {
+        virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                       _("session tickets can only be set for a TLS server"));
+        goto cleanup;
+    }
+
+    if (enable) {
+        if (!ctxt->ticketKey.data &&
+            virNetTLSContextGenerateTicketKey(ctxt) < 0)
+            goto cleanup;
+    } else {
+        virNetTLSContextClearTicketKey(ctxt);
+    }
+
+    ret = 0;
+
+ cleanup:
+    virObjectUnlock(ctxt);
+    return ret;
+}
+
+
+/**
+ * virNetTLSContextSetKTLS:
+ * @ctxt: TLS context
+ * @enable: whether to allow kernel TLS offload
+ *
+ * Sessions created from @ctxt hand the socket to GnuTLS directly
+ * instead of going through the I/O callbacks, which lets GnuTLS
+ * offload the record layer to the kernel after the handshake, if
+ * the kernel supports it and it is enabled in the GnuTLS system
+ * configuration. The sessions must be attached to a socket with
+ * virNetTLSSessionSetFD.
+ *
+ * Returns 0 on success, -1 if kernel TLS is not supported by GnuTLS.
+ */
+int virNetTLSContextSetKTLS(virNetTLSContext *ctxt,
+                            bool enable)
+{
+#if GNUTLS_VERSION_NUMBER >= 0x030703
+    virObjectLock(ctxt);
+    ctxt->ktls = enable;
+    virObjectUnlock(ctxt);
+    return 0;
+#else
+    if (!enable)
+        return 0;
+
+    virReportError(VIR_ERR_OPERATION_UNSUPPORTED, "%s",
+                   _("kernel TLS requires GnuTLS 3.7.3 or newer"));
+    return -1;
+#endif
+}
+
+
 static int virNetTLSContextValidCertificate(virNetTLSContext *ctxt,
                                             virNetTLSSession *sess)
 {
@@ -1116,6 +1265,8 @@ void virNetTLSContextDispose(void *obj)
           "ctxt=%p", ctxt);
 
     g_free(ctxt->priority);
+    g_free(ctxt->resumeID);
+    virNetTLSContextClearTicketKey(ctxt);
     gnutls_certificate_free_credentials(ctxt->x509cred);
 }
 
@@ -1161,6 +1312,8 @@ virNetTLSSession *virNetTLSSessionNew(virNetTLSContext *ctxt,
     if (!(sess = virObjectLockableNew(virNetTLSSessionClass)))
         return NULL;
 
+    virObjectLock(ctxt);
+
     sess->hostname = g_strdup(hostname);
 
     if ((err = gnutls_init(&sess->session,
@@ -1198,16 +1351,54 @@ virNetTLSSession *virNetTLSSessionNew(virNetTLSContext *ctxt,
      */
     if (ctxt->isServer) {
         gnutls_certificate_server_set_request(sess->session, GNUTLS_CERT_REQUEST);
+
+        if (ctxt->ticketKey.data &&
+            (err = gnutls_session_ticket_enable_server(sess->session,
+                                                       &ctxt->ticketKey)) != 0) {
+            virReportError(VIR_ERR_SYSTEM_ERROR,
+                           _("Failed to enable TLS session tickets: %s"),
+                           gnutls_strerror(err));
+            goto error;
+        }
+    } else if (hostname) {
+        GBytes *data;
+
+        sess->resumeKey = g_strdup_printf("%s\n%s", ctxt->resumeID, hostname);
+
+        VIR_WITH_MUTEX_LOCK_GUARD(&virNetTLSResumeLock) {
+            if ((data = g_hash_table_lookup(virNetTLSResumeCache,
+                                            sess->resumeKey))) {
+                gsize size;
+                const void *buf = g_bytes_get_data(data, &size);
+
+                /* A stale ticket is not fatal, the server simply
+                 * falls back to a full handshake */
+                if ((err = gnutls_session_set_data(sess->session,
+                                                   buf, size)) != 0)
+                    VIR_DEBUG("Cannot use resumption data for '%s': %s",
+                              hostname, gnutls_strerror(err));
+            }
+        }
     }
 
-    gnutls_transport_set_ptr(sess->session, sess);
-    gnutls_transport_set_push_function(sess->session,
-                                       virNetTLSSessionPush);
-    gnutls_transport_set_pull_function(sess->session,
-                                       virNetTLSSessionPull);
+    /* With kernel TLS the session reads and writes the socket itself,
+     * since GnuTLS can't offload the record layer to the kernel when
+     * the transport goes through custom push/pull functions. The
+     * socket is attached later by virNetTLSSessionSetFD. */
+    if (ctxt->ktls) {
+        sess->ktls = true;
+    } else {
+        gnutls_transport_set_ptr(sess->session, sess);
+        gnutls_transport_set_push_function(sess->session,
+                                           virNetTLSSessionPush);
+        gnutls_transport_set_pull_function(sess->session,
+                                           virNetTLSSessionPull);
+    }
 
     sess->isServer = ctxt->isServer;
 
+    virObjectUnlock(ctxt);
+
     PROBE(RPC_TLS_SESSION_NEW,
           "sess=%p ctxt=%p hostname=%s isServer=%d",
           sess, ctxt, hostname, sess->isServer);
@@ -1215,6 +1406,7 @@ virNetTLSSession *virNetTLSSessionNew(virNetTLSContext *ctxt,
     return sess;
 
  error:
+    virObjectUnlock(ctxt);
     virObjectUnref(sess);
     return NULL;
 }
@@ -1233,6 +1425,66 @@ void virNetTLSSessionSetIOCallbacks(virNetTLSSession *sess,
 }
 
 
+/**
+ * virNetTLSSessionSetFD:
+ * @sess: TLS session
+ * @fd: connected socket
+ *
+ * Attach @sess to @fd for sessions that use kernel TLS, which bypass
+ * the I/O callbacks. This is a no-op for other sessions.
+ */
+void virNetTLSSessionSetFD(virNetTLSSession *sess,
+                           int fd)
+{
+    virObjectLock(sess);
+    if (sess->ktls)
+        gnutls_transport_set_int(sess->session, fd);
+    virObjectUnlock(sess);
+}
+
+
+/*
+ * Remember the resumption data of a client session, once the server
+ * sent us a ticket, so that the next connection to the same server
+ * can skip the full handshake. With TLS 1.3 the ticket arrives after
+ * the handshake, together with the first application data.
+ */
+static void
+virNetTLSSessionSaveResumeData(virNetTLSSession *sess)
+{
+    gnutls_datum_t data = { NULL, 0 };
+    int err;
+
+    if (!sess->resumeKey || sess->resumeSaved)
+        return;
+
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+    if (!(gnutls_session_get_flags(sess->session) & GNUTLS_SFLAGS_SESSION_TICKET))
+        return;
+#endif
+
+    sess->resumeSaved = true;
+
+    if ((err = gnutls_session_get_data2(sess->session, &data)) != 0) {
+        VIR_DEBUG("Cannot get TLS session resumption data: %s",
+                  gnutls_strerror(err));
+        return;
+    }
+
+    VIR_WITH_MUTEX_LOCK_GUARD(&virNetTLSResumeLock) {
+        if (g_hash_table_size(virNetTLSResumeCache) >= VIR_NET_TLS_RESUME_CACHE_MAX &&
+            !g_hash_table_contains(virNetTLSResumeCache, sess->resumeKey))
+            g_hash_table_remove_all(virNetTLSResumeCache);
+
+        g_hash_table_insert(virNetTLSResumeCache,
+                            g_strdup(sess->resumeKey),
+                            g_bytes_new(data.data, data.size));
+    }
+
+    gnutls_free(data.data);
+}
+
+
 ssize_t virNetTLSSessionWrite(virNetTLSSession *sess,
                               const char *buf, size_t len)
 {
@@ -1274,8 +1526,10 @@ ssize_t virNetTLSSessionRead(virNetTLSSession *sess,
     virObjectLock(sess);
     ret = gnutls_record_recv(sess->session, buf, len);
 
-    if (ret >= 0)
+    if (ret >= 0) {
+        virNetTLSSessionSaveResumeData(sess);
         goto cleanup;
+    }
 
     switch (ret) {
     case GNUTLS_E_AGAIN:
@@ -1305,7 +1559,14 @@ int virNetTLSSessionHandshake(virNetTLSSession *sess)
     VIR_DEBUG("Ret=%d", ret);
     if (ret == 0) {
         sess->handshakeComplete = true;
-        VIR_DEBUG("Handshake is complete");
+        VIR_DEBUG("Handshake is complete resumed=%d",
+                  gnutls_session_is_resumed(sess->session));
+#if GNUTLS_VERSION_NUMBER >= 0x030703
+        if (sess->ktls)
+            VIR_DEBUG("Kernel TLS offload=%d",
+                      gnutls_transport_is_ktls_enabled(sess->session));
+#endif
+        virNetTLSSessionSaveResumeData(sess);
         goto cleanup;
     }
     if (ret == GNUTLS_E_INTERRUPTED || ret == GNUTLS_E_AGAIN) {
@@ -1361,6 +1622,17 @@ int virNetTLSSessionGetKeySize(virNetTLSSession *sess)
     return ssf;
 }
 
+bool virNetTLSSessionIsResumed(virNetTLSSession *sess)
+{
+    bool ret;
+
+    virObjectLock(sess);
+    ret = sess->handshakeComplete && gnutls_session_is_resumed(sess->session);
+    virObjectUnlock(sess);
+
+    return ret;
+}
+
 const char *virNetTLSSessionGetX509DName(virNetTLSSession *sess)
 {
     const char *ret = NULL;
@@ -1383,6 +1655,7 @@ void virNetTLSSessionDispose(void *obj)
 
     g_free(sess->x509dname);
     g_free(sess->hostname);
+    g_free(sess->resumeKey);
     gnutls_deinit(sess->session);
 }
 
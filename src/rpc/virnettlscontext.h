@@ -63,6 +63,12 @@ virNetTLSContext *virNetTLSContextNewClient(const char *cacert,
 int virNetTLSContextReloadForServer(virNetTLSContext *ctxt,
                                     bool tryUserPkiPath);
 
+int virNetTLSContextSetSessionTickets(virNetTLSContext *ctxt,
+                                      bool enable);
+
+int virNetTLSContextSetKTLS(virNetTLSContext *ctxt,
+                            bool enable);
+
 int virNetTLSContextCheckCertificate(virNetTLSContext *ctxt,
                                      virNetTLSSession *sess);
 
@@ -80,6 +86,9 @@ void virNetTLSSessionSetIOCallbacks(virNetTLSSession *sess,
                                     virNetTLSSessionReadFunc readFunc,
                                     void *opaque);
 
+void virNetTLSSessionSetFD(virNetTLSSession *sess,
+                           int fd);
+
 ssize_t virNetTLSSessionWrite(virNetTLSSession *sess,
                               const char *buf, size_t len);
 ssize_t virNetTLSSessionRead(virNetTLSSession *sess,
@@ -98,4 +107,6 @@ virNetTLSSessionGetHandshakeStatus(virNetTLSSession *sess);
 
 int virNetTLSSessionGetKeySize(virNetTLSSession *sess);
 
+bool virNetTLSSessionIsResumed(virNetTLSSession *sess);
+
 const char *virNetTLSSessionGetX509DName(virNetTLSSession *sess);
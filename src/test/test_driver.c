@@ -1682,6 +1682,9 @@ testConnectSupportsFeature(virConnectPtr conn G_GNUC_UNUSED,
     case VIR_DRV_FEATURE_REMOTE:
     case VIR_DRV_FEATURE_REMOTE_CLOSE_CALLBACK:
     case VIR_DRV_FEATURE_REMOTE_EVENT_CALLBACK:
+    case VIR_DRV_FEATURE_REMOTE_STREAM_LARGE_PAYLOAD:
+    case VIR_DRV_FEATURE_REMOTE_COMPRESSION:
+    case VIR_DRV_FEATURE_REMOTE_EVENT_BATCH:
     default:
         return 0;
     }
@@ -9980,6 +9983,80 @@ testConnectGetAllDomainStats(virConnectPtr conn,
     return ret;
 }
 
+static int
+testDomainListGetInfo(virConnectPtr conn,
+                      virDomainPtr *doms,
+                      unsigned int ndoms,
+                      unsigned int fields,
+                      virDomainStatsRecordPtr **retInfo,
+                      unsigned int flags)
+{
+    testDriver *driver = conn->privateData;
+    virDomainObj **vms = NULL;
+    size_t nvms;
+    virDomainStatsRecordPtr *tmpinfo = NULL;
+    int ninfo = 0;
+    int ret = -1;
+    size_t i;
+
+    virCheckFlags(VIR_DOMAIN_XML_COMMON_FLAGS, -1);
+
+    if (!fields)
+        fields = VIR_DOMAIN_DRIVER_LIST_INFO_ALL;
+
+    if (virDomainObjListConvert(driver->domains, conn, doms, ndoms, &vms,
+                                &nvms, NULL, 0, true) < 0)
+        return -1;
+
+    tmpinfo = g_new0(virDomainStatsRecordPtr, nvms + 1);
+
+    for (i = 0; i < nvms; i++) {
+        virDomainObj *vm = vms[i];
+        virDomainInfo info = { 0 };
+        g_autofree char *xml = NULL;
+        int rc;
+
+        virObjectLock(vm);
+
+        if (fields & VIR_DOMAIN_LIST_INFO_BASIC) {
+            info.state = virDomainObjGetState(vm, NULL);
+            info.memory = vm->def->mem.cur_balloon;
+            info.maxMem = virDomainDefGetMemoryTotal(vm->def);
+            info.nrVirtCpu = virDomainDefGetVcpus(vm->def);
+            info.cpuTime = g_get_real_time() * 1000;
+        }
+
+        if (fields & VIR_DOMAIN_LIST_INFO_XML) {
+            virDomainDef *def = (flags & VIR_DOMAIN_XML_INACTIVE) &&
+                vm->newDef ? vm->newDef : vm->def;
+
+            if (!(xml = virDomainDefFormat(def, driver->xmlopt,
+                                           virDomainDefFormatConvertXMLFlags(flags)))) {
+                virObjectUnlock(vm);
+                goto cleanup;
+            }
+        }
+
+        rc = virDomainDriverListInfoRecord(conn, vm, fields, &info, xml,
+                                           &tmpinfo[ninfo]);
+        virObjectUnlock(vm);
+
+        if (rc < 0)
+            goto cleanup;
+
+        ninfo++;
+    }
+
+    *retInfo = g_steal_pointer(&tmpinfo);
+    ret = ninfo;
+
+ cleanup:
+    virDomainStatsRecordListFree(tmpinfo);
+    virObjectListFreeCount(vms, nvms);
+
+    return ret;
+}
+
 /*
  * Test driver
  */
@@ -9995,6 +10072,7 @@ static virHypervisorDriver testHypervisorDriver = {
     .nodeGetFreeMemory = testNodeGetFreeMemory, /* 2.3.0 */
     .nodeGetFreePages = testNodeGetFreePages, /* 2.3.0 */
     .connectGetAllDomainStats = testConnectGetAllDomainStats, /* 7.8.0 */
+    .domainListGetInfo = testDomainListGetInfo, /* 8.6.0 */
     .connectGetCapabilities = testConnectGetCapabilities, /* 0.2.1 */
     .connectGetSysinfo = testConnectGetSysinfo, /* 2.3.0 */
     .connectGetType = testConnectGetType, /* 2.3.0 */
@@ -23,6 +23,7 @@
 #ifdef __linux__
 # include <mntent.h>
 # include <sys/mount.h>
+# include <sys/resource.h>
 # include <fcntl.h>
 # include <sys/stat.h>
 # include <sys/sysmacros.h>
@@ -41,6 +42,7 @@
 #include "virlog.h"
 #include "virfile.h"
 #include "virgdbus.h"
+#include "virobject.h"
 #include "virstring.h"
 #include "virsystemd.h"
 #include "virtypedparam.h"
@@ -482,19 +484,62 @@ virCgroupGetBlockDevString(const char *path)
 }
 
 
-int
-virCgroupSetValueDBus(const char *unitName,
-                      const char *key,
-                      GVariant *value)
+typedef struct _virCgroupChange virCgroupChange;
+struct _virCgroupChange {
+    char *path;
+    char *value;
+};
+
+struct _virCgroupChangeSet {
+    virObject parent;
+
+    /* Writes to cgroup files, in the order they were made */
+    GPtrArray *files;
+    /* systemd unit name -> GVariantBuilder of its properties */
+    GHashTable *units;
+};
+
+static virClass *virCgroupChangeSetClass;
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(virCgroupChangeSet, virObjectUnref);
+
+static void
+virCgroupChangeFree(virCgroupChange *change)
+{
+    g_free(change->path);
+    g_free(change->value);
+    g_free(change);
+}
+
+
+static void
+virCgroupChangeSetDispose(void *obj)
+{
+    virCgroupChangeSet *changes = obj;
+
+    g_clear_pointer(&changes->files, g_ptr_array_unref);
+    g_clear_pointer(&changes->units, g_hash_table_unref);
+}
+
+
+static int
+virCgroupChangeSetOnceInit(void)
+{
+    if (!VIR_CLASS_NEW(virCgroupChangeSet, virClassForObject()))
+        return -1;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(virCgroupChangeSet);
+
+
+static int
+virCgroupSetUnitProperties(const char *unitName,
+                           GVariant *props)
 {
     GDBusConnection *conn;
     g_autoptr(GVariant) message = NULL;
-    GVariantBuilder builder;
-    GVariant *props = NULL;
-
-    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(sv)"));
-    g_variant_builder_add(&builder, "(sv)", key, value);
-    props = g_variant_builder_end(&builder);
 
     message = g_variant_new("(sb@a(sv))", unitName, true, props);
 
@@ -513,6 +558,72 @@ virCgroupSetValueDBus(const char *unitName,
 }
 
 
+/*
+ * Make all the changes collected in @changes so far: write the cgroup
+ * files in the order they were set and then set the properties of
+ * each systemd unit with a single call. The changes are dropped even
+ * if making one of them fails.
+ */
+static int
+virCgroupChangeSetApply(virCgroupChangeSet *changes)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    size_t i;
+    int ret = -1;
+
+    for (i = 0; i < changes->files->len; i++) {
+        virCgroupChange *change = g_ptr_array_index(changes->files, i);
+
+        if (virCgroupSetValueRaw(change->path, change->value) < 0)
+            goto cleanup;
+    }
+
+    g_hash_table_iter_init(&iter, changes->units);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        if (virCgroupSetUnitProperties(key, g_variant_builder_end(value)) < 0)
+            goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    g_ptr_array_set_size(changes->files, 0);
+    g_hash_table_remove_all(changes->units);
+    return ret;
+}
+
+
+int
+virCgroupSetValueDBus(virCgroup *group,
+                      const char *key,
+                      GVariant *value)
+{
+    GVariantBuilder builder;
+
+    if (group->changes) {
+        GVariantBuilder *props = g_hash_table_lookup(group->changes->units,
+                                                     group->unitName);
+
+        if (!props) {
+            props = g_variant_builder_new(G_VARIANT_TYPE("a(sv)"));
+            g_hash_table_insert(group->changes->units,
+                                g_strdup(group->unitName), props);
+        }
+
+        g_variant_builder_add(props, "(sv)", key, value);
+        return 0;
+    }
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(sv)"));
+    g_variant_builder_add(&builder, "(sv)", key, value);
+
+    return virCgroupSetUnitProperties(group->unitName,
+                                      g_variant_builder_end(&builder));
+}
+
+
 int
 virCgroupSetValueRaw(const char *path,
                      const char *value)
@@ -561,6 +672,202 @@ virCgroupGetValueRaw(const char *path,
 }
 
 
+/* Statistics files which are read over and over again, e.g. by bulk
+ * stats, and thus worth keeping open */
+static const char *const virCgroupStatFiles[] = {
+    "blkio.throttle.io_service_bytes",
+    "blkio.throttle.io_serviced",
+    "cpu.stat",
+    "cpuacct.stat",
+    "cpuacct.usage",
+    "cpuacct.usage_percpu",
+    "io.stat",
+    "memory.current",
+    "memory.stat",
+    "memory.usage_in_bytes",
+    NULL
+};
+
+/* Upper bound on the number of stat files kept open by the process */
+# define VIR_CGROUP_STAT_FDS_MAX 1024
+
+/* Stat files kept open take up at most this fraction of the limit on
+ * open files of the process */
+# define VIR_CGROUP_STAT_FDS_SHARE 8
+
+static int virCgroupStatFDs;
+static int virCgroupStatFDsMax;
+
+typedef struct _virCgroupStatFile virCgroupStatFile;
+struct _virCgroupStatFile {
+    int fd;
+    /* Contents of the file, reused by every read */
+    char *buf;
+    size_t buflen;
+};
+
+struct _virCgroupStatCache {
+    virObjectLockable parent;
+
+    /* path -> virCgroupStatFile */
+    GHashTable *files;
+};
+
+static virClass *virCgroupStatCacheClass;
+
+static void
+virCgroupStatCacheDispose(void *obj)
+{
+    virCgroupStatCache *cache = obj;
+
+    g_clear_pointer(&cache->files, g_hash_table_unref);
+}
+
+
+static int
+virCgroupStatCacheOnceInit(void)
+{
+    struct rlimit rlim;
+
+    if (!VIR_CLASS_NEW(virCgroupStatCache, virClassForObjectLockable()))
+        return -1;
+
+    virCgroupStatFDsMax = VIR_CGROUP_STAT_FDS_MAX;
+    if (getrlimit(RLIMIT_NOFILE, &rlim) == 0 &&
+        rlim.rlim_cur != RLIM_INFINITY &&
+        rlim.rlim_cur / VIR_CGROUP_STAT_FDS_SHARE < VIR_CGROUP_STAT_FDS_MAX)
+        virCgroupStatFDsMax = rlim.rlim_cur / VIR_CGROUP_STAT_FDS_SHARE;
+
+    return 0;
+}
+
+VIR_ONCE_GLOBAL_INIT(virCgroupStatCache);
+
+
+static void
+virCgroupStatFileFree(void *opaque)
+{
+    virCgroupStatFile *file = opaque;
+
+    VIR_FORCE_CLOSE(file->fd);
+    g_atomic_int_add(&virCgroupStatFDs, -1);
+    g_free(file->buf);
+    g_free(file);
+}
+
+
+static virCgroupStatCache *
+virCgroupStatCacheNew(void)
+{
+    virCgroupStatCache *cache;
+
+    if (virCgroupStatCacheInitialize() < 0 ||
+        !(cache = virObjectLockableNew(virCgroupStatCacheClass))) {
+        /* Not fatal, stat files are then read the usual way */
+        virResetLastError();
+        return NULL;
+    }
+
+    cache->files = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                         g_free, virCgroupStatFileFree);
+    return cache;
+}
+
+
+static void
+virCgroupStatCacheClear(virCgroupStatCache *cache)
+{
+    if (!cache)
+        return;
+
+    VIR_WITH_OBJECT_LOCK_GUARD(cache) {
+        g_hash_table_remove_all(cache->files);
+    }
+}
+
+
+/*
+ * Read the stat file @key found at @path using a file descriptor and
+ * a buffer kept in the stat cache of @group, so that reading it again
+ * only costs a single pread, and pass the contents to @func.
+ *
+ * Returns -2 if the cache can't be used, in which case no error is
+ * reported and the caller is expected to read the file the usual way,
+ * otherwise the value returned by @func.
+ */
+static int
+virCgroupStatCacheRead(virCgroup *group,
+                       const char *path,
+                       const char *key,
+                       virCgroupValueFunc func,
+                       void *opaque)
+{
+    virCgroupStatCache *cache = group->statCache;
+    VIR_LOCK_GUARD lock = { NULL };
+    virCgroupStatFile *file;
+    size_t len = 0;
+    ssize_t rc;
+
+    if (!cache ||
+        !g_strv_contains(virCgroupStatFiles, key))
+        return -2;
+
+    lock = virObjectLockGuard(cache);
+
+    if (!(file = g_hash_table_lookup(cache->files, path))) {
+        int fd;
+
+        if (g_atomic_int_add(&virCgroupStatFDs, 1) >= virCgroupStatFDsMax) {
+            g_atomic_int_add(&virCgroupStatFDs, -1);
+            return -2;
+        }
+
+        if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) {
+            g_atomic_int_add(&virCgroupStatFDs, -1);
+            return -2;
+        }
+
+        file = g_new0(virCgroupStatFile, 1);
+        file->fd = fd;
+        file->buflen = 4096;
+        file->buf = g_new0(char, file->buflen);
+        g_hash_table_insert(cache->files, g_strdup(path), file);
+    }
+
+    /* Reading from offset 0 makes the kernel generate fresh contents */
+    while (true) {
+        if (len == file->buflen - 1) {
+            if (file->buflen >= VIR_CGROUP_STAT_BUFLEN_MAX) {
+                /* Too large to be worth caching */
+                g_hash_table_remove(cache->files, path);
+                return -2;
+            }
+            file->buflen *= 2;
+            file->buf = g_renew(char, file->buf, file->buflen);
+        }
+
+        if ((rc = pread(file->fd, file->buf + len,
+                        file->buflen - 1 - len, len)) < 0) {
+            if (errno == EINTR)
+                continue;
+            /* Most likely the cgroup is gone, let the caller report it */
+            g_hash_table_remove(cache->files, path);
+            return -2;
+        }
+        if (rc == 0)
+            break;
+        len += rc;
+    }
+
+    /* Terminated with '\n' has sometimes harmful effects to the caller */
+    if (len > 0 && file->buf[len - 1] == '\n')
+        len--;
+    file->buf[len] = '\0';
+
+    return func(file->buf, opaque);
+}
+
+
 int
 virCgroupSetValueStr(virCgroup *group,
                      int controller,
@@ -572,10 +879,30 @@ virCgroupSetValueStr(virCgroup *group,
     if (virCgroupPathOfController(group, controller, key, &keypath) < 0)
         return -1;
 
+    if (group->changes) {
+        virCgroupChange *change = g_new0(virCgroupChange, 1);
+
+        change->path = g_steal_pointer(&keypath);
+        change->value = g_strdup(value);
+        g_ptr_array_add(group->changes->files, change);
+        return 0;
+    }
+
     return virCgroupSetValueRaw(keypath, value);
 }
 
 
+static int
+virCgroupGetValueStrFunc(char *value,
+                         void *opaque)
+{
+    char **ret = opaque;
+
+    *ret = g_strdup(value);
+    return 0;
+}
+
+
 int
 virCgroupGetValueStr(virCgroup *group,
                      int controller,
@@ -583,14 +910,66 @@ virCgroupGetValueStr(virCgroup *group,
                      char **value)
 {
     g_autofree char *keypath = NULL;
+    int rc;
 
     if (virCgroupPathOfController(group, controller, key, &keypath) < 0)
         return -1;
 
+    /* Reads see the effect of all changes made before them */
+    if (group->changes && virCgroupChangeSetApply(group->changes) < 0)
+        return -1;
+
+    if ((rc = virCgroupStatCacheRead(group, keypath, key,
+                                     virCgroupGetValueStrFunc, value)) != -2)
+        return rc;
+
     return virCgroupGetValueRaw(keypath, value);
 }
 
 
+/**
+ * virCgroupParseValue:
+ * @group: the cgroup
+ * @controller: controller the file belongs to
+ * @key: name of the file
+ * @func: callback to parse the contents of the file
+ * @opaque: data passed to @func
+ *
+ * Like virCgroupGetValueStr, but passes the contents of the file to
+ * @func instead of returning a copy, which avoids allocating memory
+ * when the file is a stat file kept open by the group. @func may
+ * modify the contents, but must not keep a pointer to them.
+ *
+ * Returns the value returned by @func, -1 on error.
+ */
+int
+virCgroupParseValue(virCgroup *group,
+                    int controller,
+                    const char *key,
+                    virCgroupValueFunc func,
+                    void *opaque)
+{
+    g_autofree char *keypath = NULL;
+    g_autofree char *value = NULL;
+    int rc;
+
+    if (virCgroupPathOfController(group, controller, key, &keypath) < 0)
+        return -1;
+
+    if (group->changes && virCgroupChangeSetApply(group->changes) < 0)
+        return -1;
+
+    if ((rc = virCgroupStatCacheRead(group, keypath, key,
+                                     func, opaque)) != -2)
+        return rc;
+
+    if (virCgroupGetValueRaw(keypath, &value) < 0)
+        return -1;
+
+    return func(value, opaque);
+}
+
+
 int
 virCgroupGetValueForBlkDev(const char *str,
                            const char *path,
@@ -745,6 +1124,7 @@ virCgroupNew(const char *path,
 
     *group = NULL;
     newGroup = g_new0(virCgroup, 1);
+    newGroup->statCache = virCgroupStatCacheNew();
 
     if (virCgroupSetBackends(newGroup) < 0)
         return -1;
@@ -771,6 +1151,85 @@ virCgroupNew(const char *path,
 }
 
 
+/**
+ * virCgroupBeginChanges:
+ *
+ * @group: The group to change
+ *
+ * Start collecting changes of @group instead of making them right
+ * away, so that they can be made in one pass by
+ * virCgroupCommitChanges. Reading a value of @group makes the changes
+ * collected so far, adding a task to @group commits them.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int
+virCgroupBeginChanges(virCgroup *group)
+{
+    virCgroupChangeSet *changes;
+
+    if (group->changes)
+        return 0;
+
+    if (virCgroupChangeSetInitialize() < 0 ||
+        !(changes = virObjectNew(virCgroupChangeSetClass)))
+        return -1;
+
+    changes->files = g_ptr_array_new_with_free_func((GDestroyNotify) virCgroupChangeFree);
+    changes->units = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                           (GDestroyNotify) g_variant_builder_unref);
+
+    group->changes = changes;
+    if (group->nested)
+        group->nested->changes = virObjectRef(changes);
+
+    return 0;
+}
+
+
+/**
+ * virCgroupCommitChanges:
+ *
+ * @group: The group to change
+ *
+ * Make the changes of @group collected since virCgroupBeginChanges
+ * and stop collecting them.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int
+virCgroupCommitChanges(virCgroup *group)
+{
+    g_autoptr(virCgroupChangeSet) changes = g_steal_pointer(&group->changes);
+
+    if (!changes)
+        return 0;
+
+    if (group->nested)
+        virObjectUnref(g_steal_pointer(&group->nested->changes));
+
+    return virCgroupChangeSetApply(changes);
+}
+
+
+/**
+ * virCgroupAbortChanges:
+ *
+ * @group: The group to change
+ *
+ * Drop the changes of @group collected since virCgroupBeginChanges
+ * and stop collecting them.
+ */
+void
+virCgroupAbortChanges(virCgroup *group)
+{
+    if (group->nested)
+        virObjectUnref(g_steal_pointer(&group->nested->changes));
+
+    virObjectUnref(g_steal_pointer(&group->changes));
+}
+
+
 static int
 virCgroupAddTaskInternal(virCgroup *group,
                          pid_t pid,
@@ -779,6 +1238,10 @@ virCgroupAddTaskInternal(virCgroup *group,
     size_t i;
     virCgroup *parent = virCgroupGetNested(group);
 
+    /* Tasks may only be moved into a fully set up group */
+    if (virCgroupCommitChanges(group) < 0)
+        return -1;
+
     for (i = 0; i < VIR_CGROUP_BACKEND_TYPE_LAST; i++) {
         if (parent->backends[i] &&
             parent->backends[i]->addTask(parent, pid, flags) < 0) {
@@ -895,6 +1358,8 @@ virCgroupNewFromParent(virCgroup *parent,
     VIR_DEBUG("parent=%p path=%s controllers=%d group=%p",
               parent, path, controllers, group);
 
+    new->statCache = virObjectRef(parent->statCache);
+
     if (virCgroupSetBackends(new) < 0)
         return -1;
 
@@ -1143,6 +1608,8 @@ virCgroupNewDetect(pid_t pid,
     VIR_DEBUG("pid=%lld controllers=%d group=%p",
               (long long) pid, controllers, group);
 
+    new->statCache = virCgroupStatCacheNew();
+
     if (virCgroupSetBackends(new) < 0)
         return -1;
 
@@ -2618,6 +3085,10 @@ virCgroupRemove(virCgroup *group)
 {
     size_t i;
 
+    /* Drop all cached files, not just those of @group, as they are
+     * shared with its parent and siblings and reopening is cheap */
+    virCgroupStatCacheClear(group->statCache);
+
     for (i = 0; i < VIR_CGROUP_BACKEND_TYPE_LAST; i++) {
         if (group->backends[i]) {
             int rc = group->backends[i]->remove(group);
@@ -3166,6 +3637,30 @@ virCgroupPathOfController(virCgroup *group G_GNUC_UNUSED,
 }
 
 
+int
+virCgroupBeginChanges(virCgroup *group G_GNUC_UNUSED)
+{
+    virReportSystemError(ENXIO, "%s",
+                         _("Control groups not supported on this platform"));
+    return -1;
+}
+
+
+int
+virCgroupCommitChanges(virCgroup *group G_GNUC_UNUSED)
+{
+    virReportSystemError(ENXIO, "%s",
+                         _("Control groups not supported on this platform"));
+    return -1;
+}
+
+
+void
+virCgroupAbortChanges(virCgroup *group G_GNUC_UNUSED)
+{
+}
+
+
 int
 virCgroupAddProcess(virCgroup *group G_GNUC_UNUSED,
                     pid_t pid G_GNUC_UNUSED)
@@ -3816,6 +4311,8 @@ virCgroupFree(virCgroup *group)
     g_free(group->unified.mountPoint);
     g_free(group->unified.placement);
     g_free(group->unitName);
+    virObjectUnref(group->statCache);
+    virObjectUnref(group->changes);
 
     virCgroupFree(group->nested);
 
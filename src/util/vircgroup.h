@@ -114,6 +114,10 @@ void virCgroupFree(virCgroup *group);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(virCgroup, virCgroupFree);
 
+int virCgroupBeginChanges(virCgroup *group);
+int virCgroupCommitChanges(virCgroup *group);
+void virCgroupAbortChanges(virCgroup *group);
+
 bool virCgroupHasController(virCgroup *cgroup, int controller);
 int virCgroupPathOfController(virCgroup *group,
                               unsigned int controller,
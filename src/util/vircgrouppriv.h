@@ -56,6 +56,9 @@ struct _virCgroupV2Controller {
 };
 typedef struct _virCgroupV2Controller virCgroupV2Controller;
 
+typedef struct _virCgroupStatCache virCgroupStatCache;
+typedef struct _virCgroupChangeSet virCgroupChangeSet;
+
 struct _virCgroup {
     virCgroupBackend *backends[VIR_CGROUP_BACKEND_TYPE_LAST];
 
@@ -64,12 +67,18 @@ struct _virCgroup {
 
     char *unitName;
     virCgroup *nested;
+
+    /* Open stat files, shared with the groups created from this one */
+    virCgroupStatCache *statCache;
+
+    /* Changes collected since virCgroupBeginChanges, shared with nested */
+    virCgroupChangeSet *changes;
 };
 
 #define virCgroupGetNested(cgroup) \
     (cgroup->nested ? cgroup->nested : cgroup)
 
-int virCgroupSetValueDBus(const char *unitName,
+int virCgroupSetValueDBus(virCgroup *group,
                           const char *key,
                           GVariant *value);
 
@@ -89,6 +98,18 @@ int virCgroupGetValueStr(virCgroup *group,
                          const char *key,
                          char **value);
 
+/* Stat files larger than this are not kept open */
+#define VIR_CGROUP_STAT_BUFLEN_MAX (64 * 1024)
+
+typedef int (*virCgroupValueFunc)(char *value,
+                                  void *opaque);
+
+int virCgroupParseValue(virCgroup *group,
+                        int controller,
+                        const char *key,
+                        virCgroupValueFunc func,
+                        void *opaque);
+
 int virCgroupSetValueU64(virCgroup *group,
                          int controller,
                          const char *key,
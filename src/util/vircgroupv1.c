@@ -1001,7 +1001,7 @@ virCgroupV1SetBlkioWeight(virCgroup *group,
     if (group->unitName) {
         GVariant *value = g_variant_new("t", weight);
 
-        return virCgroupSetValueDBus(group->unitName, "BlockIOWeight", value);
+        return virCgroupSetValueDBus(group, "BlockIOWeight", value);
     } else {
         g_autofree char *value = g_strdup_printf("%u", weight);
 
@@ -1257,7 +1257,7 @@ virCgroupV1SetBlkioDeviceWeight(virCgroup *group,
 
         value = g_variant_new_parsed("[(%s, uint64 %u)]", path, weight);
 
-        return virCgroupSetValueDBus(group->unitName, "BlockIODeviceWeight", value);
+        return virCgroupSetValueDBus(group, "BlockIODeviceWeight", value);
     } else {
         g_autofree char *str = NULL;
         g_autofree char *blkstr = NULL;
@@ -1916,7 +1916,7 @@ virCgroupV1SetCpuShares(virCgroup *group,
     if (group->unitName) {
         GVariant *value = g_variant_new("t", shares);
 
-        return virCgroupSetValueDBus(group->unitName, "CPUShares", value);
+        return virCgroupSetValueDBus(group, "CPUShares", value);
     } else {
         return virCgroupSetValueU64(group,
                                     VIR_CGROUP_CONTROLLER_CPU,
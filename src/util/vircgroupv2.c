@@ -662,7 +662,7 @@ virCgroupV2SetBlkioWeight(virCgroup *group,
     if (group->unitName) {
         GVariant *value = g_variant_new("t", weight);
 
-        return virCgroupSetValueDBus(group->unitName, "IOWeight", value);
+        return virCgroupSetValueDBus(group, "IOWeight", value);
     } else {
         g_autofree char *value = g_strdup_printf(format, weight);
 
@@ -869,7 +869,7 @@ virCgroupV2SetBlkioDeviceWeight(virCgroup *group,
 
         value = g_variant_new_parsed("[(%s, uint64 %u)]", path, weight);
 
-        return virCgroupSetValueDBus(group->unitName, "IODeviceWeight", value);
+        return virCgroupSetValueDBus(group, "IODeviceWeight", value);
     } else {
         g_autofree char *str = NULL;
         g_autofree char *blkstr = NULL;
@@ -1227,32 +1227,23 @@ virCgroupV2SetMemory(virCgroup *group,
 }
 
 
-static int
-virCgroupV2GetMemoryStat(virCgroup *group,
-                         unsigned long long *cache,
-                         unsigned long long *activeAnon,
-                         unsigned long long *inactiveAnon,
-                         unsigned long long *activeFile,
-                         unsigned long long *inactiveFile,
-                         unsigned long long *unevictable)
-{
-    g_autofree char *stat = NULL;
-    char *line = NULL;
-    unsigned long long cacheVal = 0;
-    unsigned long long activeAnonVal = 0;
-    unsigned long long inactiveAnonVal = 0;
-    unsigned long long activeFileVal = 0;
-    unsigned long long inactiveFileVal = 0;
-    unsigned long long unevictableVal = 0;
+typedef struct _virCgroupV2MemoryStat virCgroupV2MemoryStat;
+struct _virCgroupV2MemoryStat {
+    unsigned long long cache;
+    unsigned long long activeAnon;
+    unsigned long long inactiveAnon;
+    unsigned long long activeFile;
+    unsigned long long inactiveFile;
+    unsigned long long unevictable;
+};
 
-    if (virCgroupGetValueStr(group,
-                             VIR_CGROUP_CONTROLLER_MEMORY,
-                             "memory.stat",
-                             &stat) < 0) {
-        return -1;
-    }
 
-    line = stat;
+static int
+virCgroupV2ParseMemoryStat(char *stat,
+                           void *opaque)
+{
+    virCgroupV2MemoryStat *data = opaque;
+    char *line = stat;
 
     while (*line) {
         char *newLine = strchr(line, '\n');
@@ -1277,17 +1268,17 @@ virCgroupV2GetMemoryStat(virCgroup *group,
         }
 
         if (STREQ(line, "file"))
-            cacheVal = value >> 10;
+            data->cache = value >> 10;
         else if (STREQ(line, "active_anon"))
-            activeAnonVal = value >> 10;
+            data->activeAnon = value >> 10;
         else if (STREQ(line, "inactive_anon"))
-            inactiveAnonVal = value >> 10;
+            data->inactiveAnon = value >> 10;
         else if (STREQ(line, "active_file"))
-            activeFileVal = value >> 10;
+            data->activeFile = value >> 10;
         else if (STREQ(line, "inactive_file"))
-            inactiveFileVal = value >> 10;
+            data->inactiveFile = value >> 10;
         else if (STREQ(line, "unevictable"))
-            unevictableVal = value >> 10;
+            data->unevictable = value >> 10;
 
         if (newLine)
             line = newLine + 1;
@@ -1295,12 +1286,35 @@ virCgroupV2GetMemoryStat(virCgroup *group,
             break;
     }
 
-    *cache = cacheVal;
-    *activeAnon = activeAnonVal;
-    *inactiveAnon = inactiveAnonVal;
-    *activeFile = activeFileVal;
-    *inactiveFile = inactiveFileVal;
-    *unevictable = unevictableVal;
+    return 0;
+}
+
+
+static int
+virCgroupV2GetMemoryStat(virCgroup *group,
+                         unsigned long long *cache,
+                         unsigned long long *activeAnon,
+                         unsigned long long *inactiveAnon,
+                         unsigned long long *activeFile,
+                         unsigned long long *inactiveFile,
+                         unsigned long long *unevictable)
+{
+    virCgroupV2MemoryStat data = { 0 };
+
+    if (virCgroupParseValue(group,
+                            VIR_CGROUP_CONTROLLER_MEMORY,
+                            "memory.stat",
+                            virCgroupV2ParseMemoryStat,
+                            &data) < 0) {
+        return -1;
+    }
+
+    *cache = data.cache;
+    *activeAnon = data.activeAnon;
+    *inactiveAnon = data.inactiveAnon;
+    *activeFile = data.activeFile;
+    *inactiveFile = data.inactiveFile;
+    *unevictable = data.unevictable;
 
     return 0;
 }
@@ -1512,7 +1526,7 @@ virCgroupV2SetCpuShares(virCgroup *group,
     if (group->unitName) {
         GVariant *value = g_variant_new("t", shares);
 
-        return virCgroupSetValueDBus(group->unitName, "CPUWeight", value);
+        return virCgroupSetValueDBus(group, "CPUWeight", value);
     } else {
         return virCgroupSetValueU64(group,
                                     VIR_CGROUP_CONTROLLER_CPU,
@@ -1666,17 +1680,12 @@ virCgroupV2SupportsCpuBW(virCgroup *cgroup)
 
 
 static int
-virCgroupV2GetCpuacctUsage(virCgroup *group,
-                           unsigned long long *usage)
+virCgroupV2ParseCpuacctUsage(char *str,
+                             void *opaque)
 {
-    g_autofree char *str = NULL;
+    unsigned long long *usage = opaque;
     char *tmp;
 
-    if (virCgroupGetValueStr(group, VIR_CGROUP_CONTROLLER_CPUACCT,
-                             "cpu.stat", &str) < 0) {
-        return -1;
-    }
-
     if (!(tmp = strstr(str, "usage_usec "))) {
         virReportError(VIR_ERR_INTERNAL_ERROR,
                        _("cannot parse cpu usage stat '%s'"), str);
@@ -1690,6 +1699,20 @@ virCgroupV2GetCpuacctUsage(virCgroup *group,
         return -1;
     }
 
+    return 0;
+}
+
+
+static int
+virCgroupV2GetCpuacctUsage(virCgroup *group,
+                           unsigned long long *usage)
+{
+    if (virCgroupParseValue(group, VIR_CGROUP_CONTROLLER_CPUACCT,
+                            "cpu.stat", virCgroupV2ParseCpuacctUsage,
+                            usage) < 0) {
+        return -1;
+    }
+
     *usage *= 1000;
 
     return 0;
@@ -1697,19 +1720,11 @@ virCgroupV2GetCpuacctUsage(virCgroup *group,
 
 
 static int
-virCgroupV2GetCpuacctStat(virCgroup *group,
-                          unsigned long long *user,
-                          unsigned long long *sys)
+virCgroupV2ParseCpuacctStat(char *str,
+                            void *opaque)
 {
-    g_autofree char *str = NULL;
+    unsigned long long *vals = opaque;
     char *tmp;
-    unsigned long long userVal = 0;
-    unsigned long long sysVal = 0;
-
-    if (virCgroupGetValueStr(group, VIR_CGROUP_CONTROLLER_CPUACCT,
-                             "cpu.stat", &str) < 0) {
-        return -1;
-    }
 
     if (!(tmp = strstr(str, "user_usec "))) {
         virReportError(VIR_ERR_INTERNAL_ERROR,
@@ -1718,7 +1733,7 @@ virCgroupV2GetCpuacctStat(virCgroup *group,
     }
     tmp += strlen("user_usec ");
 
-    if (virStrToLong_ull(tmp, &tmp, 10, &userVal) < 0) {
+    if (virStrToLong_ull(tmp, &tmp, 10, &vals[0]) < 0) {
         virReportError(VIR_ERR_INTERNAL_ERROR,
                        _("Failed to parse value '%s' as number."), tmp);
         return -1;
@@ -1731,14 +1746,32 @@ virCgroupV2GetCpuacctStat(virCgroup *group,
     }
     tmp += strlen("system_usec ");
 
-    if (virStrToLong_ull(tmp, &tmp, 10, &sysVal) < 0) {
+    if (virStrToLong_ull(tmp, &tmp, 10, &vals[1]) < 0) {
         virReportError(VIR_ERR_INTERNAL_ERROR,
                        _("Failed to parse value '%s' as number."), tmp);
         return -1;
     }
 
-    *user = userVal * 1000;
-    *sys = sysVal * 1000;
+    return 0;
+}
+
+
+static int
+virCgroupV2GetCpuacctStat(virCgroup *group,
+                          unsigned long long *user,
+                          unsigned long long *sys)
+{
+    /* user and system time */
+    unsigned long long vals[2] = { 0 };
+
+    if (virCgroupParseValue(group, VIR_CGROUP_CONTROLLER_CPUACCT,
+                            "cpu.stat", virCgroupV2ParseCpuacctStat,
+                            vals) < 0) {
+        return -1;
+    }
+
+    *user = vals[0] * 1000;
+    *sys = vals[1] * 1000;
 
     return 0;
 }
@@ -44,6 +44,7 @@ struct virEventGLibHandle
     int fd;
     int events;
     int removed;
+    GMainContext *context;
     GSource *source;
     virEventHandleCallback cb;
     void *opaque;
@@ -55,6 +56,7 @@ struct virEventGLibTimeout
     int timer;
     int interval;
     int removed;
+    GMainContext *context;
     GSource *source;
     virEventTimeoutCallback cb;
     void *opaque;
@@ -101,6 +103,26 @@ virEventGLibConditionToEvents(GIOCondition cond)
     return events;
 }
 
+/*
+ * Schedules @func to run in the thread iterating @context once it
+ * becomes idle, so that it is serialized with dispatching of the
+ * sources attached to @context.
+ */
+static void
+virEventGLibIdleAdd(GMainContext *context,
+                    gint priority,
+                    GSourceFunc func,
+                    gpointer data)
+{
+    GSource *source = g_idle_source_new();
+
+    g_source_set_priority(source, priority);
+    g_source_set_callback(source, func, data, NULL);
+    g_source_attach(source, context);
+    g_source_unref(source);
+}
+
+
 static gboolean
 virEventGLibHandleDispatch(int fd G_GNUC_UNUSED,
                            GIOCondition condition,
@@ -122,17 +144,42 @@ virEventGLibHandleDispatch(int fd G_GNUC_UNUSED,
 }
 
 
-static int
-virEventGLibHandleAdd(int fd,
-                      int events,
-                      virEventHandleCallback cb,
-                      void *opaque,
-                      virFreeCallback ff)
+/**
+ * virEventGLibHandleAddContext:
+ * @context: the context to dispatch the callback from, NULL for default
+ * @fd: file handle to monitor for events
+ * @events: bitset of events to watch from virEventHandleType constants
+ * @cb: callback to invoke when an event occurs
+ * @opaque: user data to pass to callback
+ * @ff: callback to free opaque when handle is removed
+ *
+ * Like virEventAddHandle(), but @cb is invoked from whichever thread
+ * iterates @context rather than from the default event loop. The
+ * returned watch can be updated and removed using the generic
+ * virEventUpdateHandle() and virEventRemoveHandle() APIs, and @ff is
+ * invoked from @context as well.
+ *
+ * This can only be used once the GLib event loop implementation was
+ * registered.
+ *
+ * Returns -1 if the file handle cannot be registered, otherwise a handle
+ * watch number to be used for updating and unregistering for events.
+ */
+int
+virEventGLibHandleAddContext(GMainContext *context,
+                             int fd,
+                             int events,
+                             virEventHandleCallback cb,
+                             void *opaque,
+                             virFreeCallback ff)
 {
     struct virEventGLibHandle *data;
     GIOCondition cond = virEventGLibEventsToCondition(events);
     int ret;
 
+    if (!eventlock)
+        return -1;
+
     g_mutex_lock(eventlock);
 
     data = g_new0(struct virEventGLibHandle, 1);
@@ -140,16 +187,18 @@ virEventGLibHandleAdd(int fd,
     data->watch = nextwatch++;
     data->fd = fd;
     data->events = events;
+    if (context)
+        data->context = g_main_context_ref(context);
     data->cb = cb;
     data->opaque = opaque;
     data->ff = ff;
 
-    VIR_DEBUG("Add handle data=%p watch=%d fd=%d events=%d opaque=%p",
-              data, data->watch, data->fd, events, data->opaque);
+    VIR_DEBUG("Add handle data=%p watch=%d fd=%d events=%d opaque=%p context=%p",
+              data, data->watch, data->fd, events, data->opaque, context);
 
     if (events != 0) {
         data->source = virEventGLibAddSocketWatch(
-            fd, cond, NULL, virEventGLibHandleDispatch, data, NULL);
+            fd, cond, data->context, virEventGLibHandleDispatch, data, NULL);
     }
 
     g_ptr_array_add(handles, data);
@@ -164,6 +213,18 @@ virEventGLibHandleAdd(int fd,
     return ret;
 }
 
+
+static int
+virEventGLibHandleAdd(int fd,
+                      int events,
+                      virEventHandleCallback cb,
+                      void *opaque,
+                      virFreeCallback ff)
+{
+    return virEventGLibHandleAddContext(NULL, fd, events, cb, opaque, ff);
+}
+
+
 static struct virEventGLibHandle *
 virEventGLibHandleFind(int watch)
 {
@@ -217,7 +278,7 @@ virEventGLibHandleUpdate(int watch,
         }
 
         data->source = virEventGLibAddSocketWatch(
-            data->fd, cond, NULL, virEventGLibHandleDispatch, data, NULL);
+            data->fd, cond, data->context, virEventGLibHandleDispatch, data, NULL);
 
         data->events = events;
         VIR_DEBUG("Added new handle source=%p", data->source);
@@ -247,6 +308,9 @@ virEventGLibHandleRemoveIdle(gpointer data)
     if (h->ff)
         (h->ff)(h->opaque);
 
+    if (h->context)
+        g_main_context_unref(h->context);
+
     g_mutex_lock(eventlock);
     g_ptr_array_remove_fast(handles, h);
     g_mutex_unlock(eventlock);
@@ -286,7 +350,8 @@ virEventGLibHandleRemove(int watch)
      * 'removed' to prevent reuse
      */
     data->removed = TRUE;
-    g_idle_add_full(G_PRIORITY_HIGH, virEventGLibHandleRemoveIdle, data, NULL);
+    virEventGLibIdleAdd(data->context, G_PRIORITY_HIGH,
+                        virEventGLibHandleRemoveIdle, data);
 
     ret = 0;
 
@@ -322,26 +387,51 @@ virEventGLibTimeoutCreate(int interval,
     g_source_set_callback(source,
                           virEventGLibTimeoutDispatch,
                           data, NULL);
-    g_source_attach(source, NULL);
+    g_source_attach(source, data->context);
 
     return source;
 }
 
 
-static int
-virEventGLibTimeoutAdd(int interval,
-                       virEventTimeoutCallback cb,
-                       void *opaque,
-                       virFreeCallback ff)
+/**
+ * virEventGLibTimeoutAddContext:
+ * @context: the context to dispatch the callback from, NULL for default
+ * @interval: time between calls in milliseconds, -1 to disable
+ * @cb: callback to invoke when the timeout expires
+ * @opaque: user data to pass to callback
+ * @ff: callback to free opaque when timeout is removed
+ *
+ * Like virEventAddTimeout(), but @cb and @ff are invoked from whichever
+ * thread iterates @context. The returned timer can be updated and removed
+ * using the generic virEventUpdateTimeout() and virEventRemoveTimeout()
+ * APIs.
+ *
+ * This can only be used once the GLib event loop implementation was
+ * registered.
+ *
+ * Returns -1 if the timeout cannot be registered, otherwise a timer
+ * number to be used for updating and unregistering the timeout.
+ */
+int
+virEventGLibTimeoutAddContext(GMainContext *context,
+                              int interval,
+                              virEventTimeoutCallback cb,
+                              void *opaque,
+                              virFreeCallback ff)
 {
     struct virEventGLibTimeout *data;
     int ret;
 
+    if (!eventlock)
+        return -1;
+
     g_mutex_lock(eventlock);
 
     data = g_new0(struct virEventGLibTimeout, 1);
     data->timer = nexttimer++;
     data->interval = interval;
+    if (context)
+        data->context = g_main_context_ref(context);
     data->cb = cb;
     data->opaque = opaque;
     data->ff = ff;
@@ -364,6 +454,16 @@ virEventGLibTimeoutAdd(int interval,
 }
 
 
+static int
+virEventGLibTimeoutAdd(int interval,
+                       virEventTimeoutCallback cb,
+                       void *opaque,
+                       virFreeCallback ff)
+{
+    return virEventGLibTimeoutAddContext(NULL, interval, cb, opaque, ff);
+}
+
+
 static struct virEventGLibTimeout *
 virEventGLibTimeoutFind(int timer)
 {
@@ -439,6 +539,9 @@ virEventGLibTimeoutRemoveIdle(gpointer data)
     if (t->ff)
         (t->ff)(t->opaque);
 
+    if (t->context)
+        g_main_context_unref(t->context);
+
     g_mutex_lock(eventlock);
     g_ptr_array_remove_fast(timeouts, t);
     g_mutex_unlock(eventlock);
@@ -477,7 +580,8 @@ virEventGLibTimeoutRemove(int timer)
      * 'removed' to prevent reuse
      */
     data->removed = TRUE;
-    g_idle_add(virEventGLibTimeoutRemoveIdle, data);
+    virEventGLibIdleAdd(data->context, G_PRIORITY_DEFAULT_IDLE,
+                        virEventGLibTimeoutRemoveIdle, data);
 
     ret = 0;
 
@@ -46,6 +46,13 @@
 VIR_LOG_INIT("fdstream");
 
 #ifndef WIN32
+/* Size of the chunks read by the helper thread. The thread follows the
+ * amount of data the stream is being read by, so that a client which
+ * negotiated larger stream packets is not limited by the default size.
+ * The upper limit matches VIR_NET_MESSAGE_STREAM_PAYLOAD_MAX. */
+# define VIR_FDSTREAM_THREAD_BUFLEN (256 * 1024)
+# define VIR_FDSTREAM_THREAD_BUFLEN_MAX (4 * 1024 * 1024)
+
 typedef enum {
     VIR_FDSTREAM_MSG_TYPE_DATA,
     VIR_FDSTREAM_MSG_TYPE_HOLE,
@@ -105,6 +112,7 @@ struct virFDStreamData {
     bool threadQuit;
     bool threadAbort;
     bool threadDoRead;
+    size_t threadBufLen;
     virFDStreamMsg *msg;
 };
 
@@ -482,7 +490,8 @@ virFDStreamThreadDoRead(virFDStreamData *fdst,
             buflen > *dataLen)
             buflen = *dataLen;
 
-        buf = g_new0(char, buflen);
+        /* No need to clear the buffer, only the data read is used */
+        buf = g_new(char, buflen);
 
         if ((got = saferead(fdin, buf, buflen)) < 0) {
             virReportSystemError(errno,
@@ -613,7 +622,6 @@ virFDStreamThread(void *opaque)
     char *fdoutname = data->fdoutname;
     virFDStreamData *fdst = st->privateData;
     bool doRead = fdst->threadDoRead;
-    size_t buflen = 256 * 1024;
     size_t total = 0;
     size_t dataLen = 0;
 
@@ -647,7 +655,7 @@ virFDStreamThread(void *opaque)
                                           fdin, fdout,
                                           fdinname, fdoutname,
                                           length, total,
-                                          &dataLen, buflen);
+                                          &dataLen, fdst->threadBufLen);
         else
             got = virFDStreamThreadDoWrite(fdst, sparse, isBlock,
                                            fdin, fdout,
@@ -838,7 +846,7 @@ static int virFDStreamWrite(virStreamPtr st, const char *bytes, size_t nbytes)
         }
 
         msg = g_new0(virFDStreamMsg, 1);
-        buf = g_new0(char, nbytes);
+        buf = g_new(char, nbytes);
 
         memcpy(buf, bytes, nbytes);
         msg->type = VIR_FDSTREAM_MSG_TYPE_DATA;
@@ -906,6 +914,12 @@ static int virFDStreamRead(virStreamPtr st, char *bytes, size_t nbytes)
     if (fdst->thread) {
         virFDStreamMsg *msg = NULL;
 
+        /* Let the thread read the next chunk in the size we're asked for */
+        if (nbytes > 0) {
+            fdst->threadBufLen = MAX(MIN(nbytes, VIR_FDSTREAM_THREAD_BUFLEN_MAX),
+                                     VIR_FDSTREAM_THREAD_BUFLEN);
+        }
+
         while (!(msg = fdst->msg)) {
             if (fdst->threadQuit || fdst->threadErr) {
                 if (nbytes) {
@@ -1150,6 +1164,7 @@ static int virFDStreamOpenInternal(virStreamPtr st,
 
     if (threadData) {
         fdst->threadDoRead = threadData->doRead;
+        fdst->threadBufLen = VIR_FDSTREAM_THREAD_BUFLEN;
 
         /* Create the thread after fdst and st were initialized.
          * The thread worker expects them to be that way. */
@@ -94,9 +94,14 @@ virFileCacheOnceInit(void)
 VIR_ONCE_GLOBAL_INIT(virFileCache);
 
 
+/* Suffix of the files written by the saveBinaryFile handler */
+#define VIR_FILE_CACHE_BINARY_SUFFIX "bin"
+
+
 static char *
 virFileCacheGetFileName(virFileCache *cache,
-                        const char *name)
+                        const char *name,
+                        const char *suffix)
 {
     g_autofree char *namehash = NULL;
     g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
@@ -113,65 +118,107 @@ virFileCacheGetFileName(virFileCache *cache,
 
     virBufferAsprintf(&buf, "%s/%s", cache->dir, namehash);
 
-    if (cache->suffix)
-        virBufferAsprintf(&buf, ".%s", cache->suffix);
+    if (suffix)
+        virBufferAsprintf(&buf, ".%s", suffix);
 
     return virBufferContentAndReset(&buf);
 }
 
 
 static int
-virFileCacheLoad(virFileCache *cache,
-                 const char *name,
-                 void **data)
+virFileCacheLoadFile(virFileCache *cache,
+                     const char *name,
+                     const char *file,
+                     virFileCacheLoadFilePtr loadFile,
+                     void **data)
 {
-    g_autofree char *file = NULL;
-    int ret = -1;
     void *loadData = NULL;
     bool outdated = false;
 
-    *data = NULL;
-
-    if (!(file = virFileCacheGetFileName(cache, name)))
-        return ret;
-
     if (!virFileExists(file)) {
         if (errno == ENOENT) {
             VIR_DEBUG("No cached data '%s' for '%s'", file, name);
-            ret = 0;
-            goto cleanup;
+            return 0;
         }
         virReportSystemError(errno,
                              _("Unable to access cache '%s' for '%s'"),
                              file, name);
-        goto cleanup;
+        return -1;
     }
 
-    if (!(loadData = cache->handlers.loadFile(file, name, cache->priv, &outdated))) {
+    if (!(loadData = loadFile(file, name, cache->priv, &outdated))) {
         if (!outdated) {
             VIR_WARN("Failed to load cached data from '%s' for '%s': %s",
                      file, name, virGetLastErrorMessage());
             virResetLastError();
         }
-        ret = 0;
-        goto cleanup;
+        return 0;
     }
 
     if (!cache->handlers.isValid(loadData, cache->priv)) {
         VIR_DEBUG("Outdated cached capabilities '%s' for '%s'", file, name);
         unlink(file);
-        ret = 0;
-        goto cleanup;
+        virObjectUnref(loadData);
+        return 0;
     }
 
     VIR_DEBUG("Loaded cached data '%s' for '%s'", file, name);
 
-    ret = 1;
-    *data = g_steal_pointer(&loadData);
+    *data = loadData;
+    return 1;
+}
 
- cleanup:
-    virObjectUnref(loadData);
-    return ret;
+
+static void
+virFileCacheSaveBinary(virFileCache *cache,
+                       const char *file,
+                       void *data)
+{
+    if (cache->handlers.saveBinaryFile(data, file, cache->priv) < 0) {
+        /* The binary copy is just an optimization, the data is still
+         * available in the main cache file. */
+        VIR_WARN("Failed to save cached data to '%s': %s",
+                 file, virGetLastErrorMessage());
+        virResetLastError();
+        unlink(file);
+    }
+}
+
+
+static int
+virFileCacheLoad(virFileCache *cache,
+                 const char *name,
+                 void **data)
+{
+    g_autofree char *file = NULL;
+    g_autofree char *binaryFile = NULL;
+    int rc;
+
+    *data = NULL;
+
+    if (cache->handlers.loadBinaryFile) {
+        if (!(binaryFile = virFileCacheGetFileName(cache, name,
+                                                   VIR_FILE_CACHE_BINARY_SUFFIX)))
+            return -1;
+
+        if ((rc = virFileCacheLoadFile(cache, name, binaryFile,
+                                       cache->handlers.loadBinaryFile,
+                                       data)) != 0)
+            return rc;
+    }
+
+    if (!(file = virFileCacheGetFileName(cache, name, cache->suffix)))
+        return -1;
+
+    if ((rc = virFileCacheLoadFile(cache, name, file,
+                                   cache->handlers.loadFile, data)) <= 0)
+        return rc;
+
+    /* Refresh the binary copy so that the next load can use it */
+    if (binaryFile && cache->handlers.saveBinaryFile)
+        virFileCacheSaveBinary(cache, binaryFile, *data);
+
+    return 1;
 }
 
 
@@ -181,13 +228,22 @@ virFileCacheSave(virFileCache *cache,
                  void *data)
 {
     g_autofree char *file = NULL;
+    g_autofree char *binaryFile = NULL;
 
-    if (!(file = virFileCacheGetFileName(cache, name)))
+    if (!(file = virFileCacheGetFileName(cache, name, cache->suffix)))
         return -1;
 
     if (cache->handlers.saveFile(data, file, cache->priv) < 0)
         return -1;
 
+    if (cache->handlers.saveBinaryFile) {
+        if (!(binaryFile = virFileCacheGetFileName(cache, name,
+                                                   VIR_FILE_CACHE_BINARY_SUFFIX)))
+            return -1;
+
+        virFileCacheSaveBinary(cache, binaryFile, data);
+    }
+
     return 0;
 }
 
@@ -91,6 +91,42 @@ typedef int
                            const char *filename,
                            void *priv);
 
+/**
+ * virFileCacheLoadBinaryFilePtr:
+ * @filename: name of a file with cached data
+ * @name: name of the cached data
+ * @priv: private data created together with cache
+ * @outdated: set to true if data was outdated
+ *
+ * Optional counterpart of virFileCacheLoadFilePtr which loads the data
+ * from a file written by virFileCacheSaveBinaryFilePtr.
+ *
+ * Returns cached data object or NULL on outdated data or error.
+ */
+typedef void *
+(*virFileCacheLoadBinaryFilePtr)(const char *filename,
+                                 const char *name,
+                                 void *priv,
+                                 bool *outdated);
+
+/**
+ * virFileCacheSaveBinaryFilePtr:
+ * @data: data object to save into a file
+ * @filename: name of the file where to store the cached data
+ * @priv: private data created together with cache
+ *
+ * Optional counterpart of virFileCacheSaveFilePtr which stores the data
+ * in a compact format that is cheaper to load. The binary file is stored
+ * next to the one written by saveFile and is preferred when loading the
+ * data.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+typedef int
+(*virFileCacheSaveBinaryFilePtr)(void *data,
+                                 const char *filename,
+                                 void *priv);
+
 /**
  * virFileCachePrivFreePtr:
  * @priv: private data created together with cache
@@ -107,6 +143,8 @@ struct _virFileCacheHandlers {
     virFileCacheNewDataPtr newData;
     virFileCacheLoadFilePtr loadFile;
     virFileCacheSaveFilePtr saveFile;
+    virFileCacheLoadBinaryFilePtr loadBinaryFile;
+    virFileCacheSaveBinaryFilePtr saveBinaryFile;
     virFileCachePrivFreePtr privFree;
 };
 
@@ -55,9 +55,15 @@ struct _virJSONObjectPair {
     virJSONValue *value;
 };
 
+/* Objects with at least this many members get a hash table index of
+ * their keys built on first lookup. Smaller objects are scanned linearly
+ * which is faster than hashing and keeps them allocation free. */
+#define VIR_JSON_OBJECT_INDEX_THRESHOLD 16
+
 struct _virJSONObject {
     size_t npairs;
     virJSONObjectPair *pairs;
+    GHashTable *index; /* key -> (position in @pairs + 1), built lazily */
 };
 
 struct _virJSONArray {
@@ -90,6 +96,10 @@ struct _virJSONParser {
     virJSONParserState *state;
     size_t nstate;
     int wrap;
+
+    const char *const *filter; /* keys of object members to keep */
+    bool skipNext; /* the next value belongs to a filtered out member */
+    size_t skipDepth; /* nesting level inside a filtered out member */
 };
 
 
@@ -100,6 +110,74 @@ virJSONValueGetType(const virJSONValue *value)
 }
 
 
+static void
+virJSONObjectIndexClear(virJSONObject *object)
+{
+    g_clear_pointer(&object->index, g_hash_table_unref);
+}
+
+
+/**
+ * virJSONObjectIndexGet:
+ * @object: JSON object
+ *
+ * Returns the key index of @object, building it if @object is large enough
+ * and the index doesn't exist yet. Returns NULL for small objects.
+ */
+static GHashTable *
+virJSONObjectIndexGet(virJSONObject *object)
+{
+    GHashTable *index = g_atomic_pointer_get(&object->index);
+    size_t i;
+
+    if (index || object->npairs < VIR_JSON_OBJECT_INDEX_THRESHOLD)
+        return index;
+
+    index = g_hash_table_new(g_str_hash, g_str_equal);
+
+    for (i = 0; i < object->npairs; i++) {
+        if (!g_hash_table_contains(index, object->pairs[i].key))
+            g_hash_table_insert(index, object->pairs[i].key, GSIZE_TO_POINTER(i + 1));
+    }
+
+    /* Lookups don't modify the object from the caller's point of view, so
+     * multiple threads may race to build the index of a shared object. */
+    if (!g_atomic_pointer_compare_and_exchange(&object->index, NULL, index)) {
+        g_hash_table_unref(index);
+        index = g_atomic_pointer_get(&object->index);
+    }
+
+    return index;
+}
+
+
+/**
+ * virJSONObjectFindKey:
+ * @object: JSON object
+ * @key: key to look up
+ *
+ * Returns position of the first pair with @key in @object or -1 if
+ * there's no such key.
+ */
+static ssize_t
+virJSONObjectFindKey(virJSONObject *object,
+                     const char *key)
+{
+    GHashTable *index = virJSONObjectIndexGet(object);
+    size_t i;
+
+    if (index)
+        return (ssize_t) GPOINTER_TO_SIZE(g_hash_table_lookup(index, key)) - 1;
+
+    for (i = 0; i < object->npairs; i++) {
+        if (STREQ(object->pairs[i].key, key))
+            return i;
+    }
+
+    return -1;
+}
+
+
 /**
  * virJSONValueObjectAddVArgs:
  * @objptr: pointer to a pointer to a JSON object to add the values to
@@ -382,6 +460,7 @@ virJSONValueFree(virJSONValue *value)
 
     switch ((virJSONType) value->type) {
     case VIR_JSON_TYPE_OBJECT:
+        virJSONObjectIndexClear(&value->data.object);
         for (i = 0; i < value->data.object.npairs; i++) {
             g_free(value->data.object.pairs[i].key);
             virJSONValueFree(value->data.object.pairs[i].value);
@@ -563,12 +642,19 @@ virJSONValueObjectInsert(virJSONValue *object,
     pair.key = g_strdup(key);
 
     if (prepend) {
+        /* positions of all members shift */
+        virJSONObjectIndexClear(&object->data.object);
         ret = VIR_INSERT_ELEMENT(object->data.object.pairs, 0,
                                  object->data.object.npairs, pair);
     } else {
         VIR_APPEND_ELEMENT(object->data.object.pairs,
                            object->data.object.npairs, pair);
         ret = 0;
+
+        if (object->data.object.index)
+            g_hash_table_insert(object->data.object.index,
+                                object->data.object.pairs[object->data.object.npairs - 1].key,
+                                GSIZE_TO_POINTER(object->data.object.npairs));
     }
 
     if (ret == 0)
@@ -802,17 +888,13 @@ int
 virJSONValueObjectHasKey(virJSONValue *object,
                          const char *key)
 {
-    size_t i;
-
     if (object->type != VIR_JSON_TYPE_OBJECT)
         return -1;
 
-    for (i = 0; i < object->data.object.npairs; i++) {
-        if (STREQ(object->data.object.pairs[i].key, key))
-            return 1;
-    }
+    if (virJSONObjectFindKey(&object->data.object, key) < 0)
+        return 0;
 
-    return 0;
+    return 1;
 }
 
 
@@ -820,17 +902,15 @@ virJSONValue *
 virJSONValueObjectGet(virJSONValue *object,
                       const char *key)
 {
-    size_t i;
+    ssize_t i;
 
     if (object->type != VIR_JSON_TYPE_OBJECT)
         return NULL;
 
-    for (i = 0; i < object->data.object.npairs; i++) {
-        if (STREQ(object->data.object.pairs[i].key, key))
-            return object->data.object.pairs[i].value;
-    }
+    if ((i = virJSONObjectFindKey(&object->data.object, key)) < 0)
+        return NULL;
 
-    return NULL;
+    return object->data.object.pairs[i].value;
 }
 
 
@@ -899,7 +979,7 @@ virJSONValueObjectRemoveKey(virJSONValue *object,
                             const char *key,
                             virJSONValue **value)
 {
-    size_t i;
+    ssize_t i;
 
     if (value)
         *value = NULL;
@@ -907,20 +987,19 @@ virJSONValueObjectRemoveKey(virJSONValue *object,
     if (object->type != VIR_JSON_TYPE_OBJECT)
         return -1;
 
-    for (i = 0; i < object->data.object.npairs; i++) {
-        if (STREQ(object->data.object.pairs[i].key, key)) {
-            if (value) {
-                *value = g_steal_pointer(&object->data.object.pairs[i].value);
-            }
-            VIR_FREE(object->data.object.pairs[i].key);
-            virJSONValueFree(object->data.object.pairs[i].value);
-            VIR_DELETE_ELEMENT(object->data.object.pairs, i,
-                               object->data.object.npairs);
-            return 1;
-        }
-    }
+    if ((i = virJSONObjectFindKey(&object->data.object, key)) < 0)
+        return 0;
 
-    return 0;
+    /* positions of the following members shift */
+    virJSONObjectIndexClear(&object->data.object);
+
+    if (value)
+        *value = g_steal_pointer(&object->data.object.pairs[i].value);
+    VIR_FREE(object->data.object.pairs[i].key);
+    virJSONValueFree(object->data.object.pairs[i].value);
+    VIR_DELETE_ELEMENT(object->data.object.pairs, i,
+                       object->data.object.npairs);
+    return 1;
 }
 
 
@@ -1440,6 +1519,60 @@ virJSONValueCopy(const virJSONValue *in)
 
 
 #if WITH_YAJL
+/* Returns true if the scalar value being parsed belongs to a member which
+ * was filtered out and thus should be ignored. */
+static bool
+virJSONParserSkipValue(virJSONParser *parser)
+{
+    if (parser->skipDepth > 0)
+        return true;
+
+    if (parser->skipNext) {
+        parser->skipNext = false;
+        return true;
+    }
+
+    return false;
+}
+
+
+static bool
+virJSONParserSkipContainerStart(virJSONParser *parser)
+{
+    if (!virJSONParserSkipValue(parser))
+        return false;
+
+    parser->skipDepth++;
+    return true;
+}
+
+
+static bool
+virJSONParserSkipContainerEnd(virJSONParser *parser)
+{
+    if (parser->skipDepth == 0)
+        return false;
+
+    parser->skipDepth--;
+    return true;
+}
+
+
+static bool
+virJSONParserFilterMatch(const char *const *filter,
+                         const unsigned char *key,
+                         size_t keyLen)
+{
+    for (; *filter; filter++) {
+        if (strlen(*filter) == keyLen &&
+            memcmp(*filter, key, keyLen) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+
 static int
 virJSONParserInsertValue(virJSONParser *parser,
                          virJSONValue **value)
@@ -1495,10 +1628,15 @@ static int
 virJSONParserHandleNull(void *ctx)
 {
     virJSONParser *parser = ctx;
-    g_autoptr(virJSONValue) value = virJSONValueNewNull();
+    g_autoptr(virJSONValue) value = NULL;
 
     VIR_DEBUG("parser=%p", parser);
 
+    if (virJSONParserSkipValue(parser))
+        return 1;
+
+    value = virJSONValueNewNull();
+
     if (virJSONParserInsertValue(parser, &value) < 0)
         return 0;
 
@@ -1511,10 +1649,15 @@ virJSONParserHandleBoolean(void *ctx,
                            int boolean_)
 {
     virJSONParser *parser = ctx;
-    g_autoptr(virJSONValue) value = virJSONValueNewBoolean(boolean_);
+    g_autoptr(virJSONValue) value = NULL;
 
     VIR_DEBUG("parser=%p boolean=%d", parser, boolean_);
 
+    if (virJSONParserSkipValue(parser))
+        return 1;
+
+    value = virJSONValueNewBoolean(boolean_);
+
     if (virJSONParserInsertValue(parser, &value) < 0)
         return 0;
 
@@ -1528,7 +1671,12 @@ virJSONParserHandleNumber(void *ctx,
                           size_t l)
 {
     virJSONParser *parser = ctx;
-    g_autoptr(virJSONValue) value = virJSONValueNewNumber(g_strndup(s, l));
+    g_autoptr(virJSONValue) value = NULL;
+
+    if (virJSONParserSkipValue(parser))
+        return 1;
+
+    value = virJSONValueNewNumber(g_strndup(s, l));
 
     VIR_DEBUG("parser=%p str=%s", parser, value->data.number);
 
@@ -1545,10 +1693,15 @@ virJSONParserHandleString(void *ctx,
                           size_t stringLen)
 {
     virJSONParser *parser = ctx;
-    g_autoptr(virJSONValue) value = virJSONValueNewString(g_strndup((const char *)stringVal, stringLen));
+    g_autoptr(virJSONValue) value = NULL;
 
     VIR_DEBUG("parser=%p str=%p", parser, (const char *)stringVal);
 
+    if (virJSONParserSkipValue(parser))
+        return 1;
+
+    value = virJSONValueNewString(g_strndup((const char *)stringVal, stringLen));
+
     if (virJSONParserInsertValue(parser, &value) < 0)
         return 0;
 
@@ -1566,9 +1719,18 @@ virJSONParserHandleMapKey(void *ctx,
 
     VIR_DEBUG("parser=%p key=%p", parser, (const char *)stringVal);
 
+    if (parser->skipDepth > 0)
+        return 1;
+
     if (!parser->nstate)
         return 0;
 
+    if (parser->filter &&
+        !virJSONParserFilterMatch(parser->filter, stringVal, stringLen)) {
+        parser->skipNext = true;
+        return 1;
+    }
+
     state = &parser->state[parser->nstate-1];
     if (state->key)
         return 0;
@@ -1581,11 +1743,17 @@ static int
 virJSONParserHandleStartMap(void *ctx)
 {
     virJSONParser *parser = ctx;
-    g_autoptr(virJSONValue) value = virJSONValueNewObject();
-    virJSONValue *tmp = value;
+    g_autoptr(virJSONValue) value = NULL;
+    virJSONValue *tmp;
 
     VIR_DEBUG("parser=%p", parser);
 
+    if (virJSONParserSkipContainerStart(parser))
+        return 1;
+
+    value = virJSONValueNewObject();
+    tmp = value;
+
     if (virJSONParserInsertValue(parser, &value) < 0)
         return 0;
 
@@ -1607,6 +1775,9 @@ virJSONParserHandleEndMap(void *ctx)
 
     VIR_DEBUG("parser=%p", parser);
 
+    if (virJSONParserSkipContainerEnd(parser))
+        return 1;
+
     if (!parser->nstate)
         return 0;
 
@@ -1626,11 +1797,17 @@ static int
 virJSONParserHandleStartArray(void *ctx)
 {
     virJSONParser *parser = ctx;
-    g_autoptr(virJSONValue) value = virJSONValueNewArray();
-    virJSONValue *tmp = value;
+    g_autoptr(virJSONValue) value = NULL;
+    virJSONValue *tmp;
 
     VIR_DEBUG("parser=%p", parser);
 
+    if (virJSONParserSkipContainerStart(parser))
+        return 1;
+
+    value = virJSONValueNewArray();
+    tmp = value;
+
     if (virJSONParserInsertValue(parser, &value) < 0)
         return 0;
 
@@ -1652,6 +1829,9 @@ virJSONParserHandleEndArray(void *ctx)
 
     VIR_DEBUG("parser=%p", parser);
 
+    if (virJSONParserSkipContainerEnd(parser))
+        return 1;
+
     if (!(parser->nstate - parser->wrap))
         return 0;
 
@@ -1683,11 +1863,12 @@ static const yajl_callbacks parserCallbacks = {
 
 
 /* XXX add an incremental streaming parser - yajl trivially supports it */
-virJSONValue *
-virJSONValueFromString(const char *jsonstring)
+static virJSONValue *
+virJSONValueFromStringInternal(const char *jsonstring,
+                               const char *const *filter)
 {
     yajl_handle hand;
-    virJSONParser parser = { NULL, NULL, 0, 0 };
+    virJSONParser parser = { .filter = filter };
     virJSONValue *ret = NULL;
     int rc;
     size_t len = strlen(jsonstring);
@@ -1742,6 +1923,35 @@ virJSONValueFromString(const char *jsonstring)
 }
 
 
+virJSONValue *
+virJSONValueFromString(const char *jsonstring)
+{
+    return virJSONValueFromStringInternal(jsonstring, NULL);
+}
+
+
+/**
+ * virJSONValueFromStringFiltered:
+ * @jsonstring: JSON document to parse
+ * @filter: NULL-terminated list of object member names to keep
+ *
+ * Parses @jsonstring similarly to virJSONValueFromString, but members of
+ * objects (at any nesting level) whose name is not listed in @filter are
+ * dropped. Their values are skipped by the parser without being converted
+ * to virJSONValue, which avoids most of the allocations when only a few
+ * fields of a large document are interesting. Array members and the
+ * top level value are never filtered.
+ *
+ * Returns the parsed value or NULL on error.
+ */
+virJSONValue *
+virJSONValueFromStringFiltered(const char *jsonstring,
+                               const char *const *filter)
+{
+    return virJSONValueFromStringInternal(jsonstring, filter);
+}
+
+
 static int
 virJSONValueToStringOne(virJSONValue *object,
                         yajl_gen g)
@@ -1861,6 +2071,16 @@ virJSONValueFromString(const char *jsonstring G_GNUC_UNUSED)
 }
 
 
+virJSONValue *
+virJSONValueFromStringFiltered(const char *jsonstring G_GNUC_UNUSED,
+                               const char *const *filter G_GNUC_UNUSED)
+{
+    virReportError(VIR_ERR_INTERNAL_ERROR, "%s",
+                   _("No JSON parser implementation is available"));
+    return NULL;
+}
+
+
 int
 virJSONValueToBuffer(virJSONValue *object G_GNUC_UNUSED,
                      virBuffer *buf G_GNUC_UNUSED,
@@ -2031,6 +2251,8 @@ virJSONValueObjectDeflattenArrays(virJSONValue *json)
         arraymembers[keynum] = pair->value;
     }
 
+    virJSONObjectIndexClear(obj);
+
     for (i = 0; i < obj->npairs; i++)
         g_free(obj->pairs[i].key);
 
@@ -260,6 +260,9 @@ virJSONValueArrayAppendString(virJSONValue *object,
 
 virJSONValue *
 virJSONValueFromString(const char *jsonstring);
+virJSONValue *
+virJSONValueFromStringFiltered(const char *jsonstring,
+                               const char *const *filter);
 char *
 virJSONValueToString(virJSONValue *object,
                      bool pretty);
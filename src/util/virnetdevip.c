@@ -850,6 +850,42 @@ virNetDevIPInfoClear(virNetDevIPInfo *ip)
 }
 
 
+/**
+ * virNetDevIPInfoCopy:
+ * @dst: IP info to fill in, expected to be empty
+ * @src: IP info to copy
+ *
+ * Deep-copies all addresses and routes of @src into @dst.
+ */
+void
+virNetDevIPInfoCopy(virNetDevIPInfo *dst,
+                    const virNetDevIPInfo *src)
+{
+    size_t i;
+
+    if (src->nips > 0) {
+        dst->ips = g_new0(virNetDevIPAddr *, src->nips);
+        dst->nips = src->nips;
+
+        for (i = 0; i < src->nips; i++) {
+            dst->ips[i] = g_new0(virNetDevIPAddr, 1);
+            *dst->ips[i] = *src->ips[i];
+        }
+    }
+
+    if (src->nroutes > 0) {
+        dst->routes = g_new0(virNetDevIPRoute *, src->nroutes);
+        dst->nroutes = src->nroutes;
+
+        for (i = 0; i < src->nroutes; i++) {
+            dst->routes[i] = g_new0(virNetDevIPRoute, 1);
+            *dst->routes[i] = *src->routes[i];
+            dst->routes[i]->family = g_strdup(src->routes[i]->family);
+        }
+    }
+}
+
+
 /**
  * virNetDevIPInfoAddToDev:
  * @ifname: name of device to operate on
@@ -53,7 +53,7 @@ int virNumaGetPageInfo(int node,
                        unsigned int page_size,
                        unsigned long long huge_page_sum,
                        unsigned long long *page_avail,
-                       unsigned long long *page_free);
+                       unsigned long long *page_free) G_NO_INLINE;
 int virNumaGetPages(int node,
                     unsigned int **pages_size,
                     unsigned long long **pages_avail,
@@ -63,4 +63,4 @@ int virNumaGetPages(int node,
 int virNumaSetPagePoolSize(int node,
                            unsigned int page_size,
                            unsigned long long page_count,
-                           bool add);
+                           bool add) G_NO_INLINE;
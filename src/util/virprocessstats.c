@@ -0,0 +1,619 @@
+/*
+ * virprocessstats.c: sampling of per-thread scheduler statistics
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "virprocessstats.h"
+#include "virerror.h"
+#include "virfile.h"
+#include "virlog.h"
+#include "virprocess.h"
+#include "virstring.h"
+#include "virthread.h"
+#include "virtime.h"
+#include "virutil.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+VIR_LOG_INIT("util.processstats");
+
+#ifdef __linux__
+
+/* Number of threads whose statistics can be cached, a power of two */
+# define VIR_PROCESS_STATS_TABLE_SIZE 8192
+
+/* Number of entries looked at for a thread before giving up. Threads
+ * which don't fit are read every time */
+# define VIR_PROCESS_STATS_MAX_PROBE 64
+
+/* Threads nobody asked about for this many seconds are not sampled
+ * anymore */
+# define VIR_PROCESS_STATS_EXPIRE 60
+
+/*
+ * Statistics of threads are kept in a fixed size open addressing hash
+ * table which is never freed, so that readers can look them up without
+ * taking any lock. Each entry is guarded by a sequence counter which is
+ * odd while the entry is being written. Readers copy the entry and
+ * retry if the counter was odd or changed meanwhile. Writers are
+ * serialized by virProcessStatsLock. Dropped entries are emptied again
+ * once no thread can be stored past them, see virProcessStatsDrop.
+ */
+typedef struct _virProcessStatsEntry virProcessStatsEntry;
+struct _virProcessStatsEntry {
+    int seq;
+    int pid; /* 0 if the entry was never used, -1 if it was dropped */
+    int tid;
+    unsigned int flags; /* virProcessStatsFlags the entry is sampled with */
+    long long when; /* monotonic time of the sample in microseconds */
+    virProcessStats stats;
+
+    int lastUsed; /* monotonic time of the last lookup in seconds, set
+                   * by readers outside of @seq */
+};
+
+static virProcessStatsEntry *virProcessStatsTable;
+static virMutex virProcessStatsLock = VIR_MUTEX_INITIALIZER;
+
+static virThread virProcessStatsThread;
+static virCond virProcessStatsCond;
+static bool virProcessStatsRunning;
+static unsigned int virProcessStatsInterval;
+
+
+static int
+virProcessStatsReadFile(pid_t pid,
+                        pid_t tid,
+                        const char *name,
+                        char *buf,
+                        size_t buflen)
+{
+    char path[128];
+    VIR_AUTOCLOSE fd = -1;
+    size_t len = 0;
+    ssize_t rc;
+
+    /* In general, we cannot assume pid_t fits in int; but /proc parsing
+     * is specific to Linux where int works fine.  */
+    if (tid)
+        g_snprintf(path, sizeof(path), "/proc/%d/task/%d/%s",
+                   (int) pid, (int) tid, name);
+    else
+        g_snprintf(path, sizeof(path), "/proc/%d/%s", (int) pid, name);
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return -1;
+
+    while (len < buflen - 1) {
+        if ((rc = read(fd, buf + len, buflen - 1 - len)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (rc == 0)
+            break;
+        len += rc;
+    }
+    buf[len] = '\0';
+
+    return 0;
+}
+
+
+/*
+ * Parse the stat file the same way virProcessGetStat does, but without
+ * splitting it into allocated fields. The command name may contain
+ * any character, so the fields start after the last ')'.
+ */
+static int
+virProcessStatsParseStat(char *buf,
+                         virProcessStats *stats)
+{
+    unsigned long long usertime = 0;
+    unsigned long long systime = 0;
+    long rss = 0;
+    int cpu = 0;
+    char *field;
+    char *rparen;
+    size_t i;
+
+    if (!(rparen = strrchr(buf, ')')) || rparen[1] != ' ')
+        return -1;
+
+    field = rparen + 2;
+    for (i = VIR_PROCESS_STAT_STATE; i <= VIR_PROCESS_STAT_PROCESSOR; i++) {
+        char *end;
+
+        switch (i) {
+        case VIR_PROCESS_STAT_UTIME:
+            if (virStrToLong_ullp(field, &end, 10, &usertime) < 0)
+                return -1;
+            break;
+        case VIR_PROCESS_STAT_STIME:
+            if (virStrToLong_ullp(field, &end, 10, &systime) < 0)
+                return -1;
+            break;
+        case VIR_PROCESS_STAT_RSS:
+            if (virStrToLong_l(field, &end, 10, &rss) < 0)
+                return -1;
+            break;
+        case VIR_PROCESS_STAT_PROCESSOR:
+            if (virStrToLong_i(field, &end, 10, &cpu) < 0)
+                return -1;
+            break;
+        }
+
+        if (i == VIR_PROCESS_STAT_PROCESSOR)
+            break;
+
+        if (!(field = strchr(field, ' ')))
+            return -1;
+        field++;
+    }
+
+    /* We got jiffies
+     * We want nanoseconds
+     * _SC_CLK_TCK is jiffies per second
+     * So calculate thus....
+     */
+    stats->cpuTime = 1000ull * 1000ull * 1000ull * (usertime + systime)
+        / (unsigned long long) sysconf(_SC_CLK_TCK);
+    stats->lastCpu = cpu;
+    stats->rss = rss * virGetSystemPageSizeKB();
+
+    return 0;
+}
+
+
+static int
+virProcessStatsParseSched(const char *buf,
+                          virProcessStats *stats)
+{
+    const char *line = buf;
+
+    while (line && *line) {
+        /* Needs CONFIG_SCHEDSTATS. The second check
+         * is the old name the kernel used in past */
+        if (STRPREFIX(line, "se.statistics.wait_sum") ||
+            STRPREFIX(line, "se.wait_sum")) {
+            const char *value = strchr(line, ':');
+            char *end;
+            double val;
+
+            if (!value)
+                return -1;
+            value++;
+            while (*value == ' ')
+                value++;
+
+            if (virStrToDouble(value, &end, &val) < 0)
+                return -1;
+
+            stats->cpuWait = (unsigned long long) (val * 1000000);
+            break;
+        }
+
+        if ((line = strchr(line, '\n')))
+            line++;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Read statistics of @tid of @pid without reporting any error.
+ *
+ * Returns 0 on success, -1 if the stat file can't be read or parsed,
+ * e.g. because the thread is gone, -2 if the scheduler statistics
+ * can't be parsed.
+ */
+static int
+virProcessStatsRead(pid_t pid,
+                    pid_t tid,
+                    unsigned int flags,
+                    virProcessStats *stats)
+{
+    /* Large enough for the stat and schedstat files, and for the part
+     * of the sched file which has the wait time */
+    char buf[2048];
+
+    memset(stats, 0, sizeof(*stats));
+
+    if (virProcessStatsReadFile(pid, tid, "stat", buf, sizeof(buf)) < 0 ||
+        virProcessStatsParseStat(buf, stats) < 0)
+        return -1;
+
+    if (!(flags & VIR_PROCESS_STATS_SCHED))
+        return 0;
+
+    /* Neither file is guaranteed to exist (needs CONFIG_SCHED_DEBUG
+     * and CONFIG_SCHED_INFO respectively) */
+    if (virProcessStatsReadFile(pid, tid, "sched", buf, sizeof(buf)) == 0 &&
+        virProcessStatsParseSched(buf, stats) < 0)
+        return -2;
+
+    if (virProcessStatsReadFile(pid, tid, "schedstat", buf, sizeof(buf)) == 0 &&
+        sscanf(buf, "%*u %llu", &stats->cpuDelay) != 1)
+        return -2;
+
+    return 0;
+}
+
+
+static size_t
+virProcessStatsHash(pid_t pid,
+                    pid_t tid)
+{
+    return ((unsigned int) pid * 31 + (unsigned int) tid) &
+        (VIR_PROCESS_STATS_TABLE_SIZE - 1);
+}
+
+
+static bool
+virProcessStatsLookup(pid_t pid,
+                      pid_t tid,
+                      unsigned int maxAge,
+                      unsigned int flags,
+                      virProcessStats *stats)
+{
+    virProcessStatsEntry *table = g_atomic_pointer_get(&virProcessStatsTable);
+    size_t hash = virProcessStatsHash(pid, tid);
+    long long now = g_get_monotonic_time();
+    size_t i;
+
+    if (!table)
+        return false;
+
+    for (i = 0; i < VIR_PROCESS_STATS_MAX_PROBE; i++) {
+        virProcessStatsEntry *entry;
+        virProcessStatsEntry copy;
+        int seq;
+
+        entry = &table[(hash + i) & (VIR_PROCESS_STATS_TABLE_SIZE - 1)];
+
+        /* The compare and exchange leaving the counter as it is acts
+         * as a full barrier, so the copy can't be reordered past it */
+        do {
+            /* The entry is being written right now, by a writer which
+             * may have been preempted */
+            while ((seq = g_atomic_int_get(&entry->seq)) & 1)
+                g_thread_yield();
+            copy = *entry;
+        } while (!g_atomic_int_compare_and_exchange(&entry->seq, seq, seq));
+
+        if (copy.pid == 0)
+            return false;
+
+        if (copy.pid != pid || copy.tid != tid)
+            continue;
+
+        g_atomic_int_set(&entry->lastUsed, now / G_USEC_PER_SEC);
+
+        if ((copy.flags & flags) != flags ||
+            now - copy.when > maxAge * 1000ll)
+            return false;
+
+        *stats = copy.stats;
+        return true;
+    }
+
+    return false;
+}
+
+
+/* Must be called with virProcessStatsLock held */
+static void
+virProcessStatsUpdate(virProcessStatsEntry *entry,
+                      pid_t pid,
+                      pid_t tid,
+                      unsigned int flags,
+                      virProcessStats *stats)
+{
+    g_atomic_int_inc(&entry->seq);
+    entry->pid = pid;
+    entry->tid = tid;
+    entry->flags = flags;
+    entry->when = g_get_monotonic_time();
+    if (stats)
+        entry->stats = *stats;
+    g_atomic_int_inc(&entry->seq);
+}
+
+
+/*
+ * Must be called with virProcessStatsLock held. Drop the entry at @idx.
+ * Lookups of a thread stop at the first empty entry, so a dropped entry
+ * followed by an empty one can be emptied as well, together with the
+ * dropped entries right before it. This keeps misses from scanning
+ * entries of threads which are long gone.
+ */
+static void
+virProcessStatsDrop(size_t idx)
+{
+    virProcessStatsUpdate(&virProcessStatsTable[idx], -1, 0, 0, NULL);
+
+    if (virProcessStatsTable[(idx + 1) & (VIR_PROCESS_STATS_TABLE_SIZE - 1)].pid != 0)
+        return;
+
+    do {
+        virProcessStatsUpdate(&virProcessStatsTable[idx], 0, 0, 0, NULL);
+        idx = (idx - 1) & (VIR_PROCESS_STATS_TABLE_SIZE - 1);
+    } while (virProcessStatsTable[idx].pid == -1);
+}
+
+
+static void
+virProcessStatsStore(pid_t pid,
+                     pid_t tid,
+                     unsigned int flags,
+                     virProcessStats *stats)
+{
+    VIR_LOCK_GUARD lock = virLockGuardLock(&virProcessStatsLock);
+    virProcessStatsEntry *entry = NULL;
+    size_t hash = virProcessStatsHash(pid, tid);
+    size_t i;
+
+    if (!virProcessStatsTable)
+        g_atomic_pointer_set(&virProcessStatsTable,
+                             g_new0(virProcessStatsEntry,
+                                    VIR_PROCESS_STATS_TABLE_SIZE));
+
+    for (i = 0; i < VIR_PROCESS_STATS_MAX_PROBE; i++) {
+        virProcessStatsEntry *tmp;
+
+        tmp = &virProcessStatsTable[(hash + i) & (VIR_PROCESS_STATS_TABLE_SIZE - 1)];
+
+        if (tmp->pid == pid && tmp->tid == tid) {
+            entry = tmp;
+            break;
+        }
+
+        /* Reuse the first dropped entry unless the thread is found
+         * further on */
+        if (tmp->pid == -1 && !entry)
+            entry = tmp;
+
+        if (tmp->pid == 0) {
+            if (!entry)
+                entry = tmp;
+            break;
+        }
+    }
+
+    /* No entry is free near the hash of the thread, it is read every
+     * time */
+    if (!entry)
+        return;
+
+    g_atomic_int_set(&entry->lastUsed, g_get_monotonic_time() / G_USEC_PER_SEC);
+    virProcessStatsUpdate(entry, pid, tid, entry->flags | flags, stats);
+}
+
+
+/**
+ * virProcessGetStats:
+ * @pid: process id
+ * @tid: thread id, 0 for the whole process
+ * @maxAge: maximum age of cached statistics in milliseconds
+ * @flags: bitwise-OR of virProcessStatsFlags
+ * @stats: filled with the statistics
+ *
+ * Get statistics of thread @tid of process @pid. If @maxAge is not 0,
+ * statistics sampled at most @maxAge milliseconds ago are returned
+ * without reading anything, and the thread is sampled periodically by
+ * the sampler, if it runs, from then on.
+ *
+ * Statistics of a thread which can't be read are reported as zeros
+ * with a warning.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virProcessGetStats(pid_t pid,
+                   pid_t tid,
+                   unsigned int maxAge,
+                   unsigned int flags,
+                   virProcessStats *stats)
+{
+    if (maxAge &&
+        virProcessStatsLookup(pid, tid, maxAge, flags, stats))
+        return 0;
+
+    switch (virProcessStatsRead(pid, tid, flags, stats)) {
+    case -2:
+        virReportError(VIR_ERR_INTERNAL_ERROR,
+                       _("Unable to parse scheduler statistics of %d/%d"),
+                       (int) pid, (int) tid);
+        return -1;
+    case -1:
+        VIR_WARN("cannot parse process status data of %d/%d",
+                 (int) pid, (int) tid);
+        memset(stats, 0, sizeof(*stats));
+        return 0;
+    }
+
+    if (maxAge)
+        virProcessStatsStore(pid, tid, flags, stats);
+
+    return 0;
+}
+
+
+/*
+ * Must be called with virProcessStatsLock held. The lock is released
+ * while reading the statistics of every thread, so that lookups
+ * storing statistics of their own don't wait for the whole table to
+ * be sampled.
+ */
+static void
+virProcessStatsSample(void)
+{
+    int now = g_get_monotonic_time() / G_USEC_PER_SEC;
+    size_t i;
+
+    for (i = 0; i < VIR_PROCESS_STATS_TABLE_SIZE && virProcessStatsRunning; i++) {
+        virProcessStatsEntry *entry = &virProcessStatsTable[i];
+        virProcessStats stats;
+        pid_t pid = entry->pid;
+        pid_t tid = entry->tid;
+        unsigned int flags = entry->flags;
+        long long when = entry->when;
+        int rc;
+
+        if (pid <= 0)
+            continue;
+
+        if (now - g_atomic_int_get(&entry->lastUsed) > VIR_PROCESS_STATS_EXPIRE) {
+            virProcessStatsDrop(i);
+            continue;
+        }
+
+        virMutexUnlock(&virProcessStatsLock);
+        rc = virProcessStatsRead(pid, tid, flags, &stats);
+        virMutexLock(&virProcessStatsLock);
+
+        /* A lookup updated the entry meanwhile, or it was reused */
+        if (entry->when != when || entry->pid != pid)
+            continue;
+
+        if (rc < 0)
+            virProcessStatsDrop(i);
+        else
+            virProcessStatsUpdate(entry, pid, tid, flags, &stats);
+    }
+}
+
+
+static void
+virProcessStatsSampler(void *opaque G_GNUC_UNUSED)
+{
+    VIR_LOCK_GUARD lock = virLockGuardLock(&virProcessStatsLock);
+
+    while (virProcessStatsRunning) {
+        unsigned long long now;
+
+        if (virTimeMillisNow(&now) < 0)
+            break;
+
+        if (virCondWaitUntil(&virProcessStatsCond, &virProcessStatsLock,
+                             now + virProcessStatsInterval) < 0 &&
+            errno != ETIMEDOUT)
+            break;
+
+        if (virProcessStatsRunning && virProcessStatsTable)
+            virProcessStatsSample();
+    }
+}
+
+
+/**
+ * virProcessStatsSamplerStart:
+ * @interval: sampling interval in milliseconds
+ *
+ * Start a thread which samples the statistics of all threads looked
+ * up by virProcessGetStats every @interval milliseconds, so that the
+ * lookups don't have to read them.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+virProcessStatsSamplerStart(unsigned int interval)
+{
+    VIR_LOCK_GUARD lock = virLockGuardLock(&virProcessStatsLock);
+
+    if (virProcessStatsRunning) {
+        virProcessStatsInterval = interval;
+        return 0;
+    }
+
+    if (virCondInit(&virProcessStatsCond) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to initialize condition variable"));
+        return -1;
+    }
+
+    virProcessStatsInterval = interval;
+    virProcessStatsRunning = true;
+
+    if (virThreadCreateFull(&virProcessStatsThread, true,
+                            virProcessStatsSampler,
+                            "proc-stats", false, NULL) < 0) {
+        virReportSystemError(errno, "%s",
+                             _("Unable to create statistics sampler thread"));
+        virProcessStatsRunning = false;
+        virCondDestroy(&virProcessStatsCond);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * virProcessStatsSamplerStop:
+ *
+ * Stop the thread started by virProcessStatsSamplerStart.
+ */
+void
+virProcessStatsSamplerStop(void)
+{
+    VIR_WITH_MUTEX_LOCK_GUARD(&virProcessStatsLock) {
+        if (!virProcessStatsRunning)
+            return;
+
+        virProcessStatsRunning = false;
+        virCondSignal(&virProcessStatsCond);
+    }
+
+    virThreadJoin(&virProcessStatsThread);
+    virCondDestroy(&virProcessStatsCond);
+}
+
+#else /* !__linux__ */
+
+int
+virProcessGetStats(pid_t pid G_GNUC_UNUSED,
+                   pid_t tid G_GNUC_UNUSED,
+                   unsigned int maxAge G_GNUC_UNUSED,
+                   unsigned int flags G_GNUC_UNUSED,
+                   virProcessStats *stats)
+{
+    /* We don't have a way to collect this information on non-Linux
+     * platforms, so just report neutral values */
+    memset(stats, 0, sizeof(*stats));
+    return 0;
+}
+
+
+int
+virProcessStatsSamplerStart(unsigned int interval G_GNUC_UNUSED)
+{
+    return 0;
+}
+
+
+void
+virProcessStatsSamplerStop(void)
+{
+}
+
+#endif /* !__linux__ */
@@ -0,0 +1,47 @@
+/*
+ * virprocessstats.h: sampling of per-thread scheduler statistics
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "internal.h"
+
+typedef struct _virProcessStats virProcessStats;
+struct _virProcessStats {
+    unsigned long long cpuTime; /* user and system time in nanoseconds */
+    unsigned long long cpuWait; /* time spent waiting for a CPU in
+                                 * nanoseconds, from the sched file */
+    unsigned long long cpuDelay; /* time spent on a run queue in
+                                  * nanoseconds, from the schedstat file */
+    long rss; /* resident set size in KiB */
+    int lastCpu;
+};
+
+typedef enum {
+    /* Fill in cpuWait and cpuDelay as well */
+    VIR_PROCESS_STATS_SCHED = 1 << 0,
+} virProcessStatsFlags;
+
+int virProcessGetStats(pid_t pid,
+                       pid_t tid,
+                       unsigned int maxAge,
+                       unsigned int flags,
+                       virProcessStats *stats);
+
+int virProcessStatsSamplerStart(unsigned int interval);
+
+void virProcessStatsSamplerStop(void);
@@ -206,6 +206,135 @@ void virSysinfoDefFree(virSysinfoDef *def)
 }
 
 
+/**
+ * virSysinfoDefCopy:
+ * @src: a sysinfo structure
+ *
+ * Returns a deep copy of @src.
+ */
+virSysinfoDef *
+virSysinfoDefCopy(const virSysinfoDef *src)
+{
+    virSysinfoDef *def = g_new0(virSysinfoDef, 1);
+    size_t i;
+
+    def->type = src->type;
+
+    if (src->bios) {
+        def->bios = g_new0(virSysinfoBIOSDef, 1);
+        def->bios->vendor = g_strdup(src->bios->vendor);
+        def->bios->version = g_strdup(src->bios->version);
+        def->bios->date = g_strdup(src->bios->date);
+        def->bios->release = g_strdup(src->bios->release);
+    }
+
+    if (src->system) {
+        def->system = g_new0(virSysinfoSystemDef, 1);
+        def->system->manufacturer = g_strdup(src->system->manufacturer);
+        def->system->product = g_strdup(src->system->product);
+        def->system->version = g_strdup(src->system->version);
+        def->system->serial = g_strdup(src->system->serial);
+        def->system->uuid = g_strdup(src->system->uuid);
+        def->system->sku = g_strdup(src->system->sku);
+        def->system->family = g_strdup(src->system->family);
+    }
+
+    if (src->nbaseBoard > 0) {
+        def->baseBoard = g_new0(virSysinfoBaseBoardDef, src->nbaseBoard);
+        def->nbaseBoard = src->nbaseBoard;
+
+        for (i = 0; i < src->nbaseBoard; i++) {
+            const virSysinfoBaseBoardDef *s = &src->baseBoard[i];
+            virSysinfoBaseBoardDef *d = &def->baseBoard[i];
+
+            d->manufacturer = g_strdup(s->manufacturer);
+            d->product = g_strdup(s->product);
+            d->version = g_strdup(s->version);
+            d->serial = g_strdup(s->serial);
+            d->asset = g_strdup(s->asset);
+            d->location = g_strdup(s->location);
+        }
+    }
+
+    if (src->chassis) {
+        def->chassis = g_new0(virSysinfoChassisDef, 1);
+        def->chassis->manufacturer = g_strdup(src->chassis->manufacturer);
+        def->chassis->version = g_strdup(src->chassis->version);
+        def->chassis->serial = g_strdup(src->chassis->serial);
+        def->chassis->asset = g_strdup(src->chassis->asset);
+        def->chassis->sku = g_strdup(src->chassis->sku);
+    }
+
+    if (src->nprocessor > 0) {
+        def->processor = g_new0(virSysinfoProcessorDef, src->nprocessor);
+        def->nprocessor = src->nprocessor;
+
+        for (i = 0; i < src->nprocessor; i++) {
+            const virSysinfoProcessorDef *s = &src->processor[i];
+            virSysinfoProcessorDef *d = &def->processor[i];
+
+            d->processor_socket_destination = g_strdup(s->processor_socket_destination);
+            d->processor_type = g_strdup(s->processor_type);
+            d->processor_family = g_strdup(s->processor_family);
+            d->processor_manufacturer = g_strdup(s->processor_manufacturer);
+            d->processor_signature = g_strdup(s->processor_signature);
+            d->processor_version = g_strdup(s->processor_version);
+            d->processor_external_clock = g_strdup(s->processor_external_clock);
+            d->processor_max_speed = g_strdup(s->processor_max_speed);
+            d->processor_status = g_strdup(s->processor_status);
+            d->processor_serial_number = g_strdup(s->processor_serial_number);
+            d->processor_part_number = g_strdup(s->processor_part_number);
+        }
+    }
+
+    if (src->nmemory > 0) {
+        def->memory = g_new0(virSysinfoMemoryDef, src->nmemory);
+        def->nmemory = src->nmemory;
+
+        for (i = 0; i < src->nmemory; i++) {
+            const virSysinfoMemoryDef *s = &src->memory[i];
+            virSysinfoMemoryDef *d = &def->memory[i];
+
+            d->memory_size = g_strdup(s->memory_size);
+            d->memory_form_factor = g_strdup(s->memory_form_factor);
+            d->memory_locator = g_strdup(s->memory_locator);
+            d->memory_bank_locator = g_strdup(s->memory_bank_locator);
+            d->memory_type = g_strdup(s->memory_type);
+            d->memory_type_detail = g_strdup(s->memory_type_detail);
+            d->memory_speed = g_strdup(s->memory_speed);
+            d->memory_manufacturer = g_strdup(s->memory_manufacturer);
+            d->memory_serial_number = g_strdup(s->memory_serial_number);
+            d->memory_part_number = g_strdup(s->memory_part_number);
+        }
+    }
+
+    if (src->oemStrings) {
+        def->oemStrings = g_new0(virSysinfoOEMStringsDef, 1);
+
+        if (src->oemStrings->nvalues > 0) {
+            def->oemStrings->values = g_new0(char *, src->oemStrings->nvalues);
+            def->oemStrings->nvalues = src->oemStrings->nvalues;
+
+            for (i = 0; i < src->oemStrings->nvalues; i++)
+                def->oemStrings->values[i] = g_strdup(src->oemStrings->values[i]);
+        }
+    }
+
+    if (src->nfw_cfgs > 0) {
+        def->fw_cfgs = g_new0(virSysinfoFWCfgDef, src->nfw_cfgs);
+        def->nfw_cfgs = src->nfw_cfgs;
+
+        for (i = 0; i < src->nfw_cfgs; i++) {
+            def->fw_cfgs[i].name = g_strdup(src->fw_cfgs[i].name);
+            def->fw_cfgs[i].value = g_strdup(src->fw_cfgs[i].value);
+            def->fw_cfgs[i].file = g_strdup(src->fw_cfgs[i].file);
+        }
+    }
+
+    return def;
+}
+
+
 static bool
 virSysinfoDefIsEmpty(const virSysinfoDef *def)
 {
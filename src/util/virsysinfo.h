@@ -147,6 +147,7 @@ void virSysinfoBaseBoardDefClear(virSysinfoBaseBoardDef *def);
 void virSysinfoChassisDefFree(virSysinfoChassisDef *def);
 void virSysinfoOEMStringsDefFree(virSysinfoOEMStringsDef *def);
 void virSysinfoDefFree(virSysinfoDef *def);
+virSysinfoDef *virSysinfoDefCopy(const virSysinfoDef *src);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(virSysinfoDef, virSysinfoDefFree);
 
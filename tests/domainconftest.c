@@ -19,7 +19,9 @@
 #include <config.h>
 
 #include "testutils.h"
+#include "virfile.h"
 #include "virlog.h"
+#include "virstring.h"
 
 #include "domain_conf.h"
 
@@ -68,6 +70,101 @@ static int testGetFilesystem(const void *opaque)
     return 0;
 }
 
+
+static int
+testDefCopyNativeFile(const char *path,
+                      size_t *ncopied,
+                      gint64 *nativeTime,
+                      gint64 *xmlTime)
+{
+    unsigned int parseFlags = VIR_DOMAIN_DEF_PARSE_INACTIVE |
+                              VIR_DOMAIN_DEF_PARSE_SKIP_VALIDATE;
+    g_autoptr(virDomainDef) def = NULL;
+    g_autoptr(virDomainDef) nativeCopy = NULL;
+    g_autoptr(virDomainDef) xmlCopy = NULL;
+    g_autofree char *expect = NULL;
+    g_autofree char *actual = NULL;
+    gint64 start;
+
+    /* some of the files are expected to fail parsing */
+    if (!(def = virDomainDefParseFile(path, xmlopt, NULL, parseFlags))) {
+        virResetLastError();
+        return 0;
+    }
+
+    if (!virDomainDefCopyNativeSupported(def))
+        return 0;
+
+    start = g_get_monotonic_time();
+    if (!(nativeCopy = virDomainDefCopyNative(def, xmlopt)))
+        return -1;
+    *nativeTime += g_get_monotonic_time() - start;
+
+    start = g_get_monotonic_time();
+    if (!(xmlCopy = virDomainDefCopy(def, xmlopt, NULL, false)))
+        return -1;
+    *xmlTime += g_get_monotonic_time() - start;
+
+    if (!(expect = virDomainDefFormat(def, xmlopt, VIR_DOMAIN_DEF_FORMAT_SECURE)) ||
+        !(actual = virDomainDefFormat(nativeCopy, xmlopt, VIR_DOMAIN_DEF_FORMAT_SECURE)))
+        return -1;
+
+    if (STRNEQ(expect, actual)) {
+        VIR_TEST_VERBOSE("native copy of '%s' differs from the original", path);
+        virTestDifference(stderr, expect, actual);
+        return -1;
+    }
+
+    (*ncopied)++;
+    return 0;
+}
+
+
+/* Copies all definitions used by qemuxml2argvtest which can be copied
+ * natively and checks that the copy formats identically to the original.
+ * Run with VIR_TEST_DEBUG=1 to see the time spent compared to copying via
+ * XML. */
+static int
+testDefCopyNative(const void *opaque G_GNUC_UNUSED)
+{
+    g_autofree char *datadir = g_strdup_printf("%s/qemuxml2argvdata", abs_srcdir);
+    g_autoptr(DIR) dir = NULL;
+    struct dirent *ent;
+    gint64 nativeTime = 0;
+    gint64 xmlTime = 0;
+    size_t ncopied = 0;
+    int rc;
+
+    if (virDirOpen(&dir, datadir) < 0)
+        return -1;
+
+    while ((rc = virDirRead(dir, &ent, datadir)) > 0) {
+        g_autofree char *path = NULL;
+
+        if (!virStringHasSuffix(ent->d_name, ".xml"))
+            continue;
+
+        path = g_strdup_printf("%s/%s", datadir, ent->d_name);
+
+        if (testDefCopyNativeFile(path, &ncopied, &nativeTime, &xmlTime) < 0)
+            return -1;
+    }
+
+    if (rc < 0)
+        return -1;
+
+    if (ncopied == 0) {
+        VIR_TEST_VERBOSE("no definition was copied natively");
+        return -1;
+    }
+
+    VIR_TEST_DEBUG("copied %zu definitions natively in %lld us, via XML in %lld us",
+                   ncopied, (long long) nativeTime, (long long) xmlTime);
+
+    return 0;
+}
+
+
 static int
 mymain(void)
 {
@@ -95,6 +192,9 @@ mymain(void)
     DO_TEST_GET_FS("/dev/pts", false);
     DO_TEST_GET_FS("/doesnotexist", false);
 
+    if (virTestRun("Copy definitions natively", testDefCopyNative, NULL) < 0)
+        ret = -1;
+
     virObjectUnref(caps);
     virObjectUnref(xmlopt);
 
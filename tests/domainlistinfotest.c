@@ -0,0 +1,225 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+
+#include "virerror.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+static const char inactiveXML[] =
+"<domain type='test'>\n"
+"  <name>inactive</name>\n"
+"  <memory>1048576</memory>\n"
+"  <os>\n"
+"    <type>hvm</type>\n"
+"  </os>\n"
+"</domain>";
+
+struct testListInfoData {
+    virDomainPtr *doms;
+    unsigned int fields;
+    /* Parameters every record must or must not have */
+    const char *present;
+    const char *absent;
+};
+
+
+static bool
+testHasParams(virDomainStatsRecordPtr rec,
+              const char *names,
+              bool expect)
+{
+    g_auto(GStrv) list = g_strsplit(names, ",", 0);
+    GStrv name;
+
+    for (name = list; *name; name++) {
+        bool has = false;
+        int i;
+
+        for (i = 0; i < rec->nparams; i++) {
+            if (STREQ(rec->params[i].field, *name))
+                has = true;
+        }
+
+        if (has != expect) {
+            VIR_TEST_DEBUG("parameter '%s' of domain '%s' %s",
+                           *name, rec->dom->name,
+                           expect ? "missing" : "unexpected");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static int
+testListInfo(const void *opaque)
+{
+    const struct testListInfoData *data = opaque;
+    virDomainStatsRecordPtr *records = NULL;
+    int nrecords;
+    int ret = -1;
+    int i;
+
+    if ((nrecords = virDomainListGetInfo(data->doms, data->fields,
+                                         &records, 0)) < 0)
+        return -1;
+
+    for (i = 0; data->doms[i]; i++) {
+        if (i >= nrecords) {
+            VIR_TEST_DEBUG("got %d records, expected more", nrecords);
+            goto cleanup;
+        }
+
+        /* Records are returned in the order of the domains */
+        if (STRNEQ(records[i]->dom->name, data->doms[i]->name)) {
+            VIR_TEST_DEBUG("record %d is for '%s', expected '%s'",
+                           i, records[i]->dom->name, data->doms[i]->name);
+            goto cleanup;
+        }
+
+        if (!testHasParams(records[i], data->present, true) ||
+            (data->absent && !testHasParams(records[i], data->absent, false)))
+            goto cleanup;
+    }
+
+    if (nrecords != i) {
+        VIR_TEST_DEBUG("got %d records, expected %d", nrecords, i);
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    virDomainStatsRecordListFree(records);
+    return ret;
+}
+
+
+static int
+testListInfoState(const void *opaque)
+{
+    const struct testListInfoData *data = opaque;
+    virDomainStatsRecordPtr *records = NULL;
+    int expect[] = { VIR_DOMAIN_RUNNING, VIR_DOMAIN_SHUTOFF };
+    int state;
+    int ret = -1;
+    size_t i;
+
+    if (virDomainListGetInfo(data->doms, data->fields, &records, 0) !=
+        (int) G_N_ELEMENTS(expect))
+        return -1;
+
+    for (i = 0; i < G_N_ELEMENTS(expect); i++) {
+        if (virTypedParamsGetInt(records[i]->params, records[i]->nparams,
+                                 "state.state", &state) != 1 ||
+            state != expect[i]) {
+            VIR_TEST_DEBUG("unexpected state of '%s'", records[i]->dom->name);
+            goto cleanup;
+        }
+    }
+
+    ret = 0;
+
+ cleanup:
+    virDomainStatsRecordListFree(records);
+    return ret;
+}
+
+
+static int
+testListInfoBadFields(const void *opaque)
+{
+    const struct testListInfoData *data = opaque;
+    virDomainStatsRecordPtr *records = NULL;
+
+    if (virDomainListGetInfo(data->doms, data->fields, &records, 0) >= 0) {
+        virDomainStatsRecordListFree(records);
+        return -1;
+    }
+
+    if (virGetLastErrorCode() != VIR_ERR_INVALID_ARG) {
+        VIR_TEST_DEBUG("unexpected error: %s", virGetLastErrorMessage());
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+mymain(void)
+{
+    virConnectPtr conn = NULL;
+    virDomainPtr doms[3] = { NULL };
+    int ret = EXIT_SUCCESS;
+
+    if (!(conn = virConnectOpen("test:///default")))
+        return EXIT_FAILURE;
+
+    if (!(doms[0] = virDomainLookupByName(conn, "test")) ||
+        !(doms[1] = virDomainDefineXML(conn, inactiveXML))) {
+        ret = EXIT_FAILURE;
+        goto cleanup;
+    }
+
+    virTestQuiesceLibvirtErrors(false);
+
+#define DO_TEST_FULL(name, func, fields, present, absent) \
+    do { \
+        struct testListInfoData data = { doms, fields, present, absent }; \
+        if (virTestRun("List info " name, func, &data) < 0) \
+            ret = EXIT_FAILURE; \
+    } while (0)
+
+#define DO_TEST(name, fields, present, absent) \
+    DO_TEST_FULL(name, testListInfo, fields, present, absent)
+
+    DO_TEST("all", 0,
+            "info.state,info.max_mem,info.memory,info.nr_virt_cpu,"
+            "info.cpu_time,state.state,state.reason,xml", NULL);
+    DO_TEST("basic", VIR_DOMAIN_LIST_INFO_BASIC,
+            "info.state,info.memory", "state.state,xml");
+    DO_TEST("state", VIR_DOMAIN_LIST_INFO_STATE,
+            "state.state,state.reason", "info.state,xml");
+    DO_TEST("xml", VIR_DOMAIN_LIST_INFO_XML,
+            "xml", "info.state,state.state");
+    DO_TEST("state and xml",
+            VIR_DOMAIN_LIST_INFO_STATE | VIR_DOMAIN_LIST_INFO_XML,
+            "state.state,xml", "info.state");
+
+    DO_TEST_FULL("state values", testListInfoState,
+                 VIR_DOMAIN_LIST_INFO_STATE, NULL, NULL);
+    DO_TEST_FULL("unknown fields", testListInfoBadFields,
+                 VIR_DOMAIN_LIST_INFO_XML << 1, NULL, NULL);
+    DO_TEST_FULL("unknown fields with known", testListInfoBadFields,
+                 VIR_DOMAIN_LIST_INFO_BASIC | (1U << 31), NULL, NULL);
+
+ cleanup:
+    if (doms[0])
+        virDomainFree(doms[0]);
+    if (doms[1])
+        virDomainFree(doms[1]);
+    virConnectClose(conn);
+
+    return ret;
+}
+
+VIR_TEST_MAIN(mymain)
@@ -0,0 +1,297 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+
+#include "virerror.h"
+#include "virthread.h"
+
+#define VIR_FROM_THIS VIR_FROM_NONE
+
+#define NDOMAINS 1000
+
+struct testLookupData {
+    virConnectPtr conn;
+    virDomainPtr *doms;
+    int ndoms;
+    int stop;
+};
+
+struct testLookupThread {
+    virThread thread;
+    struct testLookupData *data;
+    GRand *rand;
+    unsigned long long nlookups;
+    bool failed;
+};
+
+
+static int
+testCreateDomains(virConnectPtr conn,
+                  const char *prefix,
+                  int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        g_autofree char *xml = NULL;
+        virDomainPtr dom;
+
+        xml = g_strdup_printf("<domain type='test'>"
+                              "  <name>%s-%d</name>"
+                              "  <memory>8192</memory>"
+                              "  <os><type>hvm</type></os>"
+                              "</domain>", prefix, i);
+
+        if (!(dom = virDomainCreateXML(conn, xml, 0)))
+            return -1;
+        virDomainFree(dom);
+    }
+
+    return 0;
+}
+
+
+static int
+testLookupDomain(virConnectPtr conn,
+                 virDomainPtr dom)
+{
+    unsigned char uuid[VIR_UUID_BUFLEN];
+    virDomainPtr found;
+
+    if (virDomainGetUUID(dom, uuid) < 0 ||
+        !(found = virDomainLookupByUUID(conn, uuid)))
+        return -1;
+    virDomainFree(found);
+
+    if (!(found = virDomainLookupByName(conn, virDomainGetName(dom))))
+        return -1;
+    virDomainFree(found);
+
+    if (!(found = virDomainLookupByID(conn, virDomainGetID(dom))))
+        return -1;
+    virDomainFree(found);
+
+    return 0;
+}
+
+
+static int
+testLookup(const void *opaque)
+{
+    const struct testLookupData *data = opaque;
+    virDomainPtr dom;
+    int id;
+    int i;
+
+    for (i = 0; i < data->ndoms; i++) {
+        if (testLookupDomain(data->conn, data->doms[i]) < 0) {
+            VIR_TEST_DEBUG("failed to look up domain '%s'",
+                           virDomainGetName(data->doms[i]));
+            return -1;
+        }
+    }
+
+    /* The ID of a destroyed domain must not be found anymore, even
+     * though it was looked up before */
+    if (testCreateDomains(data->conn, "lookup-destroyed", 1) < 0 ||
+        !(dom = virDomainLookupByName(data->conn, "lookup-destroyed-0")))
+        return -1;
+
+    id = virDomainGetID(dom);
+    if (testLookupDomain(data->conn, dom) < 0 ||
+        virDomainDestroy(dom) < 0) {
+        virDomainFree(dom);
+        return -1;
+    }
+    virDomainFree(dom);
+
+    if ((dom = virDomainLookupByID(data->conn, id))) {
+        VIR_TEST_DEBUG("destroyed domain found by ID %d", id);
+        virDomainFree(dom);
+        return -1;
+    }
+    virResetLastError();
+
+    return 0;
+}
+
+
+/* Look up random domains by UUID, name and ID until told to stop */
+static void
+testLookupBenchReader(void *opaque)
+{
+    struct testLookupThread *thr = opaque;
+    struct testLookupData *data = thr->data;
+
+    while (!g_atomic_int_get(&data->stop)) {
+        int i = g_rand_int_range(thr->rand, 0, data->ndoms);
+
+        if (testLookupDomain(data->conn, data->doms[i]) < 0) {
+            thr->failed = true;
+            break;
+        }
+
+        thr->nlookups += 3;
+    }
+}
+
+
+/* Keep adding and removing a domain until told to stop */
+static void
+testLookupBenchWriter(void *opaque)
+{
+    struct testLookupThread *thr = opaque;
+    struct testLookupData *data = thr->data;
+
+    while (!g_atomic_int_get(&data->stop)) {
+        virDomainPtr dom;
+
+        if (testCreateDomains(data->conn, "lookup-writer", 1) < 0 ||
+            !(dom = virDomainLookupByName(data->conn, "lookup-writer-0"))) {
+            thr->failed = true;
+            break;
+        }
+        virDomainDestroy(dom);
+        virDomainFree(dom);
+    }
+}
+
+
+static int
+testLookupBenchRun(struct testLookupData *data,
+                   size_t nthreads,
+                   bool writer)
+{
+    g_autofree struct testLookupThread *threads = NULL;
+    struct testLookupThread writerThr = { .data = data };
+    unsigned long long nlookups = 0;
+    unsigned long long start;
+    double elapsed;
+    size_t nstarted;
+    size_t i;
+    int ret = 0;
+
+    threads = g_new0(struct testLookupThread, nthreads);
+    g_atomic_int_set(&data->stop, 0);
+    start = g_get_monotonic_time();
+
+    if (writer &&
+        virThreadCreate(&writerThr.thread, true,
+                        testLookupBenchWriter, &writerThr) < 0)
+        return -1;
+
+    for (nstarted = 0; nstarted < nthreads; nstarted++) {
+        threads[nstarted].data = data;
+        threads[nstarted].rand = g_rand_new_with_seed(nstarted);
+        if (virThreadCreate(&threads[nstarted].thread, true,
+                            testLookupBenchReader, &threads[nstarted]) < 0) {
+            g_rand_free(threads[nstarted].rand);
+            ret = -1;
+            break;
+        }
+    }
+
+    if (ret == 0)
+        g_usleep(G_USEC_PER_SEC);
+    g_atomic_int_set(&data->stop, 1);
+
+    for (i = 0; i < nstarted; i++) {
+        virThreadJoin(&threads[i].thread);
+        g_rand_free(threads[i].rand);
+        if (threads[i].failed)
+            ret = -1;
+        nlookups += threads[i].nlookups;
+    }
+    if (writer) {
+        virThreadJoin(&writerThr.thread);
+        if (writerThr.failed)
+            ret = -1;
+    }
+    elapsed = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+
+    if (ret == 0)
+        VIR_TEST_VERBOSE("%3zu threads%s %12.0f lookups/s",
+                         nthreads, writer ? " + writer" : "         ",
+                         nlookups / elapsed);
+
+    return ret;
+}
+
+
+/*
+ * Benchmark of the number of lookups by UUID, name and ID per second
+ * from an increasing number of threads sharing one connection, with
+ * and without another thread creating and destroying domains. Only
+ * run with VIR_TEST_EXPENSIVE=1, the results are printed with
+ * VIR_TEST_VERBOSE=1.
+ */
+static int
+testLookupBench(const void *opaque)
+{
+    struct testLookupData *data = (struct testLookupData *) opaque;
+    size_t nthreads;
+
+    if (virTestGetExpensive() == 0)
+        return EXIT_AM_SKIP;
+
+    for (nthreads = 1; nthreads <= 8; nthreads *= 2) {
+        if (testLookupBenchRun(data, nthreads, false) < 0 ||
+            testLookupBenchRun(data, nthreads, true) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+mymain(void)
+{
+    struct testLookupData data = { 0 };
+    int ret = EXIT_SUCCESS;
+    int i;
+
+    if (!(data.conn = virConnectOpen("test:///default")))
+        return EXIT_FAILURE;
+
+    if (testCreateDomains(data.conn, "lookup", NDOMAINS) < 0 ||
+        (data.ndoms = virConnectListAllDomains(data.conn, &data.doms,
+                                               VIR_CONNECT_LIST_DOMAINS_ACTIVE)) <= 0) {
+        ret = EXIT_FAILURE;
+        goto cleanup;
+    }
+
+    virTestQuiesceLibvirtErrors(false);
+
+    if (virTestRun("Domain lookup", testLookup, &data) < 0)
+        ret = EXIT_FAILURE;
+
+    if (virTestRun("Domain lookup benchmark", testLookupBench, &data) < 0)
+        ret = EXIT_FAILURE;
+
+ cleanup:
+    for (i = 0; i < data.ndoms; i++)
+        virDomainFree(data.doms[i]);
+    g_free(data.doms);
+    virConnectClose(data.conn);
+
+    return ret;
+}
+
+VIR_TEST_MAIN(mymain)
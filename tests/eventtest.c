@@ -33,6 +33,8 @@
 #include "virfile.h"
 #include "virlog.h"
 #include "virutil.h"
+#include "vireventglib.h"
+#include "vireventthread.h"
 
 VIR_LOG_INIT("tests.eventtest");
 
@@ -59,6 +61,21 @@ static struct timerInfo {
     int delete;
 } timers[NUM_TIME];
 
+/* Handle and timer dispatched by a virEventThread rather than
+ * by the default event loop */
+static struct contextInfo {
+    GMainContext *context;
+    int pipeFD[2];
+    int watch;
+    int timer;
+    bool handleFired;
+    bool handleOwner;
+    bool handleFreed;
+    bool handleFreeOwner;
+    bool timerFired;
+    bool timerOwner;
+} ctxinfo;
+
 enum {
     EV_ERROR_NONE,
     EV_ERROR_WATCH,
@@ -169,6 +186,122 @@ testTimer(int timer, void *data)
     pthread_mutex_unlock(&eventThreadMutex);
 }
 
+static void
+testContextPipeReader(int watch G_GNUC_UNUSED,
+                      int fd,
+                      int events G_GNUC_UNUSED,
+                      void *data)
+{
+    struct contextInfo *info = data;
+    char one;
+
+    pthread_mutex_lock(&eventThreadMutex);
+    ignore_value(read(fd, &one, 1));
+    info->handleFired = true;
+    info->handleOwner = g_main_context_is_owner(info->context);
+    pthread_cond_broadcast(&eventThreadCond);
+    pthread_mutex_unlock(&eventThreadMutex);
+}
+
+
+static void
+testContextPipeFree(void *data)
+{
+    struct contextInfo *info = data;
+
+    pthread_mutex_lock(&eventThreadMutex);
+    info->handleFreed = true;
+    info->handleFreeOwner = g_main_context_is_owner(info->context);
+    pthread_cond_broadcast(&eventThreadCond);
+    pthread_mutex_unlock(&eventThreadMutex);
+}
+
+
+static void
+testContextTimer(int timer,
+                 void *data)
+{
+    struct contextInfo *info = data;
+
+    pthread_mutex_lock(&eventThreadMutex);
+    info->timerFired = true;
+    info->timerOwner = g_main_context_is_owner(info->context);
+    virEventUpdateTimeout(timer, -1);
+    pthread_cond_broadcast(&eventThreadCond);
+    pthread_mutex_unlock(&eventThreadMutex);
+}
+
+
+static int
+testEventContext(void)
+{
+    virEventThread *evt;
+    char one = '1';
+    const char *name = "Dispatch from context";
+    const char *msg = NULL;
+
+    if (!(evt = virEventThreadNew("test-event")))
+        return EXIT_FAILURE;
+
+    ctxinfo.context = virEventThreadGetContext(evt);
+
+    if (virPipeQuiet(ctxinfo.pipeFD) < 0) {
+        g_object_unref(evt);
+        return EXIT_FAILURE;
+    }
+
+    ctxinfo.watch = virEventGLibHandleAddContext(ctxinfo.context,
+                                                 ctxinfo.pipeFD[0],
+                                                 VIR_EVENT_HANDLE_READABLE,
+                                                 testContextPipeReader,
+                                                 &ctxinfo,
+                                                 testContextPipeFree);
+    ctxinfo.timer = virEventGLibTimeoutAddContext(ctxinfo.context, 10,
+                                                  testContextTimer,
+                                                  &ctxinfo, NULL);
+
+    if (ctxinfo.watch < 0 || ctxinfo.timer < 0) {
+        msg = "Failed to add handle or timer\n";
+        goto cleanup;
+    }
+
+    if (safewrite(ctxinfo.pipeFD[1], &one, 1) != 1) {
+        msg = "Failed to write to pipe\n";
+        goto cleanup;
+    }
+
+    pthread_mutex_lock(&eventThreadMutex);
+    while (!ctxinfo.handleFired || !ctxinfo.timerFired)
+        pthread_cond_wait(&eventThreadCond, &eventThreadMutex);
+    pthread_mutex_unlock(&eventThreadMutex);
+
+    virEventRemoveHandle(ctxinfo.watch);
+    virEventRemoveTimeout(ctxinfo.timer);
+
+    pthread_mutex_lock(&eventThreadMutex);
+    while (!ctxinfo.handleFreed)
+        pthread_cond_wait(&eventThreadCond, &eventThreadMutex);
+    pthread_mutex_unlock(&eventThreadMutex);
+
+    if (!ctxinfo.handleOwner)
+        msg = "Handle wasn't dispatched by the owning loop\n";
+    else if (!ctxinfo.timerOwner)
+        msg = "Timer wasn't dispatched by the owning loop\n";
+    else if (!ctxinfo.handleFreeOwner)
+        msg = "Handle wasn't freed by the owning loop\n";
+
+ cleanup:
+    if (msg)
+        testEventReport(name, true, "%s", msg);
+    else
+        testEventReport(name, false, NULL);
+    g_object_unref(evt);
+    VIR_FORCE_CLOSE(ctxinfo.pipeFD[0]);
+    VIR_FORCE_CLOSE(ctxinfo.pipeFD[1]);
+    return msg ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
 G_GNUC_NORETURN static void *eventThreadLoop(void *data G_GNUC_UNUSED) {
     while (1)
         virEventRunDefaultImpl();
@@ -491,6 +624,11 @@ mymain(void)
     if (finishJob("Write duplicate", 1, -1) != EXIT_SUCCESS)
         return EXIT_FAILURE;
 
+    /* Handles and timers added to the context of another loop are
+     * dispatched and freed by the thread running that loop */
+    if (testEventContext() != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
     /* pthread_kill(eventThread, SIGTERM); */
 
     return EXIT_SUCCESS;
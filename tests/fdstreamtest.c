@@ -159,6 +159,102 @@ static int testFDStreamReadNonblock(const void *data)
 }
 
 
+#define LARGE_CHUNK_LEN (1024 * 1024)
+
+/* Reads done in large chunks must not be split up into the default
+ * size the helper thread reads regular files in */
+static int testFDStreamReadLarge(const void *data)
+{
+    const char *scratchdir = data;
+    VIR_AUTOCLOSE fd = -1;
+    g_autofree char *file = NULL;
+    g_autofree char *pattern = NULL;
+    g_autofree char *buf = NULL;
+    virStreamPtr st = NULL;
+    virConnectPtr conn = NULL;
+    size_t total = 0;
+    int maxGot = 0;
+    size_t i;
+    int ret = -1;
+
+    if (!(conn = virConnectOpen("test:///default")))
+        goto cleanup;
+
+    pattern = g_new0(char, 4 * LARGE_CHUNK_LEN);
+    buf = g_new0(char, LARGE_CHUNK_LEN);
+
+    for (i = 0; i < 4 * LARGE_CHUNK_LEN; i++)
+        pattern[i] = i % 251;
+
+    file = g_strdup_printf("%s/input-large.data", scratchdir);
+
+    if ((fd = open(file, O_CREAT|O_WRONLY|O_EXCL, 0600)) < 0)
+        goto cleanup;
+
+    if (safewrite(fd, pattern, 4 * LARGE_CHUNK_LEN) != 4 * LARGE_CHUNK_LEN)
+        goto cleanup;
+
+    if (VIR_CLOSE(fd) < 0)
+        goto cleanup;
+
+    if (!(st = virStreamNew(conn, 0)))
+        goto cleanup;
+
+    if (virFDStreamOpenFile(st, file, 0, 0, O_RDONLY) < 0)
+        goto cleanup;
+
+    for (;;) {
+        int got = st->driver->streamRecv(st, buf, LARGE_CHUNK_LEN);
+
+        if (got < 0) {
+            fprintf(stderr, "Failed to read stream: %s\n",
+                    virGetLastErrorMessage());
+            goto cleanup;
+        }
+
+        if (got == 0)
+            break;
+
+        if (total + got > 4 * LARGE_CHUNK_LEN ||
+            memcmp(buf, pattern + total, got) != 0) {
+            fprintf(stderr, "Mismatched pattern data at offset %zu\n", total);
+            goto cleanup;
+        }
+
+        total += got;
+        maxGot = MAX(maxGot, got);
+    }
+
+    if (total != 4 * LARGE_CHUNK_LEN) {
+        fprintf(stderr, "Expected %d bytes, got %zu\n",
+                4 * LARGE_CHUNK_LEN, total);
+        goto cleanup;
+    }
+
+    if (maxGot != LARGE_CHUNK_LEN) {
+        fprintf(stderr, "Expected chunks of %d bytes, largest was %d\n",
+                LARGE_CHUNK_LEN, maxGot);
+        goto cleanup;
+    }
+
+    if (st->driver->streamFinish(st) != 0) {
+        fprintf(stderr, "Failed to finish stream: %s\n",
+                virGetLastErrorMessage());
+        goto cleanup;
+    }
+
+    ret = 0;
+ cleanup:
+    if (st)
+        virStreamFree(st);
+    if (file != NULL)
+        unlink(file);
+    if (conn)
+        virConnectClose(conn);
+    return ret;
+}
+
+
 static int testFDStreamWriteCommon(const char *scratchdir, bool blocking)
 {
     VIR_AUTOCLOSE fd = -1;
@@ -314,6 +410,8 @@ mymain(void)
         ret = -1;
     if (virTestRun("Stream read non-blocking ", testFDStreamReadNonblock, scratchdir) < 0)
         ret = -1;
+    if (virTestRun("Stream read large chunks ", testFDStreamReadLarge, scratchdir) < 0)
+        ret = -1;
     if (virTestRun("Stream write blocking ", testFDStreamWriteBlock, scratchdir) < 0)
         ret = -1;
     if (virTestRun("Stream write non-blocking ", testFDStreamWriteNonblock, scratchdir) < 0)
@@ -40,6 +40,8 @@ struct _testQemuData {
     const char *version;
     const char *archName;
     const char *suffix;
+    long long xmlLoadTime;
+    long long binaryLoadTime;
     int ret;
 };
 
@@ -52,6 +54,8 @@ testQemuDataInit(testQemuData *data)
 
     data->outputDir = TEST_QEMU_CAPS_PATH;
 
+    data->xmlLoadTime = 0;
+    data->binaryLoadTime = 0;
     data->ret = 0;
 
     return 0;
@@ -163,6 +167,65 @@ testQemuCapsCopy(const void *opaque)
 }
 
 
+/*
+ * Checks that the binary capabilities cache stores the same data as the XML
+ * one. Run with VIR_TEST_DEBUG=1 to see the time spent loading the whole
+ * corpus from either format.
+ */
+static int
+testQemuCapsBinary(const void *opaque)
+{
+    testQemuData *data = (void *) opaque;
+    virArch arch = virArchFromString(data->archName);
+    g_autofree char *capsFile = NULL;
+    g_autofree char *binary = NULL;
+    g_autoptr(virQEMUCaps) orig = NULL;
+    g_autoptr(virQEMUCaps) loaded = NULL;
+    g_autofree char *bin = NULL;
+    g_autofree char *actual = NULL;
+    long long start;
+    size_t len;
+
+    capsFile = g_strdup_printf("%s/%s_%s.%s.xml",
+                               data->outputDir, data->prefix, data->version,
+                               data->archName);
+    binary = g_strdup_printf("/usr/bin/qemu-system-%s",
+                             virArchToString(arch));
+
+    start = g_get_monotonic_time();
+    if (!(orig = qemuTestParseCapabilitiesArch(arch, capsFile)))
+        return -1;
+    data->xmlLoadTime += g_get_monotonic_time() - start;
+
+    bin = virQEMUCapsFormatCacheBinary(orig, &len);
+
+    start = g_get_monotonic_time();
+    if (!(loaded = virQEMUCapsNewBinary(binary)) ||
+        virQEMUCapsLoadCacheBinary(arch, loaded, bin, len, true) != 0)
+        return -1;
+    data->binaryLoadTime += g_get_monotonic_time() - start;
+
+    if (!(actual = virQEMUCapsFormatCache(loaded)))
+        return -1;
+
+    if (virTestCompareToFile(actual, capsFile) < 0)
+        return -1;
+
+    /* truncated data must be rejected */
+    g_clear_pointer(&loaded, virObjectUnref);
+    if (!(loaded = virQEMUCapsNewBinary(binary)))
+        return -1;
+
+    if (virQEMUCapsLoadCacheBinary(arch, loaded, bin, len - 1, true) != -1) {
+        VIR_TEST_VERBOSE("truncated binary cache was accepted");
+        return -1;
+    }
+    virResetLastError();
+
+    return 0;
+}
+
+
 static int
 doCapsTest(const char *inputDir,
            const char *prefix,
@@ -174,9 +237,11 @@ doCapsTest(const char *inputDir,
     testQemuData *data = (testQemuData *) opaque;
     g_autofree char *title = NULL;
     g_autofree char *copyTitle = NULL;
+    g_autofree char *binaryTitle = NULL;
 
     title = g_strdup_printf("%s (%s)", version, archName);
     copyTitle = g_strdup_printf("copy %s (%s)", version, archName);
+    binaryTitle = g_strdup_printf("binary %s (%s)", version, archName);
 
     data->inputDir = inputDir;
     data->prefix = prefix;
@@ -190,6 +255,9 @@ doCapsTest(const char *inputDir,
     if (virTestRun(copyTitle, testQemuCapsCopy, data) < 0)
         data->ret = -1;
 
+    if (virTestRun(binaryTitle, testQemuCapsBinary, data) < 0)
+        data->ret = -1;
+
     return 0;
 }
 
@@ -207,6 +275,10 @@ mymain(void)
     if (testQemuCapsIterate(".replies", doCapsTest, &data) < 0)
         return EXIT_FAILURE;
 
+    VIR_TEST_DEBUG("loaded capabilities corpus from XML in %lld us, "
+                   "from binary cache in %lld us",
+                   data.xmlLoadTime, data.binaryLoadTime);
+
     /*
      * Run "tests/qemucapsprobe /path/to/qemu/binary >foo.replies"
      * to generate updated or new *.replies data files.
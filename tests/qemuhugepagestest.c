@@ -0,0 +1,320 @@
+#include <config.h>
+
+#include "testutils.h"
+
+#ifdef WITH_QEMU
+
+# include "virbuffer.h"
+# include "virfile.h"
+# include "virfilewrapper.h"
+# include "virhostmem.h"
+# include "virnuma.h"
+# include "viruuid.h"
+
+# define LIBVIRT_QEMU_HUGEPAGESPRIV_H_ALLOW
+# include "qemu/qemu_hugepagespriv.h"
+
+# define VIR_FROM_THIS VIR_FROM_QEMU
+
+/* Size of default huge pages on the mocked host */
+# define DEFAULT_PAGESIZE 2048
+
+static virDomainXMLOption *xmlopt;
+
+struct testInfo {
+    const char *name; /* domain under test */
+    const char *running; /* domain holding its pages already, may be NULL */
+    unsigned int flags;
+    const char *expect; /* NULL if the domain must be refused */
+};
+
+
+static virDomainDef *
+testParseDomain(const char *name)
+{
+    g_autofree char *path = NULL;
+
+    path = g_strdup_printf("%s/qemuhugepagesdata/%s.xml", abs_srcdir, name);
+
+    return virDomainDefParseFile(path, xmlopt, NULL,
+                                 VIR_DOMAIN_DEF_PARSE_INACTIVE);
+}
+
+
+static int
+testCheckResult(virBuffer *buf,
+                const char *expect)
+{
+    g_autofree char *actual = NULL;
+
+    virBufferTrim(buf, " ");
+    actual = virBufferContentAndReset(buf);
+
+    if (STRNEQ(NULLSTR_EMPTY(actual), expect)) {
+        VIR_TEST_DEBUG("expected '%s', got '%s'", expect, NULLSTR_EMPTY(actual));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Put the pools grown by a test back to their size in sysfs. The pages
+ * added to a pool are free, so are those taken away again.
+ */
+static int
+testResetPools(void)
+{
+    const unsigned int sizes[] = { 2048, 1048576 };
+    unsigned long long pool;
+    int node;
+    size_t i;
+
+    for (node = 0; node <= virNumaGetMaxNode(); node++) {
+        for (i = 0; i < G_N_ELEMENTS(sizes); i++) {
+            if (virFileReadValueUllong(&pool,
+                                       "/sys/devices/system/node/node%d/hugepages/hugepages-%ukB/nr_hugepages",
+                                       node, sizes[i]) < 0 ||
+                virNumaSetPagePoolSize(node, sizes[i], pool, false) < 0)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+/* Demands are formatted as 'pagesize:nodeset:pages', followed by
+ * ':loose' if the nodeset is merely preferred */
+static int
+testGetDemands(const void *opaque)
+{
+    const struct testInfo *info = opaque;
+    g_autoptr(virDomainDef) def = NULL;
+    g_autofree qemuHugepagesDemand *demands = NULL;
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    size_t ndemands = 0;
+    size_t i;
+
+    if (!(def = testParseDomain(info->name)))
+        return -1;
+
+    if (qemuHugepagesGetDemands(def, NULL, DEFAULT_PAGESIZE,
+                                &demands, &ndemands) < 0)
+        return -1;
+
+    for (i = 0; i < ndemands; i++) {
+        g_autofree char *nodeset = NULL;
+
+        if (demands[i].nodeset &&
+            !(nodeset = virBitmapFormat(demands[i].nodeset)))
+            return -1;
+
+        virBufferAsprintf(&buf, "%u:%s:%llu%s ",
+                          demands[i].pagesize, NULLSTR_STAR(nodeset),
+                          demands[i].pages, demands[i].strict ? "" : ":loose");
+    }
+
+    return testCheckResult(&buf, info->expect);
+}
+
+
+/* Reservations are formatted as 'node:pagesize:pages' */
+static int
+testReserve(const void *opaque)
+{
+    const struct testInfo *info = opaque;
+    g_autoptr(qemuHugepages) hugepages = NULL;
+    g_autoptr(virDomainDef) running = NULL;
+    g_autoptr(virDomainDef) def = NULL;
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    char uuidstr[VIR_UUID_STRING_BUFLEN];
+    qemuHugepagesDomain *dom;
+    size_t i;
+    int rc;
+
+    if (!(hugepages = qemuHugepagesNew()))
+        return -1;
+
+    if (info->running &&
+        (!(running = testParseDomain(info->running)) ||
+         qemuHugepagesReserve(hugepages, running, NULL, DEFAULT_PAGESIZE,
+                              QEMU_HUGEPAGES_RESERVE_CHECK) < 0))
+        return -1;
+
+    if (!(def = testParseDomain(info->name)))
+        return -1;
+
+    rc = qemuHugepagesReserve(hugepages, def, NULL, DEFAULT_PAGESIZE,
+                              info->flags);
+
+    if (testResetPools() < 0)
+        return -1;
+
+    virUUIDFormat(def->uuid, uuidstr);
+    dom = g_hash_table_lookup(hugepages->domains, uuidstr);
+
+    if (!info->expect) {
+        if (rc == 0 || dom) {
+            VIR_TEST_DEBUG("domain '%s' was not refused", info->name);
+            return -1;
+        }
+        virResetLastError();
+        return 0;
+    }
+
+    if (rc < 0)
+        return -1;
+
+    for (i = 0; dom && i < dom->nreservations; i++) {
+        virBufferAsprintf(&buf, "%d:%u:%llu ",
+                          dom->reservations[i].node,
+                          dom->reservations[i].pagesize,
+                          dom->reservations[i].pages);
+    }
+
+    return testCheckResult(&buf, info->expect);
+}
+
+
+/* Free pages of both sizes on both nodes, as qemuNodeGetFreePages()
+ * gets them with @flags while domain @running holds its pages */
+static int
+testFreePages(const void *opaque)
+{
+    const struct testInfo *info = opaque;
+    g_autoptr(qemuHugepages) hugepages = NULL;
+    g_autoptr(virDomainDef) running = NULL;
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    unsigned int pages[] = { 2048, 1048576 };
+    unsigned long long counts[4];
+    int ncounts;
+    size_t i;
+
+    if (!(hugepages = qemuHugepagesNew()))
+        return -1;
+
+    if (!(running = testParseDomain(info->running)) ||
+        qemuHugepagesReserve(hugepages, running, NULL, DEFAULT_PAGESIZE,
+                             QEMU_HUGEPAGES_RESERVE_CHECK) < 0)
+        return -1;
+
+    if ((ncounts = virHostMemGetFreePages(G_N_ELEMENTS(pages), pages,
+                                          0, 2, virNumaGetMaxNode(),
+                                          counts)) < 0)
+        return -1;
+
+    if ((info->flags & VIR_NODE_FREE_PAGES_UNRESERVED) &&
+        qemuHugepagesAdjustFreePages(hugepages, G_N_ELEMENTS(pages), pages,
+                                     0, counts, ncounts) < 0)
+        return -1;
+
+    for (i = 0; i < (size_t) ncounts; i++)
+        virBufferAsprintf(&buf, "%llu ", counts[i]);
+
+    return testCheckResult(&buf, info->expect);
+}
+
+
+static int
+mymain(void)
+{
+    g_autofree char *system = NULL;
+    int ret = 0;
+
+    system = g_strdup_printf("%s/qemuhugepagesdata/system", abs_srcdir);
+    virFileWrapperAddPrefix("/sys/devices/system", system);
+
+    if (!(xmlopt = virTestGenericDomainXMLConfInit()))
+        return EXIT_FAILURE;
+
+# define DO_TEST_FULL(desc, func, _name, _running, _flags, _expect) \
+    do { \
+        struct testInfo info = { \
+            .name = _name, \
+            .running = _running, \
+            .flags = _flags, \
+            .expect = _expect, \
+        }; \
+        if (virTestRun(desc " " _name, func, &info) < 0) \
+            ret = -1; \
+    } while (0)
+
+# define DO_TEST_DEMANDS(name, expect) \
+    DO_TEST_FULL("demands", testGetDemands, name, NULL, 0, expect)
+
+# define DO_TEST_RESERVE_FULL(name, running, flags, expect) \
+    DO_TEST_FULL("reserve", testReserve, name, running, flags, expect)
+
+# define DO_TEST_RESERVE(name, running, expect) \
+    DO_TEST_RESERVE_FULL(name, running, QEMU_HUGEPAGES_RESERVE_CHECK, expect)
+
+# define DO_TEST_RESERVE_GROW(name, running, expect) \
+    DO_TEST_RESERVE_FULL(name, running, \
+                         QEMU_HUGEPAGES_RESERVE_CHECK | \
+                         QEMU_HUGEPAGES_RESERVE_GROW, expect)
+
+# define DO_TEST_FREE(running, flags, expect) \
+    DO_TEST_FULL("free pages " #flags, testFreePages, \
+                 running, running, flags, expect)
+
+    /* The host has two nodes, node 0 with 512 free pages of 2 MiB out of
+     * 512, node 1 with 384 free out of 512, each with 2 free pages of
+     * 1 GiB */
+
+    DO_TEST_DEMANDS("none", "");
+    DO_TEST_DEMANDS("default", "2048:*:512");
+    DO_TEST_DEMANDS("pagesize", "1048576:0:2");
+    DO_TEST_DEMANDS("strict", "2048:1:512");
+    DO_TEST_DEMANDS("preferred", "2048:1:512:loose");
+    DO_TEST_DEMANDS("interleave", "2048:1:512:loose");
+    /* Page sizes come from the <hugepages> nodeset of each guest node */
+    DO_TEST_DEMANDS("cells", "2048:0:256 1048576:1:1:loose");
+    /* Modules without a page size take that of their guest node */
+    DO_TEST_DEMANDS("dimm", "2048:0:512 1048576:1:1");
+
+    DO_TEST_RESERVE("none", NULL, "");
+    DO_TEST_RESERVE("default", NULL, "0:2048:512");
+    DO_TEST_RESERVE("pagesize", NULL, "0:1048576:2");
+    DO_TEST_RESERVE("cells", NULL, "0:2048:256 1:1048576:1");
+    DO_TEST_RESERVE("dimm", NULL, "0:2048:512 1:1048576:1");
+    DO_TEST_RESERVE("spread", NULL, "0:2048:512 1:2048:256");
+
+    /* Strict binding can't fall back to other nodes, the pool has to grow */
+    DO_TEST_RESERVE("strict", NULL, NULL);
+    DO_TEST_RESERVE_GROW("strict", NULL, "1:2048:512");
+
+    /* Preferred nodes are not a hard limit */
+    DO_TEST_RESERVE("preferred", NULL, "1:2048:384 0:2048:128");
+    DO_TEST_RESERVE("interleave", NULL, "1:2048:384 0:2048:128");
+
+    /* Pages of running domains are not given to others */
+    DO_TEST_RESERVE("strict", "spread", NULL);
+    DO_TEST_RESERVE("preferred", "default", NULL);
+    DO_TEST_RESERVE("spread", "default", NULL);
+    DO_TEST_RESERVE_GROW("spread", "default", "1:2048:384 0:2048:384");
+
+    /* A domain being reconnected to holds its pages already */
+    DO_TEST_RESERVE_FULL("strict", "spread", 0, "1:2048:512");
+
+    DO_TEST_FREE("spread", 0, "512 2 384 2");
+    DO_TEST_FREE("spread", VIR_NODE_FREE_PAGES_UNRESERVED, "0 2 256 2");
+    DO_TEST_FREE("cells", VIR_NODE_FREE_PAGES_UNRESERVED, "256 2 384 1");
+
+    virObjectUnref(xmlopt);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN_PRELOAD(mymain, VIR_TEST_MOCK("virnuma"))
+
+#else
+
+int
+main(void)
+{
+    return EXIT_AM_SKIP;
+}
+
+#endif /* WITH_QEMU */
@@ -1712,6 +1712,246 @@ testQemuMonitorJSONqemuMonitorJSONGetAllBlockStatsInfo(const void *opaque)
 }
 
 
+/* Feeds the query-blockstats reply of a real QEMU, which has many members
+ * libvirt doesn't use, through the selective parsing of the reply */
+static int
+testQemuMonitorJSONGetAllBlockStatsInfoFiltered(const void *opaque)
+{
+    const testGenericData *data = opaque;
+    g_autoptr(GHashTable) blockstats = virHashNew(g_free);
+    g_autoptr(qemuMonitorTest) test = NULL;
+    g_autoptr(virJSONValue) devices = NULL;
+    g_autoptr(virJSONValue) reply = virJSONValueNewObject();
+    g_autofree char *replystr = NULL;
+    const char *names[] = { "virtio-disk0", "virtio-disk0.1", "virtio-disk0.2",
+                            "#block187", "#block306", "#block558" };
+    qemuBlockStats *stats;
+    size_t i;
+
+    if (!(devices = virTestLoadFileJSON("qemumonitorjsondata/qemumonitorjson-nodename-basic-blockstats.json",
+                                        NULL)))
+        return -1;
+
+    if (virJSONValueObjectAppend(reply, "return", &devices) < 0 ||
+        virJSONValueObjectAppendString(reply, "id", "libvirt-1") < 0)
+        return -1;
+
+    if (!(replystr = virJSONValueToString(reply, false)))
+        return -1;
+
+    if (!(test = qemuMonitorTestNewSchema(data->xmlopt, data->schema)))
+        return -1;
+
+    if (qemuMonitorTestAddItem(test, "query-blockstats", replystr) < 0 ||
+        qemuMonitorTestAddItem(test, "query-blockstats", replystr) < 0)
+        return -1;
+
+    if (qemuMonitorJSONGetAllBlockStatsInfo(qemuMonitorTestGetMonitor(test),
+                                            blockstats) < 0)
+        return -1;
+
+    /* the backing chain and node names must survive the filter */
+    if (virHashSize(blockstats) != (ssize_t) G_N_ELEMENTS(names)) {
+        VIR_TEST_VERBOSE("expected %zu block stats entries, got %zd",
+                         G_N_ELEMENTS(names), virHashSize(blockstats));
+        return -1;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(names); i++) {
+        if (!virHashLookup(blockstats, names[i])) {
+            VIR_TEST_VERBOSE("block stats for '%s' are missing", names[i]);
+            return -1;
+        }
+    }
+
+    stats = virHashLookup(blockstats, "virtio-disk0");
+
+#define CHECK(var, value) \
+    if (stats->var != value) { \
+        VIR_TEST_VERBOSE("invalid " #var " value: %llu, expected %llu", \
+                         (unsigned long long) stats->var, \
+                         (unsigned long long) value); \
+        return -1; \
+    }
+
+    CHECK(rd_req, 4038ULL);
+    CHECK(rd_bytes, 76399104ULL);
+    CHECK(rd_total_times, 11065169148ULL);
+    CHECK(wr_req, 129ULL);
+    CHECK(wr_bytes, 6517248ULL);
+    CHECK(wr_total_times, 4803102521ULL);
+    CHECK(flush_req, 10ULL);
+    CHECK(flush_total_times, 452246313ULL);
+    CHECK(wr_highest_offset, 32899072ULL);
+    CHECK(wr_highest_offset_valid, true);
+
+#undef CHECK
+
+    return 0;
+}
+
+
+static int
+testQemuMonitorJSONqemuMonitorJSONGetMemoryStats(const void *opaque)
+{
+    const testGenericData *data = opaque;
+    g_autoptr(qemuMonitorTest) test = NULL;
+    char balloonpath[] = "/machine/peripheral/balloon0";
+    virDomainMemoryStatStruct stats[VIR_DOMAIN_MEMORY_STAT_NR] = { 0 };
+    virDomainMemoryStatStruct expect[] = {
+        { VIR_DOMAIN_MEMORY_STAT_ACTUAL_BALLOON, 1048576 },
+        { VIR_DOMAIN_MEMORY_STAT_SWAP_IN, 0 },
+        { VIR_DOMAIN_MEMORY_STAT_SWAP_OUT, 0 },
+        { VIR_DOMAIN_MEMORY_STAT_MAJOR_FAULT, 951 },
+        { VIR_DOMAIN_MEMORY_STAT_MINOR_FAULT, 697283 },
+        { VIR_DOMAIN_MEMORY_STAT_UNUSED, 670264 },
+        { VIR_DOMAIN_MEMORY_STAT_AVAILABLE, 996020 },
+        { VIR_DOMAIN_MEMORY_STAT_LAST_UPDATE, 1371221540 },
+    };
+    int nstats;
+    size_t i;
+
+    if (!(test = qemuMonitorTestNewSchema(data->xmlopt, data->schema)))
+        return -1;
+
+    if (qemuMonitorTestAddItem(test, "query-balloon",
+                               "{"
+                               "    \"return\": {"
+                               "        \"actual\": 1073741824"
+                               "    },"
+                               "    \"id\": \"libvirt-1\""
+                               "}") < 0)
+        return -1;
+
+    /* members libvirt doesn't use are dropped while parsing the reply */
+    if (qemuMonitorTestAddItem(test, "qom-get",
+                               "{"
+                               "    \"return\": {"
+                               "        \"stats\": {"
+                               "            \"stat-swap-out\": 0,"
+                               "            \"stat-free-memory\": 686350336,"
+                               "            \"stat-minor-faults\": 697283,"
+                               "            \"stat-major-faults\": 951,"
+                               "            \"stat-total-memory\": 1019924480,"
+                               "            \"stat-unknown\": 12345,"
+                               "            \"stat-swap-in\": 0"
+                               "        },"
+                               "        \"last-update\": 1371221540,"
+                               "        \"unknown\": { \"values\": [ 1, 2, 3 ] }"
+                               "    },"
+                               "    \"id\": \"libvirt-2\""
+                               "}") < 0)
+        return -1;
+
+    if ((nstats = qemuMonitorJSONGetMemoryStats(qemuMonitorTestGetMonitor(test),
+                                                balloonpath, stats,
+                                                VIR_DOMAIN_MEMORY_STAT_NR)) < 0)
+        return -1;
+
+    if (nstats != (int) G_N_ELEMENTS(expect)) {
+        VIR_TEST_VERBOSE("expected %zu memory stats, got %d",
+                         G_N_ELEMENTS(expect), nstats);
+        return -1;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(expect); i++) {
+        if (stats[i].tag != expect[i].tag || stats[i].val != expect[i].val) {
+            VIR_TEST_VERBOSE("memory stat %zu: expected %d=%llu, got %d=%llu",
+                             i, expect[i].tag, expect[i].val,
+                             stats[i].tag, stats[i].val);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+static int
+testQemuMonitorJSONqemuMonitorQueryStats(const void *opaque)
+{
+    const testGenericData *data = opaque;
+    g_autoptr(qemuMonitorTest) test = NULL;
+    g_autoptr(virJSONValue) queried = NULL;
+    g_autoptr(virJSONValue) malformed = NULL;
+    g_autoptr(GHashTable) stats = NULL;
+    virJSONValue *result;
+    unsigned long long num;
+    bool b;
+
+    if (!(test = qemuMonitorTestNewSchema(data->xmlopt, data->schema)))
+        return -1;
+
+    if (qemuMonitorTestAddItem(test, "query-stats",
+                               "{"
+                               "    \"return\": ["
+                               "        {"
+                               "            \"provider\": \"kvm\","
+                               "            \"qom-path\": \"/machine/unattached/device[0]\","
+                               "            \"stats\": ["
+                               "                { \"name\": \"guest_mode\", \"value\": false },"
+                               "                { \"name\": \"halt_poll_success_ns\", \"value\": 1234 },"
+                               "                { \"name\": \"halt_wait_hist\", \"value\": [ 1, 2, 3 ] }"
+                               "            ]"
+                               "        },"
+                               "        {"
+                               "            \"provider\": \"kvm\","
+                               "            \"qom-path\": \"/machine/unattached/device[1]\","
+                               "            \"stats\": ["
+                               "                { \"name\": \"halt_poll_success_ns\", \"value\": 5678 }"
+                               "            ]"
+                               "        }"
+                               "    ],"
+                               "    \"id\": \"libvirt-1\""
+                               "}") < 0)
+        return -1;
+
+    if (!(queried = qemuMonitorQueryStats(qemuMonitorTestGetMonitor(test),
+                                          QEMU_MONITOR_QUERY_STATS_TARGET_VCPU,
+                                          NULL,
+                                          QEMU_MONITOR_QUERY_STATS_PROVIDER_KVM)))
+        return -1;
+
+    if (virJSONValueArraySize(queried) != 2) {
+        VIR_TEST_VERBOSE("expected 2 results, got %zu",
+                         virJSONValueArraySize(queried));
+        return -1;
+    }
+
+    result = virJSONValueArrayGet(queried, 0);
+
+    if (!(stats = qemuMonitorExtractQueryStats(result)))
+        return -1;
+
+    /* histograms are not reported */
+    if (g_hash_table_size(stats) != 2 ||
+        g_hash_table_contains(stats, "halt_wait_hist")) {
+        VIR_TEST_VERBOSE("unexpected set of statistics");
+        return -1;
+    }
+
+    if (virJSONValueGetBoolean(g_hash_table_lookup(stats, "guest_mode"), &b) < 0 ||
+        b != false ||
+        virJSONValueGetNumberUlong(g_hash_table_lookup(stats, "halt_poll_success_ns"),
+                                   &num) < 0 ||
+        num != 1234) {
+        VIR_TEST_VERBOSE("unexpected values of statistics");
+        return -1;
+    }
+
+    if (!(malformed = virJSONValueFromString("{\"qom-path\": \"/machine/cpu\"}")))
+        return -1;
+
+    if (qemuMonitorExtractQueryStats(malformed)) {
+        VIR_TEST_VERBOSE("result without 'stats' was accepted");
+        return -1;
+    }
+    virResetLastError();
+
+    return 0;
+}
+
+
 static int
 testQemuMonitorJSONqemuMonitorJSONGetMigrationStats(const void *opaque)
 {
@@ -3098,6 +3338,9 @@ mymain(void)
     DO_TEST(qemuMonitorJSONGetBalloonInfo);
     DO_TEST(qemuMonitorJSONGetBlockInfo);
     DO_TEST(qemuMonitorJSONGetAllBlockStatsInfo);
+    DO_TEST(GetAllBlockStatsInfoFiltered);
+    DO_TEST(qemuMonitorJSONGetMemoryStats);
+    DO_TEST(qemuMonitorQueryStats);
     DO_TEST(qemuMonitorJSONGetMigrationStats);
     DO_TEST(qemuMonitorJSONGetChardevInfo);
     DO_TEST(qemuMonitorJSONSetBlockIoThrottle);
@@ -0,0 +1,134 @@
+#include <config.h>
+
+#include "testutils.h"
+
+#ifdef WITH_QEMU
+
+# include "qemu/qemu_placement.h"
+
+# define VIR_FROM_THIS VIR_FROM_QEMU
+
+/* Distances of a host whose nodes 0 and 1, and 2 and 3 are close */
+static int distances0[] = { 10, 12, 20, 20 };
+static int distances1[] = { 12, 10, 20, 20 };
+static int distances2[] = { 20, 20, 10, 12 };
+static int distances3[] = { 20, 20, 12, 10 };
+
+# define NODE(nodeid, cpus, free, busy) \
+    { .id = nodeid, .ncpus = cpus, .memFree = free, .load = busy, \
+      .distances = distances ## nodeid, .ndistances = 4 }
+
+# define GiB (1024ull * 1024)
+
+struct testInfo {
+    const char *name;
+    qemuPlacementNode nodes[4];
+    size_t nnodes;
+    qemuPlacementPolicy policy;
+    unsigned int vcpus;
+    unsigned long long memory;
+    const char *nodeset; /* NULL if no nodeset should be chosen */
+};
+
+
+static int
+testChooseNodes(const void *opaque)
+{
+    const struct testInfo *info = opaque;
+    qemuPlacementNode nodes[4];
+    g_autoptr(virBitmap) nodeset = NULL;
+    g_autofree char *str = NULL;
+
+    memcpy(nodes, info->nodes, sizeof(nodes));
+
+    nodeset = qemuPlacementChooseNodes(nodes, info->nnodes, info->policy,
+                                       info->vcpus, info->memory);
+
+    if (!info->nodeset) {
+        if (nodeset) {
+            VIR_TEST_DEBUG("expected no nodeset, got one");
+            return -1;
+        }
+        return 0;
+    }
+
+    if (!nodeset)
+        return -1;
+
+    if (!(str = virBitmapFormat(nodeset)))
+        return -1;
+
+    if (STRNEQ(str, info->nodeset)) {
+        VIR_TEST_DEBUG("expected nodeset '%s', got '%s'", info->nodeset, str);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+# define DO_TEST(_name, _policy, _vcpus, _memory, _nodeset, ...) \
+    do { \
+        struct testInfo info = { \
+            .name = _name, \
+            .nodes = { __VA_ARGS__ }, \
+            .policy = QEMU_PLACEMENT_POLICY_ ## _policy, \
+            .vcpus = _vcpus, \
+            .memory = _memory, \
+            .nodeset = _nodeset, \
+        }; \
+        info.nnodes = sizeof((qemuPlacementNode[]) { __VA_ARGS__ }) / \
+            sizeof(qemuPlacementNode); \
+        if (virTestRun("choose nodes " _name, testChooseNodes, &info) < 0) \
+            ret = -1; \
+    } while (0)
+
+    /* The least loaded node is preferred when spreading, the busiest one
+     * the domain fits on when packing */
+    DO_TEST("spread", SPREAD, 4, 4 * GiB, "1",
+            NODE(0, 8, 16 * GiB, 2), NODE(1, 8, 16 * GiB, 1));
+    DO_TEST("pack", PACK, 4, 4 * GiB, "0",
+            NODE(0, 8, 16 * GiB, 2), NODE(1, 8, 16 * GiB, 1));
+    DO_TEST("pack-full", PACK, 4, 4 * GiB, "1",
+            NODE(0, 8, 16 * GiB, 6), NODE(1, 8, 16 * GiB, 1));
+    DO_TEST("spread-memory", SPREAD, 4, 12 * GiB, "0",
+            NODE(0, 8, 16 * GiB, 2), NODE(1, 8, 8 * GiB, 1));
+    DO_TEST("spread-tie", SPREAD, 4, 4 * GiB, "1",
+            NODE(0, 8, 8 * GiB, 0), NODE(1, 8, 16 * GiB, 0));
+
+    /* Large domains span the closest nodes */
+    DO_TEST("span-cpus", SPREAD, 12, 4 * GiB, "2-3",
+            NODE(0, 8, 16 * GiB, 4), NODE(1, 8, 16 * GiB, 2),
+            NODE(2, 8, 16 * GiB, 0), NODE(3, 8, 16 * GiB, 1));
+    DO_TEST("span-memory", PACK, 4, 40 * GiB, "0,2-3",
+            NODE(0, 8, 16 * GiB, 4), NODE(1, 8, 16 * GiB, 6),
+            NODE(2, 8, 16 * GiB, 0), NODE(3, 8, 16 * GiB, 1));
+    DO_TEST("span-all", SPREAD, 64, 4 * GiB, "0-3",
+            NODE(0, 8, 16 * GiB, 0), NODE(1, 8, 16 * GiB, 0),
+            NODE(2, 8, 16 * GiB, 0), NODE(3, 8, 16 * GiB, 0));
+
+    /* Nodes without CPUs only provide memory */
+    DO_TEST("memory-only", SPREAD, 2, 24 * GiB, "0-1",
+            NODE(0, 4, 16 * GiB, 3), NODE(1, 0, 16 * GiB, 0));
+    DO_TEST("no-cpus", SPREAD, 2, 4 * GiB, NULL,
+            NODE(0, 0, 16 * GiB, 0), NODE(1, 0, 16 * GiB, 0));
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
+
+#else
+
+int
+main(void)
+{
+    return EXIT_AM_SKIP;
+}
+
+#endif /* WITH_QEMU */
@@ -0,0 +1,214 @@
+#include <config.h>
+
+#include "testutils.h"
+
+#ifdef WITH_QEMU
+
+# include "qemu/qemu_stats.h"
+# include "virthread.h"
+
+# define VIR_FROM_THIS VIR_FROM_QEMU
+
+# define NVMS 4
+
+typedef struct _testStatsState testStatsState;
+struct _testStatsState {
+    virMutex lock;
+    virCond cond;
+    bool hang; /* collection of domain 'vm0' blocks until released */
+    bool released;
+    bool freed;
+};
+
+struct testInfo {
+    const char *name;
+    unsigned int timeout;
+    bool hang;
+    bool partial; /* whether all domains are expected to be partial */
+};
+
+
+static int
+testStatsRecord(virDomainObj *vm,
+                virDomainStatsRecordPtr *record,
+                bool partial)
+{
+    int maxparams = 0;
+
+    *record = g_new0(virDomainStatsRecord, 1);
+
+    if (virTypedParamsAddString(&(*record)->params, &(*record)->nparams,
+                                &maxparams, "name", vm->def->name) < 0 ||
+        virTypedParamsAddBoolean(&(*record)->params, &(*record)->nparams,
+                                 &maxparams, "partial", partial) < 0)
+        return -1;
+
+    return 0;
+}
+
+
+static int
+testStatsCollect(virDomainObj *vm,
+                 virDomainStatsRecordPtr *record,
+                 void *opaque)
+{
+    testStatsState *state = opaque;
+
+    virMutexLock(&state->lock);
+    if (state->hang && STREQ(vm->def->name, "vm0")) {
+        while (!state->released)
+            ignore_value(virCondWait(&state->cond, &state->lock));
+    }
+    virMutexUnlock(&state->lock);
+
+    return testStatsRecord(vm, record, false);
+}
+
+
+static int
+testStatsPartial(virDomainObj *vm,
+                 virDomainStatsRecordPtr *record,
+                 void *opaque G_GNUC_UNUSED)
+{
+    return testStatsRecord(vm, record, true);
+}
+
+
+static void
+testStatsStateFree(void *opaque)
+{
+    testStatsState *state = opaque;
+
+    virMutexLock(&state->lock);
+    state->freed = true;
+    virCondBroadcast(&state->cond);
+    virMutexUnlock(&state->lock);
+}
+
+
+static int
+testCollectParallel(const void *opaque)
+{
+    const struct testInfo *info = opaque;
+    virDomainXMLOption *xmlopt = NULL;
+    virThreadPool *pool = NULL;
+    virDomainObj *vms[NVMS] = { 0 };
+    virDomainStatsRecordPtr *records = g_new0(virDomainStatsRecordPtr, NVMS + 1);
+    testStatsState state = { .hang = info->hang };
+    int nrecords;
+    size_t i;
+    int ret = -1;
+
+    if (virMutexInit(&state.lock) < 0 ||
+        virCondInit(&state.cond) < 0)
+        goto cleanup;
+
+    if (!(xmlopt = virTestGenericDomainXMLConfInit()))
+        goto cleanup;
+
+    for (i = 0; i < NVMS; i++) {
+        if (!(vms[i] = virDomainObjNew(xmlopt)))
+            goto cleanup;
+        virObjectUnlock(vms[i]);
+        vms[i]->def = virDomainDefNew(xmlopt);
+        vms[i]->def->name = g_strdup_printf("vm%zu", i);
+    }
+
+    /* A single worker: when it hangs on 'vm0', which is queued first,
+     * the remaining domains are never picked up */
+    if (!(pool = virThreadPoolNewFull(0, 1, 0, qemuStatsWorker,
+                                      "test-stats", NULL, NULL)))
+        goto cleanup;
+
+    nrecords = qemuStatsCollectParallel(pool, vms, NVMS, info->timeout,
+                                        testStatsCollect, testStatsPartial,
+                                        &state, testStatsStateFree,
+                                        records);
+
+    /* let the worker finish so that the state is freed */
+    virMutexLock(&state.lock);
+    state.released = true;
+    virCondBroadcast(&state.cond);
+    while (!state.freed)
+        ignore_value(virCondWait(&state.cond, &state.lock));
+    virMutexUnlock(&state.lock);
+
+    if (nrecords != NVMS) {
+        VIR_TEST_DEBUG("expected %d records, got %d", NVMS, nrecords);
+        goto cleanup;
+    }
+
+    for (i = 0; i < NVMS; i++) {
+        const char *name = NULL;
+        int partial = -1;
+
+        if (virTypedParamsGetString(records[i]->params, records[i]->nparams,
+                                    "name", &name) < 0 ||
+            virTypedParamsGetBoolean(records[i]->params, records[i]->nparams,
+                                     "partial", &partial) < 0)
+            goto cleanup;
+
+        if (STRNEQ_NULLABLE(name, vms[i]->def->name)) {
+            VIR_TEST_DEBUG("record %zu: expected '%s', got '%s'",
+                           i, vms[i]->def->name, NULLSTR(name));
+            goto cleanup;
+        }
+
+        if (!!partial != info->partial) {
+            VIR_TEST_DEBUG("record %zu: expected partial=%d, got %d",
+                           i, info->partial, partial);
+            goto cleanup;
+        }
+    }
+
+    ret = 0;
+
+ cleanup:
+    virThreadPoolFree(pool);
+    for (i = 0; records[i]; i++) {
+        virTypedParamsFree(records[i]->params, records[i]->nparams);
+        g_free(records[i]);
+    }
+    g_free(records);
+    for (i = 0; i < NVMS; i++)
+        virObjectUnref(vms[i]);
+    virObjectUnref(xmlopt);
+    virCondDestroy(&state.cond);
+    virMutexDestroy(&state.lock);
+    return ret;
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+# define DO_TEST(name, timeout, hang, partial) \
+    do { \
+        struct testInfo info = { name, timeout, hang, partial }; \
+        if (virTestRun("parallel " name, testCollectParallel, &info) < 0) \
+            ret = -1; \
+    } while (0)
+
+    DO_TEST("no-timeout", 0, false, false);
+    DO_TEST("timeout-not-reached", 60000, false, false);
+
+    /* Domains queued behind the stuck one are covered by the deadline
+     * too, even though no worker ever picks them up in time */
+    DO_TEST("hung-worker", 100, true, true);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
+
+#else
+
+int
+main(void)
+{
+    return EXIT_AM_SKIP;
+}
+
+#endif /* WITH_QEMU */
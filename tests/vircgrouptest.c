@@ -786,6 +786,93 @@ static int testCgroupGetMemoryUsage(const void *args G_GNUC_UNUSED)
 }
 
 
+static int testCgroupGetMemoryUsageCached(const void *args G_GNUC_UNUSED)
+{
+    g_autoptr(virCgroup) cgroup = NULL;
+    int rv;
+    unsigned long kb;
+
+    if ((rv = virCgroupNewPartition("/virtualmachines", true,
+                                    (1 << VIR_CGROUP_CONTROLLER_MEMORY),
+                                    &cgroup)) < 0) {
+        fprintf(stderr, "Could not create /virtualmachines cgroup: %d\n", -rv);
+        return -1;
+    }
+
+    /* The first read leaves the file open, the second one has to see
+     * the updated contents nevertheless */
+    if ((rv = virCgroupGetMemoryUsage(cgroup, &kb)) < 0 ||
+        (rv = virCgroupSetValueStr(cgroup, VIR_CGROUP_CONTROLLER_MEMORY,
+                                   "memory.usage_in_bytes", "2048")) < 0 ||
+        (rv = virCgroupGetMemoryUsage(cgroup, &kb)) < 0) {
+        fprintf(stderr, "Could not retrieve GetMemoryUsage for /virtualmachines cgroup: %d\n", -rv);
+        return -1;
+    }
+
+    if (virCgroupSetValueStr(cgroup, VIR_CGROUP_CONTROLLER_MEMORY,
+                             "memory.usage_in_bytes", "1455321088") < 0)
+        return -1;
+
+    if (kb != 2UL) {
+        fprintf(stderr,
+                "Wrong value from virCgroupGetMemoryUsage (expected %ld)\n",
+                2UL);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int testCgroupChanges(const void *args G_GNUC_UNUSED)
+{
+    g_autoptr(virCgroup) cgroup = NULL;
+    g_autofree char *path = NULL;
+    g_autofree char *before = NULL;
+    g_autofree char *after = NULL;
+    unsigned long long shares;
+    int rv;
+
+    if ((rv = virCgroupNewPartition("/virtualmachines", true,
+                                    (1 << VIR_CGROUP_CONTROLLER_CPU),
+                                    &cgroup)) < 0) {
+        fprintf(stderr, "Could not create /virtualmachines cgroup: %d\n", -rv);
+        return -1;
+    }
+
+    if (virCgroupPathOfController(cgroup, VIR_CGROUP_CONTROLLER_CPU,
+                                  "cpu.shares", &path) < 0)
+        return -1;
+
+    if (virCgroupBeginChanges(cgroup) < 0 ||
+        virCgroupSetCpuShares(cgroup, 2048) < 0 ||
+        virCgroupGetValueRaw(path, &before) < 0 ||
+        virCgroupCommitChanges(cgroup) < 0 ||
+        virCgroupGetValueRaw(path, &after) < 0)
+        return -1;
+
+    if (STRNEQ(before, "1024") || STRNEQ(after, "2048")) {
+        fprintf(stderr, "Wrong cpu.shares '%s' and '%s' (expected '1024' and '2048')\n",
+                before, after);
+        return -1;
+    }
+
+    /* Reading a value makes the changes collected so far */
+    if (virCgroupBeginChanges(cgroup) < 0 ||
+        virCgroupSetCpuShares(cgroup, 1024) < 0 ||
+        virCgroupGetCpuShares(cgroup, &shares) < 0)
+        return -1;
+    virCgroupAbortChanges(cgroup);
+
+    if (shares != 1024) {
+        fprintf(stderr, "Wrong cpu.shares %llu (expected 1024)\n", shares);
+        return -1;
+    }
+
+    return 0;
+}
+
+
 static int
 testCgroupGetMemoryStat(const void *args G_GNUC_UNUSED)
 {
@@ -1063,6 +1150,12 @@ mymain(void)
     if (virTestRun("virCgroupGetMemoryUsage works", testCgroupGetMemoryUsage, NULL) < 0)
         ret = -1;
 
+    if (virTestRun("virCgroupGetMemoryUsage rereads", testCgroupGetMemoryUsageCached, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("virCgroupCommitChanges works", testCgroupChanges, NULL) < 0)
+        ret = -1;
+
     if (virTestRun("virCgroupGetMemoryStat works", testCgroupGetMemoryStat, NULL) < 0)
         ret = -1;
 
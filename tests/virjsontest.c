@@ -4,6 +4,8 @@
 
 #include "internal.h"
 #include "virjson.h"
+#include "virfile.h"
+#include "virstring.h"
 #include "testutils.h"
 
 #define VIR_FROM_THIS VIR_FROM_NONE
@@ -470,6 +472,234 @@ testJSONObjectFormatSteal(const void *opaque G_GNUC_UNUSED)
 }
 
 
+
+static int
+testJSONObjectIndexCheck(virJSONValue *obj,
+                         int nkeys)
+{
+    int i;
+
+    if (virJSONValueObjectKeysNumber(obj) != nkeys) {
+        VIR_TEST_VERBOSE("expected %d keys, got %d",
+                         nkeys, virJSONValueObjectKeysNumber(obj));
+        return -1;
+    }
+
+    for (i = 0; i < nkeys; i++) {
+        const char *key = virJSONValueObjectGetKey(obj, i);
+
+        if (virJSONValueObjectGet(obj, key) != virJSONValueObjectGetValue(obj, i)) {
+            VIR_TEST_VERBOSE("lookup of key '%s' returned wrong value", key);
+            return -1;
+        }
+    }
+
+    if (virJSONValueObjectGet(obj, "missing") ||
+        virJSONValueObjectHasKey(obj, "missing") != 0) {
+        VIR_TEST_VERBOSE("lookup of missing key succeeded");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testJSONObjectIndex(const void *data G_GNUC_UNUSED)
+{
+    g_autoptr(virJSONValue) obj = virJSONValueNewObject();
+    virJSONValue *removed = NULL;
+    int nkeys = 64;
+    int i;
+
+    for (i = 0; i < nkeys; i++) {
+        g_autofree char *key = g_strdup_printf("key%d", i);
+
+        if (virJSONValueObjectAppendNumberUlong(obj, key, i) < 0)
+            return -1;
+    }
+
+    if (testJSONObjectIndexCheck(obj, nkeys) < 0)
+        return -1;
+
+    if (virJSONValueObjectAppendNumberInt(obj, "key10", 1) == 0) {
+        VIR_TEST_VERBOSE("duplicate key was added");
+        return -1;
+    }
+
+    /* modifications after the index was built */
+    if (virJSONValueObjectPrependString(obj, "first", "value") < 0)
+        return -1;
+    nkeys++;
+
+    if (testJSONObjectIndexCheck(obj, nkeys) < 0)
+        return -1;
+
+    if (virJSONValueObjectRemoveKey(obj, "key10", &removed) != 1)
+        return -1;
+    virJSONValueFree(removed);
+    nkeys--;
+
+    if (virJSONValueObjectHasKey(obj, "key10") != 0) {
+        VIR_TEST_VERBOSE("removed key is still present");
+        return -1;
+    }
+
+    if (virJSONValueObjectAppendString(obj, "last", "value") < 0)
+        return -1;
+    nkeys++;
+
+    return testJSONObjectIndexCheck(obj, nkeys);
+}
+
+
+static int
+testJSONObjectIndexWalk(virJSONValue *value,
+                        size_t *nlookups)
+{
+    size_t n;
+    size_t i;
+
+    switch (virJSONValueGetType(value)) {
+    case VIR_JSON_TYPE_OBJECT:
+        n = virJSONValueObjectKeysNumber(value);
+
+        for (i = 0; i < n; i++) {
+            const char *key = virJSONValueObjectGetKey(value, i);
+            virJSONValue *member = virJSONValueObjectGetValue(value, i);
+
+            if (virJSONValueObjectGet(value, key) != member) {
+                VIR_TEST_VERBOSE("lookup of key '%s' returned wrong value", key);
+                return -1;
+            }
+            (*nlookups)++;
+
+            if (testJSONObjectIndexWalk(member, nlookups) < 0)
+                return -1;
+        }
+        break;
+
+    case VIR_JSON_TYPE_ARRAY:
+        for (i = 0; i < virJSONValueArraySize(value); i++) {
+            if (testJSONObjectIndexWalk(virJSONValueArrayGet(value, i), nlookups) < 0)
+                return -1;
+        }
+        break;
+
+    case VIR_JSON_TYPE_STRING:
+    case VIR_JSON_TYPE_NUMBER:
+    case VIR_JSON_TYPE_BOOLEAN:
+    case VIR_JSON_TYPE_NULL:
+        break;
+    }
+
+    return 0;
+}
+
+
+/* Parses all QMP replies used by qemucapabilitiestest and looks up every
+ * member of every object. Besides checking that indexed lookups agree with
+ * positional access this serves as a microbenchmark of the parser and of
+ * key lookups in large objects; run with VIR_TEST_DEBUG=1 to see timings. */
+static int
+testJSONObjectIndexReplies(const void *data G_GNUC_UNUSED)
+{
+    g_autofree char *capsdir = g_strdup_printf("%s/qemucapabilitiesdata", abs_srcdir);
+    g_autoptr(DIR) dir = NULL;
+    struct dirent *ent;
+    gint64 parseTime = 0;
+    gint64 lookupTime = 0;
+    size_t nreplies = 0;
+    size_t nlookups = 0;
+    int rc;
+
+    if (virDirOpen(&dir, capsdir) < 0)
+        return -1;
+
+    while ((rc = virDirRead(dir, &ent, capsdir)) > 0) {
+        g_autofree char *path = NULL;
+        g_autofree char *content = NULL;
+        g_auto(GStrv) replies = NULL;
+        char **reply;
+
+        if (!virStringHasSuffix(ent->d_name, ".replies"))
+            continue;
+
+        path = g_strdup_printf("%s/%s", capsdir, ent->d_name);
+
+        if (virTestLoadFile(path, &content) < 0)
+            return -1;
+
+        replies = g_strsplit(content, "\n\n", 0);
+
+        for (reply = replies; *reply; reply++) {
+            g_autoptr(virJSONValue) json = NULL;
+            gint64 start;
+
+            if (virStringIsEmpty(*reply))
+                continue;
+
+            start = g_get_monotonic_time();
+            if (!(json = virJSONValueFromString(*reply))) {
+                VIR_TEST_VERBOSE("failed to parse reply in '%s'", path);
+                return -1;
+            }
+            parseTime += g_get_monotonic_time() - start;
+
+            start = g_get_monotonic_time();
+            if (testJSONObjectIndexWalk(json, &nlookups) < 0) {
+                VIR_TEST_VERBOSE("lookup failed in '%s'", path);
+                return -1;
+            }
+            lookupTime += g_get_monotonic_time() - start;
+
+            nreplies++;
+        }
+    }
+
+    if (rc < 0)
+        return -1;
+
+    VIR_TEST_DEBUG("parsed %zu replies in %lld us, %zu lookups in %lld us",
+                   nreplies, (long long) parseTime,
+                   nlookups, (long long) lookupTime);
+
+    return 0;
+}
+
+
+/* Members not listed in the filter are dropped along with their whole
+ * subtree, wherever they appear. Arrays are kept as they are. */
+static int
+testJSONFromStringFiltered(const void *data G_GNUC_UNUSED)
+{
+    const char *const filter[] = { "return", "id", "name", "stats", NULL };
+    const char *doc =
+        "{\"return\": [{\"name\": \"a\","
+        "               \"stats\": {\"name\": 1, \"timed\": [1, 2]},"
+        "               \"extra\": {\"name\": \"dropped\"}},"
+        "              {\"name\": \"b\", \"stats\": [{\"x\": 1}, 2]}],"
+        " \"unused\": [{\"return\": 1}],"
+        " \"id\": \"libvirt-1\"}";
+    const char *expect =
+        "{\"return\":[{\"name\":\"a\",\"stats\":{\"name\":1}},"
+        "{\"name\":\"b\",\"stats\":[{},2]}],\"id\":\"libvirt-1\"}";
+    g_autoptr(virJSONValue) filtered = NULL;
+    g_autofree char *actual = NULL;
+
+    if (!(filtered = virJSONValueFromStringFiltered(doc, filter)) ||
+        !(actual = virJSONValueToString(filtered, false)))
+        return -1;
+
+    if (STRNEQ(expect, actual)) {
+        virTestDifference(stderr, expect, actual);
+        return -1;
+    }
+
+    return 0;
+}
+
+
 static int
 mymain(void)
 {
@@ -596,6 +826,15 @@ mymain(void)
     DO_TEST_FULL("stealing of attributes while creating objects",
                  ObjectFormatSteal, NULL, NULL, true);
 
+    if (virTestRun("object key index", testJSONObjectIndex, NULL) < 0)
+        ret = -1;
+    if (virTestRun("object key index with QMP replies",
+                   testJSONObjectIndexReplies, NULL) < 0)
+        ret = -1;
+    if (virTestRun("selective parsing",
+                   testJSONFromStringFiltered, NULL) < 0)
+        ret = -1;
+
 #define DO_TEST_DEFLATTEN(name, pass) \
     DO_TEST_FULL(name, Deflatten, NULL, NULL, pass)
 
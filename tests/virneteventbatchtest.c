@@ -0,0 +1,153 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+
+#include "virbuffer.h"
+#include "rpc/virneteventbatch.h"
+
+#define VIR_FROM_THIS VIR_FROM_RPC
+
+struct testBatchInfo {
+    /* Space separated events, each given by four characters: procedure,
+     * callback, domain and payload. A '|' flushes the queue. */
+    const char *events;
+    bool coalesce;
+    /* Payloads of the flushed events, in order, batches separated by '|' */
+    const char *expect;
+};
+
+
+static int
+testBatchFlush(virNetEventBatch *batch,
+               virBuffer *buf)
+{
+    g_autofree virNetEventBatchItem *items = NULL;
+    size_t nitems;
+    size_t size = batch->size;
+    size_t total = 0;
+    size_t i;
+
+    nitems = virNetEventBatchSteal(batch, &items);
+
+    for (i = 0; i < nitems; i++) {
+        virBufferAdd(buf, items[i].payload, items[i].len);
+        total += items[i].len;
+        g_free(items[i].payload);
+    }
+
+    if (total != size) {
+        VIR_TEST_DEBUG("queue size %zu, payloads take %zu", size, total);
+        return -1;
+    }
+
+    if (batch->nitems || batch->size || batch->items) {
+        VIR_TEST_DEBUG("queue not empty after flush");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int
+testBatch(const void *opaque)
+{
+    const struct testBatchInfo *info = opaque;
+    virNetEventBatch batch = { 0 };
+    g_auto(virBuffer) buf = VIR_BUFFER_INITIALIZER;
+    g_auto(GStrv) events = g_strsplit(info->events, " ", 0);
+    g_autofree char *actual = NULL;
+    GStrv event;
+    int ret = -1;
+
+    for (event = events; *event; event++) {
+        virNetEventBatchItem item = { 0 };
+
+        if (STREQ(*event, "|")) {
+            if (testBatchFlush(&batch, &buf) < 0)
+                goto cleanup;
+            virBufferAddChar(&buf, '|');
+            continue;
+        }
+
+        item.procnr = (*event)[0];
+        item.callbackID = (*event)[1];
+        item.uuid[0] = (*event)[2];
+        item.payload = g_strndup(*event + 3, 1);
+        item.len = 1;
+
+        virNetEventBatchAdd(&batch, &item, info->coalesce);
+
+        if (item.payload) {
+            VIR_TEST_DEBUG("payload of event '%s' not taken over", *event);
+            goto cleanup;
+        }
+    }
+
+    if (testBatchFlush(&batch, &buf) < 0)
+        goto cleanup;
+
+    actual = virBufferContentAndReset(&buf);
+
+    if (STRNEQ_NULLABLE(actual, info->expect)) {
+        virTestDifference(stderr, NULLSTR_EMPTY(info->expect),
+                          NULLSTR_EMPTY(actual));
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    virNetEventBatchClear(&batch);
+    return ret;
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+#define DO_TEST(name, events, coalesce, expect) \
+    do { \
+        struct testBatchInfo info = { events, coalesce, expect }; \
+        if (virTestRun("Event batch " name, testBatch, &info) < 0) \
+            ret = -1; \
+    } while (0)
+
+    DO_TEST("empty", "", false, NULL);
+    DO_TEST("order", "a111 a112 b113 a124", false, "1234");
+    DO_TEST("order flushed", "a111 b112 | a113 | b114", false, "12|3|4");
+
+    /* A newer event replaces a queued one and is sent last */
+    DO_TEST("coalesce", "a111 a112", true, "2");
+    DO_TEST("coalesce order", "a111 b112 a113 b114 c115", true, "345");
+
+    /* Events of other domains, callbacks or procedures are kept */
+    DO_TEST("coalesce domain", "a111 a122 a113", true, "23");
+    DO_TEST("coalesce callback", "a111 a212 a113", true, "23");
+    DO_TEST("coalesce procedure", "a111 b112 a213", true, "123");
+
+    /* Flushed events are never superseded */
+    DO_TEST("coalesce flushed", "a111 | a112 a113", true, "1|3");
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
@@ -448,8 +448,9 @@ static int testMessagePayloadDecode(const void *args G_GNUC_UNUSED)
     return ret;
 }
 
-static int testMessagePayloadStreamEncode(const void *args G_GNUC_UNUSED)
+static int testMessagePayloadStreamEncode(const void *args)
 {
+    bool inPlace = *(const bool *)args;
     char stream[] = "The quick brown fox jumps over the lazy dog";
     virNetMessage *msg = virNetMessageNew(true);
     static const char expect[] = {
@@ -488,8 +489,21 @@ static int testMessagePayloadStreamEncode(const void *args G_GNUC_UNUSED)
     if (virNetMessageEncodeHeader(msg) < 0)
         goto cleanup;
 
-    if (virNetMessageEncodePayloadRaw(msg, stream, strlen(stream)) < 0)
-        goto cleanup;
+    if (inPlace) {
+        char *payload;
+
+        /* reserve more than needed, only the committed part is sent */
+        if (!(payload = virNetMessageReservePayloadRaw(msg, 2 * strlen(stream))))
+            goto cleanup;
+
+        memcpy(payload, stream, strlen(stream));
+
+        if (virNetMessageCommitPayloadRaw(msg, strlen(stream)) < 0)
+            goto cleanup;
+    } else {
+        if (virNetMessageEncodePayloadRaw(msg, stream, strlen(stream)) < 0)
+            goto cleanup;
+    }
 
     if (G_N_ELEMENTS(expect) != msg->bufferLength) {
         VIR_DEBUG("Expect message length %zu got %zu",
@@ -514,16 +528,242 @@ static int testMessagePayloadStreamEncode(const void *args G_GNUC_UNUSED)
     return ret;
 }
 
+static int testMessagePayloadStreamLarge(const void *args G_GNUC_UNUSED)
+{
+    size_t len = VIR_NET_MESSAGE_STREAM_PAYLOAD_MAX;
+    g_autofree char *payload = g_new0(char, len);
+    virNetMessage *msg = virNetMessageNew(true);
+    virNetMessage *rx = virNetMessageNew(true);
+    size_t i;
+    int ret = -1;
+
+    for (i = 0; i < len; i++)
+        payload[i] = i % 251;
+
+    msg->header.prog = 0x11223344;
+    msg->header.vers = 0x01;
+    msg->header.proc = 0x666;
+    msg->header.type = VIR_NET_STREAM;
+    msg->header.serial = 0x99;
+    msg->header.status = VIR_NET_CONTINUE;
+
+    if (virNetMessageEncodeHeader(msg) < 0)
+        goto cleanup;
+
+    /* Packets of the size agreed upon with
+     * VIR_DRV_FEATURE_REMOTE_STREAM_LARGE_PAYLOAD must go through */
+    if (virNetMessageEncodePayloadRaw(msg, payload, len) < 0)
+        goto cleanup;
+
+    /* Pretend @msg was received by the other side */
+    rx->bufferLength = VIR_NET_MESSAGE_LEN_MAX;
+    rx->buffer = g_new0(char, rx->bufferLength);
+    memcpy(rx->buffer, msg->buffer, rx->bufferLength);
+
+    if (virNetMessageDecodeLength(rx) < 0)
+        goto cleanup;
+
+    if (rx->bufferLength != msg->bufferLength) {
+        VIR_DEBUG("Expect message length %zu got %zu",
+                  msg->bufferLength, rx->bufferLength);
+        goto cleanup;
+    }
+
+    memcpy(rx->buffer, msg->buffer, rx->bufferLength);
+
+    if (virNetMessageDecodeHeader(rx) < 0)
+        goto cleanup;
+
+    if (rx->header.type != VIR_NET_STREAM ||
+        rx->header.status != VIR_NET_CONTINUE) {
+        VIR_DEBUG("Expect type %d status %d got type %d status %d",
+                  VIR_NET_STREAM, VIR_NET_CONTINUE,
+                  rx->header.type, rx->header.status);
+        goto cleanup;
+    }
+
+    if (rx->bufferLength - rx->bufferOffset != len) {
+        VIR_DEBUG("Expect payload length %zu got %zu",
+                  len, rx->bufferLength - rx->bufferOffset);
+        goto cleanup;
+    }
+
+    if (memcmp(payload, rx->buffer + rx->bufferOffset, len) != 0) {
+        virTestDifferenceBin(stderr, payload, rx->buffer + rx->bufferOffset, len);
+        goto cleanup;
+    }
+
+    ret = 0;
+ cleanup:
+    virNetMessageFree(msg);
+    virNetMessageFree(rx);
+    return ret;
+}
+
+static int testMessagePayloadCompress(const void *args)
+{
+    size_t len = *(const size_t *)args;
+    g_autofree char *payload = g_new0(char, len);
+    virNetMessage *msg = virNetMessageNew(true);
+    virNetMessage *rx = virNetMessageNew(true);
+    size_t plainlen;
+    size_t saved;
+    size_t i;
+    int ret = -1;
+
+    /* Something XML-like, as that is what is usually compressed */
+    for (i = 0; i < len; i++)
+        payload[i] = "<domain type='kvm'>\n"[i % 20];
+
+    msg->header.prog = 0x11223344;
+    msg->header.vers = 0x01;
+    msg->header.proc = 0x666;
+    msg->header.type = VIR_NET_REPLY;
+    msg->header.serial = 0x99;
+    msg->header.status = VIR_NET_OK;
+
+    if (virNetMessageEncodeHeader(msg) < 0)
+        goto cleanup;
+
+    if (virNetMessageEncodePayloadRaw(msg, payload, len) < 0)
+        goto cleanup;
+
+    plainlen = msg->bufferLength;
+    saved = virNetMessageCompress(msg);
+
+    if (len < 4096) {
+        if (saved != 0 || msg->bufferLength != plainlen) {
+            VIR_DEBUG("Expect small payload of %zu bytes to be left alone", len);
+            goto cleanup;
+        }
+    } else if (saved == 0 || msg->bufferLength + saved != plainlen) {
+        VIR_DEBUG("Expect payload of %zu bytes to be compressed, saved %zu",
+                  len, saved);
+        goto cleanup;
+    }
+
+    if (msg->header.type != VIR_NET_REPLY) {
+        VIR_DEBUG("Expect message header to be left alone");
+        goto cleanup;
+    }
+
+    /* Pretend @msg was received by the other side */
+    rx->bufferLength = msg->bufferLength;
+    rx->buffer = g_new0(char, rx->bufferLength);
+    memcpy(rx->buffer, msg->buffer, msg->bufferLength);
+
+    if (virNetMessageDecodeHeader(rx) < 0)
+        goto cleanup;
+
+    /* Compressed messages are refused unless compression was
+     * negotiated */
+    if (saved != 0) {
+        if (virNetMessageDecompress(rx, false) == 0) {
+            VIR_DEBUG("Expect compressed message to be refused");
+            goto cleanup;
+        }
+        virResetLastError();
+    }
+
+    if (virNetMessageDecompress(rx, true) < 0)
+        goto cleanup;
+
+    if (rx->header.type != VIR_NET_REPLY ||
+        rx->header.serial != 0x99) {
+        VIR_DEBUG("Expect type %d serial %d got type %d serial %u",
+                  VIR_NET_REPLY, 0x99, rx->header.type, rx->header.serial);
+        goto cleanup;
+    }
+
+    if (rx->bufferLength - rx->bufferOffset != len) {
+        VIR_DEBUG("Expect payload length %zu got %zu",
+                  len, rx->bufferLength - rx->bufferOffset);
+        goto cleanup;
+    }
+
+    if (memcmp(payload, rx->buffer + rx->bufferOffset, len) != 0) {
+        virTestDifferenceBin(stderr, payload, rx->buffer + rx->bufferOffset, len);
+        goto cleanup;
+    }
+
+    ret = 0;
+ cleanup:
+    virNetMessageFree(msg);
+    virNetMessageFree(rx);
+    return ret;
+}
+
+static int testMessagePool(const void *args G_GNUC_UNUSED)
+{
+    virNetMessage *msg = virNetMessageNew(true);
+    char header[VIR_NET_MESSAGE_LEN_MAX + VIR_NET_MESSAGE_HEADER_MAX];
+    char *buffer;
+    int ret = -1;
+
+    virNetMessagePoolSetLimit(1024 * 1024);
+
+    msg->header.prog = 0x11223344;
+    msg->header.vers = 0x01;
+    msg->header.proc = 0x666;
+    msg->header.type = VIR_NET_CALL;
+    msg->header.serial = 0x99;
+    msg->header.status = VIR_NET_OK;
+
+    if (virNetMessageEncodeHeader(msg) < 0)
+        goto cleanup;
+
+    buffer = msg->buffer;
+    memcpy(header, msg->buffer, sizeof(header));
+
+    /* The buffer goes back to the pool and is handed out again */
+    virNetMessageClearPayload(msg);
+    if (virNetMessageEncodeHeader(msg) < 0)
+        goto cleanup;
+
+    if (msg->buffer != buffer) {
+        VIR_DEBUG("Expect buffer %p to be reused, got %p", buffer, msg->buffer);
+        goto cleanup;
+    }
+
+    /* Growing the buffer must preserve its content */
+    virNetMessageResizeBuffer(msg, 4 * VIR_NET_MESSAGE_INITIAL);
+
+    if (msg->bufferLength != 4 * VIR_NET_MESSAGE_INITIAL ||
+        msg->bufferSize < msg->bufferLength) {
+        VIR_DEBUG("Expect buffer length %d got %zu of %zu",
+                  4 * VIR_NET_MESSAGE_INITIAL,
+                  msg->bufferLength, msg->bufferSize);
+        goto cleanup;
+    }
+
+    if (memcmp(header, msg->buffer, sizeof(header)) != 0) {
+        virTestDifferenceBin(stderr, header, msg->buffer, sizeof(header));
+        goto cleanup;
+    }
+
+    ret = 0;
+ cleanup:
+    virNetMessageFree(msg);
+    virNetMessagePoolSetLimit(0);
+    return ret;
+}
+
 
 static int
 mymain(void)
 {
     int ret = 0;
+    bool copy = false;
+    bool inPlace = true;
+    size_t smallPayload = 1024;
+    size_t largePayload = 1024 * 1024;
 
 #ifndef WIN32
     signal(SIGPIPE, SIG_IGN);
 #endif /* WIN32 */
 
+    virTestQuiesceLibvirtErrors(false);
+
     if (virTestRun("Message Header Encode", testMessageHeaderEncode, NULL) < 0)
         ret = -1;
 
@@ -536,7 +776,26 @@ mymain(void)
     if (virTestRun("Message Payload Decode", testMessagePayloadDecode, NULL) < 0)
         ret = -1;
 
-    if (virTestRun("Message Payload Stream Encode", testMessagePayloadStreamEncode, NULL) < 0)
+    if (virTestRun("Message Payload Stream Encode", testMessagePayloadStreamEncode, &copy) < 0)
+        ret = -1;
+
+    if (virTestRun("Message Payload Stream Encode In Place",
+                   testMessagePayloadStreamEncode, &inPlace) < 0)
+        ret = -1;
+
+    if (virTestRun("Message Payload Stream Large",
+                   testMessagePayloadStreamLarge, NULL) < 0)
+        ret = -1;
+
+    if (virTestRun("Message Payload Compress Small",
+                   testMessagePayloadCompress, &smallPayload) < 0)
+        ret = -1;
+
+    if (virTestRun("Message Payload Compress Large",
+                   testMessagePayloadCompress, &largePayload) < 0)
+        ret = -1;
+
+    if (virTestRun("Message Pool", testMessagePool, NULL) < 0)
         ret = -1;
 
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
@@ -0,0 +1,161 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "testutils.h"
+
+#define LIBVIRT_VIRNETSERVERPRIV_H_ALLOW
+
+#include "rpc/virnetserverpriv.h"
+
+#define VIR_FROM_THIS VIR_FROM_RPC
+
+#define MAX_JOBS 32
+
+struct testFairInfo {
+    /* Weight of clients 'A', 'B', ... */
+    const char *weights;
+    /* A letter queues a job of that client, '.' dequeues a job */
+    const char *ops;
+    /* Clients of all dequeued jobs, in order */
+    const char *expect;
+};
+
+
+static void *
+testClientNew(virNetServerClient *client G_GNUC_UNUSED,
+              void *opaque G_GNUC_UNUSED)
+{
+    return g_new0(int, 1);
+}
+
+
+static void
+testClientFree(void *opaque)
+{
+    g_free(opaque);
+}
+
+
+static int
+testFairDequeue(const void *opaque)
+{
+    const struct testFairInfo *info = opaque;
+    g_autoptr(virNetServer) srv = NULL;
+    virNetServerJob *jobs[MAX_JOBS] = { 0 };
+    size_t njobs = 0;
+    size_t lastJob[26];
+    g_autofree char *actual = g_new0(char, MAX_JOBS + 1);
+    size_t nactual = 0;
+    const char *op;
+    bool drain = false;
+    size_t i;
+    int ret = -1;
+
+    for (i = 0; i < G_N_ELEMENTS(lastJob); i++)
+        lastJob[i] = SIZE_MAX;
+
+    if (!(srv = virNetServerNew("test", 1, 0, 1, 0, 10, 10, -1, 0,
+                                testClientNew, NULL, testClientFree, NULL)))
+        return -1;
+
+    virObjectLock(srv);
+
+    for (op = info->ops; ; op++) {
+        virNetServerJob *job;
+        size_t c;
+
+        if (*op >= 'A' && *op <= 'Z') {
+            c = *op - 'A';
+            job = jobs[njobs++] = g_new0(virNetServerJob, 1);
+            /* The fair queues never dereference the client */
+            job->client = GSIZE_TO_POINTER(c + 1);
+            virNetServerFairEnqueueLocked(srv, job, info->weights[c] - '0');
+            continue;
+        }
+
+        if (*op == '\0')
+            drain = true;
+
+        do {
+            if (!(job = virNetServerFairDequeueLocked(srv)))
+                break;
+
+            for (i = 0; i < njobs && jobs[i] != job; i++)
+                ;
+
+            c = GPOINTER_TO_SIZE(job->client) - 1;
+            actual[nactual++] = 'A' + c;
+
+            /* Jobs of a single client must be served in order */
+            if (lastJob[c] != SIZE_MAX && lastJob[c] > i) {
+                VIR_TEST_DEBUG("job %zu of client '%c' dequeued after job %zu",
+                               i, (char) ('A' + c), lastJob[c]);
+                goto cleanup;
+            }
+            lastJob[c] = i;
+        } while (drain);
+
+        if (drain)
+            break;
+    }
+
+    if (STRNEQ(actual, info->expect)) {
+        virTestDifference(stderr, info->expect, actual);
+        goto cleanup;
+    }
+
+    ret = 0;
+
+ cleanup:
+    /* Don't let the server free the fake clients */
+    while (virNetServerFairDequeueLocked(srv))
+        ;
+    virObjectUnlock(srv);
+    for (i = 0; i < njobs; i++)
+        g_free(jobs[i]);
+    return ret;
+}
+
+
+static int
+mymain(void)
+{
+    int ret = 0;
+
+#define DO_TEST_FAIR(name, weights, ops, expect) \
+    do { \
+        struct testFairInfo info = { weights, ops, expect }; \
+        if (virTestRun("fair dequeue " name, testFairDequeue, &info) < 0) \
+            ret = -1; \
+    } while (0)
+
+    DO_TEST_FAIR("single", "1", "AAA", "AAA");
+    DO_TEST_FAIR("equal weights", "11", "AAAABB", "ABABAA");
+    DO_TEST_FAIR("weighted", "21", "AAAABB", "AABAAB");
+    DO_TEST_FAIR("heavy", "31", "AAAAAAB", "AAABAAA");
+
+    /* A client joining mid-round waits for the turn of everyone else */
+    DO_TEST_FAIR("late arrival", "111", "AAB.C", "ABAC");
+
+    /* An emptied queue gets a fresh turn once it has jobs again */
+    DO_TEST_FAIR("requeue", "21", "AB..A", "ABA");
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+VIR_TEST_MAIN(mymain)
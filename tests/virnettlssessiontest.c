@@ -60,6 +60,39 @@ static ssize_t testRead(char *buf, size_t len, void *opaque)
     return read(*fd, buf, len);
 }
 
+/*
+ * We loop around & around doing handshake on each session until we
+ * get an error, or the handshake completes. This relies on the
+ * socketpair being nonblocking to avoid deadlocking ourselves upon
+ * handshake
+ */
+static int testTLSSessionHandshake(virNetTLSSession *serverSess,
+                                   virNetTLSSession *clientSess)
+{
+    bool clientShake = false;
+    bool serverShake = false;
+
+    do {
+        int rv;
+        if (!serverShake) {
+            rv = virNetTLSSessionHandshake(serverSess);
+            if (rv < 0)
+                return -1;
+            if (rv == VIR_NET_TLS_HANDSHAKE_COMPLETE)
+                serverShake = true;
+        }
+        if (!clientShake) {
+            rv = virNetTLSSessionHandshake(clientSess);
+            if (rv < 0)
+                return -1;
+            if (rv == VIR_NET_TLS_HANDSHAKE_COMPLETE)
+                clientShake = true;
+        }
+    } while (!clientShake || !serverShake);
+
+    return 0;
+}
+
 /*
  * This tests validation checking of peer certificates
  *
@@ -79,8 +112,6 @@ static int testTLSSessionInit(const void *opaque)
     virNetTLSSession *serverSess = NULL;
     int ret = -1;
     int channel[2];
-    bool clientShake = false;
-    bool serverShake = false;
 
 
     /* We'll use this for our fake client-server connection */
@@ -150,29 +181,8 @@ static int testTLSSessionInit(const void *opaque)
     virNetTLSSessionSetIOCallbacks(serverSess, testWrite, testRead, &channel[0]);
     virNetTLSSessionSetIOCallbacks(clientSess, testWrite, testRead, &channel[1]);
 
-    /*
-     * Finally we loop around & around doing handshake on each
-     * session until we get an error, or the handshake completes.
-     * This relies on the socketpair being nonblocking to avoid
-     * deadlocking ourselves upon handshake
-     */
-    do {
-        int rv;
-        if (!serverShake) {
-            rv = virNetTLSSessionHandshake(serverSess);
-            if (rv < 0)
-                goto cleanup;
-            if (rv == VIR_NET_TLS_HANDSHAKE_COMPLETE)
-                serverShake = true;
-        }
-        if (!clientShake) {
-            rv = virNetTLSSessionHandshake(clientSess);
-            if (rv < 0)
-                goto cleanup;
-            if (rv == VIR_NET_TLS_HANDSHAKE_COMPLETE)
-                clientShake = true;
-        }
-    } while (!clientShake || !serverShake);
+    if (testTLSSessionHandshake(serverSess, clientSess) < 0)
+        goto cleanup;
 
 
     /* Finally make sure the server validation does what
@@ -229,6 +239,266 @@ static int testTLSSessionInit(const void *opaque)
 }
 
 
+struct testTLSSessionPair {
+    int channel[2];
+    virNetTLSSession *server;
+    virNetTLSSession *client;
+};
+
+
+static void testTLSSessionDisconnect(struct testTLSSessionPair *pair)
+{
+    g_clear_pointer(&pair->server, virObjectUnref);
+    g_clear_pointer(&pair->client, virObjectUnref);
+    VIR_FORCE_CLOSE(pair->channel[0]);
+    VIR_FORCE_CLOSE(pair->channel[1]);
+}
+
+
+static int testTLSSessionConnect(virNetTLSContext *serverCtxt,
+                                 virNetTLSContext *clientCtxt,
+                                 const char *hostname,
+                                 struct testTLSSessionPair *pair)
+{
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair->channel) < 0)
+        abort();
+
+    ignore_value(virSetNonBlock(pair->channel[0]));
+    ignore_value(virSetNonBlock(pair->channel[1]));
+
+    if (!(pair->server = virNetTLSSessionNew(serverCtxt, NULL)) ||
+        !(pair->client = virNetTLSSessionNew(clientCtxt, hostname)))
+        goto error;
+
+    virNetTLSSessionSetIOCallbacks(pair->server, testWrite, testRead,
+                                   &pair->channel[0]);
+    virNetTLSSessionSetIOCallbacks(pair->client, testWrite, testRead,
+                                   &pair->channel[1]);
+
+    if (testTLSSessionHandshake(pair->server, pair->client) < 0)
+        goto error;
+
+    return 0;
+
+ error:
+    testTLSSessionDisconnect(pair);
+    return -1;
+}
+
+
+/*
+ * Send @len bytes from the server to the client, alternating
+ * between the two ends whenever the socketpair would block.
+ */
+static int testTLSSessionTransfer(struct testTLSSessionPair *pair,
+                                  size_t len)
+{
+    g_autofree char *buf = g_new0(char, 64 * 1024);
+    size_t sent = 0;
+    size_t received = 0;
+    ssize_t rv;
+
+    while (received < len) {
+        if (sent < len) {
+            rv = virNetTLSSessionWrite(pair->server, buf,
+                                       MIN(64 * 1024, len - sent));
+            if (rv < 0 && errno != EAGAIN)
+                return -1;
+            if (rv > 0)
+                sent += rv;
+        }
+
+        rv = virNetTLSSessionRead(pair->client, buf, 64 * 1024);
+        if (rv == 0 || (rv < 0 && errno != EAGAIN))
+            return -1;
+        if (rv > 0)
+            received += rv;
+    }
+
+    return 0;
+}
+
+
+static int testTLSSessionContextsNew(struct testTLSSessionData *data,
+                                     virNetTLSContext **serverCtxt,
+                                     virNetTLSContext **clientCtxt)
+{
+    *serverCtxt = virNetTLSContextNewServer(data->servercacrt,
+                                            NULL,
+                                            data->servercrt,
+                                            KEYFILE,
+                                            data->wildcards,
+                                            "NORMAL",
+                                            false,
+                                            true);
+
+    *clientCtxt = virNetTLSContextNewClient(data->clientcacrt,
+                                            NULL,
+                                            data->clientcrt,
+                                            KEYFILE,
+                                            "NORMAL",
+                                            false,
+                                            true);
+
+    if (!*serverCtxt || !*clientCtxt)
+        return -1;
+
+    return 0;
+}
+
+
+/*
+ * This tests that a client reconnecting to the same server
+ * resumes its previous session, unless the server replaced
+ * its session ticket key in the meantime
+ */
+static int testTLSSessionResume(const void *opaque)
+{
+    struct testTLSSessionData *data = (struct testTLSSessionData *)opaque;
+    virNetTLSContext *serverCtxt = NULL;
+    virNetTLSContext *clientCtxt = NULL;
+    struct testTLSSessionPair pair = { { -1, -1 }, NULL, NULL };
+    const bool expectResumed[] = { false, true, false };
+    size_t i;
+    int ret = -1;
+
+    if (testTLSSessionContextsNew(data, &serverCtxt, &clientCtxt) < 0)
+        goto cleanup;
+
+    for (i = 0; i < G_N_ELEMENTS(expectResumed); i++) {
+        if (i == 2 &&
+            (virNetTLSContextSetSessionTickets(serverCtxt, false) < 0 ||
+             virNetTLSContextSetSessionTickets(serverCtxt, true) < 0))
+            goto cleanup;
+
+        if (testTLSSessionConnect(serverCtxt, clientCtxt,
+                                  data->hostname, &pair) < 0)
+            goto cleanup;
+
+        /* With TLS 1.3 the client only gets the ticket along with
+         * the first data sent by the server */
+        if (testTLSSessionTransfer(&pair, 1) < 0)
+            goto cleanup;
+
+        if (virNetTLSContextCheckCertificate(serverCtxt, pair.server) < 0 ||
+            virNetTLSContextCheckCertificate(clientCtxt, pair.client) < 0)
+            goto cleanup;
+
+        if (virNetTLSSessionIsResumed(pair.client) != expectResumed[i]) {
+            VIR_TEST_DEBUG("Connection %zu: expected resumed=%d",
+                           i, expectResumed[i]);
+            goto cleanup;
+        }
+
+        testTLSSessionDisconnect(&pair);
+    }
+
+    ret = 0;
+
+ cleanup:
+    testTLSSessionDisconnect(&pair);
+    virObjectUnref(serverCtxt);
+    virObjectUnref(clientCtxt);
+    return ret;
+}
+
+
+/*
+ * Benchmark of the number of full and resumed handshakes per
+ * second. Only run with VIR_TEST_EXPENSIVE=1, the results are
+ * printed with VIR_TEST_VERBOSE=1.
+ */
+static int testTLSSessionBenchHandshake(const void *opaque)
+{
+    struct testTLSSessionData *data = (struct testTLSSessionData *)opaque;
+    virNetTLSContext *serverCtxt = NULL;
+    virNetTLSContext *clientCtxt = NULL;
+    struct testTLSSessionPair pair = { { -1, -1 }, NULL, NULL };
+    const size_t nconns = 500;
+    size_t i;
+    int resume;
+    int ret = -1;
+
+    if (virTestGetExpensive() == 0)
+        return EXIT_AM_SKIP;
+
+    if (testTLSSessionContextsNew(data, &serverCtxt, &clientCtxt) < 0)
+        goto cleanup;
+
+    for (resume = 0; resume < 2; resume++) {
+        unsigned long long start;
+        double elapsed;
+
+        if (virNetTLSContextSetSessionTickets(serverCtxt, resume) < 0)
+            goto cleanup;
+
+        start = g_get_monotonic_time();
+        for (i = 0; i < nconns; i++) {
+            if (testTLSSessionConnect(serverCtxt, clientCtxt,
+                                      data->hostname, &pair) < 0 ||
+                testTLSSessionTransfer(&pair, 1) < 0)
+                goto cleanup;
+            testTLSSessionDisconnect(&pair);
+        }
+        elapsed = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+
+        VIR_TEST_VERBOSE("%s handshakes: %.1f/s",
+                         resume ? "Resumed" : "Full", nconns / elapsed);
+    }
+
+    ret = 0;
+
+ cleanup:
+    testTLSSessionDisconnect(&pair);
+    virObjectUnref(serverCtxt);
+    virObjectUnref(clientCtxt);
+    return ret;
+}
+
+
+/*
+ * Benchmark of the bulk throughput of an established session.
+ * Only run with VIR_TEST_EXPENSIVE=1, the results are printed
+ * with VIR_TEST_VERBOSE=1. The sessions use the I/O callbacks
+ * over a UNIX socket pair, so kernel TLS is not covered.
+ */
+static int testTLSSessionBenchThroughput(const void *opaque)
+{
+    struct testTLSSessionData *data = (struct testTLSSessionData *)opaque;
+    virNetTLSContext *serverCtxt = NULL;
+    virNetTLSContext *clientCtxt = NULL;
+    struct testTLSSessionPair pair = { { -1, -1 }, NULL, NULL };
+    const size_t len = 256 * 1024 * 1024;
+    unsigned long long start;
+    double elapsed;
+    int ret = -1;
+
+    if (virTestGetExpensive() == 0)
+        return EXIT_AM_SKIP;
+
+    if (testTLSSessionContextsNew(data, &serverCtxt, &clientCtxt) < 0 ||
+        testTLSSessionConnect(serverCtxt, clientCtxt,
+                              data->hostname, &pair) < 0)
+        goto cleanup;
+
+    start = g_get_monotonic_time();
+    if (testTLSSessionTransfer(&pair, len) < 0)
+        goto cleanup;
+    elapsed = (g_get_monotonic_time() - start) / (double)G_USEC_PER_SEC;
+
+    VIR_TEST_VERBOSE("Throughput: %.1f MiB/s",
+                     len / elapsed / (1024 * 1024));
+
+    ret = 0;
+
+ cleanup:
+    testTLSSessionDisconnect(&pair);
+    virObjectUnref(serverCtxt);
+    virObjectUnref(clientCtxt);
+    return ret;
+}
+
+
 static int
 mymain(void)
 {
@@ -457,6 +727,22 @@ mymain(void)
     DO_SESS_TEST("cacertchain-sess.pem", servercertlevel3areq.filename, clientcertlevel2breq.filename,
                  false, false, "libvirt.org", NULL);
 
+# define DO_SESS_RUN(_name, _func) \
+    do { \
+        static struct testTLSSessionData data; \
+        data.servercacrt = cacertreq.filename; \
+        data.clientcacrt = cacertreq.filename; \
+        data.servercrt = servercertreq.filename; \
+        data.clientcrt = clientcertreq.filename; \
+        data.hostname = "libvirt.org"; \
+        if (virTestRun(_name, _func, &data) < 0) \
+            ret = -1; \
+    } while (0)
+
+    DO_SESS_RUN("TLS Session resumption", testTLSSessionResume);
+    DO_SESS_RUN("TLS Session handshake benchmark", testTLSSessionBenchHandshake);
+    DO_SESS_RUN("TLS Session throughput benchmark", testTLSSessionBenchThroughput);
+
     VIR_WARNINGS_RESET
 
     testTLSDiscardCert(&clientcertreq);
@@ -21,6 +21,9 @@
 #include "internal.h"
 #include "virnuma.h"
 #include "virfile.h"
+#include "viralloc.h"
+#include "virerror.h"
+#include "virutil.h"
 
 #define VIR_FROM_THIS VIR_FROM_NONE
 
@@ -28,6 +31,17 @@
 
 static int numa_avail = -1;
 
+/* Huge page pools read from sysfs, resized by virNumaSetPagePoolSize() */
+typedef struct {
+    int node;
+    unsigned int page_size;
+    unsigned long long avail;
+    unsigned long long free;
+} virNumaMockPool;
+
+static virNumaMockPool *pools;
+static size_t npools;
+
 
 /*
  * Poor man's mocked NUMA guesser.  We basically check if
@@ -171,3 +185,128 @@ virNumaGetNodeCPUs(int node, virBitmap **cpus)
 
     return virBitmapCountBits(*cpus);
 }
+
+
+static virNumaMockPool *
+virNumaMockGetPool(int node,
+                   unsigned int page_size)
+{
+    virNumaMockPool pool = { .node = node, .page_size = page_size };
+    int rc;
+    size_t i;
+
+    for (i = 0; i < npools; i++) {
+        if (pools[i].node == node && pools[i].page_size == page_size)
+            return &pools[i];
+    }
+
+    if ((rc = virFileReadValueUllong(&pool.avail,
+                                     "%s/node/node%d/hugepages/hugepages-%ukB/nr_hugepages",
+                                     SYSFS_SYSTEM_PATH, node, page_size)) == 0)
+        rc = virFileReadValueUllong(&pool.free,
+                                    "%s/node/node%d/hugepages/hugepages-%ukB/free_hugepages",
+                                    SYSFS_SYSTEM_PATH, node, page_size);
+
+    if (rc == -2)
+        virReportError(VIR_ERR_OPERATION_FAILED,
+                       "Mock: no pool of %u KiB pages on node %d", page_size, node);
+    if (rc < 0)
+        return NULL;
+
+    VIR_APPEND_ELEMENT(pools, npools, pool);
+    return &pools[npools - 1];
+}
+
+/*
+ * Huge pages are read from
+ * /sys/devices/system/node/nodeN/hugepages/hugepages-SIZEkB so that the
+ * pools can differ between nodes, system pages come from
+ * virNumaGetNodeMemory().
+ */
+int
+virNumaGetPageInfo(int node,
+                   unsigned int page_size,
+                   unsigned long long huge_page_sum,
+                   unsigned long long *page_avail,
+                   unsigned long long *page_free)
+{
+    unsigned long long avail = 0;
+    unsigned long long nfree = 0;
+    virNumaMockPool *pool;
+    int maxnode;
+    int n;
+
+    if (page_size == virGetSystemPageSizeKB()) {
+        if (virNumaGetNodeMemory(MAX(node, 0), &avail, &nfree) < 0)
+            return -1;
+
+        avail = (avail - huge_page_sum) / 1024 / page_size;
+        nfree = nfree / 1024 / page_size;
+    } else if (node == -1) {
+        if ((maxnode = virNumaGetMaxNode()) < 0)
+            return -1;
+
+        for (n = 0; n <= maxnode; n++) {
+            if (!virNumaNodeIsAvailable(n))
+                continue;
+
+            if (!(pool = virNumaMockGetPool(n, page_size)))
+                return -1;
+
+            avail += pool->avail;
+            nfree += pool->free;
+        }
+    } else {
+        if (!(pool = virNumaMockGetPool(node, page_size)))
+            return -1;
+
+        avail = pool->avail;
+        nfree = pool->free;
+    }
+
+    if (page_avail)
+        *page_avail = avail;
+    if (page_free)
+        *page_free = nfree;
+
+    return 0;
+}
+
+/*
+ * The kernel always manages to resize the pool, the pages it adds are
+ * free and those it drops are taken from the free ones.
+ */
+int
+virNumaSetPagePoolSize(int node,
+                       unsigned int page_size,
+                       unsigned long long page_count,
+                       bool add)
+{
+    virNumaMockPool *pool;
+
+    if (page_size == virGetSystemPageSizeKB()) {
+        virReportError(VIR_ERR_OPERATION_UNSUPPORTED, "%s",
+                       "system pages pool can't be modified");
+        return -1;
+    }
+
+    if (!(pool = virNumaMockGetPool(node, page_size)))
+        return -1;
+
+    if (add)
+        page_count += pool->avail;
+
+    if (page_count >= pool->avail) {
+        pool->free += page_count - pool->avail;
+    } else if (pool->avail - page_count <= pool->free) {
+        pool->free -= pool->avail - page_count;
+    } else {
+        virReportError(VIR_ERR_OPERATION_FAILED,
+                       "Unable to allocate %llu pages. Allocated only %llu",
+                       page_count, pool->avail);
+        return -1;
+    }
+
+    pool->avail = page_count;
+    return 0;
+}
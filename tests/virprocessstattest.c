@@ -3,6 +3,8 @@
 #include "testutils.h"
 #include "virfilewrapper.h"
 #include "virprocess.h"
+#include "virprocessstats.h"
+#include "virutil.h"
 
 
 struct testData {
@@ -60,6 +62,58 @@ test_virProcessGetStat(const void *opaque)
 }
 
 
+static int
+test_virProcessGetStats(const void *opaque G_GNUC_UNUSED)
+{
+    g_autofree char *data_dir = NULL;
+    virProcessStats stats;
+    unsigned long long cpuTime = 29ull * 1000 * 1000 * 1000 / sysconf(_SC_CLK_TCK);
+
+    data_dir = g_strdup_printf("%s/virprocessstatdata/complex/", abs_srcdir);
+    virFileWrapperAddPrefix("/proc/-1/task/-1/", data_dir);
+
+    /* Reads the stat file and caches the statistics */
+    if (virProcessGetStats(-1, -1, 60 * 1000,
+                           VIR_PROCESS_STATS_SCHED, &stats) < 0) {
+        virFileWrapperClearPrefixes();
+        return -1;
+    }
+
+    virFileWrapperClearPrefixes();
+
+    if (stats.cpuTime != cpuTime ||
+        stats.lastCpu != 39 ||
+        stats.rss != 24 * virGetSystemPageSizeKB() ||
+        stats.cpuWait != 0 ||
+        stats.cpuDelay != 0) {
+        fprintf(stderr, "Wrong statistics cpuTime=%llu lastCpu=%d rss=%ld\n",
+                stats.cpuTime, stats.lastCpu, stats.rss);
+        return -1;
+    }
+
+    /* The thread is gone now, but its statistics are still fresh */
+    if (virProcessGetStats(-1, -1, 60 * 1000,
+                           VIR_PROCESS_STATS_SCHED, &stats) < 0)
+        return -1;
+
+    if (stats.cpuTime != cpuTime || stats.lastCpu != 39) {
+        fprintf(stderr, "Statistics were not cached\n");
+        return -1;
+    }
+
+    /* Unless they are required to be fresher than that */
+    if (virProcessGetStats(-1, -1, 0, 0, &stats) < 0)
+        return -1;
+
+    if (stats.cpuTime != 0 || stats.lastCpu != 0) {
+        fprintf(stderr, "Statistics of a missing thread are not zero\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+
 static int
 mymain(void)
 {
@@ -82,6 +136,10 @@ mymain(void)
     DO_TEST("simple", "command", 5, true);
     DO_TEST("complex", "this) is ( a \t weird )\n)( (command ( ", 100, false);
 
+    if (virTestRun("Getting process statistics",
+                   test_virProcessGetStats, NULL) < 0)
+        ret = -1;
+
     return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
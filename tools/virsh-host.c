@@ -266,6 +266,10 @@ static const vshCmdOptDef opts_freepages[] = {
      .type = VSH_OT_BOOL,
      .help = N_("show free pages for all NUMA cells")
     },
+    {.name = "unreserved",
+     .type = VSH_OT_BOOL,
+     .help = N_("don't count pages reserved for running domains as free")
+    },
     {.name = NULL}
 };
 
@@ -297,10 +301,14 @@ cmdFreepages(vshControl *ctl, const vshCmd *cmd)
     bool all = vshCommandOptBool(cmd, "all");
     bool cellno = vshCommandOptBool(cmd, "cellno");
     bool pagesz = vshCommandOptBool(cmd, "pagesize");
+    unsigned int flags = 0;
     virshControl *priv = ctl->privData;
 
     VSH_EXCLUSIVE_OPTIONS_VAR(all, cellno);
 
+    if (vshCommandOptBool(cmd, "unreserved"))
+        flags |= VIR_NODE_FREE_PAGES_UNRESERVED;
+
     if (vshCommandOptScaledInt(ctl, cmd, "pagesize", &bytes, 1024, UINT_MAX) < 0)
         goto cleanup;
     kibibytes = VIR_DIV_UP(bytes, 1024);
@@ -379,7 +387,7 @@ cmdFreepages(vshControl *ctl, const vshCmd *cmd)
             }
 
             if (virNodeGetFreePages(priv->conn, npages, pagesize,
-                                    cell, 1, counts, 0) < 0)
+                                    cell, 1, counts, flags) < 0)
                 goto cleanup;
 
             vshPrint(ctl, _("Node %d:\n"), cell);
@@ -415,7 +423,7 @@ cmdFreepages(vshControl *ctl, const vshCmd *cmd)
         counts = g_new0(unsigned long long, 1);
 
         if (virNodeGetFreePages(priv->conn, 1, pagesize,
-                                cell, 1, counts, 0) < 0)
+                                cell, 1, counts, flags) < 0)
             goto cleanup;
 
         vshPrint(ctl, "%uKiB: %lld\n", *pagesize, counts[0]);
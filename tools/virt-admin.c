@@ -393,6 +393,14 @@ static const vshCmdOptDef opts_srv_threadpool_info[] = {
      .completer = vshAdmServerCompleter,
      .help = N_("Server to retrieve threadpool attributes from."),
     },
+    {.name = "io-loops",
+     .type = VSH_OT_BOOL,
+     .help = N_("report statistics of every client I/O loop instead"),
+    },
+    {.name = "fair-queues",
+     .type = VSH_OT_BOOL,
+     .help = N_("report statistics of fair scheduling queues instead"),
+    },
     {.name = NULL}
 };
 
@@ -406,15 +414,21 @@ cmdSrvThreadpoolInfo(vshControl *ctl, const vshCmd *cmd)
     const char *srvname = NULL;
     virAdmServerPtr srv = NULL;
     vshAdmControl *priv = ctl->privData;
+    unsigned int flags = 0;
 
     if (vshCommandOptStringReq(ctl, cmd, "server", &srvname) < 0)
         return false;
 
+    if (vshCommandOptBool(cmd, "io-loops"))
+        flags |= VIR_ADM_SERVER_THREADPOOL_PARAMS_IO_LOOPS;
+    if (vshCommandOptBool(cmd, "fair-queues"))
+        flags |= VIR_ADM_SERVER_THREADPOOL_PARAMS_FAIR_QUEUES;
+
     if (!(srv = virAdmConnectLookupServer(priv->conn, srvname, 0)))
         goto cleanup;
 
     if (virAdmServerGetThreadPoolParameters(srv, &params,
-                                            &nparams, 0) < 0) {
+                                            &nparams, flags) < 0) {
         vshError(ctl, "%s",
                  _("Unable to get server workerpool parameters"));
         goto cleanup;
@@ -467,6 +481,18 @@ static const vshCmdOptDef opts_srv_threadpool_set[] = {
      .type = VSH_OT_INT,
      .help = N_("Change the current number of priority workers"),
     },
+    {.name = "fair-scheduling",
+     .type = VSH_OT_INT,
+     .help = N_("Enable (1) or disable (0) fair scheduling of client calls"),
+    },
+    {.name = "fair-weight-readonly",
+     .type = VSH_OT_INT,
+     .help = N_("Change the number of calls of a read-only client served in a row"),
+    },
+    {.name = "fair-weight-readwrite",
+     .type = VSH_OT_INT,
+     .help = N_("Change the number of calls of a read-write client served in a row"),
+    },
     {.name = NULL}
 };
 
@@ -499,13 +525,18 @@ cmdSrvThreadpoolSet(vshControl *ctl, const vshCmd *cmd)
     PARSE_CMD_TYPED_PARAM("max-workers", VIR_THREADPOOL_WORKERS_MAX);
     PARSE_CMD_TYPED_PARAM("min-workers", VIR_THREADPOOL_WORKERS_MIN);
     PARSE_CMD_TYPED_PARAM("priority-workers", VIR_THREADPOOL_WORKERS_PRIORITY);
+    PARSE_CMD_TYPED_PARAM("fair-scheduling", VIR_THREADPOOL_FAIR_SCHEDULING);
+    PARSE_CMD_TYPED_PARAM("fair-weight-readonly", VIR_THREADPOOL_FAIR_WEIGHT_READONLY);
+    PARSE_CMD_TYPED_PARAM("fair-weight-readwrite", VIR_THREADPOOL_FAIR_WEIGHT_READWRITE);
 
 #undef PARSE_CMD_TYPED_PARAM
 
     if (!nparams) {
         vshError(ctl, "%s",
                  _("At least one of options --min-workers, --max-workers, "
-                   "--priority-workers is mandatory "));
+                   "--priority-workers, --fair-scheduling, "
+                   "--fair-weight-readonly, --fair-weight-readwrite "
+                   "is mandatory "));
             goto cleanup;
     }
 
@@ -831,8 +862,11 @@ cmdSrvClientsInfo(vshControl *ctl, const vshCmd *cmd)
         goto cleanup;
     }
 
-    for (i = 0; i < nparams; i++)
-        vshPrint(ctl, "%-20s: %u\n", params[i].field, params[i].value.ui);
+    for (i = 0; i < nparams; i++) {
+        char *str = vshGetTypedParamValue(ctl, &params[i]);
+        vshPrint(ctl, "%-20s: %s\n", params[i].field, str);
+        VIR_FREE(str);
+    }
 
     ret = true;
 
@@ -1096,6 +1130,45 @@ cmdDaemonTimeout(vshControl *ctl, const vshCmd *cmd)
 }
 
 
+/* --------------------------
+ * Command daemon-stats
+ * --------------------------
+ */
+static const vshCmdInfo info_daemon_stats[] = {
+    {.name = "help",
+     .data = N_("get statistics of the drivers running in the daemon")
+    },
+    {.name = "desc",
+     .data = N_("Retrieve statistics of the virtualization drivers, such as "
+                "the progress of reconnecting to running domains.")
+    },
+    {.name = NULL}
+};
+
+static bool
+cmdDaemonStats(vshControl *ctl, const vshCmd *cmd G_GNUC_UNUSED)
+{
+    vshAdmControl *priv = ctl->privData;
+    virTypedParameterPtr params = NULL;
+    int nparams = 0;
+    size_t i;
+
+    if (virAdmConnectGetDriverStats(priv->conn, &params, &nparams, 0) < 0) {
+        vshError(ctl, "%s", _("Unable to get daemon statistics"));
+        return false;
+    }
+
+    for (i = 0; i < nparams; i++) {
+        char *str = vshGetTypedParamValue(ctl, &params[i]);
+        vshPrint(ctl, "%-21s: %s\n", params[i].field, str);
+        VIR_FREE(str);
+    }
+
+    virTypedParamsFree(params, nparams);
+    return true;
+}
+
+
 /* --------------------------
  * Command daemon-timeout
  * --------------------------
@@ -1485,6 +1558,12 @@ static const vshCmdDef monitoringCmds[] = {
      .info = info_srv_clients_info,
      .flags = 0
     },
+    {.name = "daemon-stats",
+     .handler = cmdDaemonStats,
+     .opts = NULL,
+     .info = info_daemon_stats,
+     .flags = 0
+    },
     {.name = NULL}
 };
 